@@ -47,6 +47,7 @@
 #include "ndisc/nm-lndp-ndisc.h"
 
 #include "dhcp/nm-dhcp-manager.h"
+#include "dhcp/nm-dhcp-server.h"
 #include "dhcp/nm-dhcp-utils.h"
 #include "nm-act-request.h"
 #include "nm-pacrunner-manager.h"
@@ -256,9 +257,11 @@ typedef struct {
     union {
         struct {
             NMDnsMasqManager      *dnsmasq_manager;
+            NMDhcpServer          *dhcp_server;
             NMNetnsSharedIPHandle *shared_ip_handle;
             NMFirewallConfig      *firewall_config;
             gulong                 dnsmasq_state_id;
+            gulong                 dns_config_id;
             const NML3ConfigData  *l3cd;
         } v4;
         struct {
@@ -4543,7 +4546,8 @@ _dev_l3_cfg_notify_cb(NML3Cfg *l3cfg, const NML3ConfigNotifyData *notify_data, N
     }
     case NM_L3_CONFIG_NOTIFY_TYPE_POST_COMMIT:
         if (priv->ipshared_data_4.state == NM_DEVICE_IP_STATE_PENDING
-            && !priv->ipshared_data_4.v4.dnsmasq_manager && priv->ipshared_data_4.v4.l3cd) {
+            && !priv->ipshared_data_4.v4.dnsmasq_manager && !priv->ipshared_data_4.v4.dhcp_server
+            && priv->ipshared_data_4.v4.l3cd) {
             _dev_ipshared4_spawn_dnsmasq(self);
         }
         _dev_ip_state_check_async(self, AF_UNSPEC);
@@ -6873,7 +6877,7 @@ nm_device_update_dynamic_ip_setup(NMDevice *self, const char *reason)
     if (priv->ipac6_data.ndisc) {
         /* FIXME: todo */
     }
-    if (priv->ipshared_data_4.v4.dnsmasq_manager) {
+    if (priv->ipshared_data_4.v4.dnsmasq_manager || priv->ipshared_data_4.v4.dhcp_server) {
         /* FIXME: todo */
     }
 }
@@ -12917,6 +12921,11 @@ _dev_ipsharedx_cleanup(NMDevice *self, int addr_family)
             nm_dnsmasq_manager_stop(priv->ipshared_data_4.v4.dnsmasq_manager);
             g_clear_object(&priv->ipshared_data_4.v4.dnsmasq_manager);
         }
+        if (priv->ipshared_data_4.v4.dns_config_id != 0) {
+            nm_clear_g_signal_handler(nm_manager_get_dns_manager(priv->manager),
+                                      &priv->ipshared_data_4.v4.dns_config_id);
+        }
+        nm_clear_pointer(&priv->ipshared_data_4.v4.dhcp_server, nm_dhcp_server_free);
 
         if (priv->ipshared_data_4.v4.firewall_config) {
             nm_firewall_config_apply_sync(priv->ipshared_data_4.v4.firewall_config, FALSE);
@@ -13041,6 +13050,18 @@ _dev_ipshared4_dnsmasq_state_changed_cb(NMDnsMasqManager *manager, guint status,
     _dev_ip_state_check_async(self, AF_INET);
 }
 
+static void
+_dev_ipshared4_dns_config_changed_cb(NMDnsManager *dns_manager, GParamSpec *pspec, NMDevice *self)
+{
+    NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE(self);
+
+    if (!priv->ipshared_data_4.v4.dhcp_server)
+        return;
+
+    nm_dhcp_server_set_nameservers(priv->ipshared_data_4.v4.dhcp_server,
+                                   nm_dns_manager_get_upstream_nameservers(dns_manager));
+}
+
 static void
 _dev_ipshared4_start(NMDevice *self)
 {
@@ -13055,6 +13076,7 @@ _dev_ipshared4_start(NMDevice *self)
 
     nm_assert(!priv->ipshared_data_4.v4.firewall_config);
     nm_assert(!priv->ipshared_data_4.v4.dnsmasq_manager);
+    nm_assert(!priv->ipshared_data_4.v4.dhcp_server);
     nm_assert(priv->ipshared_data_4.v4.dnsmasq_state_id == 0);
 
     ip_iface = nm_device_get_ip_iface(self);
@@ -13098,11 +13120,13 @@ _dev_ipshared4_spawn_dnsmasq(NMDevice *self)
     gboolean               announce_android_metered;
     NMConnection          *applied;
     gs_unref_array GArray *conflicts = NULL;
+    gs_free char          *dhcp_server = NULL;
     gboolean               ready;
 
     nm_assert(priv->ipshared_data_4.v4.firewall_config);
     nm_assert(priv->ipshared_data_4.v4.dnsmasq_state_id == 0);
     nm_assert(!priv->ipshared_data_4.v4.dnsmasq_manager);
+    nm_assert(!priv->ipshared_data_4.v4.dhcp_server);
     nm_assert(priv->ipshared_data_4.v4.l3cd);
 
     ready = nm_l3cfg_check_ready(priv->l3cfg,
@@ -13144,6 +13168,47 @@ _dev_ipshared4_spawn_dnsmasq(NMDevice *self)
         break;
     }
 
+    dhcp_server =
+        nm_config_data_get_value(NM_CONFIG_GET_DATA,
+                                 NM_CONFIG_KEYFILE_GROUP_MAIN,
+                                 NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DHCP_SERVER,
+                                 NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+    if (nm_streq0(dhcp_server, "internal")) {
+        const NMPlatformIP4Address *addr;
+
+        addr = NMP_OBJECT_CAST_IP4_ADDRESS(
+            nm_l3_config_data_get_first_obj(priv->ipshared_data_4.v4.l3cd,
+                                            NMP_OBJECT_TYPE_IP4_ADDRESS,
+                                            NULL));
+        nm_assert(addr);
+
+        priv->ipshared_data_4.v4.dhcp_server = nm_dhcp_server_new(ip_iface,
+                                                                  addr->address,
+                                                                  addr->plen,
+                                                                  announce_android_metered,
+                                                                  NULL,
+                                                                  &error);
+        if (priv->ipshared_data_4.v4.dhcp_server) {
+            NMDnsManager *dns_manager = nm_manager_get_dns_manager(priv->manager);
+
+            /* The internal DHCP server does not forward DNS requests, it hands
+             * out the upstream name servers and follows their changes. */
+            nm_dhcp_server_set_nameservers(priv->ipshared_data_4.v4.dhcp_server,
+                                           nm_dns_manager_get_upstream_nameservers(dns_manager));
+            priv->ipshared_data_4.v4.dns_config_id =
+                g_signal_connect(dns_manager,
+                                 "notify::" NM_DNS_MANAGER_CONFIGURATION,
+                                 G_CALLBACK(_dev_ipshared4_dns_config_changed_cb),
+                                 self);
+        }
+        if (!priv->ipshared_data_4.v4.dhcp_server
+            || !nm_dhcp_server_start(priv->ipshared_data_4.v4.dhcp_server, &error)) {
+            _LOGW_ipshared(AF_INET, "could not start internal DHCP server: %s", error->message);
+            goto out_fail;
+        }
+        goto out_ready;
+    }
+
     priv->ipshared_data_4.v4.dnsmasq_manager = nm_dnsmasq_manager_new(ip_iface);
     if (!nm_dnsmasq_manager_start(priv->ipshared_data_4.v4.dnsmasq_manager,
                                   priv->ipshared_data_4.v4.l3cd,
@@ -13159,6 +13224,7 @@ _dev_ipshared4_spawn_dnsmasq(NMDevice *self)
                          G_CALLBACK(_dev_ipshared4_dnsmasq_state_changed_cb),
                          self);
 
+out_ready:
     _dev_ipsharedx_set_state(self, AF_INET, NM_DEVICE_IP_STATE_READY);
     _dev_ip_state_check_async(self, AF_INET);
     nm_clear_l3cd(&priv->ipshared_data_4.v4.l3cd);
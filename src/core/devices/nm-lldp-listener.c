@@ -817,13 +817,15 @@ lldp_event_handler(NMLldpRX *lldp, NMLldpRXEvent event, NMLldpNeighbor *n, void
 {
     NMLldpListener *self = user_data;
 
+    if (event == NM_LLDP_RX_EVENT_REFRESHED) {
+        /* The neighbor sent the same frame again. Nothing to do. */
+        return;
+    }
+
     _LOGD("event: %s", nm_lldp_rx_event_to_string(event));
     process_lldp_neighbor(self,
                           n,
-                          !NM_IN_SET(event,
-                                     NM_LLDP_RX_EVENT_ADDED,
-                                     NM_LLDP_RX_EVENT_UPDATED,
-                                     NM_LLDP_RX_EVENT_REFRESHED));
+                          !NM_IN_SET(event, NM_LLDP_RX_EVENT_ADDED, NM_LLDP_RX_EVENT_UPDATED));
 }
 
 /*****************************************************************************/
@@ -26,6 +26,9 @@
 
 #define OVSDB_MAX_FAILURES 3
 
+/* The maximum number of queued calls that are merged into one transaction. */
+#define OVSDB_BATCH_MAX 64
+
 #define OTHER_CONFIG_HWADDR "hwaddr"
 
 /*****************************************************************************/
@@ -120,8 +123,16 @@ typedef struct {
     gpointer            user_data;
     OvsdbMethodPayload  payload;
     GObject            *shutdown_wait_obj;
+    bool                no_batch : 1;
 } OvsdbMethodCall;
 
+/* State of a transaction that several add-interface calls are merged into. */
+typedef struct {
+    json_t     *new_bridges;  /* the new "bridges" of the Open_vSwitch table, once updated */
+    GHashTable *bridge_ports; /* bridge name => json_t array with its new "ports" */
+    guint       n_rows;       /* counter for unique "uuid-name"s of inserted rows */
+} OvsdbTransaction;
+
 /*****************************************************************************/
 
 enum {
@@ -146,6 +157,13 @@ typedef struct {
 
     GSource *input_timeout_source;
 
+    struct {
+        gsize pos;   /* How many bytes of input_buf were already scanned */
+        guint depth; /* Nesting level of objects/arrays at "pos" */
+        bool  in_string : 1;
+        bool  escaped : 1;
+    } input_scan;
+
     guint64 call_id_counter;
 
     CList calls_lst_head;
@@ -868,7 +886,8 @@ static void
 _insert_interface(json_t       *params,
                   NMConnection *interface,
                   NMDevice     *interface_device,
-                  const char   *cloned_mac)
+                  const char   *cloned_mac,
+                  const char   *uuid_name)
 {
     const char            *type = NULL;
     NMSettingOvsInterface *s_ovs_iface;
@@ -973,7 +992,7 @@ _insert_interface(json_t       *params,
                                     "row",
                                     row,
                                     "uuid-name",
-                                    "rowInterface"));
+                                    uuid_name));
 }
 
 /**
@@ -982,7 +1001,7 @@ _insert_interface(json_t       *params,
  * Returns an commands that adds new port from a given connection.
  */
 static void
-_insert_port(json_t *params, NMConnection *port, json_t *new_interfaces)
+_insert_port(json_t *params, NMConnection *port, json_t *new_interfaces, const char *uuid_name)
 {
     NMSettingOvsPort *s_ovs_port;
     const char       *vlan_mode      = NULL;
@@ -1055,7 +1074,7 @@ _insert_port(json_t *params, NMConnection *port, json_t *new_interfaces)
                                     "row",
                                     row,
                                     "uuid-name",
-                                    "rowPort"));
+                                    uuid_name));
 }
 
 /**
@@ -1068,7 +1087,8 @@ _insert_bridge(json_t       *params,
                NMConnection *bridge,
                NMDevice     *bridge_device,
                json_t       *new_ports,
-               const char   *cloned_mac)
+               const char   *cloned_mac,
+               const char   *uuid_name)
 {
     NMSettingOvsBridge *s_ovs_bridge;
     const char         *fail_mode             = NULL;
@@ -1120,7 +1140,7 @@ _insert_bridge(json_t       *params,
                                     "row",
                                     row,
                                     "uuid-name",
-                                    "rowBridge"));
+                                    uuid_name));
 }
 
 /**
@@ -1153,15 +1173,20 @@ _inc_next_cfg(const char *db_uuid)
  *
  * Adds an interface as specified by @interface connection, optionally creating
  * a parent @port and @bridge if needed.
+ *
+ * Several calls can be merged into one transaction @txn, as long as each of them
+ * adds a different port. Bridges created or updated by a previous call in the
+ * same transaction are reused.
  */
 static void
-_add_interface(NMOvsdb      *self,
-               json_t       *params,
-               NMConnection *bridge,
-               NMConnection *port,
-               NMConnection *interface,
-               NMDevice     *bridge_device,
-               NMDevice     *interface_device)
+_add_interface(NMOvsdb          *self,
+               json_t           *params,
+               OvsdbTransaction *txn,
+               NMConnection     *bridge,
+               NMConnection     *port,
+               NMConnection     *interface,
+               NMDevice         *bridge_device,
+               NMDevice         *interface_device)
 {
     NMOvsdbPrivate             *priv = NM_OVSDB_GET_PRIVATE(self);
     GHashTableIter              iter;
@@ -1174,13 +1199,14 @@ _add_interface(NMOvsdb      *self,
     OpenvswitchPort            *ovs_port       = NULL;
     OpenvswitchInterface       *ovs_interface  = NULL;
     nm_auto_decref_json json_t *bridges        = NULL;
-    nm_auto_decref_json json_t *new_bridges    = NULL;
     nm_auto_decref_json json_t *ports          = NULL;
-    nm_auto_decref_json json_t *new_ports      = NULL;
     nm_auto_decref_json json_t *interfaces     = NULL;
     nm_auto_decref_json json_t *new_interfaces = NULL;
+    json_t                     *new_ports;
     gboolean                    has_interface  = FALSE;
+    gboolean                    bridge_created = FALSE;
     gboolean                    interface_is_local;
+    char                        uuid_name[64];
     gs_free char               *bridge_cloned_mac    = NULL;
     gs_free char               *interface_cloned_mac = NULL;
     GError                     *error                = NULL;
@@ -1190,8 +1216,6 @@ _add_interface(NMOvsdb      *self,
     bridges        = json_array();
     ports          = json_array();
     interfaces     = json_array();
-    new_bridges    = json_array();
-    new_ports      = json_array();
     new_interfaces = json_array();
 
     bridge_name        = nm_connection_get_interface_name(bridge);
@@ -1295,29 +1319,44 @@ _add_interface(NMOvsdb      *self,
         break;
     }
 
-    json_array_extend(new_bridges, bridges);
-    json_array_extend(new_ports, ports);
     json_array_extend(new_interfaces, interfaces);
 
     if (json_array_size(interfaces) == 0) {
         /* Need to create a port. */
-        if (json_array_size(ports) == 0) {
+        new_ports = g_hash_table_lookup(txn->bridge_ports, bridge_name);
+        if (new_ports) {
+            /* The bridge was already created or updated in this transaction. */
+        } else if (json_array_size(ports) == 0) {
             /* Need to create a bridge. */
-            _expect_ovs_bridges(params, priv->db_uuid, bridges);
-            json_array_append_new(new_bridges, json_pack("[s, s]", "named-uuid", "rowBridge"));
-            _set_ovs_bridges(params, priv->db_uuid, new_bridges);
-            _insert_bridge(params, bridge, bridge_device, new_ports, bridge_cloned_mac);
+            if (!txn->new_bridges) {
+                _expect_ovs_bridges(params, priv->db_uuid, bridges);
+                txn->new_bridges = json_array();
+                json_array_extend(txn->new_bridges, bridges);
+                _set_ovs_bridges(params, priv->db_uuid, txn->new_bridges);
+            }
+            nm_sprintf_buf(uuid_name, "rowBridge%u", txn->n_rows++);
+            json_array_append_new(txn->new_bridges, json_pack("[s, s]", "named-uuid", uuid_name));
+            new_ports = json_array();
+            _insert_bridge(params, bridge, bridge_device, new_ports, bridge_cloned_mac, uuid_name);
+            bridge_created = TRUE;
         } else {
             /* Bridge already exists. */
             g_return_if_fail(ovs_bridge);
+            new_ports = json_array();
+            json_array_extend(new_ports, ports);
             _expect_bridge_ports(params, ovs_bridge->name, ports);
             _set_bridge_ports(params, bridge_name, new_ports);
-            if (bridge_cloned_mac && interface_is_local)
-                _set_bridge_mac(params, bridge_name, bridge_cloned_mac);
         }
 
-        json_array_append_new(new_ports, json_pack("[s, s]", "named-uuid", "rowPort"));
-        _insert_port(params, port, new_interfaces);
+        if (!g_hash_table_contains(txn->bridge_ports, bridge_name))
+            g_hash_table_insert(txn->bridge_ports, (gpointer) bridge_name, new_ports);
+
+        if (bridge_cloned_mac && interface_is_local && !bridge_created)
+            _set_bridge_mac(params, bridge_name, bridge_cloned_mac);
+
+        nm_sprintf_buf(uuid_name, "rowPort%u", txn->n_rows++);
+        json_array_append_new(new_ports, json_pack("[s, s]", "named-uuid", uuid_name));
+        _insert_port(params, port, new_interfaces, uuid_name);
     } else {
         /* Port already exists */
         g_return_if_fail(ovs_port);
@@ -1326,19 +1365,20 @@ _add_interface(NMOvsdb      *self,
     }
 
     if (!has_interface) {
-        _insert_interface(params, interface, interface_device, interface_cloned_mac);
-        json_array_append_new(new_interfaces, json_pack("[s, s]", "named-uuid", "rowInterface"));
+        nm_sprintf_buf(uuid_name, "rowInterface%u", txn->n_rows++);
+        _insert_interface(params, interface, interface_device, interface_cloned_mac, uuid_name);
+        json_array_append_new(new_interfaces, json_pack("[s, s]", "named-uuid", uuid_name));
     }
 }
 
 /**
- * _delete_interface:
+ * _delete_interfaces:
  *
- * Removes an interface of @ifname name, collecting empty ports and bridge
+ * Removes the interfaces named in @ifnames, collecting empty ports and bridge
  * if last item is removed from them.
  */
 static void
-_delete_interface(NMOvsdb *self, json_t *params, const char *ifname)
+_delete_interfaces(NMOvsdb *self, json_t *params, const char *const *ifnames)
 {
     NMOvsdbPrivate             *priv = NM_OVSDB_GET_PRIVATE(self);
     GHashTableIter              iter;
@@ -1396,7 +1436,7 @@ _delete_interface(NMOvsdb *self, json_t *params, const char *ifname)
                 json_array_append_new(interfaces, json_pack("[s,s]", "uuid", interface_uuid));
 
                 if (ovs_interface) {
-                    if (nm_streq(ovs_interface->name, ifname)) {
+                    if (nm_strv_contains(ifnames, -1, ovs_interface->name)) {
                         /* skip the interface */
                         interfaces_changed = TRUE;
                         continue;
@@ -1437,33 +1477,87 @@ _delete_interface(NMOvsdb *self, json_t *params, const char *ifname)
     }
 }
 
+static gboolean
+_command_is_independent(OvsdbCommand command)
+{
+    /* These commands don't depend on our view of the database, so they can
+     * be sent while other commands still wait for their response. */
+    return NM_IN_SET(command, OVSDB_SET_INTERFACE_MTU, OVSDB_SET_REAPPLY);
+}
+
+static OvsdbMethodCall *
+_call_next(NMOvsdb *self, OvsdbMethodCall *call)
+{
+    NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE(self);
+
+    if (call->calls_lst.next == &priv->calls_lst_head)
+        return NULL;
+    return c_list_entry(call->calls_lst.next, OvsdbMethodCall, calls_lst);
+}
+
 /**
- * ovsdb_next_command:
+ * _call_can_batch:
+ *
+ * Whether the queued @call can be merged into the same transaction as the
+ * consecutive calls starting at @first.
+ */
+static gboolean
+_call_can_batch(NMOvsdb *self, OvsdbMethodCall *first, OvsdbMethodCall *call)
+{
+    OvsdbMethodCall *c;
+
+    if (call->command != first->command || call->call_id != CALL_ID_UNSPEC || first->no_batch
+        || call->no_batch)
+        return FALSE;
+
+    switch (call->command) {
+    case OVSDB_DEL_INTERFACE:
+        return TRUE;
+    case OVSDB_ADD_INTERFACE:
+        break;
+    default:
+        return FALSE;
+    }
+
+    /* Each call must create or update its own port. Calls that share a bridge
+     * must agree on which bridge that is. */
+    for (c = first; c != call; c = _call_next(self, c)) {
+        if (nm_streq0(nm_connection_get_interface_name(c->payload.add_interface.port),
+                      nm_connection_get_interface_name(call->payload.add_interface.port))
+            || nm_streq0(nm_connection_get_interface_name(c->payload.add_interface.interface),
+                         nm_connection_get_interface_name(call->payload.add_interface.interface)))
+            return FALSE;
+        if (nm_streq0(nm_connection_get_interface_name(c->payload.add_interface.bridge),
+                      nm_connection_get_interface_name(call->payload.add_interface.bridge))
+            && !nm_streq0(nm_connection_get_uuid(c->payload.add_interface.bridge),
+                          nm_connection_get_uuid(call->payload.add_interface.bridge)))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * ovsdb_send_command:
  *
  * Translates a higher level operation (add/remove bridge/port) to a RFC 7047
  * command serialized into JSON ands sends it over to the database.
-
- * Only called when no command is waiting for a response, since the serialized
- * command might depend on result of a previous one (add and remove need to
- * include an up to date bridge list in their transactions to rule out races).
+ *
+ * Consecutive add or remove operations in the queue are merged into the
+ * same transaction, up to %OVSDB_BATCH_MAX of them. They all get the same
+ * call id.
+ *
+ * Returns: the next queued call that was not sent, or %NULL.
  */
-static void
-ovsdb_next_command(NMOvsdb *self)
+static OvsdbMethodCall *
+ovsdb_send_command(NMOvsdb *self, OvsdbMethodCall *call)
 {
     NMOvsdbPrivate             *priv = NM_OVSDB_GET_PRIVATE(self);
-    OvsdbMethodCall            *call;
-    nm_auto_free char          *cmd = NULL;
-    nm_auto_decref_json json_t *msg = NULL;
-
-    if (priv->conn_fd < 0)
-        return;
+    OvsdbMethodCall            *last = call;
+    nm_auto_free char          *cmd  = NULL;
+    nm_auto_decref_json json_t *msg  = NULL;
 
-    if (c_list_is_empty(&priv->calls_lst_head))
-        return;
-
-    call = c_list_first_entry(&priv->calls_lst_head, OvsdbMethodCall, calls_lst);
-    if (call->call_id != CALL_ID_UNSPEC)
-        return;
+    nm_assert(call->call_id == CALL_ID_UNSPEC);
 
     call->call_id = ++priv->call_id_counter;
 
@@ -1513,17 +1607,57 @@ ovsdb_next_command(NMOvsdb *self)
 
         switch (call->command) {
         case OVSDB_ADD_INTERFACE:
-            _add_interface(self,
-                           params,
-                           call->payload.add_interface.bridge,
-                           call->payload.add_interface.port,
-                           call->payload.add_interface.interface,
-                           call->payload.add_interface.bridge_device,
-                           call->payload.add_interface.interface_device);
+        {
+            OvsdbTransaction txn = {
+                .bridge_ports = g_hash_table_new_full(nm_str_hash,
+                                                      g_str_equal,
+                                                      NULL,
+                                                      (GDestroyNotify) json_decref),
+            };
+            OvsdbMethodCall *c = call;
+            guint            n = 0;
+
+            while (TRUE) {
+                _add_interface(self,
+                               params,
+                               &txn,
+                               c->payload.add_interface.bridge,
+                               c->payload.add_interface.port,
+                               c->payload.add_interface.interface,
+                               c->payload.add_interface.bridge_device,
+                               c->payload.add_interface.interface_device);
+                c->call_id = call->call_id;
+                last       = c;
+                if (++n >= OVSDB_BATCH_MAX || !(c = _call_next(self, c))
+                    || !_call_can_batch(self, call, c))
+                    break;
+                _LOGT_call(c, "send: batched into call-id=%" G_GUINT64_FORMAT, call->call_id);
+            }
+
+            g_hash_table_unref(txn.bridge_ports);
+            nm_clear_pointer(&txn.new_bridges, json_decref);
             break;
+        }
         case OVSDB_DEL_INTERFACE:
-            _delete_interface(self, params, call->payload.del_interface.ifname);
+        {
+            const char      *ifnames[OVSDB_BATCH_MAX + 1];
+            OvsdbMethodCall *c = call;
+            guint            n = 0;
+
+            while (TRUE) {
+                ifnames[n++] = c->payload.del_interface.ifname;
+                c->call_id   = call->call_id;
+                last         = c;
+                if (n >= OVSDB_BATCH_MAX || !(c = _call_next(self, c))
+                    || !_call_can_batch(self, call, c))
+                    break;
+                _LOGT_call(c, "send: batched into call-id=%" G_GUINT64_FORMAT, call->call_id);
+            }
+            ifnames[n] = NULL;
+
+            _delete_interfaces(self, params, ifnames);
             break;
+        }
         case OVSDB_SET_INTERFACE_MTU:
             json_array_append_new(params,
                                   json_pack("{s:s, s:s, s:{s: I}, s:[[s, s, s]]}",
@@ -1588,12 +1722,57 @@ ovsdb_next_command(NMOvsdb *self)
     }
     }
 
-    g_return_if_fail(msg);
+    g_return_val_if_fail(msg, NULL);
 
     cmd = json_dumps(msg, 0);
     _LOGT_call(call, "send: call-id=%" G_GUINT64_FORMAT ", %s", call->call_id, cmd);
     nm_str_buf_append(&priv->output_buf, cmd);
 
+    return _call_next(self, last);
+}
+
+/**
+ * ovsdb_next_command:
+ *
+ * Sends the queued commands that can be sent now.
+ *
+ * Add and remove include an up to date bridge list in their transactions to
+ * rule out races. So they are only sent when no command is waiting for a
+ * response, as they depend on the result of the previous ones. While they are
+ * pending, no other command is sent. Other commands are pipelined.
+ */
+static void
+ovsdb_next_command(NMOvsdb *self)
+{
+    NMOvsdbPrivate  *priv = NM_OVSDB_GET_PRIVATE(self);
+    OvsdbMethodCall *call;
+    guint            n_pending       = 0;
+    gboolean         pending_barrier = FALSE;
+
+    if (priv->conn_fd < 0)
+        return;
+
+    /* The calls that wait for a response are at the head of the queue. */
+    c_list_for_each_entry (call, &priv->calls_lst_head, calls_lst) {
+        if (call->call_id == CALL_ID_UNSPEC)
+            break;
+        n_pending++;
+        if (!_command_is_independent(call->command))
+            pending_barrier = TRUE;
+    }
+
+    if (&call->calls_lst == &priv->calls_lst_head)
+        return;
+
+    while (call) {
+        if (n_pending > 0 && (pending_barrier || !_command_is_independent(call->command)))
+            break;
+        if (!_command_is_independent(call->command))
+            pending_barrier = TRUE;
+        n_pending++;
+        call = ovsdb_send_command(self, call);
+    }
+
     ovsdb_write_try(self);
 }
 
@@ -2213,6 +2392,19 @@ ovsdb_got_echo(NMOvsdb *self, json_int_t id, json_t *data)
  * Called when a complete JSON object was seen and unmarshalled.
  * Either finishes a method call or processes a method call.
  */
+static gboolean
+_transact_result_has_error(const json_t *result)
+{
+    json_t *value;
+    size_t  index;
+
+    json_array_foreach (result, index, value) {
+        if (json_object_get(value, "error"))
+            return TRUE;
+    }
+    return FALSE;
+}
+
 static void
 ovsdb_got_msg(NMOvsdb *self, json_t *msg)
 {
@@ -2272,6 +2464,7 @@ ovsdb_got_msg(NMOvsdb *self, json_t *msg)
 
     if (id >= 0) {
         OvsdbMethodCall      *call;
+        OvsdbMethodCall      *next;
         gs_free_error GError *local      = NULL;
         gs_free char         *msg_as_str = NULL;
 
@@ -2293,6 +2486,23 @@ ovsdb_got_msg(NMOvsdb *self, json_t *msg)
 
         _LOGT_call(call, "response: %s", (msg_as_str = json_dumps(msg, 0)));
 
+        next = _call_next(self, call);
+        if (next && next->call_id == call->call_id
+            && (!json_is_null(error) || _transact_result_has_error(result))) {
+            /* A transaction with several merged calls failed. Nothing of it was
+             * applied, so retry the calls one by one. That way, only the calls
+             * that fail on their own get an error. */
+            _LOGD("merged transaction %" G_GUINT64_FORMAT " failed, retry the calls separately",
+                  call->call_id);
+            for (; call && call->call_id == (guint64) id; call = _call_next(self, call)) {
+                call->call_id  = CALL_ID_UNSPEC;
+                call->no_batch = TRUE;
+            }
+            priv->num_failures = 0;
+            ovsdb_next_command(self);
+            return;
+        }
+
         if (!json_is_null(error)) {
             /* The response contains an error. */
             g_set_error(&local,
@@ -2302,7 +2512,15 @@ ovsdb_got_msg(NMOvsdb *self, json_t *msg)
                         json_string_value(error));
         }
 
-        _call_complete(call, result, local);
+        /* Complete all calls that were merged into this transaction. */
+        while (TRUE) {
+            _call_complete(call, result, local);
+            if (c_list_is_empty(&priv->calls_lst_head))
+                break;
+            call = c_list_first_entry(&priv->calls_lst_head, OvsdbMethodCall, calls_lst);
+            if (call->call_id != id)
+                break;
+        }
 
         priv->num_failures = 0;
 
@@ -2323,61 +2541,113 @@ ovsdb_got_msg(NMOvsdb *self, json_t *msg)
 
 /*****************************************************************************/
 
-typedef struct {
-    gsize     bufp;
-    NMStrBuf *input;
-} JsonReadMsgData;
-
 /* Lower level marshalling and demarshalling of the JSON-RPC traffic on the
  * ovsdb socket. */
 
-static size_t
-_json_read_msg_cb(void *buffer, size_t buflen, void *user_data)
+static void
+_json_scan_reset(NMOvsdb *self)
 {
-    JsonReadMsgData *data = user_data;
+    NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE(self);
 
-    nm_assert(buffer);
-    nm_assert(buflen > 0);
+    memset(&priv->input_scan, 0, sizeof(priv->input_scan));
+}
 
-    if (data->bufp == data->input->len) {
-        /* No more bytes buffered for decoding. */
-        return 0;
+/**
+ * _json_read_msg:
+ * @self: the #NMOvsdb instance
+ * @input: the receive buffer
+ * @out_msg: (out): the decoded message
+ *
+ * The messages on the socket are not length-prefixed, so we need to find where
+ * a top level JSON object ends. The bytes in @input are scanned only once,
+ * with the scanner state kept across calls. This way, a large message that
+ * arrives in many chunks does not get decoded over and over again. Only once
+ * the message is complete, it gets decoded by jansson in one go.
+ *
+ * Returns: 1 if a message was decoded, 0 if more data is needed, or a negative
+ *   errno if the data in @input is invalid.
+ */
+static int
+_json_read_msg(NMOvsdb *self, NMStrBuf *input, json_t **out_msg)
+{
+    NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE(self);
+    const char     *str  = nm_str_buf_get_str_at_unsafe(input, 0);
+    json_error_t    json_error;
+    json_t         *msg;
+    gsize           i;
+
+    nm_assert(out_msg && !*out_msg);
+    nm_assert(priv->input_scan.pos <= input->len);
+
+    for (i = priv->input_scan.pos; i < input->len; i++) {
+        const char ch = str[i];
+
+        if (priv->input_scan.in_string) {
+            if (priv->input_scan.escaped)
+                priv->input_scan.escaped = FALSE;
+            else if (ch == '\\')
+                priv->input_scan.escaped = TRUE;
+            else if (ch == '"')
+                priv->input_scan.in_string = FALSE;
+            continue;
+        }
+
+        switch (ch) {
+        case '"':
+            if (priv->input_scan.depth == 0)
+                return -EINVAL;
+            priv->input_scan.in_string = TRUE;
+            break;
+        case '{':
+        case '[':
+            priv->input_scan.depth++;
+            break;
+        case '}':
+        case ']':
+            if (priv->input_scan.depth == 0)
+                return -EINVAL;
+            if (--priv->input_scan.depth == 0)
+                goto complete;
+            break;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            break;
+        default:
+            /* Messages are JSON objects. Other values are not expected
+             * at the top level. */
+            if (priv->input_scan.depth == 0)
+                return -EINVAL;
+            break;
+        }
     }
 
-    /* Pass one more byte to the JSON decoder. */
-    *(char *) buffer = nm_str_buf_get_char(data->input, data->bufp);
-    data->bufp++;
-    return 1;
-}
+    if (priv->input_scan.depth == 0) {
+        /* Only whitespace so far. Drop it. */
+        nm_str_buf_reset(input);
+        _json_scan_reset(self);
+        return 0;
+    }
 
-static json_t *
-_json_read_msg(NMOvsdb *self, NMStrBuf *input)
-{
-    gs_free char   *ss   = NULL;
-    JsonReadMsgData data = {
-        .bufp  = 0,
-        .input = input,
-    };
-    json_error_t json_error = {
-        0,
-    };
-    json_t *msg;
+    priv->input_scan.pos = input->len;
+    return 0;
 
-    /* The callback always eats up only up to a single byte. This makes it
-     * possible for us to identify complete JSON objects in spite of us not
-     * knowing the length in advance. */
-    msg = json_load_callback(_json_read_msg_cb, &data, JSON_DISABLE_EOF_CHECK, &json_error);
-    if (!msg)
-        return NULL;
+complete:
+    i++;
 
-    nm_assert(data.bufp > 0);
+    _LOGT("json: parse %zu bytes: \"%.*s\"", i, (int) i, str);
 
-    _LOGT("json: parse %zu bytes: \"%s\"",
-          data.bufp,
-          (ss = g_strndup(nm_str_buf_get_str_at_unsafe(input, 0), data.bufp)));
+    msg = json_loadb(str, i, 0, &json_error);
+    if (!msg) {
+        _LOGD("json: parse error: %s", json_error.text);
+        return -EINVAL;
+    }
 
-    nm_str_buf_erase(input, 0, data.bufp, FALSE);
-    return msg;
+    nm_str_buf_erase(input, 0, i, FALSE);
+    _json_scan_reset(self);
+    *out_msg = msg;
+    return 1;
 }
 
 static gboolean
@@ -2397,24 +2667,13 @@ ovsdb_read(NMOvsdb *self)
 {
     NMOvsdbPrivate *priv = NM_OVSDB_GET_PRIVATE(self);
     gssize          size;
+    int             r;
 
-again:
     size = nm_utils_fd_read(priv->conn_fd, &priv->input_buf);
 
     if (size <= 0) {
-        if (size == -EAGAIN) {
-            if (priv->input_buf.len == 0)
-                nm_clear_g_source_inst(&priv->input_timeout_source);
-            else if (!priv->input_timeout_source) {
-                /* We have data in the buffer but nothing further to read. Schedule a timer,
-                 * if we don't get the rest within timeout, it means that the buffer
-                 * content is broken (_json_read_msg() cannot extract any data) and
-                 * we disconnect. */
-                priv->input_timeout_source =
-                    nm_g_timeout_add_seconds_source(5, _ovsdb_read_input_timeout_cb, NULL);
-            }
+        if (size == -EAGAIN)
             return;
-        }
 
         /* ovsdb-server was possibly restarted */
         _LOGW("short read from ovsdb: %s", nm_strerror_native(-size));
@@ -2425,33 +2684,46 @@ again:
 
     nm_assert(priv->input_buf.len > 0);
 
-    while (TRUE) {
+    while (priv->input_buf.len > 0) {
         nm_auto_decref_json json_t *msg = NULL;
 
-        msg = _json_read_msg(self, &priv->input_buf);
-        if (!msg)
+        r = _json_read_msg(self, &priv->input_buf, &msg);
+        if (r < 0) {
+            _LOGW("received data from ovsdb that is not valid JSON");
+            priv->num_failures++;
+            ovsdb_disconnect(self, priv->num_failures <= OVSDB_MAX_FAILURES, FALSE);
+            return;
+        }
+        if (r == 0)
             break;
 
         nm_clear_g_source_inst(&priv->input_timeout_source);
         ovsdb_got_msg(self, msg);
 
-        if (priv->input_buf.len == 0)
-            break;
+        /* Handling the message might have disconnected us. */
+        if (priv->conn_fd < 0)
+            return;
     }
 
-    if (priv->input_buf.len > 0) {
-        if (priv->input_buf.len > 50 * 1024 * 1024) {
-            _LOGW("received too much data from ovsdb that is not valid JSON");
-            priv->num_failures++;
-            ovsdb_disconnect(self, priv->num_failures <= OVSDB_MAX_FAILURES, FALSE);
-            return;
-        }
-        /* We have an incomplete message in the message buffer. Don't wait for another round
-         * of "poll", instead try to read it again. */
-        goto again;
+    if (priv->input_buf.len == 0) {
+        nm_clear_g_source_inst(&priv->input_timeout_source);
+        return;
     }
 
-    nm_clear_g_source_inst(&priv->input_timeout_source);
+    if (priv->input_buf.len > 50 * 1024 * 1024) {
+        _LOGW("received too much data from ovsdb that is not valid JSON");
+        priv->num_failures++;
+        ovsdb_disconnect(self, priv->num_failures <= OVSDB_MAX_FAILURES, FALSE);
+        return;
+    }
+
+    /* We have an incomplete message in the buffer. Return to the mainloop, we
+     * will be called again when more data is available. If we don't get the
+     * rest within the timeout, the buffer content is broken and we disconnect. */
+    if (!priv->input_timeout_source) {
+        priv->input_timeout_source =
+            nm_g_timeout_add_seconds_source(5, _ovsdb_read_input_timeout_cb, self);
+    }
 }
 
 static gboolean
@@ -2545,8 +2817,10 @@ ovsdb_disconnect(NMOvsdb *self, gboolean retry, gboolean is_disposing)
      * shutting down, and cancel the remaining calls after the timeout. */
 
     if (retry) {
-        if (!c_list_is_empty(&priv->calls_lst_head)) {
-            call          = c_list_first_entry(&priv->calls_lst_head, OvsdbMethodCall, calls_lst);
+        /* Resend the calls that didn't get a response yet. */
+        c_list_for_each_entry (call, &priv->calls_lst_head, calls_lst) {
+            if (call->call_id == CALL_ID_UNSPEC)
+                break;
             call->call_id = CALL_ID_UNSPEC;
         }
     } else {
@@ -2561,6 +2835,7 @@ ovsdb_disconnect(NMOvsdb *self, gboolean retry, gboolean is_disposing)
     }
 
     nm_str_buf_reset(&priv->input_buf);
+    _json_scan_reset(self);
     nm_str_buf_reset(&priv->output_buf);
     nm_clear_fd(&priv->conn_fd);
     nm_clear_g_source_inst(&priv->conn_fd_in_source);
@@ -13,6 +13,7 @@
 #include <sys/types.h>
 
 #include "libnm-lldp/nm-lldp.h"
+#include "libnm-lldp/nm-lldp-rx.h"
 #include "devices/nm-lldp-listener.h"
 #include "platform/tests/test-common.h"
 
@@ -911,6 +912,145 @@ _test_recv_fixture_teardown(TestRecvFixture *fixture, gconstpointer user_data)
 
 /*****************************************************************************/
 
+typedef struct {
+    NMLldpRXEvent   event;
+    NMLldpNeighbor *neighbor;
+} TestRxEvent;
+
+static void
+_test_rx_event_clear(gpointer data)
+{
+    TestRxEvent *ev = data;
+
+    nm_lldp_neighbor_unref(ev->neighbor);
+}
+
+static void
+_test_rx_event_cb(NMLldpRX *lldp_rx, NMLldpRXEvent event, NMLldpNeighbor *n, void *userdata)
+{
+    GArray     *events = userdata;
+    TestRxEvent ev     = {.event = event, .neighbor = nm_lldp_neighbor_ref(n)};
+
+    g_array_append_val(events, ev);
+}
+
+static NMLldpRX *
+_test_rx_start(int ifindex, guint raw_size_max, GArray *events)
+{
+    NMLldpRX *lldp_rx;
+
+    lldp_rx = nm_lldp_rx_new(&((NMLldpRXConfig){
+        .ifindex      = ifindex,
+        .raw_size_max = raw_size_max,
+        .callback     = _test_rx_event_cb,
+        .userdata     = events,
+    }));
+    g_assert_cmpint(nm_lldp_rx_start(lldp_rx), ==, 1);
+    return lldp_rx;
+}
+
+#define _test_rx_write(fixture, frame, frame_len) \
+    g_assert_cmpint(write((fixture)->fd, (frame), (frame_len)), ==, (frame_len))
+
+static const TestRxEvent *
+_test_rx_wait_event(GArray *events, guint idx, NMLldpRXEvent event)
+{
+    const TestRxEvent *ev;
+
+    nmtst_main_context_iterate_until_assert(NULL, 500, events->len > idx);
+    g_assert_cmpint(events->len, ==, idx + 1);
+
+    ev = &nm_g_array_index(events, TestRxEvent, idx);
+    g_assert_cmpint(ev->event, ==, event);
+    return ev;
+}
+
+static void
+test_recv_events(TestRecvFixture *fixture, gconstpointer user_data)
+{
+    const TestRecvFrame                 *frame0         = &_test_recv_data0_frame0;
+    const TestRecvFrame                 *frame1         = &_test_recv_data1_frame0;
+    gs_unref_array GArray               *events         = NULL;
+    gs_unref_array GArray               *events_lo      = NULL;
+    nm_auto(nm_lldp_rx_unrefp) NMLldpRX *lldp_rx        = NULL;
+    nm_auto(nm_lldp_rx_unrefp) NMLldpRX *lldp_rx_lo     = NULL;
+    gs_free guint8                      *frame0_changed = NULL;
+    gs_free NMLldpNeighbor             **neighbors      = NULL;
+    guint8                              *sys;
+    const TestRxEvent                   *ev;
+    NMLldpNeighbor                      *neighbor;
+    const char                          *str;
+    guint                                parsed_num;
+    guint                                len;
+    int                                  ifindex_lo;
+
+    if (fixture->ifindex == 0) {
+        g_test_skip("Tun device not available");
+        return;
+    }
+
+    g_assert_cmpint(frame1->frame_len, >, frame0->frame_len);
+
+    /* The same as frame0, with the system name "SYS" changed to "SYT". */
+    frame0_changed = nm_memdup(frame0->frame, frame0->frame_len);
+    sys            = memmem(frame0_changed, frame0->frame_len, "SYS", 3);
+    g_assert(sys);
+    sys[2] = 'T';
+
+    events = g_array_new(FALSE, TRUE, sizeof(TestRxEvent));
+    g_array_set_clear_func(events, _test_rx_event_clear);
+    events_lo = g_array_new(FALSE, TRUE, sizeof(TestRxEvent));
+    g_array_set_clear_func(events_lo, _test_rx_event_clear);
+
+    lldp_rx = _test_rx_start(fixture->ifindex, frame0->frame_len, events);
+
+    /* Frames are dispatched by their ifindex. The instance on loopback never
+     * sees the frames of the TAP device. */
+    ifindex_lo = nm_platform_link_get_ifindex(NM_PLATFORM_GET, "lo");
+    g_assert_cmpint(ifindex_lo, >, 0);
+    lldp_rx_lo = _test_rx_start(ifindex_lo, 0, events_lo);
+
+    _test_rx_write(fixture, frame0->frame, frame0->frame_len);
+    ev       = _test_rx_wait_event(events, 0, NM_LLDP_RX_EVENT_ADDED);
+    neighbor = ev->neighbor;
+    g_assert_cmpint(nm_lldp_neighbor_get_system_name(neighbor, &str), ==, 0);
+    g_assert_cmpstr(str, ==, "SYS");
+    parsed_num = nmtst_lldp_rx_get_parsed_num(lldp_rx);
+    g_assert_cmpint(parsed_num, >, 0);
+
+    /* An identical frame only refreshes the neighbor, without parsing the frame again. */
+    _test_rx_write(fixture, frame0->frame, frame0->frame_len);
+    ev = _test_rx_wait_event(events, 1, NM_LLDP_RX_EVENT_REFRESHED);
+    g_assert(ev->neighbor == neighbor);
+    g_assert_cmpint(nmtst_lldp_rx_get_parsed_num(lldp_rx), ==, parsed_num);
+
+    /* A changed frame from the same chassis and port updates the neighbor. */
+    _test_rx_write(fixture, frame0_changed, frame0->frame_len);
+    ev = _test_rx_wait_event(events, 2, NM_LLDP_RX_EVENT_UPDATED);
+    g_assert(ev->neighbor != neighbor);
+    neighbor = ev->neighbor;
+    g_assert_cmpint(nm_lldp_neighbor_get_system_name(neighbor, &str), ==, 0);
+    g_assert_cmpstr(str, ==, "SYT");
+    g_assert_cmpint(nmtst_lldp_rx_get_parsed_num(lldp_rx), ==, parsed_num + 1);
+    parsed_num++;
+
+    /* A frame larger than raw_size_max is dropped. The changed frame, sent
+     * afterwards, is the next event. */
+    _test_rx_write(fixture, frame1->frame, frame1->frame_len);
+    _test_rx_write(fixture, frame0_changed, frame0->frame_len);
+    ev = _test_rx_wait_event(events, 3, NM_LLDP_RX_EVENT_REFRESHED);
+    g_assert(ev->neighbor == neighbor);
+    g_assert_cmpint(nmtst_lldp_rx_get_parsed_num(lldp_rx), ==, parsed_num);
+
+    neighbors = nm_lldp_rx_get_neighbors(lldp_rx, &len);
+    g_assert_cmpint(len, ==, 1);
+    g_assert(neighbors[0] == neighbor);
+
+    g_assert_cmpint(events_lo->len, ==, 0);
+}
+
+/*****************************************************************************/
+
 static void
 test_parse_frames(gconstpointer test_data)
 {
@@ -1299,6 +1439,13 @@ _nmtstp_setup_tests(void)
     _TEST_ADD_RECV("/lldp/recv/1", &_test_recv_data1);
     _TEST_ADD_RECV("/lldp/recv/2_ttl1", &_test_recv_data2_ttl1);
 
+    g_test_add("/lldp/recv/events",
+               TestRecvFixture,
+               NULL,
+               _test_recv_fixture_setup,
+               test_recv_events,
+               _test_recv_fixture_teardown);
+
     g_test_add_data_func("/lldp/parse-frames/0", &_test_recv_data0_frame0, test_parse_frames);
     g_test_add_data_func("/lldp/parse-frames/1", &_test_recv_data1_frame0, test_parse_frames);
     g_test_add_data_func("/lldp/parse-frames/2", &_test_recv_data2_frame0_ttl1, test_parse_frames);
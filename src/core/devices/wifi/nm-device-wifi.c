@@ -106,6 +106,13 @@ typedef struct {
 
     gint64 scan_last_request_started_at_msec;
 
+    GSource *aps_publish_source;
+
+    /* The "AccessPoints" as last published, and the removed APs that stay
+     * exported until the next publishing. */
+    const char **aps_published_paths;
+    GPtrArray   *aps_removed;
+
     guint ap_dump_id;
 
     guint periodic_update_id;
@@ -138,6 +145,8 @@ typedef struct {
 
     bool addressing_running_indicated : 1;
 
+    bool aps_publish_recheck_available : 1;
+
 } NMDeviceWifiPrivate;
 
 struct _NMDeviceWifi {
@@ -196,7 +205,12 @@ static void periodic_update(NMDeviceWifi *self);
 static void ap_add_remove(NMDeviceWifi *self,
                           gboolean      is_adding,
                           NMWifiAP     *ap,
-                          gboolean      recheck_available_connections);
+                          gboolean      recheck_available_connections,
+                          gboolean      delay_publish);
+
+static void _aps_publish(NMDeviceWifi *self, gboolean only_if_pending);
+
+static void _ap_ensure_published(NMDeviceWifi *self, NMWifiAP *ap);
 
 static void _hw_addr_set_scanning(NMDeviceWifi *self, gboolean do_reset);
 
@@ -482,6 +496,9 @@ _scan_notify_is_scanning(NMDeviceWifi *self)
     _scan_kickoff(self);
 
     if (!_scan_is_scanning_eval(priv)) {
+        /* The scan cycle is complete. Publish the changes to the AP list right
+         * away, also because they affect the autoconnect decision. */
+        _aps_publish(self, TRUE);
         if (state <= NM_DEVICE_STATE_DISCONNECTED || state > NM_DEVICE_STATE_ACTIVATED)
             nm_device_recheck_auto_activate_schedule(NM_DEVICE(self));
         nm_device_remove_pending_action(NM_DEVICE(self), NM_PENDING_ACTION_WIFI_SCAN, FALSE);
@@ -597,6 +614,18 @@ supplicant_interface_acquire_cb(NMSupplicantManager         *supplicant_manager,
 
     priv->sup_iface = g_object_ref(iface);
 
+    nm_supplicant_interface_set_signal_hysteresis(
+        priv->sup_iface,
+        nm_config_data_get_device_config_int64_by_device(
+            NM_CONFIG_GET_DATA,
+            NM_CONFIG_KEYFILE_KEY_DEVICE_WIFI_SIGNAL_HYSTERESIS,
+            NM_DEVICE(self),
+            10,
+            0,
+            G_MAXUINT8,
+            NM_SUPPLICANT_INTERFACE_SIGNAL_HYSTERESIS_DEFAULT_DBM,
+            NM_SUPPLICANT_INTERFACE_SIGNAL_HYSTERESIS_DEFAULT_DBM));
+
     g_signal_connect(priv->sup_iface,
                      NM_SUPPLICANT_INTERFACE_STATE,
                      G_CALLBACK(supplicant_iface_state_cb),
@@ -726,6 +755,7 @@ set_current_ap(NMDeviceWifi *self, NMWifiAP *new_ap, gboolean recheck_available_
         return;
 
     if (new_ap) {
+        _ap_ensure_published(self, new_ap);
         priv->current_ap = g_object_ref(new_ap);
 
         /* Update seen BSSIDs cache */
@@ -739,7 +769,7 @@ set_current_ap(NMDeviceWifi *self, NMWifiAP *new_ap, gboolean recheck_available_
         /* Remove any AP from the internal list if it was created by NM or isn't known to the supplicant */
         if (NM_IN_SET(mode, _NM_802_11_MODE_ADHOC, _NM_802_11_MODE_AP)
             || nm_wifi_ap_get_fake(old_ap))
-            ap_add_remove(self, FALSE, old_ap, recheck_available_connections);
+            ap_add_remove(self, FALSE, old_ap, recheck_available_connections, FALSE);
         g_object_unref(old_ap);
     }
 
@@ -808,11 +838,169 @@ periodic_update_cb(gpointer user_data)
     return TRUE;
 }
 
+/* In dense environments, a scan reports hundreds of BSSs, one at a time.
+ * Notifying the "AccessPoints" property (which contains the full list) and
+ * rechecking the available connections for each of them is expensive for
+ * us and for all D-Bus clients. Changes reported by a scan are therefore
+ * published once the scan is complete, or at the latest after
+ * APS_PUBLISH_DELAY_MSEC. */
+#define APS_PUBLISH_DELAY_MSEC 1000
+
+/* Bound the number of APs we track (and export on D-Bus) per device. If
+ * the limit is reached, a stale AP is dropped to make room. */
+#define APS_MAX_PER_DEVICE 256
+
+/* An AP that was not seen for longer than this is stale. Periodic scans
+ * happen at least every SCAN_INTERVAL_SEC_MAX, so APs in range are never
+ * stale. */
+#define APS_STALE_MSEC ((SCAN_INTERVAL_SEC_MAX + 30) * NM_UTILS_MSEC_PER_SEC)
+
+static void
+_aps_publish(NMDeviceWifi *self, gboolean only_if_pending)
+{
+    NMDeviceWifiPrivate         *priv    = NM_DEVICE_WIFI_GET_PRIVATE(self);
+    gs_unref_ptrarray GPtrArray *removed = NULL;
+    NMWifiAP                    *ap;
+    guint                        i;
+
+    if (!nm_clear_g_source_inst(&priv->aps_publish_source) && only_if_pending)
+        return;
+
+    /* The APs are exported and unexported together with the change of the
+     * "AccessPoints" property. Like this, the property never lists an AP
+     * that is not exported, nor omits one that is. */
+    c_list_for_each_entry (ap, &priv->aps_lst_head, aps_lst) {
+        if (nm_dbus_object_is_exported(NM_DBUS_OBJECT(ap)))
+            continue;
+        nm_dbus_object_export(NM_DBUS_OBJECT(ap));
+        nm_device_wifi_emit_signal_access_point(NM_DEVICE(self), ap, TRUE);
+    }
+
+    nm_clear_g_free(&priv->aps_published_paths);
+    priv->aps_published_paths = nm_wifi_aps_get_paths(&priv->aps_lst_head, TRUE);
+    _notify(self, PROP_ACCESS_POINTS);
+
+    removed = g_steal_pointer(&priv->aps_removed);
+    for (i = 0; removed && i < removed->len; i++) {
+        ap = removed->pdata[i];
+        nm_device_wifi_emit_signal_access_point(NM_DEVICE(self), ap, FALSE);
+        nm_dbus_object_clear_and_unexport(&ap);
+    }
+
+    nm_device_recheck_auto_activate_schedule(NM_DEVICE(self));
+    if (priv->aps_publish_recheck_available) {
+        priv->aps_publish_recheck_available = FALSE;
+        nm_device_recheck_available_connections(NM_DEVICE(self));
+    }
+}
+
+static gboolean
+_aps_publish_timeout_cb(gpointer user_data)
+{
+    _aps_publish(user_data, TRUE);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+_aps_changed(NMDeviceWifi *self, gboolean recheck_available_connections, gboolean delay_publish)
+{
+    NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE(self);
+
+    if (recheck_available_connections)
+        priv->aps_publish_recheck_available = TRUE;
+
+    if (!delay_publish) {
+        _aps_publish(self, FALSE);
+        return;
+    }
+
+    if (!priv->aps_publish_source) {
+        priv->aps_publish_source =
+            nm_g_timeout_add_source(APS_PUBLISH_DELAY_MSEC, _aps_publish_timeout_cb, self);
+    }
+}
+
+static void
+_ap_ensure_published(NMDeviceWifi *self, NMWifiAP *ap)
+{
+    /* The D-Bus path of the AP is about to be used. */
+    if (ap && !nm_dbus_object_is_exported(NM_DBUS_OBJECT(ap)))
+        _aps_publish(self, TRUE);
+}
+
+static int
+_aps_cmp_by_relevance(NMWifiAP *a, NMWifiAP *b, gint64 stale_before_msec)
+{
+    return nm_wifi_utils_ap_relevance_cmp(nm_wifi_ap_get_strength(a),
+                                          nm_wifi_ap_get_last_seen_msec(a),
+                                          nm_wifi_ap_get_strength(b),
+                                          nm_wifi_ap_get_last_seen_msec(b),
+                                          stale_before_msec);
+}
+
+static gboolean
+_ap_is_known(NMDeviceWifi *self, NMWifiAP *ap)
+{
+    NMSettingsConnection *const *connections;
+    guint                        i;
+
+    connections = nm_settings_get_connections(nm_device_get_settings(NM_DEVICE(self)), NULL);
+    for (i = 0; connections[i]; i++) {
+        if (nm_wifi_ap_check_compatible(ap, nm_settings_connection_get_connection(connections[i])))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static gboolean
+_aps_make_room_for(NMDeviceWifi *self, NMWifiAP *new_ap)
+{
+    NMDeviceWifiPrivate *priv  = NM_DEVICE_WIFI_GET_PRIVATE(self);
+    NMWifiAP            *evict = NULL;
+    NMWifiAP            *ap;
+    gint64               stale_before_msec;
+
+    if (g_hash_table_size(priv->aps_idx_by_supplicant_path) < APS_MAX_PER_DEVICE)
+        return TRUE;
+
+    /* APs of known profiles are always tracked, so that we can autoconnect
+     * to them. */
+    if (_ap_is_known(self, new_ap))
+        return TRUE;
+
+    /* Only drop the weakest of the stale APs. An AP that the supplicant
+     * still reports in its scans is never dropped, otherwise it would come
+     * back with the next scan and replace another one. Neither are the
+     * current AP and the APs of known profiles. */
+    stale_before_msec = nm_utils_get_monotonic_timestamp_msec() - APS_STALE_MSEC;
+    c_list_for_each_entry (ap, &priv->aps_lst_head, aps_lst) {
+        if (ap == priv->current_ap)
+            continue;
+        if (nm_wifi_ap_get_last_seen_msec(ap) >= stale_before_msec)
+            continue;
+        if (evict && _aps_cmp_by_relevance(ap, evict, stale_before_msec) >= 0)
+            continue;
+        if (_ap_is_known(self, ap))
+            continue;
+        evict = ap;
+    }
+
+    if (!evict) {
+        /* Ignore the new AP for now. The supplicant reports it again with
+         * the next scan, when there might be room. */
+        return FALSE;
+    }
+
+    ap_add_remove(self, FALSE, evict, TRUE, TRUE);
+    return TRUE;
+}
+
 static void
 ap_add_remove(NMDeviceWifi *self,
               gboolean      is_adding, /* or else removing */
               NMWifiAP     *ap,
-              gboolean      recheck_available_connections)
+              gboolean      recheck_available_connections,
+              gboolean      delay_publish)
 {
     NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE(self);
 
@@ -824,9 +1012,7 @@ ap_add_remove(NMDeviceWifi *self,
                                  nm_wifi_ap_get_supplicant_path(ap),
                                  ap))
             nm_assert_not_reached();
-        nm_dbus_object_export(NM_DBUS_OBJECT(ap));
         _ap_dump(self, LOGL_DEBUG, ap, "added", 0);
-        nm_device_wifi_emit_signal_access_point(NM_DEVICE(self), ap, TRUE);
     } else {
         ap->wifi_device = NULL;
         c_list_unlink(&ap->aps_lst);
@@ -834,18 +1020,20 @@ ap_add_remove(NMDeviceWifi *self,
                                  nm_wifi_ap_get_supplicant_path(ap)))
             nm_assert_not_reached();
         _ap_dump(self, LOGL_DEBUG, ap, "removed", 0);
-    }
 
-    _notify(self, PROP_ACCESS_POINTS);
-
-    if (!is_adding) {
-        nm_device_wifi_emit_signal_access_point(NM_DEVICE(self), ap, FALSE);
-        nm_dbus_object_clear_and_unexport(&ap);
+        /* The AP gets exported by _aps_publish(). If that didn't happen yet,
+         * nobody knows about it. Otherwise, it stays exported until the
+         * next publishing. */
+        if (!nm_dbus_object_is_exported(NM_DBUS_OBJECT(ap)))
+            g_object_unref(ap);
+        else {
+            if (!priv->aps_removed)
+                priv->aps_removed = g_ptr_array_new();
+            g_ptr_array_add(priv->aps_removed, ap);
+        }
     }
 
-    nm_device_recheck_auto_activate_schedule(NM_DEVICE(self));
-    if (recheck_available_connections)
-        nm_device_recheck_available_connections(NM_DEVICE(self));
+    _aps_changed(self, recheck_available_connections, delay_publish);
 }
 
 static void
@@ -860,7 +1048,9 @@ remove_all_aps(NMDeviceWifi *self)
     set_current_ap(self, NULL, FALSE);
 
     while ((ap = c_list_first_entry(&priv->aps_lst_head, NMWifiAP, aps_lst)))
-        ap_add_remove(self, FALSE, ap, FALSE);
+        ap_add_remove(self, FALSE, ap, FALSE, TRUE);
+
+    _aps_publish(self, TRUE);
 
     nm_device_recheck_available_connections(NM_DEVICE(self));
 }
@@ -1370,6 +1560,8 @@ can_auto_connect(NMDevice *device, NMSettingsConnection *sett_conn, char **speci
     ap = nm_wifi_aps_find_first_compatible(&priv->aps_lst_head, connection);
     if (ap) {
         /* All good; connection is usable */
+        if (specific_object)
+            _ap_ensure_published(self, ap);
         NM_SET_OUT(specific_object, g_strdup(nm_dbus_object_get_path(NM_DBUS_OBJECT(ap))));
         return TRUE;
     }
@@ -1999,7 +2191,7 @@ supplicant_iface_bss_changed_cb(NMSupplicantInterface *iface,
             if (nm_wifi_ap_set_fake(found_ap, TRUE))
                 _ap_dump(self, LOGL_DEBUG, found_ap, "updated", 0);
         } else {
-            ap_add_remove(self, FALSE, found_ap, TRUE);
+            ap_add_remove(self, FALSE, found_ap, TRUE, TRUE);
             schedule_ap_list_dump(self);
         }
         return;
@@ -2042,7 +2234,12 @@ supplicant_iface_bss_changed_cb(NMSupplicantInterface *iface,
             }
         }
 
-        ap_add_remove(self, TRUE, ap, TRUE);
+        if (!_aps_make_room_for(self, ap)) {
+            _ap_dump(self, LOGL_TRACE, ap, "ignored", 0);
+            return;
+        }
+
+        ap_add_remove(self, TRUE, ap, TRUE, TRUE);
     }
 
     /* Update the current AP if the supplicant notified a current BSS change
@@ -3154,7 +3351,7 @@ act_stage1_prepare(NMDevice *device, NMDeviceStateReason *out_failure_reason)
             nm_wifi_ap_set_address(ap_fake, nm_device_get_hw_address(device));
 
         g_object_freeze_notify(G_OBJECT(self));
-        ap_add_remove(self, TRUE, ap_fake, TRUE);
+        ap_add_remove(self, TRUE, ap_fake, TRUE, FALSE);
         g_object_thaw_notify(G_OBJECT(self));
         ap = ap_fake;
     }
@@ -3685,7 +3882,6 @@ get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
 {
     NMDeviceWifi        *self = NM_DEVICE_WIFI(object);
     NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE(self);
-    const char         **list;
 
     switch (prop_id) {
     case PROP_MODE:
@@ -3698,8 +3894,7 @@ get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
         g_value_set_uint(value, priv->capabilities);
         break;
     case PROP_ACCESS_POINTS:
-        list = nm_wifi_aps_get_paths(&priv->aps_lst_head, TRUE);
-        g_value_take_boxed(value, nm_strv_make_deep_copied(list));
+        g_value_set_boxed(value, priv->aps_published_paths ?: NM_STRV_EMPTY_CC());
         break;
     case PROP_ACTIVE_ACCESS_POINT:
         nm_dbus_utils_g_value_set_object_path(value, priv->current_ap);
@@ -3808,6 +4003,9 @@ dispose(GObject *object)
     g_clear_object(&priv->sup_mgr);
 
     remove_all_aps(self);
+    _aps_publish(self, TRUE);
+    nm_assert(!priv->aps_removed);
+    nm_clear_g_free(&priv->aps_published_paths);
 
     if (priv->p2p_device) {
         /* Destroy the P2P device. */
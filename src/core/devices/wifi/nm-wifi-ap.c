@@ -367,6 +367,12 @@ nm_wifi_ap_set_last_seen(NMWifiAP *ap, gint32 last_seen_msec)
     return FALSE;
 }
 
+gint64
+nm_wifi_ap_get_last_seen_msec(const NMWifiAP *self)
+{
+    return NM_WIFI_AP_GET_PRIVATE(self)->last_seen_msec;
+}
+
 gboolean
 nm_wifi_ap_get_metered(const NMWifiAP *self)
 {
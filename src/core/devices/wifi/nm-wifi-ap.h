@@ -84,6 +84,7 @@ gboolean               nm_wifi_ap_set_bandwidth(NMWifiAP *ap, guint32 bandwidth)
 gboolean               nm_wifi_ap_get_fake(const NMWifiAP *ap);
 gboolean               nm_wifi_ap_set_fake(NMWifiAP *ap, gboolean fake);
 NM80211ApFlags         nm_wifi_ap_get_flags(const NMWifiAP *self);
+gint64                 nm_wifi_ap_get_last_seen_msec(const NMWifiAP *self);
 gboolean               nm_wifi_ap_get_metered(const NMWifiAP *self);
 NM80211ApSecurityFlags nm_wifi_ap_get_wpa_flags(const NMWifiAP *self);
 NM80211ApSecurityFlags nm_wifi_ap_get_rsn_flags(const NMWifiAP *self);
@@ -853,6 +853,36 @@ nm_wifi_utils_complete_connection(GBytes       *ap_ssid,
     return TRUE;
 }
 
+/**
+ * nm_wifi_utils_ap_relevance_cmp:
+ * @a_strength: the signal strength of the first AP, in percent
+ * @a_last_seen_msec: when the first AP was last seen, in
+ *   nm_utils_get_monotonic_timestamp_msec() scale
+ * @b_strength: the signal strength of the second AP
+ * @b_last_seen_msec: when the second AP was last seen
+ * @stale_before_msec: APs last seen before this timestamp are stale
+ *
+ * Compares two APs by how relevant they are to the user. A stale AP is
+ * less relevant than one that was seen recently, regardless of the signal
+ * strength. Otherwise the weaker AP is less relevant and, at the same
+ * strength, the one seen longer ago.
+ *
+ * Returns: a negative value if the first AP is less relevant, a positive
+ *   value if it is more relevant and zero if they are equally relevant.
+ */
+int
+nm_wifi_utils_ap_relevance_cmp(int    a_strength,
+                               gint64 a_last_seen_msec,
+                               int    b_strength,
+                               gint64 b_last_seen_msec,
+                               gint64 stale_before_msec)
+{
+    NM_CMP_DIRECT(a_last_seen_msec >= stale_before_msec, b_last_seen_msec >= stale_before_msec);
+    NM_CMP_DIRECT(a_strength, b_strength);
+    NM_CMP_DIRECT(a_last_seen_msec, b_last_seen_msec);
+    return 0;
+}
+
 gboolean
 nm_wifi_utils_is_manf_default_ssid(GBytes *ssid)
 {
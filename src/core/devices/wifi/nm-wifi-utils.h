@@ -42,6 +42,12 @@ gboolean nm_wifi_utils_complete_connection(GBytes       *ssid,
 
 gboolean nm_wifi_utils_is_manf_default_ssid(GBytes *ssid);
 
+int nm_wifi_utils_ap_relevance_cmp(int    a_strength,
+                                   gint64 a_last_seen_msec,
+                                   int    b_strength,
+                                   gint64 b_last_seen_msec,
+                                   gint64 stale_before_msec);
+
 gboolean nm_wifi_connection_get_iwd_ssid_and_security(NMConnection         *connection,
                                                       char                **ssid,
                                                       NMIwdNetworkSecurity *security);
@@ -1459,6 +1459,38 @@ test_ssids_options_to_ptrarray(void)
 
 /*****************************************************************************/
 
+static void
+test_ap_relevance_cmp(void)
+{
+    const gint64 now   = 1000000;
+    const gint64 stale = now - 150000;
+
+#define _cmp(a_strength, a_last_seen, b_strength, b_last_seen) \
+    nm_wifi_utils_ap_relevance_cmp((a_strength), (a_last_seen), (b_strength), (b_last_seen), stale)
+
+    /* A stale AP is less relevant, even if it is stronger. */
+    g_assert_cmpint(_cmp(90, stale - 1, 10, now), <, 0);
+    g_assert_cmpint(_cmp(10, now, 90, stale - 1), >, 0);
+    g_assert_cmpint(_cmp(90, G_MININT64, 10, stale), <, 0);
+
+    /* Among recently seen APs, the weaker one is less relevant, also if it
+     * was seen more recently. */
+    g_assert_cmpint(_cmp(30, now, 31, stale), <, 0);
+    g_assert_cmpint(_cmp(31, stale, 30, now), >, 0);
+
+    /* The same among stale APs. */
+    g_assert_cmpint(_cmp(30, stale - 1, 31, G_MININT64), <, 0);
+
+    /* At the same strength, the AP seen longer ago is less relevant. */
+    g_assert_cmpint(_cmp(50, now - 1, 50, now), <, 0);
+    g_assert_cmpint(_cmp(50, G_MININT64, 50, stale - 1), <, 0);
+    g_assert_cmpint(_cmp(50, now, 50, now), ==, 0);
+
+#undef _cmp
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE();
 
 int
@@ -1604,6 +1636,7 @@ main(int argc, char **argv)
     g_test_add_func("/wifi/strength/all", test_strength_all);
 
     g_test_add_func("/wifi/ssids_options_to_ptrarray", test_ssids_options_to_ptrarray);
+    g_test_add_func("/wifi/ap_relevance_cmp", test_ap_relevance_cmp);
 
     return g_test_run();
 }
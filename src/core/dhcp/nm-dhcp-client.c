@@ -432,6 +432,22 @@ _no_lease_timeout_schedule(NMDhcpClient *self)
     }
 }
 
+/* While the backend waits before it starts the exchange, the time doesn't
+ * count towards the timeout. */
+void
+_nm_dhcp_client_no_lease_timeout_pause(NMDhcpClient *self, gboolean pause)
+{
+    NMDhcpClientPrivate *priv = NM_DHCP_CLIENT_GET_PRIVATE(self);
+
+    if (!pause) {
+        _no_lease_timeout_schedule(self);
+        return;
+    }
+
+    if (nm_clear_g_source_inst(&priv->no_lease_timeout_source))
+        _LOGD("activation: transaction waits to start, the timeout is paused");
+}
+
 /*****************************************************************************/
 
 static void
@@ -263,6 +263,8 @@ void _nm_dhcp_client_notify(NMDhcpClient         *self,
 
 gboolean _nm_dhcp_client_accept_offer(NMDhcpClient *self, gconstpointer p_yiaddr);
 
+void _nm_dhcp_client_no_lease_timeout_pause(NMDhcpClient *self, gboolean pause);
+
 gboolean nm_dhcp_client_handle_event(gpointer               unused,
                                      const char            *iface,
                                      int                    pid,
@@ -0,0 +1,459 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "src/core/nm-default-daemon.h"
+
+#include "nm-dhcp-lease-db.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "libnm-glib-aux/nm-io-utils.h"
+#include "libnm-glib-aux/nm-str-buf.h"
+#include "nm-config.h"
+
+/*****************************************************************************/
+
+/* The lease database keeps the address of the last lease of every DHCPv4
+ * client of the internal plugin, so that after a restart the clients can
+ * start in INIT-REBOOT state.
+ *
+ * It's one binary file, starting with LEASE_DB_MAGIC and followed by
+ * records. Each record is a RecordHeader followed by the key. New leases
+ * are appended, so a record supersedes earlier records with the same key.
+ * A record with address zero deletes the key.
+ *
+ * Every record has a checksum. When NetworkManager crashes while appending,
+ * the torn record at the end gets detected and ignored on load. When the
+ * file contains too many superseded records (or a torn one), it is
+ * rewritten atomically with only the current entries. If that fails, the
+ * torn data is truncated before the next record gets appended.
+ *
+ * When the file exists but cannot be read, the database is not used at
+ * all, so that it doesn't overwrite leases it could not load. */
+
+#define LEASE_DB_MAGIC "NMLEASE1"
+
+#define LEASE_DB_MAX_SIZE ((gsize) (4 * 1024 * 1024))
+
+/* Entries that weren't updated for this long get dropped on compaction. */
+#define LEASE_DB_MAX_AGE_SEC (90 * 24 * 3600)
+
+/* Storing the same address again only appends a record when the existing
+ * one is older than this. Otherwise, every lease renewal would append. */
+#define LEASE_DB_REFRESH_SEC (24 * 3600)
+
+#define LEASE_DB_COMPACT_SLACK 64u
+
+typedef struct _nm_packed {
+    guint32   checksum;
+    guint32   timestamp;
+    in_addr_t address;
+    guint16   key_len;
+} RecordHeader;
+
+typedef struct {
+    in_addr_t address;
+    guint32   timestamp;
+} Entry;
+
+struct _NMDhcpLeaseDb {
+    char       *path;
+    GHashTable *entries;
+
+    /* The length of the valid data at the start of the file. What follows
+     * is torn or unknown data. */
+    gsize valid_len;
+
+    /* The number of records in the file, including the superseded ones. */
+    guint n_records;
+
+    bool needs_compact : 1;
+};
+
+/*****************************************************************************/
+
+#define _NMLOG_DOMAIN      LOGD_DHCP4
+#define _NMLOG(level, ...) __NMLOG_DEFAULT(level, _NMLOG_DOMAIN, "dhcp4-lease-db", __VA_ARGS__)
+
+/*****************************************************************************/
+
+static guint32
+_now_sec(void)
+{
+    return (guint32) time(NULL);
+}
+
+static gboolean
+_entry_is_expired(const Entry *entry, guint32 now)
+{
+    /* A timestamp in the future (after the clock was set back) is not
+     * expired. */
+    return ((gint64) now) - ((gint64) entry->timestamp) > LEASE_DB_MAX_AGE_SEC;
+}
+
+static guint32
+_fnv1a(guint32 h, gconstpointer data, gsize len)
+{
+    const guint8 *p = data;
+    gsize         i;
+
+    for (i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static guint32
+_record_checksum(const RecordHeader *hdr, const char *key)
+{
+    guint32 h = 2166136261u;
+
+    h = _fnv1a(h,
+               &((const guint8 *) hdr)[sizeof(hdr->checksum)],
+               sizeof(*hdr) - sizeof(hdr->checksum));
+    return _fnv1a(h, key, hdr->key_len);
+}
+
+static void
+_record_append(NMStrBuf *sbuf, const char *key, in_addr_t address, guint32 timestamp)
+{
+    RecordHeader hdr = {
+        .timestamp = timestamp,
+        .address   = address,
+        .key_len   = strlen(key),
+    };
+
+    hdr.checksum = _record_checksum(&hdr, key);
+    nm_str_buf_append_len(sbuf, (const char *) &hdr, sizeof(hdr));
+    nm_str_buf_append_len(sbuf, key, hdr.key_len);
+}
+
+/*****************************************************************************/
+
+static void
+_entry_set(NMDhcpLeaseDb *self, char *key_take, in_addr_t address, guint32 timestamp)
+{
+    Entry *entry;
+
+    if (address == INADDR_ANY) {
+        g_hash_table_remove(self->entries, key_take);
+        g_free(key_take);
+        return;
+    }
+
+    entry  = g_new(Entry, 1);
+    *entry = (Entry){
+        .address   = address,
+        .timestamp = timestamp,
+    };
+    g_hash_table_insert(self->entries, key_take, entry);
+}
+
+static gboolean
+_load(NMDhcpLeaseDb *self, GError **error)
+{
+    gs_free_error GError *local    = NULL;
+    gs_free char         *contents = NULL;
+    gsize                 len;
+    gsize                 offset;
+    int                   errsv;
+
+    if (!nm_utils_file_get_contents(-1,
+                                    self->path,
+                                    LEASE_DB_MAX_SIZE,
+                                    NM_UTILS_FILE_GET_CONTENTS_FLAG_NONE,
+                                    &contents,
+                                    &len,
+                                    &errsv,
+                                    &local)) {
+        if (errsv == ENOENT)
+            return TRUE;
+        g_propagate_prefixed_error(error,
+                                   g_steal_pointer(&local),
+                                   "failed to read %s: ",
+                                   self->path);
+        return FALSE;
+    }
+
+    if (len == 0)
+        return TRUE;
+
+    if (len < NM_STRLEN(LEASE_DB_MAGIC)
+        || memcmp(contents, LEASE_DB_MAGIC, NM_STRLEN(LEASE_DB_MAGIC)) != 0) {
+        _LOGW("ignore %s with unknown format", self->path);
+        self->needs_compact = TRUE;
+        return TRUE;
+    }
+
+    offset = NM_STRLEN(LEASE_DB_MAGIC);
+    while (offset < len) {
+        RecordHeader hdr;
+        const char  *key;
+
+        if (len - offset < sizeof(hdr))
+            break;
+        memcpy(&hdr, &contents[offset], sizeof(hdr));
+
+        if (hdr.key_len == 0 || len - offset - sizeof(hdr) < hdr.key_len)
+            break;
+        key = &contents[offset + sizeof(hdr)];
+
+        if (hdr.checksum != _record_checksum(&hdr, key) || memchr(key, '\0', hdr.key_len))
+            break;
+
+        offset += sizeof(hdr) + hdr.key_len;
+        self->n_records++;
+        _entry_set(self, g_strndup(key, hdr.key_len), hdr.address, hdr.timestamp);
+    }
+
+    self->valid_len = offset;
+
+    if (offset < len) {
+        _LOGW("ignore invalid data at offset %zu of %s", offset, self->path);
+        self->needs_compact = TRUE;
+    }
+
+    _LOGD("loaded %u leases from %s (%u records)",
+          g_hash_table_size(self->entries),
+          self->path,
+          self->n_records);
+    return TRUE;
+}
+
+static gboolean
+_compact(NMDhcpLeaseDb *self)
+{
+    nm_auto_str_buf NMStrBuf sbuf  = NM_STR_BUF_INIT(NM_UTILS_GET_NEXT_REALLOC_SIZE_488, FALSE);
+    gs_free_error GError    *error = NULL;
+    const char              *key;
+    Entry                   *entry;
+    GHashTableIter           iter;
+    guint32                  now = _now_sec();
+
+    nm_str_buf_append(&sbuf, LEASE_DB_MAGIC);
+
+    g_hash_table_iter_init(&iter, self->entries);
+    while (g_hash_table_iter_next(&iter, (gpointer *) &key, (gpointer *) &entry)) {
+        if (_entry_is_expired(entry, now)) {
+            g_hash_table_iter_remove(&iter);
+            continue;
+        }
+        _record_append(&sbuf, key, entry->address, entry->timestamp);
+    }
+
+    if (!nm_utils_file_set_contents(self->path,
+                                    nm_str_buf_get_str_unsafe(&sbuf),
+                                    sbuf.len,
+                                    0600,
+                                    NULL,
+                                    NULL,
+                                    &error)) {
+        _LOGW("failed to write %s: %s", self->path, error->message);
+        self->needs_compact = TRUE;
+        return FALSE;
+    }
+
+    self->valid_len     = sbuf.len;
+    self->n_records     = g_hash_table_size(self->entries);
+    self->needs_compact = FALSE;
+    return TRUE;
+}
+
+static gboolean
+_append(NMDhcpLeaseDb *self, const char *key, in_addr_t address, guint32 timestamp)
+{
+    nm_auto_str_buf NMStrBuf sbuf = NM_STR_BUF_INIT(NM_UTILS_GET_NEXT_REALLOC_SIZE_104, FALSE);
+    nm_auto_close int        fd   = -1;
+    struct stat              st;
+    const char              *buf;
+    gsize                    len;
+
+    fd = open(self->path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0 || fstat(fd, &st) != 0)
+        return FALSE;
+
+    if ((gsize) st.st_size > self->valid_len) {
+        /* Don't append after torn data, or the record would be lost on the
+         * next load. */
+        if (ftruncate(fd, self->valid_len) != 0)
+            return FALSE;
+        st.st_size = self->valid_len;
+    }
+
+    if (st.st_size == 0)
+        nm_str_buf_append(&sbuf, LEASE_DB_MAGIC);
+    _record_append(&sbuf, key, address, timestamp);
+
+    /* The record is appended with a single write. If we get interrupted
+     * anyway, the remainder is detected as torn on the next load. */
+    buf = nm_str_buf_get_str_unsafe(&sbuf);
+    len = sbuf.len;
+    while (len > 0) {
+        gssize n = write(fd, buf, len);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        buf += n;
+        len -= n;
+    }
+
+    /* Like the atomic rewrite on compaction, make sure the lease is on disk
+     * before we rely on it. */
+    if (fsync(fd) != 0)
+        return FALSE;
+
+    self->valid_len = st.st_size + sbuf.len;
+    self->n_records++;
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_dhcp_lease_db_lookup:
+ * @self: the #NMDhcpLeaseDb
+ * @key: the key of the client
+ *
+ * Returns: the address of the last lease for @key, or zero.
+ */
+in_addr_t
+nm_dhcp_lease_db_lookup(NMDhcpLeaseDb *self, const char *key)
+{
+    const Entry *entry;
+
+    g_return_val_if_fail(self, INADDR_ANY);
+    g_return_val_if_fail(key, INADDR_ANY);
+
+    entry = g_hash_table_lookup(self->entries, key);
+    if (!entry || _entry_is_expired(entry, _now_sec()))
+        return INADDR_ANY;
+    return entry->address;
+}
+
+/**
+ * nm_dhcp_lease_db_store:
+ * @self: the #NMDhcpLeaseDb
+ * @key: the key of the client
+ * @address: the address of the lease, or zero to forget the lease.
+ *
+ * Returns: %TRUE if the lease is on disk, %FALSE if writing failed.
+ */
+gboolean
+nm_dhcp_lease_db_store(NMDhcpLeaseDb *self, const char *key, in_addr_t address)
+{
+    const Entry *entry;
+    guint32      now = _now_sec();
+
+    g_return_val_if_fail(self, FALSE);
+    g_return_val_if_fail(key && key[0], FALSE);
+    g_return_val_if_fail(strlen(key) <= G_MAXUINT16, FALSE);
+
+    entry = g_hash_table_lookup(self->entries, key);
+    if (address == INADDR_ANY) {
+        if (!entry)
+            return TRUE;
+    } else if (entry && entry->address == address && entry->timestamp <= now
+               && now - entry->timestamp < LEASE_DB_REFRESH_SEC)
+        return TRUE;
+
+    _entry_set(self, g_strdup(key), address, now);
+
+    if (self->needs_compact
+        || self->n_records >= 2u * g_hash_table_size(self->entries) + LEASE_DB_COMPACT_SLACK) {
+        if (_compact(self))
+            return TRUE;
+    }
+
+    if (!_append(self, key, address, now)) {
+        int errsv = errno;
+
+        _LOGW("failed to append to %s: %s", self->path, nm_strerror_native(errsv));
+        self->needs_compact = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+guint
+nm_dhcp_lease_db_get_n_records(NMDhcpLeaseDb *self)
+{
+    g_return_val_if_fail(self, 0);
+
+    return self->n_records;
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_dhcp_lease_db_new:
+ * @path: the file of the database
+ * @error: the error
+ *
+ * Returns: the database, or %NULL if @path exists but cannot be read.
+ */
+NMDhcpLeaseDb *
+nm_dhcp_lease_db_new(const char *path, GError **error)
+{
+    NMDhcpLeaseDb *self;
+
+    g_return_val_if_fail(path, NULL);
+    g_return_val_if_fail(!error || !*error, NULL);
+
+    self  = g_slice_new(NMDhcpLeaseDb);
+    *self = (NMDhcpLeaseDb){
+        .path    = g_strdup(path),
+        .entries = g_hash_table_new_full(nm_str_hash, g_str_equal, g_free, g_free),
+    };
+
+    if (!_load(self, error)) {
+        nm_dhcp_lease_db_free(self);
+        return NULL;
+    }
+    return self;
+}
+
+void
+nm_dhcp_lease_db_free(NMDhcpLeaseDb *self)
+{
+    if (!self)
+        return;
+
+    g_hash_table_unref(self->entries);
+    g_free(self->path);
+    g_slice_free(NMDhcpLeaseDb, self);
+}
+
+/**
+ * nm_dhcp_lease_db_get:
+ *
+ * Returns: the lease database of the daemon, or %NULL in the initrd. There
+ *   the per-interface lease files in NMRUNDIR are used, because they are
+ *   handed over to NetworkManager in the real root. The per-interface files
+ *   are also used if the database cannot be read.
+ */
+NMDhcpLeaseDb *
+nm_dhcp_lease_db_get(void)
+{
+    static NMDhcpLeaseDb *db;
+    static gboolean       initialized;
+
+    if (G_UNLIKELY(!initialized)) {
+        initialized = TRUE;
+        if (nm_config_get_configure_and_quit(nm_config_get())
+            != NM_CONFIG_CONFIGURE_AND_QUIT_INITRD) {
+            gs_free_error GError *error = NULL;
+
+            db = nm_dhcp_lease_db_new(NMSTATEDIR "/internal-leases.db", &error);
+            if (!db)
+                _LOGW("lease database disabled: %s", error->message);
+        }
+    }
+
+    return db;
+}
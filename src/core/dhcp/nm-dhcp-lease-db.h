@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#ifndef __NM_DHCP_LEASE_DB_H__
+#define __NM_DHCP_LEASE_DB_H__
+
+#include <netinet/in.h>
+
+/*****************************************************************************/
+
+typedef struct _NMDhcpLeaseDb NMDhcpLeaseDb;
+
+NMDhcpLeaseDb *nm_dhcp_lease_db_new(const char *path, GError **error);
+
+void nm_dhcp_lease_db_free(NMDhcpLeaseDb *self);
+
+NM_AUTO_DEFINE_FCN0(NMDhcpLeaseDb *, _nm_auto_free_dhcp_lease_db, nm_dhcp_lease_db_free);
+#define nm_auto_free_dhcp_lease_db nm_auto(_nm_auto_free_dhcp_lease_db)
+
+NMDhcpLeaseDb *nm_dhcp_lease_db_get(void);
+
+in_addr_t nm_dhcp_lease_db_lookup(NMDhcpLeaseDb *self, const char *key);
+
+gboolean nm_dhcp_lease_db_store(NMDhcpLeaseDb *self, const char *key, in_addr_t address);
+
+guint nm_dhcp_lease_db_get_n_records(NMDhcpLeaseDb *self);
+
+#endif /* __NM_DHCP_LEASE_DB_H__ */
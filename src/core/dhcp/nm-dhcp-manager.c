@@ -16,6 +16,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 
+#include "libnm-glib-aux/nm-c-list.h"
 #include "libnm-glib-aux/nm-dedup-multi.h"
 
 #include "nm-config.h"
@@ -23,8 +24,44 @@
 
 /*****************************************************************************/
 
+typedef struct {
+    /* The key of the uplinks table, hashed by nm_pint_hash(). Must be the first field. */
+    int    ifindex;
+    gint64 next_start_msec;
+} AdmissionUplink;
+
+struct _NMDhcpAdmission {
+    /* Linked in the waiting or granted list of the queue. Unlinked, once the
+     * reservation of a granted admission expired. */
+    CList lst;
+
+    NMDhcpAdmissionCallback callback;
+    gpointer                user_data;
+
+    gint64 expiry_msec;
+    int    uplink_ifindex;
+
+    bool init_reboot : 1;
+    bool granted : 1;
+};
+
+struct _NMDhcpAdmissionQueue {
+    CList waiting_lst_head;
+    CList granted_lst_head;
+
+    /* AdmissionUplink by ifindex, for the per-uplink rate limit. */
+    GHashTable *uplinks;
+
+    guint n_granted;
+    guint max_inflight;
+    guint uplink_rate;
+};
+
 typedef struct {
     const NMDhcpClientFactory *client_factory;
+
+    NMDhcpAdmissionQueue *admission_queue;
+    GSource              *admission_source;
 } NMDhcpManagerPrivate;
 
 struct _NMDhcpManager {
@@ -230,6 +267,360 @@ nm_dhcp_manager_start_client(NMDhcpManager *self, NMDhcpClientConfig *config, GE
     return g_steal_pointer(&client);
 }
 
+/*****************************************************************************/
+
+/* An admitted client counts as in-flight until it gets a lease or stops,
+ * but at most this long. Otherwise, clients that never get a lease would
+ * block the others. */
+#define ADMISSION_SLOT_MAX_MSEC 10000
+
+NMDhcpAdmissionQueue *
+_nm_dhcp_admission_queue_new(void)
+{
+    NMDhcpAdmissionQueue *queue;
+
+    queue  = g_slice_new(NMDhcpAdmissionQueue);
+    *queue = (NMDhcpAdmissionQueue){
+        .waiting_lst_head = C_LIST_INIT(queue->waiting_lst_head),
+        .granted_lst_head = C_LIST_INIT(queue->granted_lst_head),
+        .uplinks          = g_hash_table_new_full(nm_pint_hash, nm_pint_equal, g_free, NULL),
+    };
+    return queue;
+}
+
+void
+_nm_dhcp_admission_queue_free(NMDhcpAdmissionQueue *queue)
+{
+    /* The admissions are owned by the clients, which release them before. */
+    nm_assert(c_list_is_empty(&queue->waiting_lst_head));
+    nm_assert(c_list_is_empty(&queue->granted_lst_head));
+
+    g_hash_table_unref(queue->uplinks);
+    nm_g_slice_free(queue);
+}
+
+static void
+_admission_queue_prune(NMDhcpAdmissionQueue *queue, gint64 now_msec)
+{
+    NMDhcpAdmission *admission;
+    NMDhcpAdmission *safe;
+    AdmissionUplink *uplink;
+    GHashTableIter   iter;
+
+    c_list_for_each_entry_safe (admission, safe, &queue->granted_lst_head, lst) {
+        if (admission->expiry_msec <= now_msec) {
+            c_list_unlink(&admission->lst);
+            queue->n_granted--;
+        }
+    }
+
+    g_hash_table_iter_init(&iter, queue->uplinks);
+    while (g_hash_table_iter_next(&iter, (gpointer *) &uplink, NULL)) {
+        if (uplink->next_start_msec <= now_msec)
+            g_hash_table_iter_remove(&iter);
+    }
+}
+
+static gboolean
+_admission_queue_is_full(NMDhcpAdmissionQueue *queue)
+{
+    return queue->max_inflight > 0 && queue->n_granted >= queue->max_inflight;
+}
+
+static AdmissionUplink *
+_admission_get_uplink(NMDhcpAdmissionQueue *queue, NMDhcpAdmission *admission)
+{
+    if (queue->uplink_rate == 0 || admission->uplink_ifindex <= 0)
+        return NULL;
+    return g_hash_table_lookup(queue->uplinks, &admission->uplink_ifindex);
+}
+
+static void
+_admission_grant(NMDhcpAdmissionQueue *queue, NMDhcpAdmission *admission, gint64 now_msec)
+{
+    AdmissionUplink *uplink;
+
+    c_list_unlink(&admission->lst);
+    c_list_link_tail(&queue->granted_lst_head, &admission->lst);
+    queue->n_granted++;
+    admission->granted     = TRUE;
+    admission->expiry_msec = now_msec + ADMISSION_SLOT_MAX_MSEC;
+
+    if (admission->init_reboot || queue->uplink_rate == 0 || admission->uplink_ifindex <= 0)
+        return;
+
+    uplink = _admission_get_uplink(queue, admission);
+    if (!uplink) {
+        uplink  = g_new(AdmissionUplink, 1);
+        *uplink = (AdmissionUplink){
+            .ifindex = admission->uplink_ifindex,
+        };
+        nm_assert((gpointer) uplink == (gpointer) &uplink->ifindex);
+        g_hash_table_add(queue->uplinks, uplink);
+    }
+    uplink->next_start_msec = now_msec + (1000 / queue->uplink_rate);
+}
+
+/**
+ * _nm_dhcp_admission_queue_admit:
+ * @queue: the queue
+ * @now_msec: the current time
+ * @max_inflight: the maximum number of granted admissions, or zero
+ * @uplink_rate: the maximum number of admissions per second and uplink,
+ *   or zero
+ * @uplink_ifindex: the ifindex of the uplink, or zero if unknown
+ * @init_reboot: whether the client starts in INIT-REBOOT state
+ * @callback: called by _nm_dhcp_admission_queue_dispatch() when the
+ *   admission is granted later
+ * @user_data: the user data for @callback
+ * @out_granted: (out): whether the admission was granted right away
+ *
+ * Clients in INIT-REBOOT state are always granted right away, but take a
+ * slot. The others are granted in the order they ask for admission.
+ *
+ * Returns: the admission, to be released with
+ *   _nm_dhcp_admission_queue_release().
+ */
+NMDhcpAdmission *
+_nm_dhcp_admission_queue_admit(NMDhcpAdmissionQueue   *queue,
+                               gint64                  now_msec,
+                               guint                   max_inflight,
+                               guint                   uplink_rate,
+                               int                     uplink_ifindex,
+                               gboolean                init_reboot,
+                               NMDhcpAdmissionCallback callback,
+                               gpointer                user_data,
+                               gboolean               *out_granted)
+{
+    NMDhcpAdmission *admission;
+    AdmissionUplink *uplink;
+
+    queue->max_inflight = max_inflight;
+    queue->uplink_rate  = NM_MIN(uplink_rate, 1000u);
+
+    _admission_queue_prune(queue, now_msec);
+
+    admission  = g_slice_new(NMDhcpAdmission);
+    *admission = (NMDhcpAdmission){
+        .lst            = C_LIST_INIT(admission->lst),
+        .callback       = callback,
+        .user_data      = user_data,
+        .uplink_ifindex = uplink_ifindex,
+        .init_reboot    = init_reboot,
+    };
+
+    if (!init_reboot) {
+        uplink = _admission_get_uplink(queue, admission);
+        if (!c_list_is_empty(&queue->waiting_lst_head) || _admission_queue_is_full(queue)
+            || (uplink && uplink->next_start_msec > now_msec)) {
+            c_list_link_tail(&queue->waiting_lst_head, &admission->lst);
+            *out_granted = FALSE;
+            return admission;
+        }
+    }
+
+    _admission_grant(queue, admission, now_msec);
+    *out_granted = TRUE;
+    return admission;
+}
+
+void
+_nm_dhcp_admission_queue_release(NMDhcpAdmissionQueue *queue, NMDhcpAdmission *admission)
+{
+    if (c_list_is_linked(&admission->lst)) {
+        c_list_unlink(&admission->lst);
+        if (admission->granted)
+            queue->n_granted--;
+    }
+    nm_g_slice_free(admission);
+}
+
+/**
+ * _nm_dhcp_admission_queue_dispatch:
+ * @queue: the queue
+ * @now_msec: the current time
+ *
+ * Drops the expired reservations and grants the waiting admissions that
+ * can start now, invoking their callback.
+ *
+ * Returns: the time when to dispatch again, or zero if there is nothing
+ *   to wait for. A release also requires to dispatch again.
+ */
+gint64
+_nm_dhcp_admission_queue_dispatch(NMDhcpAdmissionQueue *queue, gint64 now_msec)
+{
+    NMDhcpAdmission *admission;
+    AdmissionUplink *uplink;
+    gint64           next_msec = 0;
+
+again:
+    _admission_queue_prune(queue, now_msec);
+
+    if (!_admission_queue_is_full(queue)) {
+        c_list_for_each_entry (admission, &queue->waiting_lst_head, lst) {
+            uplink = _admission_get_uplink(queue, admission);
+            if (uplink && uplink->next_start_msec > now_msec)
+                continue;
+
+            _admission_grant(queue, admission, now_msec);
+
+            /* The callback may admit and release clients. Start over. */
+            admission->callback(admission, admission->user_data);
+            goto again;
+        }
+    }
+
+    if (c_list_is_empty(&queue->waiting_lst_head))
+        return 0;
+
+    if (_admission_queue_is_full(queue)) {
+        c_list_for_each_entry (admission, &queue->granted_lst_head, lst) {
+            if (next_msec == 0 || admission->expiry_msec < next_msec)
+                next_msec = admission->expiry_msec;
+        }
+        return next_msec;
+    }
+
+    c_list_for_each_entry (admission, &queue->waiting_lst_head, lst) {
+        uplink = _admission_get_uplink(queue, admission);
+        nm_assert(uplink && uplink->next_start_msec > now_msec);
+        if (next_msec == 0 || uplink->next_start_msec < next_msec)
+            next_msec = uplink->next_start_msec;
+    }
+    return next_msec;
+}
+
+/*****************************************************************************/
+
+static void _admission_dispatch_schedule(NMDhcpManager *self, gint64 at_msec);
+
+static gboolean
+_admission_dispatch_cb(gpointer user_data)
+{
+    NMDhcpManager        *self = user_data;
+    NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE(self);
+    gint64                next_msec;
+
+    nm_clear_g_source_inst(&priv->admission_source);
+
+    next_msec = _nm_dhcp_admission_queue_dispatch(priv->admission_queue,
+                                                  nm_utils_get_monotonic_timestamp_msec());
+    _admission_dispatch_schedule(self, next_msec);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+_admission_dispatch_schedule(NMDhcpManager *self, gint64 at_msec)
+{
+    NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE(self);
+
+    nm_clear_g_source_inst(&priv->admission_source);
+    if (at_msec == 0)
+        return;
+
+    priv->admission_source =
+        nm_g_timeout_add_source(NM_MAX(at_msec - nm_utils_get_monotonic_timestamp_msec(), 0),
+                                _admission_dispatch_cb,
+                                self);
+}
+
+/**
+ * nm_dhcp_manager_admit_client:
+ * @self: the #NMDhcpManager
+ * @uplink_ifindex: the ifindex of the uplink, which is the parent link for
+ *   VLANs and similar, or the interface itself. Pass zero if unknown.
+ * @init_reboot: whether the client starts in INIT-REBOOT state, because
+ *   it has an address from a previous lease.
+ * @callback: invoked when the client may start, unless it may start
+ *   right away
+ * @user_data: the user data for @callback
+ * @out_granted: (out): whether the client may start right away
+ *
+ * When many DHCPv4 clients start at the same time (for example, at boot
+ * or when a trunk with many VLANs comes up), their DISCOVERs can overwhelm
+ * the server or relay. This spreads the starts according to
+ * "main.dhcp-max-inflight" and "main.dhcp-uplink-rate". A client in
+ * INIT-REBOOT state only REQUESTs its previous address, which is cheap for
+ * the server. It is admitted right away, but still takes a slot.
+ *
+ * The client must release the admission with
+ * nm_dhcp_manager_release_admission() when it gets a lease or stops.
+ *
+ * Returns: the admission.
+ */
+NMDhcpAdmission *
+nm_dhcp_manager_admit_client(NMDhcpManager          *self,
+                             int                     uplink_ifindex,
+                             gboolean                init_reboot,
+                             NMDhcpAdmissionCallback callback,
+                             gpointer                user_data,
+                             gboolean               *out_granted)
+{
+    NMDhcpManagerPrivate *priv;
+    NMDhcpAdmission      *admission;
+    gint64                now_msec;
+
+    g_return_val_if_fail(NM_IS_DHCP_MANAGER(self), NULL);
+    g_return_val_if_fail(callback, NULL);
+    g_return_val_if_fail(out_granted, NULL);
+
+    priv = NM_DHCP_MANAGER_GET_PRIVATE(self);
+
+    now_msec  = nm_utils_get_monotonic_timestamp_msec();
+    admission = _nm_dhcp_admission_queue_admit(
+        priv->admission_queue,
+        now_msec,
+        nm_config_data_get_value_int64(NM_CONFIG_GET_DATA,
+                                       NM_CONFIG_KEYFILE_GROUP_MAIN,
+                                       NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_MAX_INFLIGHT,
+                                       10,
+                                       0,
+                                       G_MAXINT32,
+                                       0),
+        nm_config_data_get_value_int64(NM_CONFIG_GET_DATA,
+                                       NM_CONFIG_KEYFILE_GROUP_MAIN,
+                                       NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_UPLINK_RATE,
+                                       10,
+                                       0,
+                                       1000,
+                                       0),
+        uplink_ifindex,
+        init_reboot,
+        callback,
+        user_data,
+        out_granted);
+
+    if (!*out_granted) {
+        _LOGD(AF_INET,
+              "admission: client on uplink %d waits (%u in-flight)",
+              uplink_ifindex,
+              priv->admission_queue->n_granted);
+        if (!priv->admission_source)
+            _admission_dispatch_schedule(self, now_msec);
+    }
+
+    return admission;
+}
+
+void
+nm_dhcp_manager_release_admission(NMDhcpManager *self, NMDhcpAdmission *admission)
+{
+    NMDhcpManagerPrivate *priv;
+
+    g_return_if_fail(NM_IS_DHCP_MANAGER(self));
+    g_return_if_fail(admission);
+
+    priv = NM_DHCP_MANAGER_GET_PRIVATE(self);
+
+    _nm_dhcp_admission_queue_release(priv->admission_queue, admission);
+
+    /* A waiting client might start now. */
+    if (!c_list_is_empty(&priv->admission_queue->waiting_lst_head))
+        _admission_dispatch_schedule(self, nm_utils_get_monotonic_timestamp_msec());
+}
+
+/*****************************************************************************/
+
 const char *
 nm_dhcp_manager_get_config(NMDhcpManager *self)
 {
@@ -261,6 +652,8 @@ nm_dhcp_manager_init(NMDhcpManager *self)
     int                        i;
     const NMDhcpClientFactory *client_factory = NULL;
 
+    priv->admission_queue = _nm_dhcp_admission_queue_new();
+
     for (i = 0; i < (int) G_N_ELEMENTS(_nm_dhcp_manager_factories); i++) {
         const NMDhcpClientFactory *f = _nm_dhcp_manager_factories[i];
 
@@ -319,6 +712,21 @@ nm_dhcp_manager_init(NMDhcpManager *self)
     priv->client_factory = client_factory;
 }
 
+static void
+finalize(GObject *object)
+{
+    NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE(object);
+
+    nm_clear_g_source_inst(&priv->admission_source);
+    nm_clear_pointer(&priv->admission_queue, _nm_dhcp_admission_queue_free);
+
+    G_OBJECT_CLASS(nm_dhcp_manager_parent_class)->finalize(object);
+}
+
 static void
 nm_dhcp_manager_class_init(NMDhcpManagerClass *manager_class)
-{}
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(manager_class);
+
+    object_class->finalize = finalize;
+}
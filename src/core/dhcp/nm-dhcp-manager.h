@@ -34,9 +34,41 @@ void nm_dhcp_manager_set_default_hostname(NMDhcpManager *manager, const char *ho
 NMDhcpClient *
 nm_dhcp_manager_start_client(NMDhcpManager *manager, NMDhcpClientConfig *config, GError **error);
 
+typedef struct _NMDhcpAdmission NMDhcpAdmission;
+
+typedef void (*NMDhcpAdmissionCallback)(NMDhcpAdmission *admission, gpointer user_data);
+
+NMDhcpAdmission *nm_dhcp_manager_admit_client(NMDhcpManager          *self,
+                                              int                     uplink_ifindex,
+                                              gboolean                init_reboot,
+                                              NMDhcpAdmissionCallback callback,
+                                              gpointer                user_data,
+                                              gboolean               *out_granted);
+
+void nm_dhcp_manager_release_admission(NMDhcpManager *self, NMDhcpAdmission *admission);
+
 /* For testing only */
 extern const char *nm_dhcp_helper_path;
 
+typedef struct _NMDhcpAdmissionQueue NMDhcpAdmissionQueue;
+
+NMDhcpAdmissionQueue *_nm_dhcp_admission_queue_new(void);
+void                  _nm_dhcp_admission_queue_free(NMDhcpAdmissionQueue *queue);
+
+NMDhcpAdmission *_nm_dhcp_admission_queue_admit(NMDhcpAdmissionQueue   *queue,
+                                                gint64                  now_msec,
+                                                guint                   max_inflight,
+                                                guint                   uplink_rate,
+                                                int                     uplink_ifindex,
+                                                gboolean                init_reboot,
+                                                NMDhcpAdmissionCallback callback,
+                                                gpointer                user_data,
+                                                gboolean               *out_granted);
+
+void _nm_dhcp_admission_queue_release(NMDhcpAdmissionQueue *queue, NMDhcpAdmission *admission);
+
+gint64 _nm_dhcp_admission_queue_dispatch(NMDhcpAdmissionQueue *queue, gint64 now_msec);
+
 extern const NMDhcpClientFactory *const _nm_dhcp_manager_factories[6];
 
 void nmtst_dhcp_manager_unget(gpointer singleton_instance);
@@ -25,9 +25,12 @@
 #include "nm-config.h"
 #include "nm-core-utils.h"
 #include "nm-dhcp-client-logging.h"
+#include "nm-dhcp-lease-db.h"
+#include "nm-dhcp-manager.h"
 #include "nm-dhcp-options.h"
 #include "nm-dhcp-utils.h"
 #include "nm-l3-config-data.h"
+#include "nm-l3cfg.h"
 #include "nm-utils.h"
 
 #include "libnm-systemd-shared/nm-sd-utils-shared.h"
@@ -60,8 +63,13 @@ typedef struct {
 
     GSource *pop_all_events_on_idle_source;
 
-    GSource *event_source;
-    char    *lease_file;
+    /* The admission by the DHCP manager, and the probe that waits for it. */
+    NMDhcpAdmission         *admission;
+    NDhcp4ClientProbeConfig *pending_probe_config;
+
+    guint64 mux_id;
+    char   *lease_file;
+    char   *lease_db_key;
 } NMDhcpNettoolsPrivate;
 
 struct _NMDhcpNettools {
@@ -80,6 +88,44 @@ G_DEFINE_TYPE(NMDhcpNettools, nm_dhcp_nettools, NM_TYPE_DHCP_CLIENT)
 
 /*****************************************************************************/
 
+static void dhcp4_event_dispatch(NMDhcpNettools *self);
+
+static void _admission_release(NMDhcpNettools *self);
+
+/* The FDs of all clients are registered with one shared epoll instance,
+ * see nm_dhcp_mux_register(). */
+
+static void
+_mux_dispatch_cb(gpointer user_data)
+{
+    dhcp4_event_dispatch(user_data);
+}
+
+static gboolean
+_mux_register(NMDhcpNettools *self, int fd, GError **error)
+{
+    NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE(self);
+
+    nm_assert(priv->mux_id == 0);
+
+    return nm_dhcp_mux_register(fd, _mux_dispatch_cb, self, &priv->mux_id, error);
+}
+
+static void
+_mux_unregister(NMDhcpNettools *self)
+{
+    NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE(self);
+    int                    fd;
+
+    if (priv->mux_id == 0)
+        return;
+
+    n_dhcp4_client_get_fd(priv->client, &fd);
+    nm_dhcp_mux_unregister(fd, &priv->mux_id);
+}
+
+/*****************************************************************************/
+
 static void dhcp4_event_pop_all_events_on_idle(NMDhcpNettools *self);
 
 /*****************************************************************************/
@@ -346,13 +392,14 @@ lease_parse_address_list(NDhcp4ClientLease       *lease,
     }
 
     nm_str_buf_reset(sbuf);
+    nm_str_buf_maybe_expand(sbuf, (l_data_len / 4) * NM_INET_ADDRSTRLEN, FALSE);
 
     for (; l_data_len > 0; l_data_len -= 4, l_data += 4) {
         char            addr_str[NM_INET_ADDRSTRLEN];
         const in_addr_t addr = unaligned_read_ne32(l_data);
 
         nm_str_buf_append_required_delimiter(sbuf, ' ');
-        nm_str_buf_append(sbuf, nm_inet4_ntop(addr, addr_str));
+        nm_dhcp_lease_str_buf_append_in_addr(sbuf, addr);
 
         switch (option) {
         case NM_DHCP_OPTION_DHCP4_DOMAIN_NAME_SERVER:
@@ -391,8 +438,6 @@ lease_parse_routes(NDhcp4ClientLease *lease,
                    GHashTable        *options,
                    NMStrBuf          *sbuf)
 {
-    char          dest_str[NM_INET_ADDRSTRLEN];
-    char          gateway_str[NM_INET_ADDRSTRLEN];
     in_addr_t     dest;
     in_addr_t     gateway;
     uint8_t       plen;
@@ -423,13 +468,12 @@ lease_parse_routes(NDhcp4ClientLease *lease,
         if (_client_lease_query(lease, option_code, &l_data, &l_data_len) != 0)
             continue;
 
+        /* A classless route takes at least 5 bytes. */
         nm_str_buf_reset(sbuf);
-        while (lease_option_consume_route(&l_data, &l_data_len, TRUE, &dest, &plen, &gateway)) {
-            nm_inet4_ntop(dest, dest_str);
-            nm_inet4_ntop(gateway, gateway_str);
+        nm_str_buf_maybe_expand(sbuf, (l_data_len / 5) * NM_DHCP_LEASE_ROUTE_STR_MAX_LEN, FALSE);
 
-            nm_str_buf_append_required_delimiter(sbuf, ' ');
-            nm_str_buf_append_printf(sbuf, "%s/%d %s", dest_str, (int) plen, gateway_str);
+        while (lease_option_consume_route(&l_data, &l_data_len, TRUE, &dest, &plen, &gateway)) {
+            nm_dhcp_lease_str_buf_append_route(sbuf, dest, plen, gateway);
 
             if (has_classless) {
                 /* Ignore private option if the standard one is present */
@@ -465,13 +509,10 @@ lease_parse_routes(NDhcp4ClientLease *lease,
     r = _client_lease_query(lease, NM_DHCP_OPTION_DHCP4_STATIC_ROUTE, &l_data, &l_data_len);
     if (r == 0) {
         nm_str_buf_reset(sbuf);
+        nm_str_buf_maybe_expand(sbuf, (l_data_len / 8) * NM_DHCP_LEASE_ROUTE_STR_MAX_LEN, FALSE);
 
         while (lease_option_consume_route(&l_data, &l_data_len, FALSE, &dest, &plen, &gateway)) {
-            nm_inet4_ntop(dest, dest_str);
-            nm_inet4_ntop(gateway, gateway_str);
-
-            nm_str_buf_append_required_delimiter(sbuf, ' ');
-            nm_str_buf_append_printf(sbuf, "%s/%d %s", dest_str, (int) plen, gateway_str);
+            nm_dhcp_lease_str_buf_append_route(sbuf, dest, plen, gateway);
 
             if (has_classless) {
                 /* RFC 3443: if the DHCP server returns both a Classless Static Routes
@@ -508,10 +549,11 @@ lease_parse_routes(NDhcp4ClientLease *lease,
     r = _client_lease_query(lease, NM_DHCP_OPTION_DHCP4_ROUTER, &l_data, &l_data_len);
     if (r == 0) {
         nm_str_buf_reset(sbuf);
+        nm_str_buf_maybe_expand(sbuf, (l_data_len / 4) * NM_INET_ADDRSTRLEN, FALSE);
 
         while (nm_dhcp_lease_data_consume_in_addr(&l_data, &l_data_len, &gateway)) {
             nm_str_buf_append_required_delimiter(sbuf, ' ');
-            nm_str_buf_append(sbuf, nm_inet4_ntop(gateway, gateway_str));
+            nm_dhcp_lease_str_buf_append_in_addr(sbuf, gateway);
 
             if (gateway == 0) {
                 /* silently skip 0.0.0.0 */
@@ -870,25 +912,37 @@ lease_to_ip4_config(NMDhcpNettools *self, NDhcp4ClientLease *lease, GError **err
 /*****************************************************************************/
 
 static void
-lease_save(NMDhcpNettools *self, NDhcp4ClientLease *lease, const char *lease_file)
+lease_save(NMDhcpNettools *self, NDhcp4ClientLease *lease)
 {
+    NMDhcpNettoolsPrivate   *priv = NM_DHCP_NETTOOLS_GET_PRIVATE(self);
     struct in_addr           a_address;
     nm_auto_str_buf NMStrBuf sbuf = NM_STR_BUF_INIT(NM_UTILS_GET_NEXT_REALLOC_SIZE_104, FALSE);
     char                     addr_str[NM_INET_ADDRSTRLEN];
     gs_free_error GError    *error = NULL;
+    NMDhcpLeaseDb           *lease_db;
 
     nm_assert(lease);
-    nm_assert(lease_file);
+    nm_assert(priv->lease_file);
+    nm_assert(priv->lease_db_key);
 
     n_dhcp4_client_lease_get_yiaddr(lease, &a_address);
     if (a_address.s_addr == INADDR_ANY)
         return;
 
+    /* If the lease database fails, write the lease file instead. It
+     * gets moved into the database on the next start. */
+    lease_db = nm_dhcp_lease_db_get();
+    if (lease_db && nm_dhcp_lease_db_store(lease_db, priv->lease_db_key, a_address.s_addr))
+        return;
+
     nm_str_buf_append(&sbuf, "# This is private data. Do not parse.\n");
     nm_str_buf_append_printf(&sbuf, "ADDRESS=%s\n", nm_inet4_ntop(a_address.s_addr, addr_str));
 
-    if (!g_file_set_contents(lease_file, nm_str_buf_get_str_unsafe(&sbuf), sbuf.len, &error))
-        _LOGW("error saving lease to %s: %s", lease_file, error->message);
+    if (!g_file_set_contents(priv->lease_file,
+                             nm_str_buf_get_str_unsafe(&sbuf),
+                             sbuf.len,
+                             &error))
+        _LOGW("error saving lease to %s: %s", priv->lease_file, error->message);
 }
 
 static void
@@ -917,10 +971,12 @@ bound4_handle(NMDhcpNettools *self, guint event, NDhcp4ClientLease *lease)
     }
 
     if (event == N_DHCP4_CLIENT_EVENT_GRANTED) {
+        /* The exchange is done, let the next client start. */
+        _admission_release(self);
         priv->granted.lease      = n_dhcp4_client_lease_ref(lease);
         priv->granted.lease_l3cd = nm_l3_config_data_ref(l3cd);
     } else
-        lease_save(self, lease, priv->lease_file);
+        lease_save(self, lease);
 
     _nm_dhcp_client_notify(NM_DHCP_CLIENT(self),
                            event == N_DHCP4_CLIENT_EVENT_GRANTED
@@ -1073,10 +1129,9 @@ dhcp4_event_pop_all_events_on_idle(NMDhcpNettools *self)
     }
 }
 
-static gboolean
-dhcp4_event_cb(int fd, GIOCondition condition, gpointer user_data)
+static void
+dhcp4_event_dispatch(NMDhcpNettools *self)
 {
-    NMDhcpNettools        *self = user_data;
     NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE(self);
     int                    r;
 
@@ -1093,14 +1148,12 @@ dhcp4_event_cb(int fd, GIOCondition condition, gpointer user_data)
          * and the client needs to be restarted.
          */
         _LOGE("error %d dispatching events", r);
-        nm_clear_g_source_inst(&priv->event_source);
+        _mux_unregister(self);
         _nm_dhcp_client_notify(NM_DHCP_CLIENT(self), NM_DHCP_CLIENT_EVENT_TYPE_FAIL, NULL);
-        return G_SOURCE_REMOVE;
+        return;
     }
 
     dhcp4_event_pop_all_events(self);
-
-    return G_SOURCE_CONTINUE;
 }
 
 static gboolean
@@ -1207,15 +1260,17 @@ nettools_create(NMDhcpNettools *self, GBytes **out_effective_client_id, GError *
         return FALSE;
     }
 
-    priv->client = client;
-    client       = NULL;
+    n_dhcp4_client_get_fd(client, &fd);
 
-    n_dhcp4_client_set_log_level(priv->client,
-                                 nm_log_level_to_syslog(nm_logging_get_level(LOGD_DHCP4)));
+    priv->client = g_steal_pointer(&client);
 
-    n_dhcp4_client_get_fd(priv->client, &fd);
+    if (!_mux_register(self, fd, error)) {
+        nm_clear_pointer(&priv->client, n_dhcp4_client_unref);
+        return FALSE;
+    }
 
-    priv->event_source = nm_g_unix_fd_add_source(fd, G_IO_IN, dhcp4_event_cb, self);
+    n_dhcp4_client_set_log_level(priv->client,
+                                 nm_log_level_to_syslog(nm_logging_get_level(LOGD_DHCP4)));
 
     *out_effective_client_id =
         (client_id == client_id_new) ? g_steal_pointer(&client_id_new) : g_bytes_ref(client_id);
@@ -1241,7 +1296,7 @@ _accept(NMDhcpClient *client, const NML3ConfigData *l3cd, GError **error)
 
     r = n_dhcp4_client_lease_accept(priv->granted.lease);
     if (!r)
-        lease_save(self, priv->granted.lease, priv->lease_file);
+        lease_save(self, priv->granted.lease);
 
     dhcp4_event_pop_all_events_on_idle(self);
 
@@ -1306,6 +1361,70 @@ fqdn_flags_to_wire(NMDhcpHostnameFlags flags)
     return r;
 }
 
+/* The start delay of n-dhcp4 is random in [0, delay). For a client that
+ * waited for admission, this spreads the clients that were admitted at
+ * the same time. */
+#define PROBE_START_JITTER_MSEC 100
+
+static gboolean
+_probe_start(NMDhcpNettools *self, NDhcp4ClientProbeConfig *config, GError **error)
+{
+    NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE(self);
+    int                    r;
+
+    r = n_dhcp4_client_probe(priv->client, &priv->probe, config);
+    if (r) {
+        set_error_nettools(error, r, "failed to start DHCP client");
+        return FALSE;
+    }
+
+    _LOGT("dhcp-client4: start " NM_HASH_OBFUSCATE_PTR_FMT, NM_HASH_OBFUSCATE_PTR(priv->client));
+    return TRUE;
+}
+
+static void
+_admission_release(NMDhcpNettools *self)
+{
+    NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE(self);
+
+    nm_clear_pointer(&priv->pending_probe_config, n_dhcp4_client_probe_config_free);
+    if (priv->admission)
+        nm_dhcp_manager_release_admission(nm_dhcp_manager_get(),
+                                          g_steal_pointer(&priv->admission));
+}
+
+static void
+_admission_granted_cb(NMDhcpAdmission *admission, gpointer user_data)
+{
+    nm_auto(n_dhcp4_client_probe_config_freep) NDhcp4ClientProbeConfig *config = NULL;
+    NMDhcpNettools        *self  = user_data;
+    NMDhcpNettoolsPrivate *priv  = NM_DHCP_NETTOOLS_GET_PRIVATE(self);
+    gs_free_error GError  *error = NULL;
+
+    nm_assert(priv->admission == admission);
+
+    config = g_steal_pointer(&priv->pending_probe_config);
+    _nm_dhcp_client_no_lease_timeout_pause(NM_DHCP_CLIENT(self), FALSE);
+
+    if (!_probe_start(self, config, &error)) {
+        _LOGW("%s", error->message);
+        _nm_dhcp_client_notify(NM_DHCP_CLIENT(self), NM_DHCP_CLIENT_EVENT_TYPE_FAIL, NULL);
+    }
+}
+
+static int
+_get_uplink_ifindex(NMDhcpNettools *self)
+{
+    const NMDhcpClientConfig *client_config = nm_dhcp_client_get_config(NM_DHCP_CLIENT(self));
+    const NMPlatformLink     *pllink;
+
+    pllink = nm_l3cfg_get_pllink(client_config->l3cfg, TRUE);
+    if (!pllink)
+        return 0;
+
+    return pllink->parent > 0 ? pllink->parent : pllink->ifindex;
+}
+
 static gboolean
 ip4_start(NMDhcpClient *client, GError **error)
 {
@@ -1315,12 +1434,16 @@ ip4_start(NMDhcpClient *client, GError **error)
     gs_unref_bytes GBytes    *effective_client_id = NULL;
     const NMDhcpClientConfig *client_config;
     gs_free char             *lease_file = NULL;
+    gs_free char             *lease_key  = NULL;
+    NMDhcpLeaseDb            *lease_db;
     struct in_addr            last_addr  = {0};
+    gboolean                  admitted;
     int                       r, i;
 
     client_config = nm_dhcp_client_get_config(client);
 
     g_return_val_if_fail(!priv->probe, FALSE);
+    g_return_val_if_fail(!priv->admission, FALSE);
     g_return_val_if_fail(client_config, FALSE);
 
     if (!nettools_create(self, &effective_client_id, error))
@@ -1332,24 +1455,27 @@ ip4_start(NMDhcpClient *client, GError **error)
         return FALSE;
     }
 
-    /*
-     * FIXME:
-     * Select, or configure, a reasonable start delay, to protect poor servers being flooded.
-     */
-    n_dhcp4_client_probe_config_set_start_delay(config, 1);
-
     nm_dhcp_utils_get_leasefile_path(AF_INET,
                                      "internal",
                                      client_config->iface,
                                      client_config->uuid,
                                      &lease_file);
 
+    lease_key = g_strdup_printf("%s-%s", client_config->uuid, client_config->iface);
+
+    lease_db = nm_dhcp_lease_db_get();
+
     if (client_config->v4.last_address)
         inet_pton(AF_INET, client_config->v4.last_address, &last_addr);
     else {
         gs_free char *contents = NULL;
         gs_free char *s_addr   = NULL;
 
+        /* Without lease database (in the initrd), the per-interface lease
+         * file is used. With the database, such a file was handed over from
+         * the initrd, or written by an older version or after the database
+         * failed. Then it's newer than the database entry. Move it into the
+         * database, so that it doesn't go stale. */
         nm_utils_file_get_contents(-1,
                                    lease_file,
                                    64 * 1024,
@@ -1361,6 +1487,21 @@ ip4_start(NMDhcpClient *client, GError **error)
         nm_parse_env_file(contents, "ADDRESS", &s_addr);
         if (s_addr)
             nm_inet_parse_bin(AF_INET, s_addr, NULL, &last_addr);
+
+        if (lease_db) {
+            if (!last_addr.s_addr)
+                last_addr.s_addr = nm_dhcp_lease_db_lookup(lease_db, lease_key);
+            else if (nm_dhcp_lease_db_store(lease_db, lease_key, last_addr.s_addr)) {
+                if (unlink(lease_file) != 0) {
+                    int errsv = errno;
+
+                    _LOGW("failed to remove lease file %s: %s",
+                          lease_file,
+                          nm_strerror_native(errsv));
+                } else
+                    _LOGD("moved lease file %s into the lease database", lease_file);
+            }
+        }
     }
 
     if (last_addr.s_addr) {
@@ -1368,6 +1509,8 @@ ip4_start(NMDhcpClient *client, GError **error)
         n_dhcp4_client_probe_config_set_init_reboot(config, TRUE);
     }
 
+    n_dhcp4_client_probe_config_set_start_delay(config, 1);
+
     /* Add requested options */
     for (i = 0; i < (int) G_N_ELEMENTS(_nm_dhcp_option_dhcp4_options); i++) {
         if (_nm_dhcp_option_dhcp4_options[i].include) {
@@ -1463,15 +1606,28 @@ ip4_start(NMDhcpClient *client, GError **error)
 
     g_free(priv->lease_file);
     priv->lease_file = g_steal_pointer(&lease_file);
-
-    r = n_dhcp4_client_probe(priv->client, &priv->probe, config);
-    if (r) {
-        set_error_nettools(error, r, "failed to start DHCP client");
+    g_free(priv->lease_db_key);
+    priv->lease_db_key = g_steal_pointer(&lease_key);
+
+    /* Protect the servers from being flooded when many clients start at
+     * once. The start delay of n-dhcp4 only applies to the INIT state, not
+     * to INIT-REBOOT. */
+    priv->admission = nm_dhcp_manager_admit_client(nm_dhcp_manager_get(),
+                                                   _get_uplink_ifindex(self),
+                                                   last_addr.s_addr != 0,
+                                                   _admission_granted_cb,
+                                                   self,
+                                                   &admitted);
+    if (!admitted) {
+        _LOGD("dhcp-client4: wait for admission to start");
+        n_dhcp4_client_probe_config_set_start_delay(config, PROBE_START_JITTER_MSEC);
+        priv->pending_probe_config = g_steal_pointer(&config);
+        _nm_dhcp_client_no_lease_timeout_pause(client, TRUE);
+    } else if (!_probe_start(self, config, error)) {
+        _admission_release(self);
         return FALSE;
     }
 
-    _LOGT("dhcp-client4: start " NM_HASH_OBFUSCATE_PTR_FMT, NM_HASH_OBFUSCATE_PTR(priv->client));
-
     nm_dhcp_client_set_effective_client_id(client, effective_client_id);
 
     return TRUE;
@@ -1487,6 +1643,7 @@ stop(NMDhcpClient *client, gboolean release)
 
     _LOGT("dhcp-client4: stop " NM_HASH_OBFUSCATE_PTR_FMT, NM_HASH_OBFUSCATE_PTR(priv->client));
 
+    _admission_release(self);
     priv->probe = n_dhcp4_client_probe_free(priv->probe);
 }
 
@@ -1502,8 +1659,10 @@ dispose(GObject *object)
     NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE(object);
 
     nm_clear_g_free(&priv->lease_file);
-    nm_clear_g_source_inst(&priv->event_source);
+    nm_clear_g_free(&priv->lease_db_key);
+    _mux_unregister(NM_DHCP_NETTOOLS(object));
     nm_clear_g_source_inst(&priv->pop_all_events_on_idle_source);
+    _admission_release(NM_DHCP_NETTOOLS(object));
     nm_clear_pointer(&priv->granted.lease, n_dhcp4_client_lease_unref);
     nm_clear_l3cd(&priv->granted.lease_l3cd);
     nm_clear_pointer(&priv->probe, n_dhcp4_client_probe_free);
@@ -0,0 +1,872 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "src/core/nm-default-daemon.h"
+
+#include "nm-dhcp-server.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "libnm-std-aux/unaligned.h"
+#include "dnsmasq/nm-dnsmasq-utils.h"
+#include "nm-dhcp-options.h"
+
+/*****************************************************************************/
+
+/* A minimal DHCPv4 server for shared connections (ipv4.method=shared), as
+ * an alternative to spawning one dnsmasq per interface. Every instance serves
+ * one interface, but all of them run on the main loop of NetworkManager.
+ *
+ * The pool is the same as the one we pass to dnsmasq, see
+ * nm_dnsmasq_utils_get_range_bin(). It has at most 257 addresses, so the
+ * lease table is a flat array indexed by the offset of the address in the
+ * pool. The array is a shared mapping of the lease file, so that leases
+ * survive a restart without any explicit writes.
+ *
+ * Unlike dnsmasq, we don't provide a DNS forwarder. Instead, we announce the
+ * upstream name servers that NMDnsManager configured, see
+ * nm_dhcp_server_set_nameservers(). */
+
+#define DHCP_PORT_SERVER 67
+#define DHCP_PORT_CLIENT 68
+
+#define DHCP_MAGIC_COOKIE   0x63825363u
+#define DHCP_OP_BOOTREQUEST 1
+#define DHCP_OP_BOOTREPLY   2
+
+/* These options are only used internally by DHCP clients, so NMDhcpOption
+ * doesn't list them. */
+#define DHCP_OPTION_REQUESTED_IP 50
+#define DHCP_OPTION_MESSAGE_TYPE 53
+
+enum {
+    DHCP_MSG_DISCOVER = 1,
+    DHCP_MSG_OFFER    = 2,
+    DHCP_MSG_REQUEST  = 3,
+    DHCP_MSG_DECLINE  = 4,
+    DHCP_MSG_ACK      = 5,
+    DHCP_MSG_NAK      = 6,
+    DHCP_MSG_RELEASE  = 7,
+    DHCP_MSG_INFORM   = 8,
+};
+
+/* Same as the "60m" we pass to dnsmasq. */
+#define LEASE_TIME_SEC 3600u
+
+/* How long an offered address is reserved for the client. */
+#define OFFER_HOLD_SEC 60u
+
+/* How long a declined address is not handed out again. */
+#define DECLINE_HOLD_SEC 600u
+
+#define CLIENT_ID_MAX_LEN 64u
+#define MAX_NAMESERVERS   3u
+
+/* Some clients reject replies shorter than the minimal BOOTP message. */
+#define REPLY_MIN_LEN 300u
+#define REPLY_MAX_LEN 576u
+
+#define RECV_BURST 32u
+
+#define LEASE_TABLE_MAGIC "NMDHCPS1"
+
+typedef struct _nm_packed {
+    guint8    op;
+    guint8    htype;
+    guint8    hlen;
+    guint8    hops;
+    guint32   xid;
+    guint16   secs;
+    guint16   flags;
+    in_addr_t ciaddr;
+    in_addr_t yiaddr;
+    in_addr_t siaddr;
+    in_addr_t giaddr;
+    guint8    chaddr[16];
+    guint8    sname[64];
+    guint8    file[128];
+    guint32   magic;
+} DhcpHeader;
+
+G_STATIC_ASSERT(sizeof(DhcpHeader) == 240);
+
+typedef struct {
+    DhcpHeader hdr;
+    in_addr_t  requested_ip;
+    in_addr_t  server_id;
+    guint8     type;
+
+    /* The client identifier option, or the hardware type and address. */
+    guint8 client_id_len;
+    guint8 client_id[CLIENT_ID_MAX_LEN];
+
+    /* Whether the client sent a client identifier, which we then echo. */
+    bool has_client_id_opt : 1;
+} Request;
+
+typedef enum _nm_packed {
+    LEASE_STATE_FREE = 0,
+    LEASE_STATE_OFFERED,
+    LEASE_STATE_BOUND,
+    LEASE_STATE_DECLINED,
+} LeaseState;
+
+typedef struct {
+    char      magic[8];
+    in_addr_t pool_first;
+    guint32   n_leases;
+} LeaseTableHeader;
+
+typedef struct {
+    /* Seconds in CLOCK_REALTIME, so that it stays valid across reboots. */
+    guint64 expiry;
+
+    LeaseState state;
+
+    /* The last client of the address. It is kept for free leases too, so that
+     * returning clients get their previous address. */
+    guint8 client_id_len;
+    guint8 client_id[CLIENT_ID_MAX_LEN];
+} LeaseRecord;
+
+struct _NMDhcpServer {
+    char             *iface;
+    char             *lease_file;
+    LeaseTableHeader *table;
+    LeaseRecord      *leases;
+    GSource          *source;
+    gsize             table_size;
+    in_addr_t         address;
+    in_addr_t         netmask;
+    in_addr_t         pool_first;
+    guint             n_leases;
+    int               fd;
+
+    struct {
+        in_addr_t addrs[MAX_NAMESERVERS];
+        guint     len;
+    } nameservers;
+
+    bool announce_android_metered : 1;
+
+    guint8 buf[1500];
+};
+
+/*****************************************************************************/
+
+#define _NMLOG_DOMAIN LOGD_SHARING
+#define _NMLOG(level, ...)                                              \
+    G_STMT_START                                                        \
+    {                                                                   \
+        nm_log((level),                                                 \
+               _NMLOG_DOMAIN,                                           \
+               self->iface,                                             \
+               NULL,                                                    \
+               "dhcp4-server[%s]: " _NM_UTILS_MACRO_FIRST(__VA_ARGS__), \
+               self->iface _NM_UTILS_MACRO_REST(__VA_ARGS__));          \
+    }                                                                   \
+    G_STMT_END
+
+/*****************************************************************************/
+
+static NM_UTILS_LOOKUP_STR_DEFINE(_msg_type_to_string,
+                                  guint8,
+                                  NM_UTILS_LOOKUP_DEFAULT("UNKNOWN"),
+                                  NM_UTILS_LOOKUP_STR_ITEM(DHCP_MSG_DISCOVER, "DISCOVER"),
+                                  NM_UTILS_LOOKUP_STR_ITEM(DHCP_MSG_OFFER, "OFFER"),
+                                  NM_UTILS_LOOKUP_STR_ITEM(DHCP_MSG_REQUEST, "REQUEST"),
+                                  NM_UTILS_LOOKUP_STR_ITEM(DHCP_MSG_DECLINE, "DECLINE"),
+                                  NM_UTILS_LOOKUP_STR_ITEM(DHCP_MSG_ACK, "ACK"),
+                                  NM_UTILS_LOOKUP_STR_ITEM(DHCP_MSG_NAK, "NAK"),
+                                  NM_UTILS_LOOKUP_STR_ITEM(DHCP_MSG_RELEASE, "RELEASE"),
+                                  NM_UTILS_LOOKUP_STR_ITEM(DHCP_MSG_INFORM, "INFORM"), );
+
+/*****************************************************************************/
+
+static void *
+_lease_table_map_file(NMDhcpServer *self, gsize size, gboolean *out_reset)
+{
+    nm_auto_close int fd = -1;
+    struct stat       st;
+    void             *mem;
+    int               errsv;
+
+    fd = open(self->lease_file, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        errsv = errno;
+        _LOGW("cannot open lease file %s: %s", self->lease_file, nm_strerror_native(errsv));
+        return MAP_FAILED;
+    }
+
+    *out_reset = fstat(fd, &st) != 0 || st.st_size != (off_t) size;
+    if (*out_reset && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)) {
+        errsv = errno;
+        _LOGW("cannot resize lease file %s: %s", self->lease_file, nm_strerror_native(errsv));
+        return MAP_FAILED;
+    }
+
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        errsv = errno;
+        _LOGW("cannot map lease file %s: %s", self->lease_file, nm_strerror_native(errsv));
+    }
+    return mem;
+}
+
+static gboolean
+_lease_table_open(NMDhcpServer *self)
+{
+    gsize    size = sizeof(LeaseTableHeader) + self->n_leases * sizeof(LeaseRecord);
+    gboolean reset;
+    void    *mem;
+
+    mem = _lease_table_map_file(self, size, &reset);
+    if (mem == MAP_FAILED) {
+        /* Still serve addresses, we only lose the leases on restart. */
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+            return FALSE;
+        reset = TRUE;
+    }
+
+    self->table      = mem;
+    self->table_size = size;
+    self->leases     = (LeaseRecord *) &self->table[1];
+
+    if (!reset
+        && (memcmp(self->table->magic, LEASE_TABLE_MAGIC, sizeof(self->table->magic)) != 0
+            || self->table->pool_first != self->pool_first
+            || self->table->n_leases != self->n_leases)) {
+        _LOGD("pool changed, drop the previous leases");
+        reset = TRUE;
+    }
+
+    if (reset) {
+        memset(mem, 0, size);
+        memcpy(self->table->magic, LEASE_TABLE_MAGIC, sizeof(self->table->magic));
+        self->table->pool_first = self->pool_first;
+        self->table->n_leases   = self->n_leases;
+    }
+
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static in_addr_t
+_lease_get_addr(NMDhcpServer *self, const LeaseRecord *lease)
+{
+    return htonl(ntohl(self->pool_first) + (guint32) (lease - self->leases));
+}
+
+static LeaseRecord *
+_lease_lookup_addr(NMDhcpServer *self, in_addr_t addr)
+{
+    guint32 idx = ntohl(addr) - ntohl(self->pool_first);
+
+    if (idx >= self->n_leases)
+        return NULL;
+    return &self->leases[idx];
+}
+
+static gboolean
+_lease_is_owned(const LeaseRecord *lease, const Request *req)
+{
+    return lease->client_id_len == req->client_id_len
+           && memcmp(lease->client_id, req->client_id, req->client_id_len) == 0;
+}
+
+static gboolean
+_lease_is_available(const LeaseRecord *lease, const Request *req, guint64 now)
+{
+    if (lease->state == LEASE_STATE_DECLINED)
+        return lease->expiry <= now;
+    return lease->state == LEASE_STATE_FREE || lease->expiry <= now || _lease_is_owned(lease, req);
+}
+
+static LeaseRecord *
+_lease_lookup_client(NMDhcpServer *self, const Request *req)
+{
+    guint i;
+
+    for (i = 0; i < self->n_leases; i++) {
+        LeaseRecord *lease = &self->leases[i];
+
+        if (lease->state != LEASE_STATE_DECLINED && _lease_is_owned(lease, req))
+            return lease;
+    }
+    return NULL;
+}
+
+static LeaseRecord *
+_lease_pick(NMDhcpServer *self, const Request *req, guint64 now)
+{
+    LeaseRecord *lease;
+    LeaseRecord *oldest = NULL;
+    guint        i;
+
+    lease = _lease_lookup_client(self, req);
+    if (lease && _lease_is_available(lease, req, now))
+        return lease;
+
+    if (req->requested_ip) {
+        lease = _lease_lookup_addr(self, req->requested_ip);
+        if (lease && _lease_is_available(lease, req, now))
+            return lease;
+    }
+
+    /* Prefer addresses that were never handed out, and otherwise take the one
+     * that expired the longest time ago. */
+    for (i = 0; i < self->n_leases; i++) {
+        lease = &self->leases[i];
+        if (!_lease_is_available(lease, req, now))
+            continue;
+        if (lease->state == LEASE_STATE_FREE && lease->client_id_len == 0)
+            return lease;
+        if (!oldest || lease->expiry < oldest->expiry)
+            oldest = lease;
+    }
+    return oldest;
+}
+
+static void
+_lease_set(LeaseRecord *lease, const Request *req, LeaseState state, guint64 expiry)
+{
+    lease->state         = state;
+    lease->expiry        = expiry;
+    lease->client_id_len = req->client_id_len;
+    memcpy(lease->client_id, req->client_id, req->client_id_len);
+}
+
+/*****************************************************************************/
+
+static gboolean
+_request_parse(const guint8 *msg, gsize len, Request *req)
+{
+    gsize pos;
+
+    if (len < sizeof(DhcpHeader))
+        return FALSE;
+
+    *req = (Request){};
+    memcpy(&req->hdr, msg, sizeof(req->hdr));
+
+    if (req->hdr.op != DHCP_OP_BOOTREQUEST || ntohl(req->hdr.magic) != DHCP_MAGIC_COOKIE
+        || req->hdr.hlen == 0 || req->hdr.hlen > sizeof(req->hdr.chaddr))
+        return FALSE;
+
+    /* Relayed messages would need replies to the relay agent. On a shared
+     * link there are none. */
+    if (req->hdr.giaddr != INADDR_ANY)
+        return FALSE;
+
+    /* We ignore option overloading into "sname" and "file". None of the
+     * options we care about is big enough for clients to do that. */
+    pos = sizeof(DhcpHeader);
+    while (pos < len) {
+        guint8 code = msg[pos++];
+        guint8 opt_len;
+
+        if (code == NM_DHCP_OPTION_DHCP4_PAD)
+            continue;
+        if (code == NM_DHCP_OPTION_DHCP4_END)
+            break;
+        if (pos >= len)
+            return FALSE;
+        opt_len = msg[pos++];
+        if (pos + opt_len > len)
+            return FALSE;
+
+        switch (code) {
+        case DHCP_OPTION_MESSAGE_TYPE:
+            if (opt_len == 1)
+                req->type = msg[pos];
+            break;
+        case DHCP_OPTION_REQUESTED_IP:
+            if (opt_len == 4)
+                memcpy(&req->requested_ip, &msg[pos], 4);
+            break;
+        case NM_DHCP_OPTION_DHCP4_SERVER_ID:
+            if (opt_len == 4)
+                memcpy(&req->server_id, &msg[pos], 4);
+            break;
+        case NM_DHCP_OPTION_DHCP4_CLIENT_ID:
+            if (opt_len >= 1 && opt_len <= CLIENT_ID_MAX_LEN) {
+                req->client_id_len     = opt_len;
+                req->has_client_id_opt = TRUE;
+                memcpy(req->client_id, &msg[pos], opt_len);
+            }
+            break;
+        }
+        pos += opt_len;
+    }
+
+    if (req->type < DHCP_MSG_DISCOVER || req->type > DHCP_MSG_INFORM)
+        return FALSE;
+
+    if (!req->has_client_id_opt) {
+        req->client_id[0] = req->hdr.htype;
+        memcpy(&req->client_id[1], req->hdr.chaddr, req->hdr.hlen);
+        req->client_id_len = 1 + req->hdr.hlen;
+    }
+
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+/* Returns the type of the reply, or zero for no reply. */
+static guint8
+_handle_request(NMDhcpServer *self, const Request *req, guint64 now, in_addr_t *out_yiaddr)
+{
+    LeaseRecord *lease;
+    in_addr_t    addr;
+    char         sbuf[NM_INET_ADDRSTRLEN];
+
+    switch (req->type) {
+    case DHCP_MSG_DISCOVER:
+        lease = _lease_pick(self, req, now);
+        if (!lease) {
+            _LOGW("no free address left in the pool");
+            return 0;
+        }
+        if (lease->state != LEASE_STATE_BOUND || lease->expiry <= now)
+            _lease_set(lease, req, LEASE_STATE_OFFERED, now + OFFER_HOLD_SEC);
+        *out_yiaddr = _lease_get_addr(self, lease);
+        return DHCP_MSG_OFFER;
+
+    case DHCP_MSG_REQUEST:
+        if (req->server_id != INADDR_ANY) {
+            /* SELECTING. If the client chose another server, we release our offer. */
+            if (req->server_id != self->address) {
+                lease = _lease_lookup_client(self, req);
+                if (lease && lease->state == LEASE_STATE_OFFERED)
+                    lease->state = LEASE_STATE_FREE;
+                return 0;
+            }
+            addr = req->requested_ip;
+        } else if (req->hdr.ciaddr != INADDR_ANY) {
+            /* RENEWING or REBINDING. */
+            addr = req->hdr.ciaddr;
+        } else {
+            /* INIT-REBOOT. */
+            addr = req->requested_ip;
+        }
+        if (addr == INADDR_ANY)
+            return 0;
+
+        lease = _lease_lookup_addr(self, addr);
+        if (!lease || !_lease_is_available(lease, req, now))
+            return DHCP_MSG_NAK;
+
+        _lease_set(lease, req, LEASE_STATE_BOUND, now + LEASE_TIME_SEC);
+        *out_yiaddr = addr;
+        return DHCP_MSG_ACK;
+
+    case DHCP_MSG_DECLINE:
+        if (req->server_id != self->address)
+            return 0;
+        lease = _lease_lookup_addr(self, req->requested_ip);
+        if (lease && _lease_is_owned(lease, req)) {
+            _LOGW("address %s declined by the client", nm_inet4_ntop(req->requested_ip, sbuf));
+            lease->state         = LEASE_STATE_DECLINED;
+            lease->expiry        = now + DECLINE_HOLD_SEC;
+            lease->client_id_len = 0;
+        }
+        return 0;
+
+    case DHCP_MSG_RELEASE:
+        if (req->server_id != self->address)
+            return 0;
+        lease = _lease_lookup_addr(self, req->hdr.ciaddr);
+        if (lease && _lease_is_owned(lease, req)) {
+            lease->state  = LEASE_STATE_FREE;
+            lease->expiry = 0;
+        }
+        return 0;
+
+    case DHCP_MSG_INFORM:
+        if (req->hdr.ciaddr == INADDR_ANY)
+            return 0;
+        return DHCP_MSG_ACK;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+static void
+_opt_append(guint8 *buf, gsize *pos, guint8 code, gconstpointer data, guint8 len)
+{
+    nm_assert(*pos + 2u + len < REPLY_MAX_LEN);
+
+    buf[(*pos)++] = code;
+    buf[(*pos)++] = len;
+    memcpy(&buf[*pos], data, len);
+    *pos += len;
+}
+
+static void
+_opt_append_be32(guint8 *buf, gsize *pos, guint8 code, guint32 val)
+{
+    guint8 data[4];
+
+    unaligned_write_be32(data, val);
+    _opt_append(buf, pos, code, data, sizeof(data));
+}
+
+static gsize
+_build_reply(NMDhcpServer  *self,
+             const Request *req,
+             guint8         type,
+             in_addr_t      yiaddr,
+             guint8        *buf)
+{
+    DhcpHeader hdr = {
+        .op    = DHCP_OP_BOOTREPLY,
+        .htype = req->hdr.htype,
+        .hlen  = req->hdr.hlen,
+        .xid   = req->hdr.xid,
+        .flags = req->hdr.flags,
+        .magic = htonl(DHCP_MAGIC_COOKIE),
+    };
+    gsize pos;
+
+    if (type == DHCP_MSG_ACK)
+        hdr.ciaddr = req->hdr.ciaddr;
+    if (type != DHCP_MSG_NAK && req->type != DHCP_MSG_INFORM)
+        hdr.yiaddr = yiaddr;
+    memcpy(hdr.chaddr, req->hdr.chaddr, sizeof(hdr.chaddr));
+
+    memcpy(buf, &hdr, sizeof(hdr));
+    pos = sizeof(hdr);
+
+    _opt_append(buf, &pos, DHCP_OPTION_MESSAGE_TYPE, &type, 1);
+    _opt_append(buf, &pos, NM_DHCP_OPTION_DHCP4_SERVER_ID, &self->address, 4);
+
+    if (type != DHCP_MSG_NAK) {
+        in_addr_t broadcast = self->address | ~self->netmask;
+
+        if (req->type != DHCP_MSG_INFORM) {
+            _opt_append_be32(buf, &pos, NM_DHCP_OPTION_DHCP4_IP_ADDRESS_LEASE_TIME, LEASE_TIME_SEC);
+            _opt_append_be32(buf, &pos, NM_DHCP_OPTION_DHCP4_RENEWAL_T1_TIME, LEASE_TIME_SEC / 2);
+            _opt_append_be32(buf,
+                             &pos,
+                             NM_DHCP_OPTION_DHCP4_REBINDING_T2_TIME,
+                             LEASE_TIME_SEC * 7 / 8);
+        }
+        _opt_append(buf, &pos, NM_DHCP_OPTION_DHCP4_SUBNET_MASK, &self->netmask, 4);
+        _opt_append(buf, &pos, NM_DHCP_OPTION_DHCP4_BROADCAST, &broadcast, 4);
+        _opt_append(buf, &pos, NM_DHCP_OPTION_DHCP4_ROUTER, &self->address, 4);
+        if (self->nameservers.len > 0) {
+            _opt_append(buf,
+                        &pos,
+                        NM_DHCP_OPTION_DHCP4_DOMAIN_NAME_SERVER,
+                        self->nameservers.addrs,
+                        self->nameservers.len * 4);
+        }
+        if (self->announce_android_metered) {
+            /* Like dnsmasq, we force this even if the client did not ask for it.
+             * See https://www.lorier.net/docs/android-metered.html */
+            _opt_append(buf,
+                        &pos,
+                        NM_DHCP_OPTION_DHCP4_VENDOR_SPECIFIC,
+                        "ANDROID_METERED",
+                        NM_STRLEN("ANDROID_METERED"));
+        }
+    }
+
+    /* RFC 6842 */
+    if (req->has_client_id_opt)
+        _opt_append(buf, &pos, NM_DHCP_OPTION_DHCP4_CLIENT_ID, req->client_id, req->client_id_len);
+
+    buf[pos++] = NM_DHCP_OPTION_DHCP4_END;
+
+    if (pos < REPLY_MIN_LEN) {
+        memset(&buf[pos], 0, REPLY_MIN_LEN - pos);
+        pos = REPLY_MIN_LEN;
+    }
+    return pos;
+}
+
+static gsize
+_process(NMDhcpServer *self,
+         const guint8 *msg,
+         gsize         len,
+         guint64       now,
+         guint8       *reply,
+         in_addr_t    *out_dest)
+{
+    Request   req;
+    in_addr_t yiaddr = INADDR_ANY;
+    guint8    type;
+    char      sbuf_addr[NM_INET_ADDRSTRLEN];
+    char      sbuf_hwaddr[sizeof(req.hdr.chaddr) * 3];
+
+    if (!_request_parse(msg, len, &req)) {
+        _LOGT("ignore invalid message of %zu bytes", len);
+        return 0;
+    }
+
+    type = _handle_request(self, &req, now, &yiaddr);
+
+    _nm_utils_hwaddr_ntoa(req.hdr.chaddr, req.hdr.hlen, FALSE, sbuf_hwaddr, sizeof(sbuf_hwaddr));
+
+    if (type == 0) {
+        _LOGD("%s from %s", _msg_type_to_string(req.type), sbuf_hwaddr);
+        return 0;
+    }
+
+    _LOGD("%s from %s, reply %s %s",
+          _msg_type_to_string(req.type),
+          sbuf_hwaddr,
+          _msg_type_to_string(type),
+          nm_inet4_ntop(yiaddr, sbuf_addr));
+
+    /* Without a packet socket we cannot unicast to a client that has no
+     * address yet, so all replies to such clients are broadcast. */
+    *out_dest = (type != DHCP_MSG_NAK && req.hdr.ciaddr != INADDR_ANY) ? req.hdr.ciaddr
+                                                                      : INADDR_BROADCAST;
+
+    return _build_reply(self, &req, type, yiaddr, reply);
+}
+
+/*****************************************************************************/
+
+static gboolean
+_recv_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    NMDhcpServer *self = user_data;
+    guint8        reply[REPLY_MAX_LEN];
+    guint         n;
+
+    for (n = 0; n < RECV_BURST; n++) {
+        struct sockaddr_in dest_sa;
+        in_addr_t          dest;
+        gssize             len;
+        gsize              reply_len;
+
+        len = recv(fd, self->buf, sizeof(self->buf), MSG_DONTWAIT);
+        if (len < 0) {
+            int errsv = errno;
+
+            if (NM_IN_SET(errsv, EAGAIN, EINTR))
+                break;
+            _LOGD("receive failed: %s", nm_strerror_native(errsv));
+            continue;
+        }
+
+        reply_len = _process(self, self->buf, len, time(NULL), reply, &dest);
+        if (reply_len == 0)
+            continue;
+
+        dest_sa = (struct sockaddr_in){
+            .sin_family      = AF_INET,
+            .sin_port        = htons(DHCP_PORT_CLIENT),
+            .sin_addr.s_addr = dest,
+        };
+        if (sendto(fd,
+                   reply,
+                   reply_len,
+                   MSG_NOSIGNAL,
+                   (const struct sockaddr *) &dest_sa,
+                   sizeof(dest_sa))
+            < 0) {
+            int errsv = errno;
+
+            _LOGD("failed to send reply: %s", nm_strerror_native(errsv));
+        }
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+gsize
+nmtst_dhcp_server_process(NMDhcpServer *self,
+                          const guint8 *msg,
+                          gsize         len,
+                          guint64       now,
+                          guint8       *reply,
+                          gsize         reply_size)
+{
+    in_addr_t dest;
+
+    g_return_val_if_fail(self, 0);
+    g_return_val_if_fail(reply_size >= REPLY_MAX_LEN, 0);
+
+    return _process(self, msg, len, now, reply, &dest);
+}
+
+/*****************************************************************************/
+
+gboolean
+nm_dhcp_server_start(NMDhcpServer *self, GError **error)
+{
+    nm_auto_close int  fd  = -1;
+    const int          one = 1;
+    struct sockaddr_in sa;
+    char               sbuf1[NM_INET_ADDRSTRLEN];
+    char               sbuf2[NM_INET_ADDRSTRLEN];
+    int                errsv;
+
+    g_return_val_if_fail(self, FALSE);
+    g_return_val_if_fail(self->fd < 0, FALSE);
+    g_return_val_if_fail(!error || !*error, FALSE);
+
+    fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot create socket: %s",
+                    nm_strerror_native(errsv));
+        return FALSE;
+    }
+
+    /* Every instance binds the DHCP server port on its own interface. */
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0
+        || setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one)) < 0
+        || setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, self->iface, strlen(self->iface) + 1)
+               < 0) {
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot set socket options: %s",
+                    nm_strerror_native(errsv));
+        return FALSE;
+    }
+
+    sa = (struct sockaddr_in){
+        .sin_family      = AF_INET,
+        .sin_port        = htons(DHCP_PORT_SERVER),
+        .sin_addr.s_addr = INADDR_ANY,
+    };
+    if (bind(fd, (struct sockaddr *) &sa, sizeof(sa)) < 0) {
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot bind to port %u: %s",
+                    DHCP_PORT_SERVER,
+                    nm_strerror_native(errsv));
+        return FALSE;
+    }
+
+    self->fd     = nm_steal_fd(&fd);
+    self->source = nm_g_unix_fd_add_source(self->fd, G_IO_IN, _recv_cb, self);
+
+    if (self->nameservers.len == 0)
+        _LOGW("there are no upstream IPv4 name servers to announce. Clients get no DNS server");
+
+    _LOGD("serving %s - %s from %s",
+          nm_inet4_ntop(self->pool_first, sbuf1),
+          nm_inet4_ntop(htonl(ntohl(self->pool_first) + self->n_leases - 1), sbuf2),
+          self->lease_file);
+    return TRUE;
+}
+
+void
+nm_dhcp_server_set_nameservers(NMDhcpServer *self, const char *const *nameservers)
+{
+    in_addr_t addrs[MAX_NAMESERVERS];
+    guint     len = 0;
+    guint     i;
+
+    g_return_if_fail(self);
+
+    for (i = 0; nameservers && nameservers[i] && len < MAX_NAMESERVERS; i++) {
+        in_addr_t a;
+
+        /* IPv6 name servers, and those with a DoT server name, cannot be
+         * announced. Neither can a local stub resolver. */
+        if (!nm_inet_parse_bin(AF_INET, nameservers[i], NULL, &a) || nm_ip4_addr_is_loopback(a))
+            continue;
+        addrs[len++] = a;
+    }
+
+    if (len == self->nameservers.len
+        && memcmp(addrs, self->nameservers.addrs, len * sizeof(in_addr_t)) == 0)
+        return;
+
+    memcpy(self->nameservers.addrs, addrs, len * sizeof(in_addr_t));
+    self->nameservers.len = len;
+
+    _LOGD("announce %u name servers", len);
+}
+
+NMDhcpServer *
+nm_dhcp_server_new(const char *iface,
+                   in_addr_t   address,
+                   guint8      plen,
+                   gboolean    announce_android_metered,
+                   const char *lease_file,
+                   GError    **error)
+{
+    const NMPlatformIP4Address addr = {
+        .address = address,
+        .plen    = plen,
+    };
+    gs_free char *error_desc = NULL;
+    NMDhcpServer *self;
+    in_addr_t     first;
+    in_addr_t     last;
+    int           errsv;
+
+    g_return_val_if_fail(iface, NULL);
+    g_return_val_if_fail(!error || !*error, NULL);
+
+    if (!nm_dnsmasq_utils_get_range_bin(&addr, &first, &last, &error_desc)) {
+        g_set_error_literal(error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN, error_desc);
+        return NULL;
+    }
+
+    self  = g_new(NMDhcpServer, 1);
+    *self = (NMDhcpServer){
+        .iface      = g_strdup(iface),
+        .lease_file = lease_file
+                          ? g_strdup(lease_file)
+                          : g_strdup_printf("%s/internal-dhcp-server-%s.leases", NMSTATEDIR, iface),
+        .fd         = -1,
+        .address    = address,
+        .netmask    = nm_ip4_addr_netmask_from_prefix(plen),
+        .pool_first = first,
+        .n_leases   = ntohl(last) - ntohl(first) + 1u,
+        .announce_android_metered = announce_android_metered,
+    };
+
+    if (!_lease_table_open(self)) {
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot allocate the lease table: %s",
+                    nm_strerror_native(errsv));
+        nm_dhcp_server_free(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+void
+nm_dhcp_server_free(NMDhcpServer *self)
+{
+    if (!self)
+        return;
+
+    nm_clear_g_source_inst(&self->source);
+    nm_clear_fd(&self->fd);
+    if (self->table)
+        munmap(self->table, self->table_size);
+    g_free(self->iface);
+    g_free(self->lease_file);
+    g_free(self);
+}
@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#ifndef __NM_DHCP_SERVER_H__
+#define __NM_DHCP_SERVER_H__
+
+#include <netinet/in.h>
+
+/*****************************************************************************/
+
+typedef struct _NMDhcpServer NMDhcpServer;
+
+NMDhcpServer *nm_dhcp_server_new(const char *iface,
+                                 in_addr_t   address,
+                                 guint8      plen,
+                                 gboolean    announce_android_metered,
+                                 const char *lease_file,
+                                 GError    **error);
+
+void nm_dhcp_server_set_nameservers(NMDhcpServer *self, const char *const *nameservers);
+
+gboolean nm_dhcp_server_start(NMDhcpServer *self, GError **error);
+
+void nm_dhcp_server_free(NMDhcpServer *self);
+
+NM_AUTO_DEFINE_FCN0(NMDhcpServer *, _nm_auto_free_dhcp_server, nm_dhcp_server_free);
+#define nm_auto_free_dhcp_server nm_auto(_nm_auto_free_dhcp_server)
+
+/*****************************************************************************/
+
+gsize nmtst_dhcp_server_process(NMDhcpServer *self,
+                                const guint8 *msg,
+                                gsize         len,
+                                guint64       now,
+                                guint8       *reply,
+                                gsize         reply_size);
+
+#endif /* __NM_DHCP_SERVER_H__ */
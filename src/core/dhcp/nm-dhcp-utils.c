@@ -7,6 +7,7 @@
 
 #include <unistd.h>
 #include <arpa/inet.h>
+#include <sys/epoll.h>
 
 #include "libnm-std-aux/unaligned.h"
 #include "libnm-glib-aux/nm-dedup-multi.h"
@@ -1101,6 +1102,40 @@ nm_dhcp_lease_data_parse_in_addr(const guint8 *data,
 
 /*****************************************************************************/
 
+/* The options of every lease (also on renewal) get formatted for the options
+ * dictionary. Leases can carry hundreds of (classless) static routes, so the
+ * addresses are formatted directly into the buffer, without printf() and
+ * without intermediate buffers. */
+
+void
+nm_dhcp_lease_str_buf_append_in_addr(NMStrBuf *sbuf, in_addr_t addr)
+{
+    const gsize len = sbuf->len;
+    char       *s;
+
+    nm_str_buf_maybe_expand(sbuf, NM_INET_ADDRSTRLEN, FALSE);
+    s = nm_str_buf_get_str_at_unsafe(sbuf, len);
+    nm_inet4_ntop(addr, s);
+    nm_str_buf_set_size(sbuf, len + strlen(s), FALSE, FALSE);
+}
+
+void
+nm_dhcp_lease_str_buf_append_route(NMStrBuf *sbuf, in_addr_t dest, guint8 plen, in_addr_t gateway)
+{
+    nm_assert(plen <= 32);
+
+    nm_str_buf_append_required_delimiter(sbuf, ' ');
+    nm_dhcp_lease_str_buf_append_in_addr(sbuf, dest);
+    nm_str_buf_append_c(sbuf, '/');
+    if (plen >= 10)
+        nm_str_buf_append_c(sbuf, '0' + (plen / 10));
+    nm_str_buf_append_c(sbuf, '0' + (plen % 10));
+    nm_str_buf_append_c(sbuf, ' ');
+    nm_dhcp_lease_str_buf_append_in_addr(sbuf, gateway);
+}
+
+/*****************************************************************************/
+
 static gboolean
 lease_option_print_label(NMStrBuf *sbuf, size_t n_label, const uint8_t **datap, size_t *n_datap)
 {
@@ -1278,3 +1313,172 @@ nm_dhcp_lease_data_parse_search_list(const guint8 *data,
     g_ptr_array_add(array, NULL);
     return (char **) g_ptr_array_free(array, FALSE);
 }
+
+/*****************************************************************************/
+
+/* Each NDhcp4Client has one (epoll) FD, that becomes readable when one of
+ * its sockets or timers is ready. When running DHCP on many interfaces,
+ * attaching each of these FDs to the main context means that every main
+ * loop iteration polls all of them.
+ *
+ * Instead, the FDs of all clients are registered with one shared epoll
+ * instance, and only that one is attached to the main context. When it
+ * becomes readable, only the clients that are ready get dispatched. */
+
+#define MUX_MAX_EVENTS 64
+
+typedef struct {
+    guint64           id;
+    NMDhcpMuxCallback callback;
+    gpointer          user_data;
+} MuxClient;
+
+static struct {
+    /* The registered MuxClient by their ID. The ID is the epoll data of the
+     * client's FD, so that an event of a client that got unregistered
+     * meanwhile is ignored. */
+    GHashTable *clients;
+    GSource    *source;
+    guint64     id_counter;
+    int         fd_epoll;
+} _mux = {
+    .fd_epoll = -1,
+};
+
+static gboolean
+_mux_dispatch_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    gs_unref_hashtable GHashTable *clients = NULL;
+    struct epoll_event             events[MUX_MAX_EVENTS];
+    int                            n;
+    int                            i;
+
+    n = epoll_wait(_mux.fd_epoll, events, G_N_ELEMENTS(events), 0);
+    if (n < 0) {
+        int errsv = errno;
+
+        if (!NM_IN_SET(errsv, EAGAIN, EINTR))
+            nm_log_warn(LOGD_DHCP4,
+                        "dhcp4: failed to wait on the shared epoll FD: %s",
+                        nm_strerror_native(errsv));
+        return G_SOURCE_CONTINUE;
+    }
+
+    /* Dispatching a client can unregister clients. When the last one goes away,
+     * _mux.clients gets released (and a new table might be created by a client
+     * that registers right away). Keep our table alive, the unregistered
+     * clients are already removed from it. */
+    clients = g_hash_table_ref(_mux.clients);
+
+    /* If more clients are ready, the FD stays readable and we are called
+     * again on the next iteration. */
+    for (i = 0; i < n; i++) {
+        guint64          id = events[i].data.u64;
+        const MuxClient *client;
+
+        client = g_hash_table_lookup(clients, &id);
+        if (!client) {
+            /* Unregistered while dispatching an earlier client. */
+            continue;
+        }
+        client->callback(client->user_data);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * nm_dhcp_mux_register:
+ * @fd: the FD to poll for %EPOLLIN
+ * @callback: invoked from the main context when @fd is readable
+ * @user_data: the user data for @callback
+ * @out_id: (out): the ID of the registration, never zero
+ * @error: the error
+ *
+ * Registers @fd with the epoll instance that is shared by all DHCP clients.
+ * The registration must be released with nm_dhcp_mux_unregister(), which
+ * also may be called from @callback.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_dhcp_mux_register(int               fd,
+                     NMDhcpMuxCallback callback,
+                     gpointer          user_data,
+                     guint64          *out_id,
+                     GError          **error)
+{
+    struct epoll_event ev;
+    MuxClient         *client;
+
+    nm_assert(fd >= 0);
+    nm_assert(callback);
+    nm_assert(out_id);
+
+    if (_mux.fd_epoll < 0) {
+        _mux.fd_epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (_mux.fd_epoll < 0) {
+            nm_utils_error_set_errno(error, errno, "failed to create epoll FD: %s");
+            return FALSE;
+        }
+        _mux.clients = g_hash_table_new_full(g_int64_hash,
+                                             g_int64_equal,
+                                             NULL,
+                                             nm_g_slice_free_fcn(MuxClient));
+        _mux.source  = nm_g_unix_fd_add_source(_mux.fd_epoll, G_IO_IN, _mux_dispatch_cb, NULL);
+    }
+
+    client  = g_slice_new(MuxClient);
+    *client = (MuxClient){
+        .id        = ++_mux.id_counter,
+        .callback  = callback,
+        .user_data = user_data,
+    };
+
+    ev = (struct epoll_event){
+        .events   = EPOLLIN,
+        .data.u64 = client->id,
+    };
+    if (epoll_ctl(_mux.fd_epoll, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        nm_utils_error_set_errno(error, errno, "failed to register with epoll FD: %s");
+        nm_g_slice_free(client);
+        if (g_hash_table_size(_mux.clients) == 0) {
+            nm_clear_g_source_inst(&_mux.source);
+            nm_clear_pointer(&_mux.clients, g_hash_table_unref);
+            nm_clear_fd(&_mux.fd_epoll);
+        }
+        return FALSE;
+    }
+
+    g_hash_table_insert(_mux.clients, &client->id, client);
+    *out_id = client->id;
+    return TRUE;
+}
+
+/**
+ * nm_dhcp_mux_unregister:
+ * @fd: the FD that was registered
+ * @p_id: (inout): the ID of the registration. If zero, nothing happens.
+ *   Otherwise, it is reset to zero.
+ */
+void
+nm_dhcp_mux_unregister(int fd, guint64 *p_id)
+{
+    guint64 id = *p_id;
+
+    if (id == 0)
+        return;
+
+    *p_id = 0;
+
+    epoll_ctl(_mux.fd_epoll, EPOLL_CTL_DEL, fd, NULL);
+
+    if (!g_hash_table_remove(_mux.clients, &id))
+        nm_assert_not_reached();
+
+    if (g_hash_table_size(_mux.clients) == 0) {
+        nm_clear_g_source_inst(&_mux.source);
+        nm_clear_pointer(&_mux.clients, g_hash_table_unref);
+        nm_clear_fd(&_mux.fd_epoll);
+    }
+}
@@ -103,4 +103,22 @@ char   **nm_dhcp_lease_data_parse_search_list(const guint8 *data,
                                               int           addr_family,
                                               guint         option);
 
+/* "255.255.255.255/32 255.255.255.255 " */
+#define NM_DHCP_LEASE_ROUTE_STR_MAX_LEN (2 * (NM_INET_ADDRSTRLEN - 1) + 5)
+
+void nm_dhcp_lease_str_buf_append_in_addr(struct _NMStrBuf *sbuf, in_addr_t addr);
+void nm_dhcp_lease_str_buf_append_route(struct _NMStrBuf *sbuf,
+                                        in_addr_t         dest,
+                                        guint8            plen,
+                                        in_addr_t         gateway);
+
+typedef void (*NMDhcpMuxCallback)(gpointer user_data);
+
+gboolean nm_dhcp_mux_register(int               fd,
+                              NMDhcpMuxCallback callback,
+                              gpointer          user_data,
+                              guint64          *out_id,
+                              GError          **error);
+void     nm_dhcp_mux_unregister(int fd, guint64 *p_id);
+
 #endif /* __NETWORKMANAGER_DHCP_UTILS_H__ */
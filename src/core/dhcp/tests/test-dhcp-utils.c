@@ -7,13 +7,20 @@
 
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <linux/rtnetlink.h>
 
 #include "libnm-glib-aux/nm-dedup-multi.h"
+#include "libnm-glib-aux/nm-str-buf.h"
+#include "libnm-std-aux/unaligned.h"
 #include "nm-utils.h"
 
 #include "dhcp/nm-dhcp-utils.h"
 #include "dhcp/nm-dhcp-options.h"
+#include "dhcp/nm-dhcp-lease-db.h"
+#include "dhcp/nm-dhcp-manager.h"
+#include "dhcp/nm-dhcp-server.h"
 #include "libnm-platform/nm-platform.h"
 
 #include "nm-test-utils-core.h"
@@ -747,6 +754,633 @@ test_dhcp_opt_list(gconstpointer test_data)
 
 /*****************************************************************************/
 
+typedef struct {
+    NMDhcpAdmission *admission;
+    guint            n_granted;
+} AdmissionClient;
+
+static void
+_admission_granted_cb(NMDhcpAdmission *admission, gpointer user_data)
+{
+    AdmissionClient *client = user_data;
+
+    g_assert(client->admission == admission);
+    client->n_granted++;
+}
+
+static void
+_admission_admit(NMDhcpAdmissionQueue *queue,
+                 gint64                now_msec,
+                 guint                 max_inflight,
+                 guint                 uplink_rate,
+                 int                   uplink_ifindex,
+                 gboolean              init_reboot,
+                 AdmissionClient      *client,
+                 gboolean              expect_granted)
+{
+    gboolean granted = !expect_granted;
+
+    client->admission = _nm_dhcp_admission_queue_admit(queue,
+                                                       now_msec,
+                                                       max_inflight,
+                                                       uplink_rate,
+                                                       uplink_ifindex,
+                                                       init_reboot,
+                                                       _admission_granted_cb,
+                                                       client,
+                                                       &granted);
+    g_assert(client->admission);
+    g_assert_cmpint(granted, ==, expect_granted);
+}
+
+static void
+test_admission_max_inflight(void)
+{
+    NMDhcpAdmissionQueue *queue = _nm_dhcp_admission_queue_new();
+    AdmissionClient       c[4]  = {};
+    AdmissionClient       rb    = {};
+    const gint64          now   = 1000000;
+    int                   i;
+
+    for (i = 0; i < 4; i++)
+        _admission_admit(queue, now, 2, 0, 0, FALSE, &c[i], i < 2);
+
+    /* Nothing happens until a slot is released, or the first reservation
+     * expires. */
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now), ==, now + 10000);
+    g_assert_cmpint(c[2].n_granted, ==, 0);
+
+    /* A client that got a lease releases its slot, the next one starts. */
+    _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&c[0].admission));
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now + 1), ==, now + 10000);
+    g_assert_cmpint(c[2].n_granted, ==, 1);
+    g_assert_cmpint(c[3].n_granted, ==, 0);
+
+    /* A client in INIT-REBOOT starts right away, but takes a slot. */
+    _admission_admit(queue, now + 2, 2, 0, 0, TRUE, &rb, TRUE);
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now + 3), ==, now + 10000);
+    _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&rb.admission));
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now + 4), ==, now + 10000);
+    g_assert_cmpint(c[3].n_granted, ==, 0);
+
+    /* A reservation that is not released in time is dropped. */
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now + 10000), ==, 0);
+    g_assert_cmpint(c[3].n_granted, ==, 1);
+
+    /* Releasing a dropped reservation is fine. */
+    for (i = 1; i < 4; i++)
+        _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&c[i].admission));
+    g_assert_cmpint(c[0].n_granted + c[1].n_granted, ==, 0);
+
+    _nm_dhcp_admission_queue_free(queue);
+}
+
+static void
+test_admission_uplink_rate(void)
+{
+    NMDhcpAdmissionQueue *queue = _nm_dhcp_admission_queue_new();
+    AdmissionClient       a     = {};
+    AdmissionClient       b     = {};
+    AdmissionClient       c     = {};
+    AdmissionClient       d     = {};
+    AdmissionClient       rb    = {};
+    const gint64          now   = 1000000;
+
+    /* 10 starts per second, so one every 100 msec on the same uplink. */
+    _admission_admit(queue, now, 0, 10, 5, FALSE, &a, TRUE);
+    _admission_admit(queue, now, 0, 10, 5, FALSE, &b, FALSE);
+
+    /* Clients wait in order, but a client on another uplink doesn't wait for
+     * the uplink of the ones before. */
+    _admission_admit(queue, now, 0, 10, 6, FALSE, &c, FALSE);
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now), ==, now + 100);
+    g_assert_cmpint(b.n_granted, ==, 0);
+    g_assert_cmpint(c.n_granted, ==, 1);
+
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now + 100), ==, 0);
+    g_assert_cmpint(b.n_granted, ==, 1);
+
+    /* A client in INIT-REBOOT is not limited and doesn't delay others. */
+    _admission_admit(queue, now + 150, 0, 10, 5, TRUE, &rb, TRUE);
+    _admission_admit(queue, now + 150, 0, 10, 5, FALSE, &d, FALSE);
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now + 150), ==, now + 200);
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now + 200), ==, 0);
+    g_assert_cmpint(d.n_granted, ==, 1);
+
+    /* A waiting client can be released. */
+    _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&a.admission));
+    _admission_admit(queue, now + 250, 0, 10, 5, FALSE, &a, FALSE);
+    _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&a.admission));
+    g_assert_cmpint(_nm_dhcp_admission_queue_dispatch(queue, now + 300), ==, 0);
+
+    _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&b.admission));
+    _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&c.admission));
+    _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&d.admission));
+    _nm_dhcp_admission_queue_release(queue, g_steal_pointer(&rb.admission));
+    _nm_dhcp_admission_queue_free(queue);
+}
+
+/*****************************************************************************/
+
+typedef struct _MuxTestClient MuxTestClient;
+
+struct _MuxTestClient {
+    int            fds[2];
+    guint64        id;
+    guint          n_called;
+    MuxTestClient *unregister;
+};
+
+static void
+_mux_test_cb(gpointer user_data)
+{
+    MuxTestClient *client = user_data;
+    char           buf[16];
+
+    g_assert_cmpint(client->id, !=, 0);
+
+    client->n_called++;
+    g_assert_cmpint(read(client->fds[0], buf, sizeof(buf)), >, 0);
+
+    if (client->unregister)
+        nm_dhcp_mux_unregister(client->unregister->fds[0], &client->unregister->id);
+}
+
+static void
+_mux_test_register(MuxTestClient *client)
+{
+    gs_free_error GError *error = NULL;
+
+    g_assert_cmpint(client->id, ==, 0);
+    g_assert(nm_dhcp_mux_register(client->fds[0], _mux_test_cb, client, &client->id, &error));
+    g_assert_no_error(error);
+    g_assert_cmpint(client->id, !=, 0);
+}
+
+static void
+_mux_test_fire(MuxTestClient *client)
+{
+    g_assert_cmpint(write(client->fds[1], "x", 1), ==, 1);
+}
+
+static void
+_mux_test_drain(MuxTestClient *client)
+{
+    char buf[16];
+
+    while (read(client->fds[0], buf, sizeof(buf)) > 0) {}
+}
+
+static void
+_mux_test_iterate(void)
+{
+    while (g_main_context_iteration(NULL, FALSE)) {}
+}
+
+static void
+test_dhcp_mux(void)
+{
+    MuxTestClient c[3] = {};
+    guint         i;
+
+    for (i = 0; i < G_N_ELEMENTS(c); i++) {
+        g_assert_cmpint(pipe2(c[i].fds, O_CLOEXEC | O_NONBLOCK), ==, 0);
+        _mux_test_register(&c[i]);
+    }
+    g_assert_cmpint(c[0].id, !=, c[1].id);
+    g_assert_cmpint(c[1].id, !=, c[2].id);
+
+    /* Only the client whose FD is ready gets dispatched. */
+    _mux_test_fire(&c[1]);
+    nmtst_main_context_iterate_until_assert(NULL, 1000, c[1].n_called == 1);
+    _mux_test_iterate();
+    g_assert_cmpint(c[0].n_called, ==, 0);
+    g_assert_cmpint(c[1].n_called, ==, 1);
+    g_assert_cmpint(c[2].n_called, ==, 0);
+
+    /* An unregistered client is not dispatched, even if its FD is ready. */
+    _mux_test_fire(&c[2]);
+    nm_dhcp_mux_unregister(c[2].fds[0], &c[2].id);
+    g_assert_cmpint(c[2].id, ==, 0);
+    _mux_test_fire(&c[0]);
+    nmtst_main_context_iterate_until_assert(NULL, 1000, c[0].n_called == 1);
+    _mux_test_iterate();
+    g_assert_cmpint(c[2].n_called, ==, 0);
+    _mux_test_drain(&c[2]);
+
+    /* Both FDs are ready, and whichever client is dispatched first unregisters
+     * the other one. The other one must not be dispatched anymore. */
+    _mux_test_register(&c[2]);
+    c[0].n_called   = 0;
+    c[0].unregister = &c[2];
+    c[2].unregister = &c[0];
+    _mux_test_fire(&c[0]);
+    _mux_test_fire(&c[2]);
+    nmtst_main_context_iterate_until_assert(NULL, 1000, c[0].n_called + c[2].n_called > 0);
+    _mux_test_iterate();
+    g_assert_cmpint(c[0].n_called + c[2].n_called, ==, 1);
+    g_assert((c[0].id == 0) != (c[2].id == 0));
+    nm_dhcp_mux_unregister(c[0].fds[0], &c[0].id);
+    nm_dhcp_mux_unregister(c[2].fds[0], &c[2].id);
+    c[0].unregister = NULL;
+    c[2].unregister = NULL;
+
+    /* The last client unregisters itself while being dispatched. That releases
+     * the shared epoll instance, and a new one is created when needed. */
+    c[1].unregister = &c[1];
+    _mux_test_fire(&c[1]);
+    nmtst_main_context_iterate_until_assert(NULL, 1000, c[1].n_called == 2);
+    _mux_test_iterate();
+    g_assert_cmpint(c[1].id, ==, 0);
+
+    c[0].n_called = 0;
+    _mux_test_drain(&c[0]);
+    _mux_test_register(&c[0]);
+    _mux_test_fire(&c[0]);
+    nmtst_main_context_iterate_until_assert(NULL, 1000, c[0].n_called == 1);
+
+    for (i = 0; i < G_N_ELEMENTS(c); i++) {
+        nm_dhcp_mux_unregister(c[i].fds[0], &c[i].id);
+        nm_close(c[i].fds[0]);
+        nm_close(c[i].fds[1]);
+    }
+}
+
+/*****************************************************************************/
+
+static void
+test_lease_str_buf_append(void)
+{
+    static const guint8      plens[] = {0, 1, 9, 10, 24, 31, 32};
+    static const char *const addrs[] = {
+        "0.0.0.0",
+        "1.2.3.4",
+        "10.0.0.0",
+        "192.168.100.200",
+        "255.255.255.255",
+    };
+    nm_auto_str_buf NMStrBuf sbuf     = NM_STR_BUF_INIT(0, FALSE);
+    nm_auto_str_buf NMStrBuf expected = NM_STR_BUF_INIT(0, FALSE);
+    guint                    i, j, k;
+
+    /* The options must be formatted exactly as with printf() before. */
+    for (i = 0; i < G_N_ELEMENTS(addrs); i++) {
+        nm_str_buf_append_required_delimiter(&sbuf, ' ');
+        nm_dhcp_lease_str_buf_append_in_addr(&sbuf, nmtst_inet4_from_string(addrs[i]));
+        nm_str_buf_append_required_delimiter(&expected, ' ');
+        nm_str_buf_append(&expected, addrs[i]);
+        g_assert_cmpstr(nm_str_buf_get_str(&sbuf), ==, nm_str_buf_get_str(&expected));
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(addrs); i++) {
+        for (j = 0; j < G_N_ELEMENTS(plens); j++) {
+            for (k = 0; k < G_N_ELEMENTS(addrs); k++) {
+                const in_addr_t dest    = nmtst_inet4_from_string(addrs[i]);
+                const in_addr_t gateway = nmtst_inet4_from_string(addrs[k]);
+
+                nm_str_buf_reset(&sbuf);
+                nm_str_buf_reset(&expected);
+
+                /* Two routes, delimited like in the (classless) static route options. */
+                nm_dhcp_lease_str_buf_append_route(&sbuf, dest, plens[j], gateway);
+                nm_dhcp_lease_str_buf_append_route(&sbuf, gateway, plens[j], dest);
+                nm_str_buf_append_printf(&expected,
+                                         "%s/%d %s %s/%d %s",
+                                         addrs[i],
+                                         (int) plens[j],
+                                         addrs[k],
+                                         addrs[k],
+                                         (int) plens[j],
+                                         addrs[i]);
+                g_assert_cmpstr(nm_str_buf_get_str(&sbuf), ==, nm_str_buf_get_str(&expected));
+                g_assert_cmpint(sbuf.len, <, 2 * NM_DHCP_LEASE_ROUTE_STR_MAX_LEN);
+            }
+        }
+    }
+}
+
+/*****************************************************************************/
+
+static void
+test_lease_db(void)
+{
+    nmtst_auto_unlinkfile char *path  = NULL;
+    gs_free_error GError       *error = NULL;
+    NMDhcpLeaseDb              *db;
+    guint                       i;
+    int                         fd;
+
+    fd = g_file_open_tmp(NULL, &path, &error);
+    g_assert_no_error(error);
+    nm_close(fd);
+
+    db = nm_dhcp_lease_db_new(path, &error);
+    nmtst_assert_success(db, error);
+    g_assert_cmpint(nm_dhcp_lease_db_lookup(db, "a-eth0"), ==, INADDR_ANY);
+    nm_dhcp_lease_db_store(db, "a-eth0", nmtst_inet4_from_string("192.168.1.5"));
+    nm_dhcp_lease_db_store(db, "b-eth1", nmtst_inet4_from_string("192.168.2.5"));
+    nm_dhcp_lease_db_store(db, "c-eth2", nmtst_inet4_from_string("192.168.3.5"));
+    nm_dhcp_lease_db_store(db, "a-eth0", nmtst_inet4_from_string("192.168.1.6"));
+    nm_dhcp_lease_db_store(db, "c-eth2", INADDR_ANY);
+
+    /* Storing the same address again doesn't append. */
+    nm_dhcp_lease_db_store(db, "b-eth1", nmtst_inet4_from_string("192.168.2.5"));
+    g_assert_cmpint(nm_dhcp_lease_db_get_n_records(db), ==, 5);
+    nm_dhcp_lease_db_free(db);
+
+    db = nm_dhcp_lease_db_new(path, &error);
+    nmtst_assert_success(db, error);
+    g_assert_cmpint(nm_dhcp_lease_db_get_n_records(db), ==, 5);
+    g_assert_cmpint(nm_dhcp_lease_db_lookup(db, "a-eth0"),
+                    ==,
+                    nmtst_inet4_from_string("192.168.1.6"));
+    g_assert_cmpint(nm_dhcp_lease_db_lookup(db, "b-eth1"),
+                    ==,
+                    nmtst_inet4_from_string("192.168.2.5"));
+    g_assert_cmpint(nm_dhcp_lease_db_lookup(db, "c-eth2"), ==, INADDR_ANY);
+
+    /* Superseded records get compacted. */
+    for (i = 0; i < 200; i++)
+        nm_dhcp_lease_db_store(db, "a-eth0", htonl(0x0a000001u + i));
+    g_assert_cmpint(nm_dhcp_lease_db_get_n_records(db), <, 100);
+    nm_dhcp_lease_db_free(db);
+
+    /* A torn record at the end is ignored. */
+    fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    g_assert_cmpint(fd, >=, 0);
+    g_assert_cmpint(write(fd, "\x01\x02\x03", 3), ==, 3);
+    nm_close(fd);
+
+    db = nm_dhcp_lease_db_new(path, &error);
+    nmtst_assert_success(db, error);
+    g_assert_cmpint(nm_dhcp_lease_db_lookup(db, "a-eth0"), ==, htonl(0x0a000001u + 199));
+    g_assert_cmpint(nm_dhcp_lease_db_lookup(db, "b-eth1"),
+                    ==,
+                    nmtst_inet4_from_string("192.168.2.5"));
+    g_assert(nm_dhcp_lease_db_store(db, "b-eth1", nmtst_inet4_from_string("192.168.2.7")));
+    g_assert_cmpint(nm_dhcp_lease_db_get_n_records(db), ==, 2);
+    nm_dhcp_lease_db_free(db);
+
+    /* A database that exists but cannot be read is not used, so that it
+     * doesn't get overwritten. */
+    db = nm_dhcp_lease_db_new("/", &error);
+    g_assert_null(db);
+    g_assert(error);
+    g_clear_error(&error);
+}
+
+/*****************************************************************************/
+
+static gsize
+_dhcp_server_msg(guint8   *buf,
+                 guint8    type,
+                 guint8    client,
+                 in_addr_t ciaddr,
+                 in_addr_t requested_ip,
+                 in_addr_t server_id)
+{
+    gsize pos = 240;
+
+    memset(buf, 0, 240);
+    buf[0] = 1;
+    buf[1] = 1;
+    buf[2] = 6;
+    unaligned_write_be32(&buf[4], 0x1000u + client);
+    memcpy(&buf[12], &ciaddr, 4);
+    memcpy(&buf[28], ((const guint8[]){0x02, 0x00, 0x00, 0x00, 0x00, client}), 6);
+    unaligned_write_be32(&buf[236], 0x63825363u);
+
+    buf[pos++] = 53;
+    buf[pos++] = 1;
+    buf[pos++] = type;
+    if (requested_ip) {
+        buf[pos++] = 50;
+        buf[pos++] = 4;
+        memcpy(&buf[pos], &requested_ip, 4);
+        pos += 4;
+    }
+    if (server_id) {
+        buf[pos++] = 54;
+        buf[pos++] = 4;
+        memcpy(&buf[pos], &server_id, 4);
+        pos += 4;
+    }
+    buf[pos++] = 255;
+    return pos;
+}
+
+static const guint8 *
+_dhcp_server_reply_get_option(const guint8 *reply, gsize len, guint8 code, guint8 *out_len)
+{
+    gsize pos = 240;
+
+    while (pos + 1 < len && reply[pos] != 255) {
+        if (reply[pos] == 0) {
+            pos++;
+            continue;
+        }
+        g_assert_cmpint(pos + 2 + reply[pos + 1], <=, len);
+        if (reply[pos] == code) {
+            *out_len = reply[pos + 1];
+            return &reply[pos + 2];
+        }
+        pos += 2 + reply[pos + 1];
+    }
+    return NULL;
+}
+
+static guint8
+_dhcp_server_process(NMDhcpServer *server,
+                     guint64       now,
+                     guint8        type,
+                     guint8        client,
+                     in_addr_t     ciaddr,
+                     in_addr_t     requested_ip,
+                     in_addr_t     server_id,
+                     in_addr_t    *out_yiaddr)
+{
+    guint8        msg[576];
+    guint8        reply[576];
+    const guint8 *opt;
+    gsize         len;
+    guint8        opt_len;
+    in_addr_t     addr;
+
+    len = _dhcp_server_msg(msg, type, client, ciaddr, requested_ip, server_id);
+    len = nmtst_dhcp_server_process(server, msg, len, now, reply, sizeof(reply));
+    if (len == 0)
+        return 0;
+
+    g_assert_cmpint(len, >=, 300);
+    g_assert_cmpint(reply[0], ==, 2);
+    g_assert_cmpint(unaligned_read_be32(&reply[4]), ==, 0x1000u + client);
+    g_assert_cmpint(reply[33], ==, client);
+    memcpy(out_yiaddr, &reply[16], 4);
+
+    opt = _dhcp_server_reply_get_option(reply, len, 54, &opt_len);
+    g_assert(opt);
+    g_assert_cmpint(opt_len, ==, 4);
+    memcpy(&addr, opt, 4);
+    g_assert_cmpint(addr, ==, nmtst_inet4_from_string("192.168.1.1"));
+
+    if (type == 1) {
+        opt = _dhcp_server_reply_get_option(reply, len, 43, &opt_len);
+        g_assert(opt);
+        g_assert_cmpmem(opt, opt_len, "ANDROID_METERED", 15);
+    }
+
+    opt = _dhcp_server_reply_get_option(reply, len, 53, &opt_len);
+    g_assert(opt);
+    g_assert_cmpint(opt_len, ==, 1);
+    return opt[0];
+}
+
+static void
+test_dhcp_server(void)
+{
+    nmtst_auto_unlinkfile char *path      = NULL;
+    gs_free_error GError       *error     = NULL;
+    const in_addr_t             server_id = nmtst_inet4_from_string("192.168.1.1");
+    const guint64               now       = 1000000;
+    NMDhcpServer               *server;
+    in_addr_t                   yiaddr;
+    int                         fd;
+
+    fd = g_file_open_tmp(NULL, &path, &error);
+    g_assert_no_error(error);
+    nm_close(fd);
+
+    server = nm_dhcp_server_new("eth0", server_id, 24, TRUE, path, &error);
+    g_assert_no_error(error);
+
+    /* The pool is 192.168.1.10 - 192.168.1.254, see nm_dnsmasq_utils_get_range(). */
+    g_assert_cmpint(_dhcp_server_process(server, now, 1, 1, 0, 0, 0, &yiaddr), ==, 2);
+    g_assert_cmpint(yiaddr, ==, nmtst_inet4_from_string("192.168.1.10"));
+
+    /* The offered address is reserved for the first client. */
+    g_assert_cmpint(_dhcp_server_process(server, now, 1, 2, 0, yiaddr, 0, &yiaddr), ==, 2);
+    g_assert_cmpint(yiaddr, ==, nmtst_inet4_from_string("192.168.1.11"));
+
+    g_assert_cmpint(_dhcp_server_process(server,
+                                         now,
+                                         3,
+                                         1,
+                                         0,
+                                         nmtst_inet4_from_string("192.168.1.10"),
+                                         server_id,
+                                         &yiaddr),
+                    ==,
+                    5);
+    g_assert_cmpint(yiaddr, ==, nmtst_inet4_from_string("192.168.1.10"));
+
+    /* INIT-REBOOT with the address of another client or outside the pool. */
+    g_assert_cmpint(_dhcp_server_process(server,
+                                         now,
+                                         3,
+                                         2,
+                                         0,
+                                         nmtst_inet4_from_string("192.168.1.10"),
+                                         0,
+                                         &yiaddr),
+                    ==,
+                    6);
+    g_assert_cmpint(_dhcp_server_process(server,
+                                         now,
+                                         3,
+                                         2,
+                                         0,
+                                         nmtst_inet4_from_string("10.0.0.5"),
+                                         0,
+                                         &yiaddr),
+                    ==,
+                    6);
+
+    /* The client chose another server. */
+    g_assert_cmpint(_dhcp_server_process(server,
+                                         now,
+                                         3,
+                                         2,
+                                         0,
+                                         nmtst_inet4_from_string("192.168.1.11"),
+                                         nmtst_inet4_from_string("192.168.1.2"),
+                                         &yiaddr),
+                    ==,
+                    0);
+
+    nm_dhcp_server_free(server);
+
+    /* The leases survive a restart. */
+    server = nm_dhcp_server_new("eth0", server_id, 24, TRUE, path, &error);
+    g_assert_no_error(error);
+
+    g_assert_cmpint(_dhcp_server_process(server,
+                                         now + 10,
+                                         3,
+                                         1,
+                                         nmtst_inet4_from_string("192.168.1.10"),
+                                         0,
+                                         0,
+                                         &yiaddr),
+                    ==,
+                    5);
+    g_assert_cmpint(yiaddr, ==, nmtst_inet4_from_string("192.168.1.10"));
+    g_assert_cmpint(_dhcp_server_process(server, now + 20, 1, 3, 0, 0, 0, &yiaddr), ==, 2);
+    g_assert_cmpint(yiaddr, ==, nmtst_inet4_from_string("192.168.1.12"));
+
+    nm_dhcp_server_free(server);
+}
+
+static void
+test_dhcp_server_nameservers(void)
+{
+    nmtst_auto_unlinkfile char *path      = NULL;
+    gs_free_error GError       *error     = NULL;
+    const in_addr_t             server_id = nmtst_inet4_from_string("192.168.1.1");
+    NMDhcpServer               *server;
+    guint8                      msg[576];
+    guint8                      reply[576];
+    const guint8               *opt;
+    gsize                       len;
+    guint8                      opt_len;
+    in_addr_t                   addrs[2];
+    int                         fd;
+
+    fd = g_file_open_tmp(NULL, &path, &error);
+    g_assert_no_error(error);
+    nm_close(fd);
+
+    server = nm_dhcp_server_new("eth0", server_id, 24, FALSE, path, &error);
+    g_assert_no_error(error);
+
+    /* Only IPv4 name servers that are not loopback addresses are announced. */
+    nm_dhcp_server_set_nameservers(server,
+                                   NM_MAKE_STRV("127.0.0.53",
+                                                "fd00::1",
+                                                "192.168.2.1#dns.example.com",
+                                                "192.168.2.1",
+                                                "10.0.0.1"));
+
+    len = _dhcp_server_msg(msg, 1, 1, 0, 0, 0);
+    len = nmtst_dhcp_server_process(server, msg, len, 1000000, reply, sizeof(reply));
+    g_assert_cmpint(len, >, 0);
+    opt = _dhcp_server_reply_get_option(reply, len, 6, &opt_len);
+    g_assert(opt);
+    addrs[0] = nmtst_inet4_from_string("192.168.2.1");
+    addrs[1] = nmtst_inet4_from_string("10.0.0.1");
+    g_assert_cmpmem(opt, opt_len, addrs, sizeof(addrs));
+
+    nm_dhcp_server_set_nameservers(server, NULL);
+
+    len = _dhcp_server_msg(msg, 1, 1, 0, 0, 0);
+    len = nmtst_dhcp_server_process(server, msg, len, 1000000, reply, sizeof(reply));
+    g_assert_cmpint(len, >, 0);
+    g_assert(!_dhcp_server_reply_get_option(reply, len, 6, &opt_len));
+
+    nm_dhcp_server_free(server);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE();
 
 int
@@ -785,6 +1419,13 @@ main(int argc, char **argv)
     g_test_add_func("/dhcp/parse-search-list", test_parse_search_list);
     g_test_add_data_func("/dhcp/test_dhcp_opt_list/IPv4", GINT_TO_POINTER(0), test_dhcp_opt_list);
     g_test_add_data_func("/dhcp/test_dhcp_opt_list/IPv6", GINT_TO_POINTER(1), test_dhcp_opt_list);
+    g_test_add_func("/dhcp/mux", test_dhcp_mux);
+    g_test_add_func("/dhcp/lease-str-buf-append", test_lease_str_buf_append);
+    g_test_add_func("/dhcp/lease-db", test_lease_db);
+    g_test_add_func("/dhcp/admission/max-inflight", test_admission_max_inflight);
+    g_test_add_func("/dhcp/admission/uplink-rate", test_admission_uplink_rate);
+    g_test_add_func("/dhcp/server", test_dhcp_server);
+    g_test_add_func("/dhcp/server/nameservers", test_dhcp_server_nameservers);
 
     return g_test_run();
 }
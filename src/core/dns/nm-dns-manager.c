@@ -26,12 +26,14 @@
 
 #include "libnm-core-intern/nm-core-internal.h"
 #include "libnm-glib-aux/nm-str-buf.h"
+#include "nm-dns-stub/nm-dns-stub-server.h"
 
 #include "NetworkManagerUtils.h"
 #include "devices/nm-device.h"
 #include "nm-config.h"
 #include "nm-dbus-object.h"
 #include "nm-dns-dnsmasq.h"
+#include "nm-dns-stub.h"
 #include "nm-dns-plugin.h"
 #include "nm-dns-systemd-resolved.h"
 #include "nm-ip-config.h"
@@ -57,6 +59,9 @@
 
 #define UPDATE_PENDING_UNBLOCK_TIMEOUT_MSEC 5000
 
+#define UPDATE_DNS_MIN_INTERVAL_MSEC_DEFAULT 250
+#define UPDATE_DNS_MAX_LATENCY_MSEC_DEFAULT  2000
+
 /*****************************************************************************/
 
 typedef enum { SR_SUCCESS, SR_NOTFOUND, SR_ERROR } SpawnResult;
@@ -72,6 +77,63 @@ typedef struct {
 
 /*****************************************************************************/
 
+/* The search and routing domains of all ip_data are tracked in a trie,
+ * where each node is a domain and its parent is the domain without the
+ * first label. The root of the trie is the wildcard domain "". The trie
+ * is updated when an ip_data gets added or removed, so that on
+ * update we only need to look at the ancestors of a domain to decide
+ * whether it gets dropped. */
+typedef struct _DomainTrackNode DomainTrackNode;
+
+struct _DomainTrackNode {
+    /* must be the first field, for nm_pstr_hash(). */
+    const char *domain;
+
+    DomainTrackNode *parent;
+    CList            entries_lst_head;
+    guint            ref_count;
+
+    /* The lowest priority of the entries of the node. For the
+     * automatically added wildcard domains (only on the root node), we
+     * track the lowest priority separately, because which of them
+     * apply depends on all ip_data. */
+    int prio_min;
+    int prio_min_auto_wildcard;
+    int prio_min_auto_non_vpn;
+
+    /* Evaluated lazily, valid if eval_gen matches the generation of the trie.
+     * "acc_prio" is the priority with which the domain is used (or G_MAXINT),
+     * "shadow_prio" and "shadow_node" is the lowest of the "acc_prio" of the
+     * ancestors. */
+    guint64          eval_gen;
+    int              acc_prio;
+    int              shadow_prio;
+    DomainTrackNode *shadow_node;
+
+    char domain_buf[];
+};
+
+typedef struct {
+    CList            ip_data_lst;
+    CList            node_lst;
+    DomainTrackNode *node;
+    int              priority;
+
+    /* Whether this is the automatically added wildcard domain, and
+     * in which case it applies. */
+    bool is_auto : 1;
+    bool auto_wildcard : 1;
+    bool auto_non_vpn : 1;
+} DomainTrackEntry;
+
+typedef enum {
+    DOMAIN_TRACK_RESULT_ADD,
+    DOMAIN_TRACK_RESULT_DROP_EXISTS,
+    DOMAIN_TRACK_RESULT_DROP_SHADOWED,
+} DomainTrackResult;
+
+/*****************************************************************************/
+
 enum {
     CONFIG_CHANGED,
 
@@ -109,8 +171,9 @@ typedef struct {
 
     bool update_pending : 1;
 
-    char *hostdomain;
-    guint updates_queue;
+    char  *hostdomain;
+    char **upstream_nameservers;
+    guint  updates_queue;
 
     guint8 hash[HASH_LEN];      /* SHA1 hash of current DNS config */
     guint8 prev_hash[HASH_LEN]; /* Hash when begin_updates() was called */
@@ -128,11 +191,28 @@ typedef struct {
     NMDnsConfigIPData *best_ip_config_4;
     NMDnsConfigIPData *best_ip_config_6;
 
+    struct {
+        GHashTable *nodes;
+        guint64     gen;
+        guint       wildcard_num;
+    } domain_track;
+
     struct {
         guint64 ts;
         guint   num_restarts;
         guint   timer;
     } plugin_ratelimit;
+
+    /* Changes to the IP configurations are not committed right away, but
+     * coalesced by a timer. See _update_dns_schedule(). */
+    struct {
+        GSource *source;
+        gint64   first_msec;
+        gint64   deadline_msec;
+        gint64   last_msec;
+        guint    min_interval_msec;
+        guint    max_latency_msec;
+    } update_dns_schedule;
 } NMDnsManagerPrivate;
 
 struct _NMDnsManager {
@@ -260,6 +340,10 @@ _update_pending_detect(NMDnsManager *self)
         return TRUE;
     if (priv->sd_resolve_plugin && nm_dns_plugin_get_update_pending(priv->sd_resolve_plugin))
         return TRUE;
+    if (priv->update_dns_schedule.source) {
+        /* a coalesced update is scheduled, but not yet committed. */
+        return TRUE;
+    }
     return FALSE;
 }
 
@@ -311,6 +395,23 @@ _update_pending_changed_cb(NMDnsPlugin *plugin, gboolean update_pending, NMDnsMa
     _update_pending_maybe_changed(self);
 }
 
+/**
+ * nm_dns_manager_get_upstream_nameservers:
+ * @self: the #NMDnsManager
+ *
+ * Returns: (transfer none): the name servers of the last DNS update, before
+ *   they were replaced by the address of a local caching resolver. The
+ *   array is only valid until the next update, which is announced by
+ *   a change of #NMDnsManager:configuration.
+ */
+const char *const *
+nm_dns_manager_get_upstream_nameservers(NMDnsManager *self)
+{
+    g_return_val_if_fail(NM_IS_DNS_MANAGER(self), NULL);
+
+    return NM_CAST_STRV_CC(NM_DNS_MANAGER_GET_PRIVATE(self)->upstream_nameservers);
+}
+
 gboolean
 nm_dns_manager_get_update_pending(NMDnsManager *self)
 {
@@ -387,6 +488,313 @@ _ASSERT_dns_config_ip_data(const NMDnsConfigIPData *ip_data)
 #endif
 }
 
+static gboolean
+_dns_config_ip_data_has_nameservers(const NMDnsConfigIPData *ip_data)
+{
+    guint num;
+
+    nm_l3_config_data_get_nameservers(ip_data->l3cd, ip_data->addr_family, &num);
+    return num > 0;
+}
+
+static gboolean
+_dns_config_ip_data_is_wildcard(const NMDnsConfigIPData *ip_data)
+{
+    guint num;
+
+    if (nm_l3_config_data_get_best_default_route(ip_data->l3cd, ip_data->addr_family)) {
+        /* FIXME(l3cfg): the best-default route of a l3cd is not significant! */
+        return TRUE;
+    }
+
+    /* If a VPN has never-default=no but doesn't get a default
+     * route (this can happen for example when the server
+     * pushes routes with openconnect), and there are no
+     * search or routing domains, then the name servers pushed
+     * by the server would be unused. It is preferable in this
+     * case to use the VPN DNS server for all queries. */
+    return ip_data->ip_config_type == NM_DNS_IP_CONFIG_TYPE_VPN
+           && nm_l3_config_data_get_never_default(ip_data->l3cd, ip_data->addr_family)
+                  == NM_TERNARY_FALSE
+           && !nm_l3_config_data_get_searches(ip_data->l3cd, ip_data->addr_family, &num)
+           && !nm_l3_config_data_get_domains(ip_data->l3cd, ip_data->addr_family, &num);
+}
+
+static const char *const *
+_dns_config_ip_data_get_domains(const NMDnsConfigIPData *ip_data, guint *out_len)
+{
+    const char *const *strv;
+
+    /* searches are preferred over domains */
+    strv = nm_l3_config_data_get_searches(ip_data->l3cd, ip_data->addr_family, out_len);
+    if (*out_len > 0)
+        return strv;
+    return nm_l3_config_data_get_domains(ip_data->l3cd, ip_data->addr_family, out_len);
+}
+
+/*****************************************************************************/
+
+static const char *
+_domain_track_parent_domain(const char *domain)
+{
+    const char *parent;
+
+    /* The parent of "a.b.c" is "b.c", and the parent of "c" is the
+     * wildcard domain "". */
+    nm_assert(domain && domain[0]);
+
+    parent = strchr(domain, '.');
+    if (parent && parent[1])
+        return &parent[1];
+    return "";
+}
+
+static void
+_domain_track_node_update_prio(DomainTrackNode *node)
+{
+    DomainTrackEntry *entry;
+
+    node->prio_min               = G_MAXINT;
+    node->prio_min_auto_wildcard = G_MAXINT;
+    node->prio_min_auto_non_vpn  = G_MAXINT;
+
+    c_list_for_each_entry (entry, &node->entries_lst_head, node_lst) {
+        int *p_prio;
+
+        if (!entry->is_auto)
+            p_prio = &node->prio_min;
+        else if (entry->auto_wildcard) {
+            p_prio = &node->prio_min_auto_wildcard;
+            if (entry->auto_non_vpn)
+                node->prio_min_auto_non_vpn = NM_MIN(node->prio_min_auto_non_vpn, entry->priority);
+        } else if (entry->auto_non_vpn)
+            p_prio = &node->prio_min_auto_non_vpn;
+        else
+            continue;
+
+        *p_prio = NM_MIN(*p_prio, entry->priority);
+    }
+}
+
+static DomainTrackNode *
+_domain_track_node_ref(NMDnsManager *self, const char *domain)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    DomainTrackNode     *node;
+    gsize                l;
+
+    node = g_hash_table_lookup(priv->domain_track.nodes, &domain);
+    if (node) {
+        node->ref_count++;
+        return node;
+    }
+
+    l     = strlen(domain) + 1;
+    node  = g_malloc(sizeof(DomainTrackNode) + l);
+    *node = (DomainTrackNode){
+        .domain                 = node->domain_buf,
+        .entries_lst_head       = C_LIST_INIT(node->entries_lst_head),
+        .ref_count              = 1,
+        .prio_min               = G_MAXINT,
+        .prio_min_auto_wildcard = G_MAXINT,
+        .prio_min_auto_non_vpn  = G_MAXINT,
+    };
+    memcpy(node->domain_buf, domain, l);
+
+    if (domain[0])
+        node->parent = _domain_track_node_ref(self, _domain_track_parent_domain(domain));
+
+    g_hash_table_add(priv->domain_track.nodes, node);
+    return node;
+}
+
+static void
+_domain_track_node_unref(NMDnsManager *self, DomainTrackNode *node)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    DomainTrackNode     *parent;
+
+    while (node) {
+        nm_assert(node->ref_count > 0);
+        if (--node->ref_count > 0)
+            return;
+
+        nm_assert(c_list_is_empty(&node->entries_lst_head));
+
+        parent = node->parent;
+        g_hash_table_remove(priv->domain_track.nodes, node);
+        g_free(node);
+        node = parent;
+    }
+}
+
+static DomainTrackEntry *
+_domain_track_entry_add(NMDnsManager      *self,
+                        NMDnsConfigIPData *ip_data,
+                        const char        *domain,
+                        int                priority)
+{
+    DomainTrackEntry *entry;
+
+    entry  = g_slice_new(DomainTrackEntry);
+    *entry = (DomainTrackEntry){
+        .node     = _domain_track_node_ref(self, domain),
+        .priority = priority,
+    };
+    c_list_link_tail(&ip_data->domain_track_lst_head, &entry->ip_data_lst);
+    c_list_link_tail(&entry->node->entries_lst_head, &entry->node_lst);
+    return entry;
+}
+
+static void
+_domain_track_add_ip_data(NMDnsManager *self, NMDnsConfigIPData *ip_data)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    DomainTrackEntry    *entry;
+    const char *const   *strv;
+    guint                len;
+    guint                i;
+    int                  priority;
+
+    nm_assert(c_list_is_empty(&ip_data->domain_track_lst_head));
+
+    if (!_dns_config_ip_data_has_nameservers(ip_data))
+        return;
+
+    priority = _dns_config_ip_data_get_dns_priority(ip_data);
+
+    strv = _dns_config_ip_data_get_domains(ip_data, &len);
+    for (i = 0; i < len; i++) {
+        entry = _domain_track_entry_add(self,
+                                        ip_data,
+                                        nm_utils_parse_dns_domain(strv[i], NULL),
+                                        priority);
+        entry->node->prio_min = NM_MIN(entry->node->prio_min, priority);
+    }
+
+    /* Whether the automatic wildcard domain applies, depends on whether any
+     * ip_data is a wildcard entry. See _mgr_configs_data_construct(). */
+    entry                = _domain_track_entry_add(self, ip_data, "", priority);
+    entry->is_auto       = TRUE;
+    entry->auto_wildcard = _dns_config_ip_data_is_wildcard(ip_data);
+    entry->auto_non_vpn  = (ip_data->ip_config_type != NM_DNS_IP_CONFIG_TYPE_VPN);
+    if (entry->auto_wildcard)
+        priv->domain_track.wildcard_num++;
+    _domain_track_node_update_prio(entry->node);
+
+    priv->domain_track.gen++;
+}
+
+static void
+_domain_track_remove_ip_data(NMDnsManager *self, NMDnsConfigIPData *ip_data)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    DomainTrackEntry    *entry;
+
+    if (c_list_is_empty(&ip_data->domain_track_lst_head))
+        return;
+
+    while ((entry = c_list_first_entry(&ip_data->domain_track_lst_head,
+                                       DomainTrackEntry,
+                                       ip_data_lst))) {
+        DomainTrackNode *node = entry->node;
+
+        if (entry->auto_wildcard) {
+            nm_assert(priv->domain_track.wildcard_num > 0);
+            priv->domain_track.wildcard_num--;
+        }
+
+        c_list_unlink_stale(&entry->ip_data_lst);
+        c_list_unlink_stale(&entry->node_lst);
+        nm_g_slice_free(entry);
+
+        _domain_track_node_update_prio(node);
+        _domain_track_node_unref(self, node);
+    }
+
+    priv->domain_track.gen++;
+}
+
+static int
+_domain_track_node_get_prio_min(NMDnsManager *self, const DomainTrackNode *node)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+
+    return NM_MIN(node->prio_min,
+                  priv->domain_track.wildcard_num > 0 ? node->prio_min_auto_wildcard
+                                                      : node->prio_min_auto_non_vpn);
+}
+
+static void
+_domain_track_node_eval(NMDnsManager *self, DomainTrackNode *node)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    DomainTrackNode     *parent;
+    int                  prio_min;
+
+    if (node->eval_gen == priv->domain_track.gen)
+        return;
+
+    parent = node->parent;
+    if (parent) {
+        _domain_track_node_eval(self, parent);
+        node->shadow_prio = parent->shadow_prio;
+        node->shadow_node = parent->shadow_node;
+        if (parent->acc_prio < node->shadow_prio) {
+            node->shadow_prio = parent->acc_prio;
+            node->shadow_node = parent;
+        }
+    } else {
+        node->shadow_prio = G_MAXINT;
+        node->shadow_node = NULL;
+    }
+
+    /* A domain is used by the entries with the lowest priority, unless
+     * an ancestor with a lower, negative priority shadows it. */
+    prio_min = _domain_track_node_get_prio_min(self, node);
+    if (prio_min != G_MAXINT && !(node->shadow_prio < 0 && node->shadow_prio < prio_min))
+        node->acc_prio = prio_min;
+    else
+        node->acc_prio = G_MAXINT;
+
+    node->eval_gen = priv->domain_track.gen;
+}
+
+static DomainTrackResult
+_domain_track_check(NMDnsManager *self,
+                    const char   *domain,
+                    int           priority,
+                    const char  **out_other_domain,
+                    int          *out_other_priority)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    DomainTrackNode     *node;
+
+    node = g_hash_table_lookup(priv->domain_track.nodes, &domain);
+    nm_assert(node);
+
+    _domain_track_node_eval(self, node);
+
+    if (node->acc_prio == priority)
+        return DOMAIN_TRACK_RESULT_ADD;
+
+    if (node->acc_prio < priority) {
+        /* Remove domains with lower priority */
+        *out_other_domain   = node->domain;
+        *out_other_priority = node->acc_prio;
+        return DOMAIN_TRACK_RESULT_DROP_EXISTS;
+    }
+
+    /* the domain is shadowed by a parent domain with more negative priority. */
+    nm_assert(node->shadow_node);
+    nm_assert(node->shadow_prio < 0 && node->shadow_prio < priority);
+    *out_other_domain   = node->shadow_node->domain;
+    *out_other_priority = node->shadow_prio;
+    return DOMAIN_TRACK_RESULT_DROP_SHADOWED;
+}
+
+/*****************************************************************************/
+
 static NMDnsConfigIPData *
 _dns_config_ip_data_new(NMDnsConfigData      *data,
                         int                   addr_family,
@@ -402,16 +810,19 @@ _dns_config_ip_data_new(NMDnsConfigData      *data,
 
     ip_data  = g_slice_new(NMDnsConfigIPData);
     *ip_data = (NMDnsConfigIPData){
-        .data           = data,
-        .source_tag     = source_tag,
-        .l3cd           = nm_l3_config_data_ref_and_seal(l3cd),
-        .ip_config_type = ip_config_type,
-        .addr_family    = addr_family,
+        .data                  = data,
+        .source_tag            = source_tag,
+        .l3cd                  = nm_l3_config_data_ref_and_seal(l3cd),
+        .ip_config_type        = ip_config_type,
+        .addr_family           = addr_family,
+        .domain_track_lst_head = C_LIST_INIT(ip_data->domain_track_lst_head),
     };
     c_list_link_tail(&data->data_lst_head, &ip_data->data_lst);
     c_list_link_tail(&NM_DNS_MANAGER_GET_PRIVATE(data->self)->ip_data_lst_head,
                      &ip_data->ip_data_lst);
 
+    _domain_track_add_ip_data(data->self, ip_data);
+
     /* We also need to set priv->ip_data_lst_need_sort, but the caller will do that! */
 
     _ASSERT_dns_config_ip_data(ip_data);
@@ -423,6 +834,8 @@ _dns_config_ip_data_free(NMDnsConfigIPData *ip_data)
 {
     _ASSERT_dns_config_ip_data(ip_data);
 
+    _domain_track_remove_ip_data(ip_data->data->self, ip_data);
+
     c_list_unlink_stale(&ip_data->data_lst);
     c_list_unlink_stale(&ip_data->ip_data_lst);
 
@@ -433,6 +846,26 @@ _dns_config_ip_data_free(NMDnsConfigIPData *ip_data)
     nm_g_slice_free(ip_data);
 }
 
+static void
+_dns_config_ip_data_set_type(NMDnsConfigIPData *ip_data, NMDnsIPConfigType ip_config_type)
+{
+    gboolean vpn_changed;
+
+    if (ip_data->ip_config_type == ip_config_type)
+        return;
+
+    vpn_changed = ((ip_data->ip_config_type == NM_DNS_IP_CONFIG_TYPE_VPN)
+                   != (ip_config_type == NM_DNS_IP_CONFIG_TYPE_VPN));
+
+    ip_data->ip_config_type = ip_config_type;
+
+    if (vpn_changed) {
+        /* the automatic wildcard domain depends on whether this is a VPN. */
+        _domain_track_remove_ip_data(ip_data->data->self, ip_data);
+        _domain_track_add_ip_data(ip_data->data->self, ip_data);
+    }
+}
+
 static void
 _dns_config_data_free(NMDnsConfigData *data)
 {
@@ -1453,69 +1886,13 @@ get_ip_rdns_domains(int addr_family, const NML3ConfigData *l3cd)
     return nm_strv_cleanup(strv, FALSE, FALSE, TRUE);
 }
 
-static gboolean
-_domain_track_get_priority(GHashTable *ht, const char *domain, int *out_priority)
-{
-    gpointer ptr;
-
-    if (!ht || !g_hash_table_lookup_extended(ht, domain, NULL, &ptr)) {
-        *out_priority = 0;
-        return FALSE;
-    }
-    *out_priority = GPOINTER_TO_INT(ptr);
-    return TRUE;
-}
-
-/* Check if the domain is shadowed by a parent domain with more negative priority */
-static gboolean
-_domain_track_is_shadowed(GHashTable  *ht,
-                          const char  *domain,
-                          int          priority,
-                          const char **out_parent,
-                          int         *out_parent_priority)
-{
-    char *parent;
-    int   parent_priority;
-
-    if (!ht)
-        return FALSE;
-
-    nm_assert(!g_hash_table_contains(ht, domain));
-
-    if (_domain_track_get_priority(ht, "", &parent_priority)) {
-        nm_assert(parent_priority <= priority);
-        if (parent_priority < 0 && parent_priority < priority) {
-            *out_parent          = "";
-            *out_parent_priority = parent_priority;
-            return TRUE;
-        }
-    }
-
-    parent = strchr(domain, '.');
-    while (parent && parent[1]) {
-        parent++;
-        if (_domain_track_get_priority(ht, parent, &parent_priority)) {
-            nm_assert(parent_priority <= priority);
-            if (parent_priority < 0 && parent_priority < priority) {
-                *out_parent          = parent;
-                *out_parent_priority = parent_priority;
-                return TRUE;
-            }
-        }
-        parent = strchr(parent, '.');
-    }
-
-    return FALSE;
-}
-
 static void
 _mgr_configs_data_construct(NMDnsManager *self)
 {
-    NMDnsConfigIPData             *ip_data;
-    gs_unref_hashtable GHashTable *ht               = NULL;
-    gs_unref_hashtable GHashTable *wildcard_entries = NULL;
-    CList                         *head;
-    int                            prev_priority = G_MININT;
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    NMDnsConfigIPData   *ip_data;
+    CList               *head;
+    int                  prev_priority = G_MININT;
 
     head = _mgr_get_ip_data_lst_head(self);
 
@@ -1531,62 +1908,22 @@ _mgr_configs_data_construct(NMDnsManager *self)
     }
 #endif
 
-    c_list_for_each_entry (ip_data, head, ip_data_lst) {
-        gboolean add_wildcard = FALSE;
-        guint    num;
-
-        nm_l3_config_data_get_nameservers(ip_data->l3cd, ip_data->addr_family, &num);
-        if (num == 0)
-            continue;
-        if (nm_l3_config_data_get_best_default_route(ip_data->l3cd, ip_data->addr_family)) {
-            /* FIXME(l3cfg): the best-default route of a l3cd is not significant! */
-            add_wildcard = TRUE;
-        } else {
-            /* If a VPN has never-default=no but doesn't get a default
-             * route (this can happen for example when the server
-             * pushes routes with openconnect), and there are no
-             * search or routing domains, then the name servers pushed
-             * by the server would be unused. It is preferable in this
-             * case to use the VPN DNS server for all queries. */
-            if (ip_data->ip_config_type == NM_DNS_IP_CONFIG_TYPE_VPN
-                && nm_l3_config_data_get_never_default(ip_data->l3cd, ip_data->addr_family)
-                       == NM_TERNARY_FALSE
-                && !nm_l3_config_data_get_searches(ip_data->l3cd, ip_data->addr_family, &num)
-                && !nm_l3_config_data_get_domains(ip_data->l3cd, ip_data->addr_family, &num))
-                add_wildcard = TRUE;
-        }
-
-        if (add_wildcard) {
-            if (!wildcard_entries)
-                wildcard_entries = g_hash_table_new(nm_direct_hash, NULL);
-            g_hash_table_add(wildcard_entries, ip_data);
-        }
-    }
-
     c_list_for_each_entry (ip_data, head, ip_data_lst) {
         int                priority;
         const char       **domains;
-        const char *const *strv_searches;
         const char *const *strv_domains;
-        guint              n_searches;
         guint              n_domains;
         guint              num_dom1;
         guint              num_dom2;
-        guint              n_domains_allocated;
         guint              i;
         gboolean           has_default_route_maybe    = FALSE;
         gboolean           has_default_route_explicit = FALSE;
         gboolean           has_default_route_auto     = FALSE;
-        guint              num;
 
-        nm_l3_config_data_get_nameservers(ip_data->l3cd, ip_data->addr_family, &num);
-        if (num == 0)
+        if (!_dns_config_ip_data_has_nameservers(ip_data))
             continue;
 
-        strv_searches =
-            nm_l3_config_data_get_searches(ip_data->l3cd, ip_data->addr_family, &n_searches);
-        strv_domains =
-            nm_l3_config_data_get_domains(ip_data->l3cd, ip_data->addr_family, &n_domains);
+        strv_domains = _dns_config_ip_data_get_domains(ip_data, &n_domains);
 
         priority = _dns_config_ip_data_get_dns_priority(ip_data);
 
@@ -1596,48 +1933,34 @@ _mgr_configs_data_construct(NMDnsManager *self)
         /* Add wildcard lookup domain to connections with the default route.
          * If there is no default route, add the wildcard domain to all non-VPN
          * connections */
-        if (wildcard_entries) {
+        if (priv->domain_track.wildcard_num > 0) {
             /* FIXME: this heuristic of which device has a default route does
              * not work with policy routing (as used by default with WireGuard).
              * We should have a more stable mechanism where an NMIPConfig indicates
              * whether it is suitable for certain operations (like having an automatically
              * added "~" domain). */
-            if (g_hash_table_contains(wildcard_entries, ip_data))
+            if (_dns_config_ip_data_is_wildcard(ip_data))
                 has_default_route_maybe = TRUE;
         } else {
             if (ip_data->ip_config_type != NM_DNS_IP_CONFIG_TYPE_VPN)
                 has_default_route_maybe = TRUE;
         }
 
-        n_domains_allocated = (n_searches > 0 ? n_searches : n_domains) + 1u;
-        domains             = g_new(const char *, n_domains_allocated);
-
-        num_dom1 = 0;
-
-        /* searches are preferred over domains */
-        if (n_searches > 0) {
-            for (i = 0; i < n_searches; i++)
-                domains[num_dom1++] = strv_searches[i];
-        } else {
-            for (i = 0; i < n_domains; i++)
-                domains[num_dom1++] = strv_domains[i];
-        }
-
-        nm_assert(num_dom1 < n_domains_allocated);
+        num_dom1 = n_domains;
+        domains  = g_new(const char *, num_dom1 + 1u);
 
         num_dom2 = 0;
         for (i = 0; TRUE; i++) {
             const char *domain_full;
             const char *domain_clean;
-            const char *parent;
-            int         old_priority;
-            int         parent_priority;
+            const char *other;
+            int         other_priority;
             gboolean    check_default_route;
 
             if (i < num_dom1) {
                 check_default_route = FALSE;
-                domain_full         = domains[i];
-                domain_clean        = nm_utils_parse_dns_domain(domains[i], NULL);
+                domain_full         = strv_domains[i];
+                domain_clean        = nm_utils_parse_dns_domain(domain_full, NULL);
             } else if (i == num_dom1) {
                 if (!has_default_route_maybe)
                     continue;
@@ -1649,27 +1972,22 @@ _mgr_configs_data_construct(NMDnsManager *self)
             } else
                 break;
 
-            /* Remove domains with lower priority */
-            if (_domain_track_get_priority(ht, domain_clean, &old_priority)) {
-                nm_assert(old_priority <= priority);
-                if (old_priority < priority) {
-                    _LOGT("plugin: drop domain %s%s%s (i=%d, p=%d) because it already exists "
-                          "with p=%d",
-                          NM_PRINT_FMT_QUOTED(!check_default_route,
-                                              "'",
-                                              domain_full,
-                                              "'",
-                                              "<auto-default>"),
-                          ip_data->data->ifindex,
-                          priority,
-                          old_priority);
-                    continue;
-                }
-            } else if (_domain_track_is_shadowed(ht,
-                                                 domain_clean,
-                                                 priority,
-                                                 &parent,
-                                                 &parent_priority)) {
+            switch (_domain_track_check(self, domain_clean, priority, &other, &other_priority)) {
+            case DOMAIN_TRACK_RESULT_ADD:
+                break;
+            case DOMAIN_TRACK_RESULT_DROP_EXISTS:
+                _LOGT("plugin: drop domain %s%s%s (i=%d, p=%d) because it already exists "
+                      "with p=%d",
+                      NM_PRINT_FMT_QUOTED(!check_default_route,
+                                          "'",
+                                          domain_full,
+                                          "'",
+                                          "<auto-default>"),
+                      ip_data->data->ifindex,
+                      priority,
+                      other_priority);
+                continue;
+            case DOMAIN_TRACK_RESULT_DROP_SHADOWED:
                 _LOGT("plugin: drop domain %s%s%s (i=%d, p=%d) shadowed by '%s' (p=%d)",
                       NM_PRINT_FMT_QUOTED(!check_default_route,
                                           "'",
@@ -1678,8 +1996,8 @@ _mgr_configs_data_construct(NMDnsManager *self)
                                           "<auto-default>"),
                       ip_data->data->ifindex,
                       priority,
-                      parent,
-                      parent_priority);
+                      other,
+                      other_priority);
                 continue;
             }
 
@@ -1689,21 +2007,16 @@ _mgr_configs_data_construct(NMDnsManager *self)
                 ip_data->data->ifindex,
                 priority);
 
-            if (!ht)
-                ht = g_hash_table_new(nm_str_hash, g_str_equal);
-            g_hash_table_insert(ht, (gpointer) domain_clean, GINT_TO_POINTER(priority));
-
             if (check_default_route)
                 has_default_route_auto = TRUE;
             else {
                 nm_assert(num_dom2 <= num_dom1);
-                nm_assert(num_dom2 < n_domains_allocated);
                 domains[num_dom2++] = domain_full;
                 if (domain_clean[0] == '\0')
                     has_default_route_explicit = TRUE;
             }
         }
-        nm_assert(num_dom2 < n_domains_allocated);
+        nm_assert(num_dom2 <= num_dom1);
         domains[num_dom2] = NULL;
 
         nm_assert(!ip_data->domains.search);
@@ -1751,10 +2064,44 @@ _mgr_configs_data_clear(NMDnsManager *self)
     }
 }
 
+char *
+nmtst_dns_manager_get_domains(NMDnsManager *self)
+{
+    NMDnsConfigIPData *ip_data;
+    GString           *str;
+
+    g_return_val_if_fail(NM_IS_DNS_MANAGER(self), NULL);
+
+    /* Returns the domains that each ip_data gets, in the order of the ip_data,
+     * like "1: a.com,<auto-default>; 2: ~b.com". */
+    str = g_string_new(NULL);
+
+    _mgr_configs_data_construct(self);
+
+    c_list_for_each_entry (ip_data, _mgr_get_ip_data_lst_head(self), ip_data_lst) {
+        gsize i;
+
+        if (!ip_data->domains.search)
+            continue;
+
+        if (str->len > 0)
+            g_string_append(str, "; ");
+        g_string_append_printf(str, "%d:", ip_data->data->ifindex);
+        for (i = 0; ip_data->domains.search[i]; i++)
+            g_string_append_printf(str, "%s%s", i == 0 ? " " : ",", ip_data->domains.search[i]);
+        if (ip_data->domains.has_default_route && !ip_data->domains.has_default_route_explicit)
+            g_string_append_printf(str, "%s<auto-default>", i == 0 ? " " : ",");
+    }
+
+    _mgr_configs_data_clear(self);
+
+    return g_string_free(str, FALSE);
+}
+
 /*****************************************************************************/
 
 static gboolean
-update_dns(NMDnsManager *self, gboolean no_caching, gboolean force_emit, GError **error)
+_update_dns(NMDnsManager *self, gboolean no_caching, gboolean force_emit, GError **error)
 {
     NMDnsManagerPrivate  *priv                = NM_DNS_MANAGER_GET_PRIVATE(self);
     const char           *nis_domain          = NULL;
@@ -1858,6 +2205,11 @@ plugin_skip:;
                                NM_CAST_STRV_CC(nameservers),
                                NM_CAST_STRV_CC(options));
 
+    /* Remember the upstream name servers before they get replaced by the
+     * address of the local caching resolver below. */
+    g_strfreev(priv->upstream_nameservers);
+    priv->upstream_nameservers = g_strdupv(nameservers);
+
     /* If caching was successful, we only send 127.0.1.1 to /etc/resolv.conf
      * to ensure that the glibc resolver doesn't try to round-robin nameservers,
      * but only uses the local caching nameserver.
@@ -1870,7 +2222,8 @@ plugin_skip:;
         if (NM_IS_DNS_SYSTEMD_RESOLVED(priv->plugin)) {
             /* systemd-resolved uses a different link-local address */
             lladdr = "127.0.0.53";
-        }
+        } else if (NM_IS_DNS_STUB(priv->plugin))
+            lladdr = NM_DNS_STUB_DEFAULT_LISTEN_ADDRESS;
 
         g_strfreev(nameservers);
         nameservers    = g_new0(char *, 2);
@@ -1984,6 +2337,123 @@ plugin_skip:;
     return TRUE;
 }
 
+static gboolean
+update_dns(NMDnsManager *self, gboolean no_caching, gboolean force_emit, GError **error)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    gboolean             success;
+
+    success = _update_dns(self, no_caching, force_emit, error);
+
+    priv->update_dns_schedule.last_msec = nm_utils_get_monotonic_timestamp_msec();
+
+    /* Any update commits all pending changes, so a scheduled update is
+     * no longer necessary. We only clear it now, so that "update-pending"
+     * does not flip while the plugins are being updated. */
+    if (nm_clear_g_source_inst(&priv->update_dns_schedule.source))
+        _update_pending_maybe_changed(self);
+
+    return success;
+}
+
+static gboolean
+_update_dns_schedule_cb(gpointer user_data)
+{
+    NMDnsManager         *self  = user_data;
+    gs_free_error GError *error = NULL;
+
+    _LOGT("update-dns: commit coalesced changes");
+
+    if (!update_dns(self, FALSE, FALSE, &error))
+        _LOGW("could not commit DNS changes: %s", error->message);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+_update_dns_schedule(NMDnsManager *self)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    gint64               now_msec;
+    gint64               deadline_msec;
+
+    nm_assert(priv->updates_queue == 0);
+
+    if (priv->update_dns_schedule.min_interval_msec == 0) {
+        gs_free_error GError *error = NULL;
+
+        /* Coalescing is disabled. Commit right away. */
+        if (!update_dns(self, FALSE, FALSE, &error))
+            _LOGW("could not commit DNS changes: %s", error->message);
+        return;
+    }
+
+    /* When many interfaces change their configuration in a short time (for
+     * example, on mass activation), we don't want to rewrite resolv.conf
+     * and reconfigure the plugins for every single change.
+     *
+     * A change after a quiet period is committed right away (on idle). Otherwise,
+     * the commit is delayed until there were no further changes for
+     * "min_interval_msec", but at most "max_latency_msec" after the first
+     * pending change. */
+
+    now_msec = nm_utils_get_monotonic_timestamp_msec();
+
+    if (!priv->update_dns_schedule.source) {
+        deadline_msec = priv->update_dns_schedule.last_msec
+                        + priv->update_dns_schedule.min_interval_msec;
+        deadline_msec = NM_MAX(deadline_msec, now_msec);
+
+        priv->update_dns_schedule.first_msec = now_msec;
+    } else {
+        if (priv->update_dns_schedule.deadline_msec <= now_msec) {
+            /* The update is about to be committed. */
+            return;
+        }
+        deadline_msec = NM_MIN(now_msec + priv->update_dns_schedule.min_interval_msec,
+                               priv->update_dns_schedule.first_msec
+                                   + priv->update_dns_schedule.max_latency_msec);
+        if (deadline_msec <= priv->update_dns_schedule.deadline_msec)
+            return;
+        nm_clear_g_source_inst(&priv->update_dns_schedule.source);
+    }
+
+    priv->update_dns_schedule.deadline_msec = deadline_msec;
+    priv->update_dns_schedule.source =
+        nm_g_timeout_add_source(deadline_msec - now_msec, _update_dns_schedule_cb, self);
+
+    _LOGT("update-dns: commit changes in %" G_GINT64_FORMAT " msec", deadline_msec - now_msec);
+
+    _update_pending_maybe_changed(self);
+}
+
+static void
+_update_dns_schedule_read_config(NMDnsManager *self)
+{
+    NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
+    NMConfigData        *data = nm_config_get_data(priv->config);
+
+    priv->update_dns_schedule.min_interval_msec =
+        nm_config_data_get_value_int64(data,
+                                       NM_CONFIG_KEYFILE_GROUP_MAIN,
+                                       NM_CONFIG_KEYFILE_KEY_MAIN_DNS_UPDATE_MIN_INTERVAL,
+                                       10,
+                                       0,
+                                       G_MAXINT32,
+                                       UPDATE_DNS_MIN_INTERVAL_MSEC_DEFAULT);
+    priv->update_dns_schedule.max_latency_msec =
+        nm_config_data_get_value_int64(data,
+                                       NM_CONFIG_KEYFILE_GROUP_MAIN,
+                                       NM_CONFIG_KEYFILE_KEY_MAIN_DNS_UPDATE_MAX_LATENCY,
+                                       10,
+                                       0,
+                                       G_MAXINT32,
+                                       UPDATE_DNS_MAX_LATENCY_MSEC_DEFAULT);
+    priv->update_dns_schedule.max_latency_msec =
+        NM_MAX(priv->update_dns_schedule.max_latency_msec,
+               priv->update_dns_schedule.min_interval_msec);
+}
+
 gboolean
 nm_dns_manager_is_unmanaged(NMDnsManager *self)
 {
@@ -2131,8 +2601,8 @@ nm_dns_manager_set_ip_config(NMDnsManager         *self,
             changed = TRUE;
         }
     } else {
-        ip_data->ip_config_type = ip_config_type;
-        changed                 = TRUE;
+        _dns_config_ip_data_set_type(ip_data, ip_config_type);
+        changed = TRUE;
     }
 
     p_best = NM_IS_IPv4(addr_family) ? &priv->best_ip_config_4 : &priv->best_ip_config_6;
@@ -2140,7 +2610,7 @@ nm_dns_manager_set_ip_config(NMDnsManager         *self,
         /* Only one best-device per IP version is allowed */
         if (*p_best != ip_data) {
             if (*p_best)
-                (*p_best)->ip_config_type = NM_DNS_IP_CONFIG_TYPE_DEFAULT;
+                _dns_config_ip_data_set_type(*p_best, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
             *p_best = ip_data;
         }
     } else {
@@ -2167,12 +2637,8 @@ done:
     if (data && c_list_is_empty(&data->data_lst_head))
         g_hash_table_remove(priv->configs_dict, data);
 
-    if (!priv->updates_queue) {
-        gs_free_error GError *error = NULL;
-
-        if (!update_dns(self, FALSE, FALSE, &error))
-            _LOGW("could not commit DNS changes: %s", error->message);
-    }
+    if (!priv->updates_queue)
+        _update_dns_schedule(self);
 
     return TRUE;
 }
@@ -2223,12 +2689,8 @@ nm_dns_manager_set_hostname(NMDnsManager *self, const char *hostname, gboolean s
     if (skip_update)
         return;
 
-    if (!priv->updates_queue) {
-        gs_free_error GError *error = NULL;
-
-        if (!update_dns(self, FALSE, FALSE, &error))
-            _LOGW("could not commit DNS changes: %s", error->message);
-    }
+    if (!priv->updates_queue)
+        _update_dns_schedule(self);
 }
 
 void
@@ -2294,7 +2756,8 @@ nm_dns_manager_stop(NMDnsManager *self)
      * done any DNS updates yet, there's no reason to touch resolv.conf
      * on shutdown.
      */
-    if (priv->dns_touched && priv->plugin && NM_IS_DNS_DNSMASQ(priv->plugin)) {
+    if (priv->dns_touched && priv->plugin
+        && (NM_IS_DNS_DNSMASQ(priv->plugin) || NM_IS_DNS_STUB(priv->plugin))) {
         gs_free_error GError *error = NULL;
 
         if (!update_dns(self, TRUE, FALSE, &error))
@@ -2304,6 +2767,9 @@ nm_dns_manager_stop(NMDnsManager *self)
     }
 
     priv->is_stopped = TRUE;
+
+    if (nm_clear_g_source_inst(&priv->update_dns_schedule.source))
+        _update_pending_maybe_changed(self);
 }
 
 /*****************************************************************************/
@@ -2525,6 +2991,12 @@ again:
             priv->plugin   = nm_dns_dnsmasq_new();
             plugin_changed = TRUE;
         }
+    } else if (nm_streq0(mode, "stub")) {
+        if (force_reload_plugin || !NM_IS_DNS_STUB(priv->plugin)) {
+            _clear_plugin(self);
+            priv->plugin   = nm_dns_stub_new();
+            plugin_changed = TRUE;
+        }
     } else {
         if (!NM_IN_STRSET(mode, "none", "default")) {
             if (mode) {
@@ -2632,6 +3104,9 @@ config_changed_cb(NMConfig           *config,
 {
     NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE(self);
 
+    if (NM_FLAGS_HAS(changes, NM_CONFIG_CHANGE_VALUES))
+        _update_dns_schedule_read_config(self);
+
     if (NM_FLAGS_ANY(changes,
                      NM_CONFIG_CHANGE_DNS_MODE | NM_CONFIG_CHANGE_RC_MANAGER
                          | NM_CONFIG_CHANGE_CAUSE_SIGHUP | NM_CONFIG_CHANGE_CAUSE_DNS_FULL)) {
@@ -2844,7 +3319,12 @@ nm_dns_manager_init(NMDnsManager *self)
                                                (GDestroyNotify) _dns_config_data_free,
                                                NULL);
 
+    G_STATIC_ASSERT_EXPR(G_STRUCT_OFFSET(DomainTrackNode, domain) == 0);
+    priv->domain_track.nodes = g_hash_table_new(nm_pstr_hash, nm_pstr_equal);
+    priv->domain_track.gen   = 1;
+
     compute_hash(self, NULL, NM_DNS_MANAGER_GET_PRIVATE(self)->hash);
+    _update_dns_schedule_read_config(self);
     g_signal_connect(G_OBJECT(priv->config),
                      NM_CONFIG_SIGNAL_CONFIG_CHANGED,
                      G_CALLBACK(config_changed_cb),
@@ -2871,6 +3351,7 @@ dispose(GObject *object)
     _clear_plugin(self);
 
     nm_clear_g_source_inst(&priv->update_pending_unblock);
+    nm_clear_g_source_inst(&priv->update_dns_schedule.source);
 
     priv->best_ip_config_4 = NULL;
     priv->best_ip_config_6 = NULL;
@@ -2881,6 +3362,9 @@ dispose(GObject *object)
     nm_clear_pointer(&priv->configs_dict, g_hash_table_destroy);
     nm_assert(c_list_is_empty(&priv->configs_lst_head));
 
+    nm_assert(!priv->domain_track.nodes || g_hash_table_size(priv->domain_track.nodes) == 0);
+    nm_clear_pointer(&priv->domain_track.nodes, g_hash_table_destroy);
+
     nm_clear_g_source(&priv->plugin_ratelimit.timer);
 
     g_clear_object(&priv->config);
@@ -2898,6 +3382,7 @@ finalize(GObject *object)
 
     g_free(priv->hostdomain);
     g_free(priv->mode);
+    g_strfreev(priv->upstream_nameservers);
 
     G_OBJECT_CLASS(nm_dns_manager_parent_class)->finalize(object);
 }
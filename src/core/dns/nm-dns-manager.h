@@ -23,6 +23,10 @@ typedef struct {
     CList                    ip_data_lst;
     NMDnsIPConfigType        ip_config_type;
     int                      addr_family;
+
+    /* The entries of this ip_data in the domain tracking trie of NMDnsManager. */
+    CList domain_track_lst_head;
+
     struct {
         const char **search;
         char       **reverse;
@@ -142,12 +146,16 @@ NMDnsPlugin *nm_dns_manager_get_systemd_resolved(NMDnsManager *self);
 
 gboolean nm_dns_manager_get_update_pending(NMDnsManager *self);
 
+const char *const *nm_dns_manager_get_upstream_nameservers(NMDnsManager *self);
+
 /*****************************************************************************/
 
 char *nmtst_dns_create_resolv_conf(const char *const *searches,
                                    const char *const *nameservers,
                                    const char *const *options);
 
+char *nmtst_dns_manager_get_domains(NMDnsManager *self);
+
 gboolean nm_dns_manager_is_unmanaged(NMDnsManager *self);
 
 #endif /* __NETWORKMANAGER_DNS_MANAGER_H__ */
@@ -0,0 +1,391 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "src/core/nm-default-daemon.h"
+
+#include "nm-dns-stub.h"
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "libnm-glib-aux/nm-io-utils.h"
+#include "libnm-core-intern/nm-core-internal.h"
+#include "libnm-platform/nm-platform.h"
+#include "nm-dns-stub/nm-dns-stub-server.h"
+#include "NetworkManagerUtils.h"
+#include "nm-l3-config-data.h"
+#include "nm-utils.h"
+
+#define STUB_BINARY      LIBEXECDIR "/nm-dns-stub"
+#define STUB_CONFIG_FILE NMRUNDIR "/dns-stub.conf"
+
+#define RATELIMIT_INTERVAL_MSEC 30000
+#define RATELIMIT_BURST         5
+
+#define WAIT_MSEC_AFTER_SIGTERM 1000
+
+#define _NMLOG_DOMAIN LOGD_DNS
+
+/*****************************************************************************/
+
+#define _NMLOG(level, ...) __NMLOG_DEFAULT(level, _NMLOG_DOMAIN, "dns-stub", __VA_ARGS__)
+
+/*****************************************************************************/
+
+typedef struct {
+    GSource *child_watch_source;
+    GSource *respawn_source;
+
+    /* The configuration that was last written to STUB_CONFIG_FILE. */
+    char *config_data;
+
+    gint64 burst_start_at;
+
+    GPid pid;
+
+    guint burst_count;
+
+    bool is_stopped : 1;
+} NMDnsStubPrivate;
+
+struct _NMDnsStub {
+    NMDnsPlugin      parent;
+    NMDnsStubPrivate _priv;
+};
+
+struct _NMDnsStubClass {
+    NMDnsPluginClass parent;
+};
+
+G_DEFINE_TYPE(NMDnsStub, nm_dns_stub, NM_TYPE_DNS_PLUGIN)
+
+#define NM_DNS_STUB_GET_PRIVATE(self) _NM_GET_PRIVATE(self, NMDnsStub, NM_IS_DNS_STUB, NMDnsPlugin)
+
+/*****************************************************************************/
+
+static void
+_config_add_upstream(GKeyFile          *keyfile,
+                     guint             *p_idx,
+                     int                addr_family,
+                     const NMIPAddr    *addr,
+                     int                ifindex,
+                     const char        *ifname,
+                     const char *const *domains,
+                     gsize              n_domains)
+{
+    char group[50];
+    char addr_buf[NM_INET_ADDRSTRLEN];
+
+    if (n_domains == 0)
+        return;
+
+    nm_sprintf_buf(group, "upstream-%u", (*p_idx)++);
+    g_key_file_set_string(keyfile, group, "address", nm_inet_ntop(addr_family, addr, addr_buf));
+    if (ifindex > 0)
+        g_key_file_set_integer(keyfile, group, "ifindex", ifindex);
+    if (ifname)
+        g_key_file_set_string(keyfile, group, "interface", ifname);
+    g_key_file_set_string_list(keyfile, group, "domains", domains, n_domains);
+
+    _LOGD("adding upstream %s%s%s",
+          addr_buf,
+          NM_PRINT_FMT_QUOTED(ifname, " on \"", ifname, "\"", ""));
+}
+
+static void
+_config_add_global(GKeyFile *keyfile, guint *p_idx, const NMGlobalDnsConfig *global_config)
+{
+    guint i;
+    guint j;
+
+    for (i = 0; i < nm_global_dns_config_get_num_domains(global_config); i++) {
+        NMGlobalDnsDomain *domain  = nm_global_dns_config_get_domain(global_config, i);
+        const char *const *servers = nm_global_dns_domain_get_servers(domain);
+        const char        *name    = nm_global_dns_domain_get_name(domain);
+
+        for (j = 0; servers && servers[j]; j++) {
+            NMIPAddr a;
+            int      addr_family;
+
+            if (!nm_inet_parse_bin(AF_UNSPEC, servers[j], &addr_family, &a))
+                continue;
+
+            _config_add_upstream(keyfile,
+                                 p_idx,
+                                 addr_family,
+                                 &a,
+                                 0,
+                                 NULL,
+                                 NM_MAKE_STRV(nm_streq(name, "*") ? "." : name),
+                                 1);
+        }
+    }
+}
+
+static void
+_config_add_ip_data(GKeyFile *keyfile, guint *p_idx, const NMDnsConfigIPData *ip_data)
+{
+    gs_unref_ptrarray GPtrArray *domains = NULL;
+    const char *const           *strarr;
+    const char                  *ifname;
+    guint                        num;
+    guint                        i;
+
+    domains = g_ptr_array_new();
+
+    /* Same routing as with dnsmasq: the device is used as default server
+     * only if it has a default route, and otherwise only for its search and
+     * reverse domains. */
+    if (!ip_data->domains.has_default_route_explicit && ip_data->domains.has_default_route)
+        g_ptr_array_add(domains, ".");
+    for (i = 0; ip_data->domains.search && ip_data->domains.search[i]; i++) {
+        const char *domain = nm_utils_parse_dns_domain(ip_data->domains.search[i], NULL);
+
+        g_ptr_array_add(domains, (gpointer) (domain[0] ? domain : "."));
+    }
+    for (i = 0; ip_data->domains.reverse && ip_data->domains.reverse[i]; i++)
+        g_ptr_array_add(domains, ip_data->domains.reverse[i]);
+
+    if (domains->len == 0)
+        return;
+
+    ifname = nm_platform_link_get_name(NM_PLATFORM_GET, ip_data->data->ifindex);
+
+    strarr = nm_l3_config_data_get_nameservers(ip_data->l3cd, ip_data->addr_family, &num);
+    for (i = 0; i < num; i++) {
+        NMIPAddr a;
+
+        if (!nm_utils_dnsname_parse_assert(ip_data->addr_family, strarr[i], NULL, &a, NULL))
+            continue;
+
+        _config_add_upstream(keyfile,
+                             p_idx,
+                             ip_data->addr_family,
+                             &a,
+                             ip_data->data->ifindex,
+                             ifname,
+                             (const char *const *) domains->pdata,
+                             domains->len);
+    }
+}
+
+static char *
+_config_create(const NMGlobalDnsConfig *global_config, const CList *ip_data_lst_head)
+{
+    nm_auto_unref_keyfile GKeyFile *keyfile = NULL;
+    const NMDnsConfigIPData        *ip_data;
+    guint                           idx = 0;
+
+    keyfile = g_key_file_new();
+
+    g_key_file_set_string(keyfile, "main", "listen", NM_DNS_STUB_DEFAULT_LISTEN_ADDRESS);
+
+    if (global_config)
+        _config_add_global(keyfile, &idx, global_config);
+
+    if (!global_config || !nm_global_dns_config_lookup_domain(global_config, "*")) {
+        c_list_for_each_entry (ip_data, ip_data_lst_head, ip_data_lst)
+            _config_add_ip_data(keyfile, &idx, ip_data);
+    }
+
+    return g_key_file_to_data(keyfile, NULL, NULL);
+}
+
+/*****************************************************************************/
+
+static gboolean start_stub(NMDnsStub *self, GError **error);
+
+static void
+_child_watch_cb(GPid pid, int status, gpointer user_data)
+{
+    NMDnsStub        *self = user_data;
+    NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE(self);
+
+    nm_assert(pid == priv->pid);
+
+    if (WIFEXITED(status))
+        _LOGW("process %" G_PID_FORMAT " exited with status %d", pid, WEXITSTATUS(status));
+    else if (WIFSIGNALED(status))
+        _LOGW("process %" G_PID_FORMAT " killed by signal %d", pid, WTERMSIG(status));
+    else
+        _LOGW("process %" G_PID_FORMAT " died", pid);
+
+    nm_clear_g_source_inst(&priv->child_watch_source);
+    priv->pid = 0;
+
+    if (!priv->is_stopped)
+        start_stub(self, NULL);
+}
+
+static gboolean
+_respawn_timeout_cb(gpointer user_data)
+{
+    NMDnsStub        *self = user_data;
+    NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE(self);
+
+    nm_clear_g_source_inst(&priv->respawn_source);
+    start_stub(self, NULL);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+start_stub(NMDnsStub *self, GError **error)
+{
+    NMDnsStubPrivate *priv    = NM_DNS_STUB_GET_PRIVATE(self);
+    gs_strfreev char **envp   = NULL;
+    const char        *argv[] = {STUB_BINARY, STUB_CONFIG_FILE, NULL};
+    gint64             now;
+    GPid               pid;
+
+    if (priv->pid > 0 || priv->respawn_source)
+        return TRUE;
+
+    now = nm_utils_get_monotonic_timestamp_msec();
+    if (priv->burst_start_at == 0 || now > priv->burst_start_at + RATELIMIT_INTERVAL_MSEC) {
+        priv->burst_start_at = now;
+        priv->burst_count    = 0;
+    } else if (priv->burst_count >= RATELIMIT_BURST) {
+        _LOGW("nm-dns-stub dies and gets respawned too quickly. Back off. Something is very "
+              "wrong");
+        priv->respawn_source =
+            nm_g_timeout_add_source(priv->burst_start_at + RATELIMIT_INTERVAL_MSEC - now,
+                                    _respawn_timeout_cb,
+                                    self);
+        return TRUE;
+    }
+    priv->burst_count++;
+
+    envp = g_get_environ();
+    if (_LOGT_ENABLED())
+        envp = g_environ_setenv(envp, "NM_DNS_STUB_LOG", "trace", TRUE);
+    else if (_LOGD_ENABLED())
+        envp = g_environ_setenv(envp, "NM_DNS_STUB_LOG", "debug", TRUE);
+
+    _LOGD("starting %s", STUB_BINARY);
+
+    if (!g_spawn_async(NULL,
+                       (char **) argv,
+                       envp,
+                       G_SPAWN_DO_NOT_REAP_CHILD,
+                       nm_utils_setpgid,
+                       NULL,
+                       &pid,
+                       error))
+        return FALSE;
+
+    _LOGD("started with pid %" G_PID_FORMAT, pid);
+
+    priv->pid                = pid;
+    priv->child_watch_source = nm_g_child_watch_add_source(pid, _child_watch_cb, self);
+    return TRUE;
+}
+
+static void
+stop_stub(NMDnsStub *self)
+{
+    NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE(self);
+
+    nm_clear_g_source_inst(&priv->respawn_source);
+    nm_clear_g_source_inst(&priv->child_watch_source);
+
+    if (priv->pid > 0) {
+        nm_utils_kill_child_async(nm_steal_int(&priv->pid),
+                                  SIGTERM,
+                                  LOGD_DNS,
+                                  "nm-dns-stub",
+                                  WAIT_MSEC_AFTER_SIGTERM,
+                                  NULL,
+                                  NULL);
+    }
+
+    nm_clear_g_free(&priv->config_data);
+}
+
+/*****************************************************************************/
+
+static gboolean
+update(NMDnsPlugin             *plugin,
+       const NMGlobalDnsConfig *global_config,
+       const CList             *ip_data_lst_head,
+       const char              *hostdomain,
+       GError                 **error)
+{
+    NMDnsStub        *self        = NM_DNS_STUB(plugin);
+    NMDnsStubPrivate *priv        = NM_DNS_STUB_GET_PRIVATE(self);
+    gs_free char     *config_data = NULL;
+
+    priv->is_stopped = FALSE;
+
+    config_data = _config_create(global_config, ip_data_lst_head);
+
+    if (!nm_streq0(config_data, priv->config_data)) {
+        if (!nm_utils_file_set_contents(STUB_CONFIG_FILE,
+                                        config_data,
+                                        -1,
+                                        0600,
+                                        NULL,
+                                        NULL,
+                                        error))
+            return FALSE;
+
+        nm_clear_g_free(&priv->config_data);
+        priv->config_data = g_steal_pointer(&config_data);
+
+        /* A running process picks up the new configuration on SIGHUP. It only
+         * flushes its cache if the upstreams actually changed. */
+        if (priv->pid > 0) {
+            _LOGD("reload configuration of process %" G_PID_FORMAT, priv->pid);
+            kill(priv->pid, SIGHUP);
+        }
+    }
+
+    return start_stub(self, error);
+}
+
+static void
+stop(NMDnsPlugin *plugin)
+{
+    NMDnsStub        *self = NM_DNS_STUB(plugin);
+    NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE(self);
+
+    priv->is_stopped = TRUE;
+    stop_stub(self);
+}
+
+/*****************************************************************************/
+
+static void
+nm_dns_stub_init(NMDnsStub *self)
+{}
+
+NMDnsPlugin *
+nm_dns_stub_new(void)
+{
+    return g_object_new(NM_TYPE_DNS_STUB, NULL);
+}
+
+static void
+dispose(GObject *object)
+{
+    NMDnsStub        *self = NM_DNS_STUB(object);
+    NMDnsStubPrivate *priv = NM_DNS_STUB_GET_PRIVATE(self);
+
+    priv->is_stopped = TRUE;
+    stop_stub(self);
+
+    G_OBJECT_CLASS(nm_dns_stub_parent_class)->dispose(object);
+}
+
+static void
+nm_dns_stub_class_init(NMDnsStubClass *dns_class)
+{
+    NMDnsPluginClass *plugin_class = NM_DNS_PLUGIN_CLASS(dns_class);
+    GObjectClass     *object_class = G_OBJECT_CLASS(dns_class);
+
+    object_class->dispose = dispose;
+
+    plugin_class->plugin_name = "stub";
+    plugin_class->is_caching  = TRUE;
+    plugin_class->stop        = stop;
+    plugin_class->update      = update;
+}
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#ifndef __NETWORKMANAGER_DNS_STUB_H__
+#define __NETWORKMANAGER_DNS_STUB_H__
+
+#include "nm-dns-plugin.h"
+#include "nm-dns-manager.h"
+
+#define NM_TYPE_DNS_STUB (nm_dns_stub_get_type())
+#define NM_DNS_STUB(obj) (_NM_G_TYPE_CHECK_INSTANCE_CAST((obj), NM_TYPE_DNS_STUB, NMDnsStub))
+#define NM_DNS_STUB_CLASS(klass) \
+    (G_TYPE_CHECK_CLASS_CAST((klass), NM_TYPE_DNS_STUB, NMDnsStubClass))
+#define NM_IS_DNS_STUB(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj), NM_TYPE_DNS_STUB))
+#define NM_IS_DNS_STUB_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), NM_TYPE_DNS_STUB))
+#define NM_DNS_STUB_GET_CLASS(obj) \
+    (G_TYPE_INSTANCE_GET_CLASS((obj), NM_TYPE_DNS_STUB, NMDnsStubClass))
+
+typedef struct _NMDnsStub      NMDnsStub;
+typedef struct _NMDnsStubClass NMDnsStubClass;
+
+GType nm_dns_stub_get_type(void);
+
+NMDnsPlugin *nm_dns_stub_new(void);
+
+#endif /* __NETWORKMANAGER_DNS_STUB_H__ */
@@ -54,6 +54,14 @@ typedef struct {
     int                   ref_count;
 } RequestItem;
 
+/* The argument of the last request for an operation on a link that
+ * we sent to systemd-resolved. */
+typedef struct {
+    const char *operation;
+    GVariant   *argument;
+    int         ifindex;
+} AppliedItem;
+
 struct _NMDnsSystemdResolvedResolveHandle {
     CList                 handle_lst;
     NMDnsSystemdResolved *self;
@@ -78,6 +86,7 @@ struct _NMDnsSystemdResolvedResolveHandle {
 typedef struct {
     GDBusConnection *dbus_connection;
     GHashTable      *dirty_interfaces;
+    GHashTable      *applied_items;
     GCancellable    *cancellable;
     GCancellable    *service_start_cancellable;
     CList            request_queue_lst_head;
@@ -260,6 +269,90 @@ _request_item_append(NMDnsSystemdResolved *self,
 
 /*****************************************************************************/
 
+static guint
+_applied_item_hash(gconstpointer ptr)
+{
+    const AppliedItem *item = ptr;
+    NMHashState        h;
+
+    nm_hash_init(&h, 1763441273u);
+    nm_hash_update_str(&h, item->operation);
+    nm_hash_update_val(&h, item->ifindex);
+    return nm_hash_complete(&h);
+}
+
+static gboolean
+_applied_item_equal(gconstpointer ptr_a, gconstpointer ptr_b)
+{
+    const AppliedItem *a = ptr_a;
+    const AppliedItem *b = ptr_b;
+
+    return a->ifindex == b->ifindex && nm_streq(a->operation, b->operation);
+}
+
+static void
+_applied_item_free(AppliedItem *item)
+{
+    g_variant_unref(item->argument);
+    nm_g_slice_free(item);
+}
+
+static gboolean
+_applied_item_is_unchanged(NMDnsSystemdResolved *self, const RequestItem *request_item)
+{
+    NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE(self);
+    const AppliedItem           *item;
+    AppliedItem                  needle;
+
+    needle = (AppliedItem){
+        .operation = request_item->operation,
+        .ifindex   = request_item->ifindex,
+    };
+    item = g_hash_table_lookup(priv->applied_items, &needle);
+    return item && g_variant_equal(item->argument, request_item->argument);
+}
+
+static void
+_applied_item_set(NMDnsSystemdResolved *self,
+                  const char           *operation,
+                  int                   ifindex,
+                  GVariant             *argument)
+{
+    NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE(self);
+    AppliedItem                 *item;
+
+    item  = g_slice_new(AppliedItem);
+    *item = (AppliedItem){
+        .operation = operation,
+        .ifindex   = ifindex,
+        .argument  = g_variant_ref(argument),
+    };
+    g_hash_table_add(priv->applied_items, item);
+}
+
+static void
+_applied_item_drop(NMDnsSystemdResolved *self,
+                   const char           *operation,
+                   int                   ifindex,
+                   GVariant             *argument)
+{
+    NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE(self);
+    const AppliedItem           *item;
+    AppliedItem                  needle;
+
+    needle = (AppliedItem){
+        .operation = operation,
+        .ifindex   = ifindex,
+    };
+    item = g_hash_table_lookup(priv->applied_items, &needle);
+
+    /* Only forget the argument if no newer request was sent in the meantime. */
+    if (item && item->argument == argument)
+        g_hash_table_remove(priv->applied_items, item);
+}
+
+/*****************************************************************************/
+
 static void
 _interface_config_free(InterfaceConfig *config)
 {
@@ -270,8 +363,9 @@ _interface_config_free(InterfaceConfig *config)
 static void
 call_done(GObject *source, GAsyncResult *r, gpointer user_data)
 {
-    gs_unref_variant GVariant   *v     = NULL;
-    gs_free_error GError        *error = NULL;
+    gs_unref_variant GVariant   *v        = NULL;
+    gs_unref_variant GVariant   *argument = NULL;
+    gs_free_error GError        *error    = NULL;
     NMDnsSystemdResolved        *self;
     NMDnsSystemdResolvedPrivate *priv;
     RequestItem                 *request_item;
@@ -284,6 +378,7 @@ call_done(GObject *source, GAsyncResult *r, gpointer user_data)
     self         = request_item->self;
     operation    = request_item->operation;
     ifindex      = request_item->ifindex;
+    argument     = g_variant_ref(request_item->argument);
     _request_item_unref(request_item);
 
     priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE(self);
@@ -313,6 +408,10 @@ call_done(GObject *source, GAsyncResult *r, gpointer user_data)
         goto out_dec_pending;
     }
 
+    /* The request failed, and systemd-resolved might not have the configuration.
+     * Send it again with the next update. */
+    _applied_item_drop(self, operation, ifindex, argument);
+
     if (nm_g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
         if (operation == DBUS_OP_SET_LINK_DEFAULT_ROUTE) {
             if (priv->has_set_link_default_route == NM_TERNARY_DEFAULT) {
@@ -362,6 +461,7 @@ out_dec_pending:
     }
 
     if (reconfigure) {
+        g_hash_table_remove_all(priv->applied_items);
         priv->send_updates_waiting = TRUE;
         send_updates(self);
     }
@@ -689,6 +789,7 @@ send_updates(NMDnsSystemdResolved *self)
     NMDnsSystemdResolvedPrivate       *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE(self);
     RequestItem                       *request_item;
     NMDnsSystemdResolvedResolveHandle *handle;
+    guint                              n_unchanged = 0;
 
     if (!priv->send_updates_waiting) {
         /* nothing to do. */
@@ -727,6 +828,13 @@ send_updates(NMDnsSystemdResolved *self)
             continue;
         }
 
+        if (_applied_item_is_unchanged(self, request_item)) {
+            /* systemd-resolved already has this configuration for the link. Only
+             * links whose configuration changed need to be updated. */
+            n_unchanged++;
+            continue;
+        }
+
         _LOGT("send-updates: %s ( %s )",
               request_item->operation,
               (ss = g_variant_print(request_item->argument, FALSE)));
@@ -749,8 +857,19 @@ send_updates(NMDnsSystemdResolved *self)
                                priv->cancellable,
                                call_done,
                                _request_item_ref(request_item));
+
+        /* The message is queued on the connection right away. Cancelling the call
+         * later only drops the reply, and systemd-resolved processes the requests
+         * in order. So remember what we sent, not what was acknowledged. */
+        _applied_item_set(self,
+                          request_item->operation,
+                          request_item->ifindex,
+                          request_item->argument);
     }
 
+    if (n_unchanged > 0)
+        _LOGT("send-updates: skipped %u requests for unchanged links", n_unchanged);
+
 start_resolve:
     c_list_for_each_entry (handle, &priv->handle_lst_head, handle_lst) {
         if (handle->handle_cancellable)
@@ -830,6 +949,17 @@ update(NMDnsPlugin             *plugin,
             g_hash_table_remove(priv->dirty_interfaces, GINT_TO_POINTER(ic->ifindex));
     }
 
+    /* Forget what we sent for links that are neither configured nor need to be
+     * reset. If such a link comes back, it gets its full configuration. */
+    g_hash_table_iter_init(&iter, priv->applied_items);
+    while (g_hash_table_iter_next(&iter, &pointer, NULL)) {
+        const AppliedItem *item = pointer;
+
+        if (!g_hash_table_contains(interfaces, GINT_TO_POINTER(item->ifindex))
+            && !g_hash_table_contains(priv->dirty_interfaces, GINT_TO_POINTER(item->ifindex)))
+            g_hash_table_iter_remove(&iter);
+    }
+
     /* If we previously configured an ifindex with non-empty values in
      * resolved, and the current update doesn't contain that interface,
      * reset the resolved configuration for that ifindex. */
@@ -886,6 +1016,9 @@ name_owner_changed(NMDnsSystemdResolved *self, const char *owner)
     nm_clear_g_cancellable(&priv->service_start_cancellable);
     nm_strdup_reset(&priv->dbus_owner, owner);
 
+    /* A new (or no) instance of systemd-resolved does not have our configuration. */
+    g_hash_table_remove_all(priv->applied_items);
+
     if (owner) {
         priv->try_start_blocked    = FALSE;
         priv->send_updates_waiting = TRUE;
@@ -1238,6 +1371,8 @@ stop(NMDnsPlugin *plugin)
     }
 
     free_pending_updates(self);
+    if (priv->applied_items)
+        g_hash_table_remove_all(priv->applied_items);
 
     nm_clear_g_dbus_connection_signal(priv->dbus_connection, &priv->name_owner_changed_id);
 
@@ -1258,6 +1393,10 @@ nm_dns_systemd_resolved_init(NMDnsSystemdResolved *self)
     c_list_init(&priv->request_queue_lst_head);
     c_list_init(&priv->handle_lst_head);
     priv->dirty_interfaces = g_hash_table_new(nm_direct_hash, NULL);
+    priv->applied_items    = g_hash_table_new_full(_applied_item_hash,
+                                                _applied_item_equal,
+                                                (GDestroyNotify) _applied_item_free,
+                                                NULL);
 
     priv->dbus_connection = nm_g_object_ref(NM_MAIN_DBUS_CONNECTION_GET);
     if (!priv->dbus_connection) {
@@ -1298,6 +1437,7 @@ dispose(GObject *object)
 
     g_clear_object(&priv->dbus_connection);
     nm_clear_pointer(&priv->dirty_interfaces, g_hash_table_destroy);
+    nm_clear_pointer(&priv->applied_items, g_hash_table_destroy);
 
     G_OBJECT_CLASS(nm_dns_systemd_resolved_parent_class)->dispose(object);
 }
@@ -42,6 +42,7 @@ typedef struct {
 
 enum {
     RS_SENT,
+    RA_SENT,
     LAST_SIGNAL,
 };
 static guint signals[LAST_SIGNAL] = {0};
@@ -223,6 +224,14 @@ send_rs(NMNDisc *ndisc, GError **error)
     return TRUE;
 }
 
+static gboolean
+send_ra(NMNDisc *ndisc, gboolean data_changed, GError **error)
+{
+    _LOGT("send_ra()");
+    g_signal_emit(ndisc, signals[RA_SENT], 0);
+    return TRUE;
+}
+
 static gboolean
 receive_ra(gpointer user_data)
 {
@@ -325,6 +334,10 @@ start(NMNDisc *ndisc)
     NMFakeNDiscPrivate *priv = NM_FAKE_NDISC_GET_PRIVATE(ndisc);
     FakeRa             *ra;
 
+    /* In router mode, we only send RAs. */
+    if (nm_ndisc_get_node_type(ndisc) == NM_NDISC_NODE_TYPE_ROUTER)
+        return;
+
     /* Queue up the first fake RA */
     g_assert(priv->ras);
     ra = priv->ras->data;
@@ -355,18 +368,18 @@ nm_fake_ndisc_init(NMFakeNDisc *fake_ndisc)
 {}
 
 NMNDisc *
-nm_fake_ndisc_new(NML3Cfg *l3cfg)
+nm_fake_ndisc_new(NML3Cfg *l3cfg, NMNDiscNodeType node_type)
 {
     const NMNDiscConfig config = {
         .l3cfg                        = NM_L3CFG(l3cfg),
         .ifname                       = nm_l3cfg_get_ifname(l3cfg, TRUE),
-        .node_type                    = NM_NDISC_NODE_TYPE_HOST,
+        .node_type                    = node_type,
         .stable_type                  = NM_UTILS_STABLE_TYPE_UUID,
         .network_id                   = "fake",
         .max_addresses                = NM_NDISC_MAX_ADDRESSES_DEFAULT,
         .router_solicitations         = NM_NDISC_ROUTER_SOLICITATIONS_DEFAULT,
         .router_solicitation_interval = NM_NDISC_RFC4861_RTR_SOLICITATION_INTERVAL,
-        .ra_timeout                   = 30u,
+        .ra_timeout                   = node_type == NM_NDISC_NODE_TYPE_ROUTER ? 0u : 30u,
         .addr_gen_mode                = NM_SETTING_IP6_CONFIG_ADDR_GEN_MODE_EUI64,
         .ip6_privacy                  = NM_SETTING_IP6_CONFIG_PRIVACY_PREFER_TEMP_ADDR,
     };
@@ -398,6 +411,7 @@ nm_fake_ndisc_class_init(NMFakeNDiscClass *klass)
     ndisc_class->start   = start;
     ndisc_class->stop    = stop;
     ndisc_class->send_rs = send_rs;
+    ndisc_class->send_ra = send_ra;
 
     signals[RS_SENT] = g_signal_new(NM_FAKE_NDISC_RS_SENT,
                                     G_OBJECT_CLASS_TYPE(klass),
@@ -408,4 +422,14 @@ nm_fake_ndisc_class_init(NMFakeNDiscClass *klass)
                                     NULL,
                                     G_TYPE_NONE,
                                     0);
+
+    signals[RA_SENT] = g_signal_new(NM_FAKE_NDISC_RA_SENT,
+                                    G_OBJECT_CLASS_TYPE(klass),
+                                    G_SIGNAL_RUN_FIRST,
+                                    0,
+                                    NULL,
+                                    NULL,
+                                    NULL,
+                                    G_TYPE_NONE,
+                                    0);
 }
@@ -18,13 +18,14 @@
     (G_TYPE_INSTANCE_GET_CLASS((obj), NM_TYPE_FAKE_NDISC, NMFakeNDiscClass))
 
 #define NM_FAKE_NDISC_RS_SENT "rs-sent"
+#define NM_FAKE_NDISC_RA_SENT "ra-sent"
 
 typedef struct _NMFakeRNDisc      NMFakeNDisc;
 typedef struct _NMFakeRNDiscClass NMFakeNDiscClass;
 
 GType nm_fake_ndisc_get_type(void);
 
-NMNDisc *nm_fake_ndisc_new(NML3Cfg *l3cfg);
+NMNDisc *nm_fake_ndisc_new(NML3Cfg *l3cfg, NMNDiscNodeType node_type);
 
 guint nm_fake_ndisc_add_ra(NMFakeNDisc     *self,
                            guint            seconds,
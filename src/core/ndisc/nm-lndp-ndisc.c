@@ -13,6 +13,7 @@
 #include <ndp.h>
 
 #include "NetworkManagerUtils.h"
+#include "libnm-glib-aux/nm-c-list.h"
 #include "libnm-glib-aux/nm-str-buf.h"
 #include "libnm-platform/nm-platform.h"
 #include "libnm-platform/nmp-netns.h"
@@ -24,9 +25,23 @@
 
 /*****************************************************************************/
 
+/* Router mode instances in the same network namespace share one libndp
+ * handle, and thus one raw ICMPv6 socket. libndp passes received messages
+ * to the handler registered for the incoming interface, and sends each
+ * message via the interface of the message. */
 typedef struct {
+    CList       shared_ndp_lst;
+    NMPNetns   *netns;
     struct ndp *ndp;
     GSource    *event_source;
+    int         ref_count;
+} SharedNdp;
+
+typedef struct {
+    struct ndp     *ndp;
+    GSource        *event_source;
+    SharedNdp      *shared_ndp;
+    struct ndp_msg *ra_msg;
 } NMLndpNDiscPrivate;
 
 /*****************************************************************************/
@@ -381,10 +396,9 @@ G_STATIC_ASSERT(sizeof(NMLndpDnsslOption) == 8u);
 
 /*****************************************************************************/
 
-static gboolean
-send_ra(NMNDisc *ndisc, GError **error)
+static struct ndp_msg *
+_ra_msg_build(NMNDisc *ndisc, GError **error)
 {
-    NMLndpNDiscPrivate      *priv  = NM_LNDP_NDISC_GET_PRIVATE(ndisc);
     NMNDiscDataInternal     *rdata = ndisc->rdata;
     int                      errsv;
     struct in6_addr         *addr;
@@ -398,7 +412,7 @@ send_ra(NMNDisc *ndisc, GError **error)
                             NM_UTILS_ERROR,
                             NM_UTILS_ERROR_UNKNOWN,
                             "cannot create a router advertisement");
-        return FALSE;
+        return NULL;
     }
 
     ndp_msg_ifindex_set(msg, nm_ndisc_get_ifindex(ndisc));
@@ -542,9 +556,27 @@ dns_servers_done:
     }
 dns_domains_done:
 
-    errsv = ndp_msg_send(priv->ndp, msg);
+    return msg;
+}
 
-    ndp_msg_destroy(msg);
+static gboolean
+send_ra(NMNDisc *ndisc, gboolean data_changed, GError **error)
+{
+    NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE(ndisc);
+    int                 errsv;
+
+    /* The RA only depends on the configured data. Build it once, and
+     * again only after the data changed. */
+    if (data_changed)
+        nm_clear_pointer(&priv->ra_msg, ndp_msg_destroy);
+
+    if (!priv->ra_msg) {
+        priv->ra_msg = _ra_msg_build(ndisc, error);
+        if (!priv->ra_msg)
+            return FALSE;
+    }
+
+    errsv = ndp_msg_send(priv->ndp, priv->ra_msg);
     if (errsv) {
         errsv = nm_errno_native(errsv);
         g_set_error(error,
@@ -587,6 +619,78 @@ event_ready(int fd, GIOCondition condition, gpointer user_data)
     return G_SOURCE_CONTINUE;
 }
 
+static CList _shared_ndp_lst_head = C_LIST_INIT(_shared_ndp_lst_head);
+
+static gboolean
+_shared_ndp_event_ready(int fd, GIOCondition condition, gpointer user_data)
+{
+    SharedNdp                  *shared_ndp = user_data;
+    nm_auto_pop_netns NMPNetns *netns      = NULL;
+
+    if (shared_ndp->netns) {
+        if (!nmp_netns_push(shared_ndp->netns)) {
+            /* something is very wrong. Stop handling events. */
+            nm_clear_g_source_inst(&shared_ndp->event_source);
+            return G_SOURCE_REMOVE;
+        }
+        netns = shared_ndp->netns;
+    }
+
+    ndp_callall_eventfd_handler(shared_ndp->ndp);
+    return G_SOURCE_CONTINUE;
+}
+
+static int
+_shared_ndp_acquire(NMPNetns *netns, SharedNdp **out_shared_ndp)
+{
+    SharedNdp  *shared_ndp;
+    struct ndp *ndp;
+    int         errsv;
+
+    c_list_for_each_entry (shared_ndp, &_shared_ndp_lst_head, shared_ndp_lst) {
+        if (shared_ndp->netns == netns) {
+            shared_ndp->ref_count++;
+            *out_shared_ndp = shared_ndp;
+            return 0;
+        }
+    }
+
+    errsv = ndp_open(&ndp);
+    if (errsv != 0)
+        return errsv;
+
+    shared_ndp  = g_slice_new(SharedNdp);
+    *shared_ndp = (SharedNdp){
+        .netns     = nm_g_object_ref(netns),
+        .ndp       = ndp,
+        .ref_count = 1,
+    };
+    shared_ndp->event_source = nm_g_unix_fd_add_source(ndp_get_eventfd(ndp),
+                                                       G_IO_IN,
+                                                       _shared_ndp_event_ready,
+                                                       shared_ndp);
+    c_list_link_tail(&_shared_ndp_lst_head, &shared_ndp->shared_ndp_lst);
+    *out_shared_ndp = shared_ndp;
+    return 0;
+}
+
+static void
+_shared_ndp_release(SharedNdp *shared_ndp)
+{
+    nm_assert(shared_ndp->ref_count > 0);
+
+    if (--shared_ndp->ref_count > 0)
+        return;
+
+    c_list_unlink_stale(&shared_ndp->shared_ndp_lst);
+    nm_clear_g_source_inst(&shared_ndp->event_source);
+    ndp_close(shared_ndp->ndp);
+    g_clear_object(&shared_ndp->netns);
+    nm_g_slice_free(shared_ndp);
+}
+
+/*****************************************************************************/
+
 static void
 start(NMNDisc *ndisc)
 {
@@ -595,12 +699,14 @@ start(NMNDisc *ndisc)
 
     g_return_if_fail(!priv->event_source);
 
-    fd = ndp_get_eventfd(priv->ndp);
+    if (!priv->shared_ndp) {
+        fd = ndp_get_eventfd(priv->ndp);
 
-    priv->event_source = nm_g_unix_fd_add_source(fd, G_IO_IN, event_ready, ndisc);
+        priv->event_source = nm_g_unix_fd_add_source(fd, G_IO_IN, event_ready, ndisc);
 
-    /* Flush any pending messages to avoid using obsolete information */
-    event_ready(fd, 0, ndisc);
+        /* Flush any pending messages to avoid using obsolete information */
+        event_ready(fd, 0, ndisc);
+    }
 
     switch (nm_ndisc_get_node_type(ndisc)) {
     case NM_NDISC_NODE_TYPE_HOST:
@@ -649,9 +755,14 @@ _cleanup(NMNDisc *ndisc)
             nm_assert_not_reached();
             break;
         }
-        ndp_close(priv->ndp);
+        if (priv->shared_ndp)
+            _shared_ndp_release(g_steal_pointer(&priv->shared_ndp));
+        else
+            ndp_close(priv->ndp);
         priv->ndp = NULL;
     }
+
+    nm_clear_pointer(&priv->ra_msg, ndp_msg_destroy);
 }
 
 static void
@@ -689,7 +800,12 @@ nm_lndp_ndisc_new(const NMNDiscConfig *config)
 
     priv = NM_LNDP_NDISC_GET_PRIVATE(ndisc);
 
-    errsv = ndp_open(&priv->ndp);
+    if (config->node_type == NM_NDISC_NODE_TYPE_ROUTER) {
+        errsv = _shared_ndp_acquire(nm_ndisc_netns_get(ndisc), &priv->shared_ndp);
+        if (errsv == 0)
+            priv->ndp = priv->shared_ndp->ndp;
+    } else
+        errsv = ndp_open(&priv->ndp);
 
     if (errsv != 0) {
         /* This is serious. It might be ENOMEM or the inability to open (or modify)
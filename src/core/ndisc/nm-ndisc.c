@@ -10,6 +10,7 @@
 #include <arpa/inet.h>
 #include <stdlib.h>
 
+#include "libnm-glib-aux/nm-prioq.h"
 #include "libnm-glib-aux/nm-random-utils.h"
 #include "libnm-platform/nm-platform-utils.h"
 #include "libnm-platform/nm-platform.h"
@@ -37,6 +38,37 @@
 
 /*****************************************************************************/
 
+typedef enum {
+    ITEM_TYPE_GATEWAY,
+    ITEM_TYPE_ADDRESS,
+    ITEM_TYPE_ROUTE,
+    ITEM_TYPE_DNS_SERVER,
+    ITEM_TYPE_DNS_DOMAIN,
+    _ITEM_TYPE_NUM,
+} ItemType;
+
+/* Book keeping for an element of the rdata arrays. For each array, there is a
+ * parallel array of ItemEntry. The entry tracks the expiry of the element in
+ * the expiry queue, and (except for addresses, which get matched by prefix)
+ * makes it findable by its key via the entries index. */
+typedef struct {
+    union {
+        /* for gateways and DNS servers. */
+        struct in6_addr addr;
+        struct {
+            struct in6_addr network;
+            guint8          plen;
+            bool            on_link;
+        } route;
+        /* owned by the NMNDiscDNSDomain in the array. */
+        const char *domain;
+    } key;
+    gint64   expiry_msec;
+    guint    prioq_idx;
+    guint    idx;
+    ItemType type;
+} ItemEntry;
+
 struct _NMNDiscPrivate {
     /* this *must* be the first field. */
     NMNDiscDataInternal rdata;
@@ -48,8 +80,10 @@ struct _NMNDiscPrivate {
     GSource *ra_timeout_source;
 
     gint32 announcements_left;
-    guint  send_ra_id;
     gint32 last_ra;
+    gint64 ra_next_msec;
+    guint  ra_prioq_idx;
+    bool   ra_data_changed;
 
     gint32 solicit_retransmit_time_msec;
     gint64 last_rs_msec;
@@ -58,6 +92,10 @@ struct _NMNDiscPrivate {
 
     GSource *timeout_expire_source;
 
+    GPtrArray  *entries[_ITEM_TYPE_NUM];
+    GHashTable *entries_idx;
+    NMPrioq     expiry_queue;
+
     NMUtilsIPv6IfaceId iid;
     gboolean           iid_is_token;
 
@@ -228,23 +266,236 @@ _preference_to_priority(NMIcmpv6RouterPref pref)
 
 /*****************************************************************************/
 
+static NMNDiscConfigMap
+_item_type_to_config_map(ItemType type)
+{
+    switch (type) {
+    case ITEM_TYPE_GATEWAY:
+        return NM_NDISC_CONFIG_GATEWAYS;
+    case ITEM_TYPE_ADDRESS:
+        return NM_NDISC_CONFIG_ADDRESSES;
+    case ITEM_TYPE_ROUTE:
+        return NM_NDISC_CONFIG_ROUTES;
+    case ITEM_TYPE_DNS_SERVER:
+        return NM_NDISC_CONFIG_DNS_SERVERS;
+    case ITEM_TYPE_DNS_DOMAIN:
+        return NM_NDISC_CONFIG_DNS_DOMAINS;
+    case _ITEM_TYPE_NUM:
+        break;
+    }
+    return nm_assert_unreachable_val(NM_NDISC_CONFIG_NONE);
+}
+
+static GArray *
+_item_array(NMNDiscPrivate *priv, ItemType type)
+{
+    switch (type) {
+    case ITEM_TYPE_GATEWAY:
+        return priv->rdata.gateways;
+    case ITEM_TYPE_ADDRESS:
+        return priv->rdata.addresses;
+    case ITEM_TYPE_ROUTE:
+        return priv->rdata.routes;
+    case ITEM_TYPE_DNS_SERVER:
+        return priv->rdata.dns_servers;
+    case ITEM_TYPE_DNS_DOMAIN:
+        return priv->rdata.dns_domains;
+    case _ITEM_TYPE_NUM:
+        break;
+    }
+    return nm_assert_unreachable_val(NULL);
+}
+
+static void
+_entry_key_init(ItemEntry *entry, ItemType type, gconstpointer item)
+{
+    entry->type = type;
+
+    switch (type) {
+    case ITEM_TYPE_GATEWAY:
+        entry->key.addr = ((const NMNDiscGateway *) item)->address;
+        return;
+    case ITEM_TYPE_ADDRESS:
+        return;
+    case ITEM_TYPE_ROUTE:
+        entry->key.route.network = ((const NMNDiscRoute *) item)->network;
+        entry->key.route.plen    = ((const NMNDiscRoute *) item)->plen;
+        entry->key.route.on_link = ((const NMNDiscRoute *) item)->on_link;
+        return;
+    case ITEM_TYPE_DNS_SERVER:
+        entry->key.addr = ((const NMNDiscDNSServer *) item)->address;
+        return;
+    case ITEM_TYPE_DNS_DOMAIN:
+        entry->key.domain = ((const NMNDiscDNSDomain *) item)->domain;
+        return;
+    case _ITEM_TYPE_NUM:
+        break;
+    }
+    nm_assert_not_reached();
+}
+
+static guint
+_entry_hash(gconstpointer ptr)
+{
+    const ItemEntry *entry = ptr;
+    NMHashState      h;
+
+    nm_hash_init(&h, 1830455449u);
+    nm_hash_update_val(&h, entry->type);
+    switch (entry->type) {
+    case ITEM_TYPE_ROUTE:
+        nm_hash_update_in6addr(&h, &entry->key.route.network);
+        nm_hash_update_vals(&h, entry->key.route.plen, (bool) entry->key.route.on_link);
+        break;
+    case ITEM_TYPE_DNS_DOMAIN:
+        nm_hash_update_str(&h, entry->key.domain);
+        break;
+    default:
+        nm_hash_update_in6addr(&h, &entry->key.addr);
+        break;
+    }
+    return nm_hash_complete(&h);
+}
+
 static gboolean
-expiry_next(gint64 now_msec, gint64 expiry_msec, gint64 *next_msec)
+_entry_equal(gconstpointer ptr_a, gconstpointer ptr_b)
 {
-    if (expiry_msec == NM_NDISC_EXPIRY_INFINITY)
-        return TRUE;
+    const ItemEntry *a = ptr_a;
+    const ItemEntry *b = ptr_b;
 
-    if (expiry_msec <= now_msec) {
-        /* expired. */
+    if (a->type != b->type)
         return FALSE;
+
+    switch (a->type) {
+    case ITEM_TYPE_ROUTE:
+        return IN6_ARE_ADDR_EQUAL(&a->key.route.network, &b->key.route.network)
+               && a->key.route.plen == b->key.route.plen
+               && a->key.route.on_link == b->key.route.on_link;
+    case ITEM_TYPE_DNS_DOMAIN:
+        return nm_streq(a->key.domain, b->key.domain);
+    default:
+        return IN6_ARE_ADDR_EQUAL(&a->key.addr, &b->key.addr);
+    }
+}
+
+static int
+_entry_cmp_expiry(gconstpointer ptr_a, gconstpointer ptr_b)
+{
+    const ItemEntry *a = ptr_a;
+    const ItemEntry *b = ptr_b;
+
+    NM_CMP_FIELD(a, b, expiry_msec);
+    return 0;
+}
+
+static void
+_entries_reindex(NMNDiscPrivate *priv, ItemType type, guint start)
+{
+    GPtrArray *entries = priv->entries[type];
+    guint      i;
+
+    nm_assert(entries->len == _item_array(priv, type)->len);
+
+    for (i = start; i < entries->len; i++)
+        ((ItemEntry *) entries->pdata[i])->idx = i;
+}
+
+/* Returns the index of the element with the key of @item, or G_MAXUINT. */
+static guint
+_item_lookup(NMNDiscPrivate *priv, ItemType type, gconstpointer item)
+{
+    const ItemEntry *entry;
+    ItemEntry        needle;
+
+    nm_assert(type != ITEM_TYPE_ADDRESS);
+
+    _entry_key_init(&needle, type, item);
+    entry = g_hash_table_lookup(priv->entries_idx, &needle);
+    if (!entry)
+        return G_MAXUINT;
+
+    nm_assert(priv->entries[type]->pdata[entry->idx] == entry);
+    return entry->idx;
+}
+
+static void
+_item_insert(NMNDiscPrivate *priv, ItemType type, guint idx, gconstpointer item, gint64 expiry_msec)
+{
+    GArray    *array = _item_array(priv, type);
+    ItemEntry *entry;
+
+    nm_assert(idx <= array->len);
+
+    g_array_insert_vals(array, idx, item, 1);
+
+    entry  = g_new(ItemEntry, 1);
+    *entry = (ItemEntry){
+        .expiry_msec = expiry_msec,
+        .prioq_idx   = NM_PRIOQ_IDX_NULL,
+    };
+    _entry_key_init(entry, type, &array->data[idx * g_array_get_element_size(array)]);
+
+    g_ptr_array_insert(priv->entries[type], idx, entry);
+    _entries_reindex(priv, type, idx);
+
+    if (type != ITEM_TYPE_ADDRESS) {
+        if (!g_hash_table_add(priv->entries_idx, entry))
+            nm_assert_not_reached();
     }
+    nm_prioq_put(&priv->expiry_queue, entry, &entry->prioq_idx);
+}
+
+static void
+_item_remove(NMNDiscPrivate *priv, ItemType type, guint idx)
+{
+    ItemEntry *entry = priv->entries[type]->pdata[idx];
+
+    nm_assert(entry->idx == idx);
+
+    nm_prioq_remove(&priv->expiry_queue, entry, &entry->prioq_idx);
+    if (type != ITEM_TYPE_ADDRESS) {
+        if (!g_hash_table_remove(priv->entries_idx, entry))
+            nm_assert_not_reached();
+    }
+
+    g_ptr_array_remove_index(priv->entries[type], idx);
+    g_array_remove_index(_item_array(priv, type), idx);
+    _entries_reindex(priv, type, idx);
+}
+
+static void
+_item_set_expiry(NMNDiscPrivate *priv, ItemType type, guint idx, gint64 expiry_msec)
+{
+    ItemEntry *entry = priv->entries[type]->pdata[idx];
+
+    nm_assert(entry->idx == idx);
+
+    if (entry->expiry_msec == expiry_msec)
+        return;
+
+    entry->expiry_msec = expiry_msec;
+    nm_prioq_reshuffle(&priv->expiry_queue, entry, &entry->prioq_idx);
+}
+
+static gboolean
+_item_clear(NMNDiscPrivate *priv, ItemType type)
+{
+    GPtrArray *entries = priv->entries[type];
+    guint      i;
+
+    if (entries->len == 0)
+        return FALSE;
+
+    for (i = 0; i < entries->len; i++) {
+        ItemEntry *entry = entries->pdata[i];
 
-    if (next_msec) {
-        if (*next_msec > expiry_msec)
-            *next_msec = expiry_msec;
+        nm_prioq_remove(&priv->expiry_queue, entry, &entry->prioq_idx);
+        if (type != ITEM_TYPE_ADDRESS)
+            g_hash_table_remove(priv->entries_idx, entry);
     }
 
-    /* the timestamp is good (not yet expired) */
+    g_ptr_array_set_size(entries, 0);
+    g_array_set_size(_item_array(priv, type), 0);
     return TRUE;
 }
 
@@ -349,47 +600,34 @@ _ASSERT_data_gateways(const NMNDiscDataInternal *data)
 }
 
 /*****************************************************************************/
-static bool
-is_duplicate_route(const NMNDiscRoute *r0, const NMNDiscRoute *r1)
-{
-    return IN6_ARE_ADDR_EQUAL(&r0->network, &r1->network) && r0->plen == r1->plen;
-}
-
 static void
-_data_complete_prepare_routes(GArray *routes)
+_data_complete_prepare_routes(NMNDiscPrivate *priv)
 {
-    guint i, j;
+    GArray *routes = priv->rdata.routes;
+    guint   i;
 
+    /* The same prefix can be present twice, once as on-link prefix and once
+     * from a route information option. Both get marked as duplicate. */
     for (i = 0; i < routes->len; i++) {
-        NMNDiscRoute *r0 = &nm_g_array_index(routes, NMNDiscRoute, i);
-
-        r0->duplicate = FALSE;
-    }
-    for (i = 0; i < routes->len; i++) {
-        NMNDiscRoute *r0 = &nm_g_array_index(routes, NMNDiscRoute, i);
-
-        for (j = i + 1; j < routes->len; j++) {
-            NMNDiscRoute *r1 = &nm_g_array_index(routes, NMNDiscRoute, j);
-
-            if (!is_duplicate_route(r0, r1))
-                continue;
-
-            r0->duplicate = TRUE;
-            r1->duplicate = TRUE;
+        NMNDiscRoute      *r = &nm_g_array_index(routes, NMNDiscRoute, i);
+        const NMNDiscRoute other = {
+            .network = r->network,
+            .plen    = r->plen,
+            .on_link = !r->on_link,
+        };
 
-            /* Maybe after index j, there is yet another duplicate. But we
-            * will find that later, when i becomes j. */
-            break;
-        }
+        r->duplicate = (_item_lookup(priv, ITEM_TYPE_ROUTE, &other) != G_MAXUINT);
     }
 }
 
 static const NMNDiscData *
-_data_complete(NMNDiscDataInternal *data)
+_data_complete(NMNDiscPrivate *priv)
 {
+    NMNDiscDataInternal *data = &priv->rdata;
+
     _ASSERT_data_gateways(data);
 
-    _data_complete_prepare_routes(data->routes);
+    _data_complete_prepare_routes(priv);
 #define _SET(data, field)                                      \
     G_STMT_START                                               \
     {                                                          \
@@ -417,7 +655,7 @@ nm_ndisc_emit_config_change(NMNDisc *self, NMNDiscConfigMap changed)
 
     _config_changed_log(self, changed);
 
-    rdata = _data_complete(&NM_NDISC_GET_PRIVATE(self)->rdata),
+    rdata = _data_complete(priv);
 
     l3cd = nm_ndisc_data_to_l3cd(nm_l3cfg_get_multi_idx(priv->config.l3cfg),
                                  nm_l3cfg_get_ifindex(priv->config.l3cfg),
@@ -437,40 +675,32 @@ nm_ndisc_emit_config_change(NMNDisc *self, NMNDiscConfigMap changed)
 gboolean
 nm_ndisc_add_gateway(NMNDisc *ndisc, const NMNDiscGateway *new_item, gint64 now_msec)
 {
-    NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
+    NMNDiscPrivate      *priv  = NM_NDISC_GET_PRIVATE(ndisc);
+    NMNDiscDataInternal *rdata = &priv->rdata;
     guint                i;
-    guint                insert_idx = G_MAXUINT;
 
-    for (i = 0; i < rdata->gateways->len;) {
+    i = _item_lookup(priv, ITEM_TYPE_GATEWAY, new_item);
+    if (i != G_MAXUINT) {
         NMNDiscGateway *item = &nm_g_array_index(rdata->gateways, NMNDiscGateway, i);
 
-        if (IN6_ARE_ADDR_EQUAL(&item->address, &new_item->address)) {
-            if (new_item->expiry_msec <= now_msec) {
-                g_array_remove_index(rdata->gateways, i);
-                _ASSERT_data_gateways(rdata);
-                return TRUE;
-            }
-
-            if (item->preference != new_item->preference) {
-                g_array_remove_index(rdata->gateways, i);
-                continue;
-            }
+        if (new_item->expiry_msec <= now_msec) {
+            _item_remove(priv, ITEM_TYPE_GATEWAY, i);
+            _ASSERT_data_gateways(rdata);
+            return TRUE;
+        }
 
+        if (item->preference == new_item->preference) {
             if (item->expiry_msec == new_item->expiry_msec)
                 return FALSE;
 
             item->expiry_msec = new_item->expiry_msec;
+            _item_set_expiry(priv, ITEM_TYPE_GATEWAY, i, item->expiry_msec);
             _ASSERT_data_gateways(rdata);
             return TRUE;
         }
 
-        /* Put before less preferable gateways. */
-        if (_preference_to_priority(item->preference)
-                < _preference_to_priority(new_item->preference)
-            && insert_idx == G_MAXUINT)
-            insert_idx = i;
-
-        i++;
+        /* The preference changed. Re-add it at the right position. */
+        _item_remove(priv, ITEM_TYPE_GATEWAY, i);
     }
 
     if (rdata->gateways->len >= _SIZE_MAX_GATEWAYS)
@@ -479,9 +709,16 @@ nm_ndisc_add_gateway(NMNDisc *ndisc, const NMNDiscGateway *new_item, gint64 now_
     if (new_item->expiry_msec <= now_msec)
         return FALSE;
 
-    g_array_insert_val(rdata->gateways,
-                       insert_idx == G_MAXUINT ? rdata->gateways->len : insert_idx,
-                       *new_item);
+    /* Put before less preferable gateways. */
+    for (i = 0; i < rdata->gateways->len; i++) {
+        const NMNDiscGateway *item = &nm_g_array_index(rdata->gateways, NMNDiscGateway, i);
+
+        if (_preference_to_priority(item->preference)
+            < _preference_to_priority(new_item->preference))
+            break;
+    }
+
+    _item_insert(priv, ITEM_TYPE_GATEWAY, i, new_item, new_item->expiry_msec);
     _ASSERT_data_gateways(rdata);
     return TRUE;
 }
@@ -548,7 +785,7 @@ nm_ndisc_add_address(NMNDisc              *ndisc,
 {
     NMNDiscPrivate      *priv  = NM_NDISC_GET_PRIVATE(ndisc);
     NMNDiscDataInternal *rdata = &priv->rdata;
-    NMNDiscAddress      *new2;
+    NMNDiscAddress       new2;
     NMNDiscAddress      *existing = NULL;
     guint                i;
 
@@ -614,7 +851,7 @@ nm_ndisc_add_address(NMNDisc              *ndisc,
             new_expiry_preferred_msec = NM_MIN(new_expiry_preferred_msec, new_expiry_msec);
         } else {
             if (new_item->expiry_msec <= now_msec) {
-                g_array_remove_index(rdata->addresses, i);
+                _item_remove(priv, ITEM_TYPE_ADDRESS, i);
                 return TRUE;
             }
 
@@ -631,6 +868,7 @@ nm_ndisc_add_address(NMNDisc              *ndisc,
 
         existing->expiry_msec           = new_expiry_msec;
         existing->expiry_preferred_msec = new_expiry_preferred_msec;
+        _item_set_expiry(priv, ITEM_TYPE_ADDRESS, i, new_expiry_msec);
         return TRUE;
     }
 
@@ -644,20 +882,17 @@ nm_ndisc_add_address(NMNDisc              *ndisc,
     if (new_item->expiry_msec <= now_msec)
         return FALSE;
 
-    new2 = nm_g_array_append_new(rdata->addresses, NMNDiscAddress);
-
-    *new2 = *new_item;
+    new2 = *new_item;
 
-    new2->expiry_preferred_msec = NM_MIN(new2->expiry_preferred_msec, new2->expiry_msec);
+    new2.expiry_preferred_msec = NM_MIN(new2.expiry_preferred_msec, new2.expiry_msec);
 
     if (from_ra) {
-        new2->dad_counter = 0;
-        if (!complete_address(ndisc, new2)) {
-            g_array_set_size(rdata->addresses, rdata->addresses->len - 1);
+        new2.dad_counter = 0;
+        if (!complete_address(ndisc, &new2))
             return FALSE;
-        }
     }
 
+    _item_insert(priv, ITEM_TYPE_ADDRESS, rdata->addresses->len, &new2, new2.expiry_msec);
     return TRUE;
 }
 
@@ -673,8 +908,6 @@ nm_ndisc_add_route(NMNDisc *ndisc, const NMNDiscRoute *new_item, gint64 now_msec
     NMNDiscPrivate      *priv;
     NMNDiscDataInternal *rdata;
     guint                i;
-    guint                insert_idx = G_MAXUINT;
-    gboolean             changed    = FALSE;
 
     if (new_item->plen == 0 || new_item->plen > 128) {
         /* Only expect non-default routes.  The router has no idea what the
@@ -690,58 +923,57 @@ nm_ndisc_add_route(NMNDisc *ndisc, const NMNDiscRoute *new_item, gint64 now_msec
     priv  = NM_NDISC_GET_PRIVATE(ndisc);
     rdata = &priv->rdata;
 
-    for (i = 0; i < rdata->routes->len;) {
+    /*
+     * It is possible that two entries in rdata->routes have
+     * the same prefix as well as the same prefix length.
+     * One of them, however, refers to the on-link prefix,
+     * and the other one to a route from the route information field.
+     * Moreover, they might have different route preferences.
+     * Hence, the on-link flag is part of the key, and both routes
+     * are added.
+     */
+    i = _item_lookup(priv, ITEM_TYPE_ROUTE, new_item);
+    if (i != G_MAXUINT) {
         NMNDiscRoute *item = &nm_g_array_index(rdata->routes, NMNDiscRoute, i);
 
-        /*
-         * It is possible that two entries in rdata->routes have
-         * the same prefix as well as the same prefix length.
-         * One of them, however, refers to the on-link prefix,
-         * and the other one to a route from the route information field.
-         * Moreover, they might have different route preferences.
-         * Hence, if both routes differ in the on-link flag,
-         * comparison is aborted, and both routes are added.
-         */
-        if (IN6_ARE_ADDR_EQUAL(&item->network, &new_item->network) && item->plen == new_item->plen
-            && item->on_link == new_item->on_link) {
-            if (new_item->expiry_msec <= now_msec) {
-                g_array_remove_index(rdata->routes, i);
-                return TRUE;
-            }
-
-            if (item->preference != new_item->preference) {
-                g_array_remove_index(rdata->routes, i);
-                changed = TRUE;
-                continue;
-            }
+        if (new_item->expiry_msec <= now_msec) {
+            _item_remove(priv, ITEM_TYPE_ROUTE, i);
+            return TRUE;
+        }
 
+        if (item->preference == new_item->preference) {
             if (item->expiry_msec == new_item->expiry_msec
                 && IN6_ARE_ADDR_EQUAL(&item->gateway, &new_item->gateway))
                 return FALSE;
 
             item->expiry_msec = new_item->expiry_msec;
             item->gateway     = new_item->gateway;
+            _item_set_expiry(priv, ITEM_TYPE_ROUTE, i, item->expiry_msec);
             return TRUE;
         }
 
-        /* Put before less preferable routes. */
-        if (_preference_to_priority(item->preference)
-                < _preference_to_priority(new_item->preference)
-            && insert_idx == G_MAXUINT)
-            insert_idx = i;
-
-        i++;
+        /* The preference changed. Re-add it at the right position. */
+        _item_remove(priv, ITEM_TYPE_ROUTE, i);
     }
 
     if (rdata->routes->len >= _SIZE_MAX_ROUTES)
         return FALSE;
 
-    if (new_item->expiry_msec <= now_msec) {
-        nm_assert(!changed);
+    if (new_item->expiry_msec <= now_msec)
         return FALSE;
+
+    /* Put before less preferable routes. */
+    for (i = 0; i < rdata->routes->len; i++) {
+        const NMNDiscRoute *item = &nm_g_array_index(rdata->routes, NMNDiscRoute, i);
+
+        if (_preference_to_priority(item->preference)
+            < _preference_to_priority(new_item->preference))
+            break;
     }
+    if (i == rdata->routes->len)
+        i = 0;
 
-    g_array_insert_val(rdata->routes, insert_idx == G_MAXUINT ? 0u : insert_idx, *new_item);
+    _item_insert(priv, ITEM_TYPE_ROUTE, i, new_item, new_item->expiry_msec);
     return TRUE;
 }
 
@@ -755,21 +987,21 @@ nm_ndisc_add_dns_server(NMNDisc *ndisc, const NMNDiscDNSServer *new_item, gint64
     priv  = NM_NDISC_GET_PRIVATE(ndisc);
     rdata = &priv->rdata;
 
-    for (i = 0; i < rdata->dns_servers->len; i++) {
+    i = _item_lookup(priv, ITEM_TYPE_DNS_SERVER, new_item);
+    if (i != G_MAXUINT) {
         NMNDiscDNSServer *item = &nm_g_array_index(rdata->dns_servers, NMNDiscDNSServer, i);
 
-        if (IN6_ARE_ADDR_EQUAL(&item->address, &new_item->address)) {
-            if (new_item->expiry_msec <= now_msec) {
-                g_array_remove_index(rdata->dns_servers, i);
-                return TRUE;
-            }
-
-            if (item->expiry_msec == new_item->expiry_msec)
-                return FALSE;
-
-            item->expiry_msec = new_item->expiry_msec;
+        if (new_item->expiry_msec <= now_msec) {
+            _item_remove(priv, ITEM_TYPE_DNS_SERVER, i);
             return TRUE;
         }
+
+        if (item->expiry_msec == new_item->expiry_msec)
+            return FALSE;
+
+        item->expiry_msec = new_item->expiry_msec;
+        _item_set_expiry(priv, ITEM_TYPE_DNS_SERVER, i, item->expiry_msec);
+        return TRUE;
     }
 
     if (rdata->dns_servers->len >= _SIZE_MAX_DNS_SERVERS)
@@ -778,7 +1010,11 @@ nm_ndisc_add_dns_server(NMNDisc *ndisc, const NMNDiscDNSServer *new_item, gint64
     if (new_item->expiry_msec <= now_msec)
         return FALSE;
 
-    g_array_append_val(rdata->dns_servers, *new_item);
+    _item_insert(priv,
+                 ITEM_TYPE_DNS_SERVER,
+                 rdata->dns_servers->len,
+                 new_item,
+                 new_item->expiry_msec);
     return TRUE;
 }
 
@@ -788,27 +1024,27 @@ nm_ndisc_add_dns_domain(NMNDisc *ndisc, const NMNDiscDNSDomain *new_item, gint64
 {
     NMNDiscPrivate      *priv;
     NMNDiscDataInternal *rdata;
-    NMNDiscDNSDomain    *item;
+    NMNDiscDNSDomain     item_new;
     guint                i;
 
     priv  = NM_NDISC_GET_PRIVATE(ndisc);
     rdata = &priv->rdata;
 
-    for (i = 0; i < rdata->dns_domains->len; i++) {
-        item = &nm_g_array_index(rdata->dns_domains, NMNDiscDNSDomain, i);
-
-        if (nm_streq(item->domain, new_item->domain)) {
-            if (new_item->expiry_msec <= now_msec) {
-                g_array_remove_index(rdata->dns_domains, i);
-                return TRUE;
-            }
+    i = _item_lookup(priv, ITEM_TYPE_DNS_DOMAIN, new_item);
+    if (i != G_MAXUINT) {
+        NMNDiscDNSDomain *item = &nm_g_array_index(rdata->dns_domains, NMNDiscDNSDomain, i);
 
-            if (item->expiry_msec == new_item->expiry_msec)
-                return FALSE;
-
-            item->expiry_msec = new_item->expiry_msec;
+        if (new_item->expiry_msec <= now_msec) {
+            _item_remove(priv, ITEM_TYPE_DNS_DOMAIN, i);
             return TRUE;
         }
+
+        if (item->expiry_msec == new_item->expiry_msec)
+            return FALSE;
+
+        item->expiry_msec = new_item->expiry_msec;
+        _item_set_expiry(priv, ITEM_TYPE_DNS_DOMAIN, i, item->expiry_msec);
+        return TRUE;
     }
 
     if (rdata->dns_domains->len >= _SIZE_MAX_DNS_DOMAINS)
@@ -817,11 +1053,15 @@ nm_ndisc_add_dns_domain(NMNDisc *ndisc, const NMNDiscDNSDomain *new_item, gint64
     if (new_item->expiry_msec <= now_msec)
         return FALSE;
 
-    item  = nm_g_array_append_new(rdata->dns_domains, NMNDiscDNSDomain);
-    *item = (NMNDiscDNSDomain){
+    item_new = (NMNDiscDNSDomain){
         .domain      = g_strdup(new_item->domain),
         .expiry_msec = new_item->expiry_msec,
     };
+    _item_insert(priv,
+                 ITEM_TYPE_DNS_DOMAIN,
+                 rdata->dns_domains->len,
+                 &item_new,
+                 item_new.expiry_msec);
     return TRUE;
 }
 
@@ -948,7 +1188,112 @@ solicit_timer_start(NMNDisc *ndisc)
 
 /*****************************************************************************/
 
+/* All router mode instances share one timer for sending their router
+ * advertisements. The instances are queued by their next announcement. */
+static struct {
+    NMPrioq  queue;
+    GSource *source;
+    gint64   source_msec;
+    bool     initialized;
+    bool     dispatching;
+} _ra_sched;
+
+static void announce_router(NMNDisc *ndisc);
+
+static int
+_ra_sched_cmp(gconstpointer a, gconstpointer b)
+{
+    NM_CMP_DIRECT(NM_NDISC_GET_PRIVATE((NMNDisc *) a)->ra_next_msec,
+                  NM_NDISC_GET_PRIVATE((NMNDisc *) b)->ra_next_msec);
+    return 0;
+}
+
+static gboolean _ra_sched_cb(gpointer user_data);
+
+static void
+_ra_sched_rearm(void)
+{
+    NMNDisc *ndisc;
+    gint64   next_msec;
+    gint64   timeout_msec;
+
+    if (_ra_sched.dispatching)
+        return;
+
+    ndisc = nm_prioq_peek(&_ra_sched.queue);
+    if (!ndisc) {
+        nm_clear_g_source_inst(&_ra_sched.source);
+        return;
+    }
+
+    next_msec = NM_NDISC_GET_PRIVATE(ndisc)->ra_next_msec;
+    if (_ra_sched.source && _ra_sched.source_msec == next_msec)
+        return;
+
+    timeout_msec = next_msec - nm_utils_get_monotonic_timestamp_msec();
+
+    nm_clear_g_source_inst(&_ra_sched.source);
+    _ra_sched.source_msec = next_msec;
+    _ra_sched.source      = nm_g_timeout_add_source(
+        NM_CLAMP(timeout_msec, (gint64) 0, (gint64) G_MAXINT32),
+        _ra_sched_cb,
+        NULL);
+}
+
+static gboolean
+_ra_sched_cb(gpointer user_data)
+{
+    const gint64 now_msec = nm_utils_get_monotonic_timestamp_msec();
+    NMNDisc     *ndisc;
+
+    nm_clear_g_source_inst(&_ra_sched.source);
+
+    _ra_sched.dispatching = TRUE;
+    while ((ndisc = nm_prioq_peek(&_ra_sched.queue))
+           && NM_NDISC_GET_PRIVATE(ndisc)->ra_next_msec <= now_msec) {
+        nm_prioq_pop(&_ra_sched.queue);
+        announce_router(ndisc);
+    }
+    _ra_sched.dispatching = FALSE;
+
+    _ra_sched_rearm();
+    return G_SOURCE_CONTINUE;
+}
+
 static gboolean
+_ra_is_scheduled(NMNDisc *ndisc)
+{
+    return NM_NDISC_GET_PRIVATE(ndisc)->ra_prioq_idx != NM_PRIOQ_IDX_NULL;
+}
+
+static void
+_ra_schedule(NMNDisc *ndisc, gint64 timeout_msec)
+{
+    NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE(ndisc);
+
+    if (!_ra_sched.initialized) {
+        nm_prioq_init(&_ra_sched.queue, _ra_sched_cmp);
+        _ra_sched.initialized = TRUE;
+    }
+
+    priv->ra_next_msec = nm_utils_get_monotonic_timestamp_msec() + timeout_msec;
+    nm_prioq_update(&_ra_sched.queue, ndisc, &priv->ra_prioq_idx, TRUE);
+    _ra_sched_rearm();
+}
+
+static void
+_ra_unschedule(NMNDisc *ndisc)
+{
+    NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE(ndisc);
+
+    if (priv->ra_prioq_idx == NM_PRIOQ_IDX_NULL)
+        return;
+
+    nm_prioq_remove(&_ra_sched.queue, ndisc, &priv->ra_prioq_idx);
+    _ra_sched_rearm();
+}
+
+static void
 announce_router(NMNDisc *ndisc)
 {
     nm_auto_pop_netns NMPNetns *netns = NULL;
@@ -957,38 +1302,34 @@ announce_router(NMNDisc *ndisc)
     GError                     *error = NULL;
 
     if (!nm_ndisc_netns_push(ndisc, &netns))
-        return G_SOURCE_REMOVE;
+        return;
 
     priv->last_ra = nm_utils_get_monotonic_timestamp_sec();
-    if (klass->send_ra(ndisc, &error)) {
+    if (klass->send_ra(ndisc, priv->ra_data_changed, &error)) {
         _LOGD("router advertisement sent");
         nm_clear_g_free(&priv->last_error);
     } else {
         _MAYBE_WARN("failure sending router advertisement: %s", error->message);
         g_clear_error(&error);
     }
+    priv->ra_data_changed = FALSE;
 
     if (--priv->announcements_left) {
         _LOGD("will resend an initial router advertisement");
 
         /* Schedule next initial announcement retransmit. */
-        priv->send_ra_id =
-            g_timeout_add_seconds(nm_random_u64_range_full(NM_NDISC_ROUTER_ADVERT_DELAY,
-                                                           NM_NDISC_ROUTER_ADVERT_INITIAL_INTERVAL,
-                                                           FALSE),
-                                  (GSourceFunc) announce_router,
-                                  ndisc);
+        _ra_schedule(ndisc,
+                     nm_random_u64_range_full(NM_NDISC_ROUTER_ADVERT_DELAY,
+                                              NM_NDISC_ROUTER_ADVERT_INITIAL_INTERVAL,
+                                              FALSE)
+                         * 1000);
     } else {
         _LOGD("will send an unsolicited router advertisement");
 
         /* Schedule next unsolicited announcement. */
         priv->announcements_left = 1;
-        priv->send_ra_id         = g_timeout_add_seconds(NM_NDISC_ROUTER_ADVERT_MAX_INTERVAL,
-                                                 (GSourceFunc) announce_router,
-                                                 ndisc);
+        _ra_schedule(ndisc, NM_NDISC_ROUTER_ADVERT_MAX_INTERVAL * 1000);
     }
-
-    return G_SOURCE_REMOVE;
 }
 
 static void
@@ -1004,15 +1345,12 @@ announce_router_initial(NMNDisc *ndisc)
     /* Unschedule an unsolicited resend if we are allowed to send now. */
     if (G_LIKELY(nm_utils_get_monotonic_timestamp_sec() - priv->last_ra
                  > NM_NDISC_ROUTER_ADVERT_DELAY))
-        nm_clear_g_source(&priv->send_ra_id);
+        _ra_unschedule(ndisc);
 
     /* Schedule the initial send rather early. Clamp the delay by minimal
      * delay and not the initial advert internal so that we start fast. */
-    if (G_LIKELY(!priv->send_ra_id)) {
-        priv->send_ra_id = g_timeout_add_seconds(nm_random_u64_range(NM_NDISC_ROUTER_ADVERT_DELAY),
-                                                 (GSourceFunc) announce_router,
-                                                 ndisc);
-    }
+    if (G_LIKELY(!_ra_is_scheduled(ndisc)))
+        _ra_schedule(ndisc, nm_random_u64_range(NM_NDISC_ROUTER_ADVERT_DELAY) * 1000);
 }
 
 static void
@@ -1024,13 +1362,10 @@ announce_router_solicited(NMNDisc *ndisc)
 
     /* Unschedule an unsolicited resend if we are allowed to send now. */
     if (nm_utils_get_monotonic_timestamp_sec() - priv->last_ra > NM_NDISC_ROUTER_ADVERT_DELAY)
-        nm_clear_g_source(&priv->send_ra_id);
+        _ra_unschedule(ndisc);
 
-    if (!priv->send_ra_id) {
-        priv->send_ra_id = g_timeout_add(nm_random_u64_range(NM_NDISC_ROUTER_ADVERT_DELAY_MS),
-                                         (GSourceFunc) announce_router,
-                                         ndisc);
-    }
+    if (!_ra_is_scheduled(ndisc))
+        _ra_schedule(ndisc, nm_random_u64_range(NM_NDISC_ROUTER_ADVERT_DELAY_MS));
 }
 
 /*****************************************************************************/
@@ -1119,8 +1454,10 @@ nm_ndisc_set_config(NMNDisc *ndisc, const NML3ConfigData *l3cd)
             changed = TRUE;
     }
 
-    if (changed)
+    if (changed) {
+        NM_NDISC_GET_PRIVATE(ndisc)->ra_data_changed = TRUE;
         announce_router_initial(ndisc);
+    }
 }
 
 /**
@@ -1162,7 +1499,7 @@ nm_ndisc_set_iid(NMNDisc *ndisc, const NMUtilsIPv6IfaceId iid, gboolean is_token
 
         if (rdata->addresses->len) {
             _LOGD("IPv6 interface identifier changed, flushing addresses");
-            g_array_remove_range(rdata->addresses, 0, rdata->addresses->len);
+            _item_clear(priv, ITEM_TYPE_ADDRESS);
             nm_ndisc_emit_config_change(ndisc, NM_NDISC_CONFIG_ADDRESSES);
             solicit_timer_start(ndisc);
         }
@@ -1234,8 +1571,8 @@ void
 nm_ndisc_stop(NMNDisc *ndisc)
 {
     nm_auto_pop_netns NMPNetns *netns = NULL;
-    NMNDiscDataInternal        *rdata;
     NMNDiscPrivate             *priv;
+    ItemType                    type;
 
     g_return_if_fail(NM_IS_NDISC(ndisc));
 
@@ -1250,17 +1587,14 @@ nm_ndisc_stop(NMNDisc *ndisc)
 
     NM_NDISC_GET_CLASS(ndisc)->stop(ndisc);
 
-    rdata = &priv->rdata;
-
-    g_array_set_size(rdata->gateways, 0);
-    g_array_set_size(rdata->addresses, 0);
-    g_array_set_size(rdata->routes, 0);
-    g_array_set_size(rdata->dns_servers, 0);
-    g_array_set_size(rdata->dns_domains, 0);
+    for (type = 0; type < _ITEM_TYPE_NUM; type++)
+        _item_clear(priv, type);
+    nm_assert(nm_prioq_isempty(&priv->expiry_queue));
     priv->rdata.public.hop_limit = 64;
 
     nm_clear_g_source_inst(&priv->ra_timeout_source);
-    nm_clear_g_source(&priv->send_ra_id);
+    _ra_unschedule(ndisc);
+    priv->ra_data_changed = TRUE;
     nm_clear_g_free(&priv->last_error);
     nm_clear_g_source_inst(&priv->timeout_expire_source);
 
@@ -1275,6 +1609,7 @@ nm_ndisc_stop(NMNDisc *ndisc)
 NMNDiscConfigMap
 nm_ndisc_dad_failed(NMNDisc *ndisc, GArray *addresses, gboolean emit_changed_signal)
 {
+    NMNDiscPrivate      *priv;
     NMNDiscDataInternal *rdata;
     guint                i;
     guint                j;
@@ -1282,7 +1617,8 @@ nm_ndisc_dad_failed(NMNDisc *ndisc, GArray *addresses, gboolean emit_changed_sig
 
     g_return_val_if_fail(addresses, NM_NDISC_CONFIG_NONE);
 
-    rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
+    priv  = NM_NDISC_GET_PRIVATE(ndisc);
+    rdata = &priv->rdata;
 
     for (i = 0; i < addresses->len; i++) {
         const struct in6_addr *addr = &nm_g_array_index(addresses, struct in6_addr, i);
@@ -1294,7 +1630,7 @@ nm_ndisc_dad_failed(NMNDisc *ndisc, GArray *addresses, gboolean emit_changed_sig
                 changed = TRUE;
 
                 if (!complete_address(ndisc, item)) {
-                    g_array_remove_index(rdata->addresses, j);
+                    _item_remove(priv, ITEM_TYPE_ADDRESS, j);
                     continue;
                 }
             }
@@ -1403,193 +1739,27 @@ _config_changed_log(NMNDisc *ndisc, NMNDiscConfigMap changed)
 
 /*****************************************************************************/
 
-static gboolean
-_array_set_size_max(GArray *array, guint size_max)
-{
-    nm_assert(array);
-    nm_assert(size_max > 0u);
-
-    if (array->len <= size_max)
-        return FALSE;
-
-    g_array_set_size(array, size_max);
-    return TRUE;
-}
-
-static void
-clean_gateways(NMNDisc *ndisc, gint64 now_msec, NMNDiscConfigMap *changed, gint64 *next_msec)
-{
-    NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
-    NMNDiscGateway      *arr;
-    guint                i;
-    guint                j;
-
-    if (rdata->gateways->len == 0)
-        return;
-
-    arr = &nm_g_array_first(rdata->gateways, NMNDiscGateway);
-
-    for (i = 0, j = 0; i < rdata->gateways->len; i++) {
-        if (!expiry_next(now_msec, arr[i].expiry_msec, next_msec))
-            continue;
-        if (i != j)
-            arr[j] = arr[i];
-        j++;
-    }
-
-    if (i != j) {
-        *changed |= NM_NDISC_CONFIG_GATEWAYS;
-        g_array_set_size(rdata->gateways, j);
-    }
-
-    if (_array_set_size_max(rdata->gateways, _SIZE_MAX_GATEWAYS))
-        *changed |= NM_NDISC_CONFIG_GATEWAYS;
-
-    _ASSERT_data_gateways(rdata);
-}
-
-static void
-clean_addresses(NMNDisc *ndisc, gint64 now_msec, NMNDiscConfigMap *changed, gint64 *next_msec)
-{
-    NMNDiscPrivate      *priv  = NM_NDISC_GET_PRIVATE(ndisc);
-    NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
-    NMNDiscAddress      *arr;
-    guint                i;
-    guint                j;
-
-    if (rdata->addresses->len == 0)
-        return;
-
-    arr = &nm_g_array_first(rdata->addresses, NMNDiscAddress);
-
-    for (i = 0, j = 0; i < rdata->addresses->len; i++) {
-        if (!expiry_next(now_msec, arr[i].expiry_msec, next_msec))
-            continue;
-        if (i != j)
-            arr[j] = arr[i];
-        j++;
-    }
-
-    if (i != j) {
-        *changed = NM_NDISC_CONFIG_ADDRESSES;
-        g_array_set_size(rdata->addresses, j);
-    }
-
-    if (_array_set_size_max(rdata->gateways, priv->config.max_addresses))
-        *changed |= NM_NDISC_CONFIG_ADDRESSES;
-}
-
-static void
-clean_routes(NMNDisc *ndisc, gint64 now_msec, NMNDiscConfigMap *changed, gint64 *next_msec)
-{
-    NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
-    NMNDiscRoute        *arr;
-    guint                i;
-    guint                j;
-
-    if (rdata->routes->len == 0)
-        return;
-
-    arr = &nm_g_array_first(rdata->routes, NMNDiscRoute);
-
-    for (i = 0, j = 0; i < rdata->routes->len; i++) {
-        if (!expiry_next(now_msec, arr[i].expiry_msec, next_msec))
-            continue;
-        if (i != j)
-            arr[j] = arr[i];
-        j++;
-    }
-
-    if (i != j) {
-        *changed |= NM_NDISC_CONFIG_ROUTES;
-        g_array_set_size(rdata->routes, j);
-    }
-
-    if (_array_set_size_max(rdata->gateways, _SIZE_MAX_ROUTES))
-        *changed |= NM_NDISC_CONFIG_ROUTES;
-}
-
-static void
-clean_dns_servers(NMNDisc *ndisc, gint64 now_msec, NMNDiscConfigMap *changed, gint64 *next_msec)
-{
-    NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
-    NMNDiscDNSServer    *arr;
-    guint                i;
-    guint                j;
-
-    if (rdata->dns_servers->len == 0)
-        return;
-
-    arr = &nm_g_array_first(rdata->dns_servers, NMNDiscDNSServer);
-
-    for (i = 0, j = 0; i < rdata->dns_servers->len; i++) {
-        if (!expiry_next(now_msec, arr[i].expiry_msec, next_msec))
-            continue;
-        if (i != j)
-            arr[j] = arr[i];
-        j++;
-    }
-
-    if (i != j) {
-        *changed |= NM_NDISC_CONFIG_DNS_SERVERS;
-        g_array_set_size(rdata->dns_servers, j);
-    }
-
-    if (_array_set_size_max(rdata->gateways, _SIZE_MAX_DNS_SERVERS))
-        *changed |= NM_NDISC_CONFIG_DNS_SERVERS;
-}
-
-static void
-clean_dns_domains(NMNDisc *ndisc, gint64 now_msec, NMNDiscConfigMap *changed, gint64 *next_msec)
-{
-    NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
-    NMNDiscDNSDomain    *arr;
-    guint                i;
-    guint                j;
-
-    if (rdata->dns_domains->len == 0)
-        return;
-
-    arr = &nm_g_array_first(rdata->dns_domains, NMNDiscDNSDomain);
-
-    for (i = 0, j = 0; i < rdata->dns_domains->len; i++) {
-        if (!expiry_next(now_msec, arr[i].expiry_msec, next_msec))
-            continue;
-
-        if (i != j) {
-            g_free(arr[j].domain);
-            arr[j]        = arr[i];
-            arr[i].domain = NULL;
-        }
-
-        j++;
-    }
-
-    if (i != 0) {
-        *changed |= NM_NDISC_CONFIG_DNS_DOMAINS;
-        g_array_set_size(rdata->dns_domains, j);
-    }
-
-    if (_array_set_size_max(rdata->gateways, _SIZE_MAX_DNS_DOMAINS))
-        *changed |= NM_NDISC_CONFIG_DNS_DOMAINS;
-}
-
 static void
 check_timestamps(NMNDisc *ndisc, gint64 now_msec, NMNDiscConfigMap changed)
 {
-    NMNDiscPrivate *priv      = NM_NDISC_GET_PRIVATE(ndisc);
-    gint64          next_msec = G_MAXINT64;
+    NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE(ndisc);
+    ItemEntry      *entry;
+    gint64          next_msec;
 
     _LOGT("router-data: check for changed router advertisement data");
 
-    clean_gateways(ndisc, now_msec, &changed, &next_msec);
-    clean_addresses(ndisc, now_msec, &changed, &next_msec);
-    clean_routes(ndisc, now_msec, &changed, &next_msec);
-    clean_dns_servers(ndisc, now_msec, &changed, &next_msec);
-    clean_dns_domains(ndisc, now_msec, &changed, &next_msec);
+    /* The queue is sorted by expiry. Only the expired elements get touched. */
+    while ((entry = nm_prioq_peek(&priv->expiry_queue)) && entry->expiry_msec <= now_msec) {
+        changed |= _item_type_to_config_map(entry->type);
+        _item_remove(priv, entry->type, entry->idx);
+    }
+
+    next_msec = entry ? entry->expiry_msec : NM_NDISC_EXPIRY_INFINITY;
 
     nm_assert(next_msec > now_msec);
 
+    _ASSERT_data_gateways(&priv->rdata);
+
     nm_clear_g_source_inst(&priv->timeout_expire_source);
 
     if (next_msec == NM_NDISC_EXPIRY_INFINITY)
@@ -1650,44 +1820,12 @@ _calc_pre_expiry_rs_msec_worker(gint64 *earliest_expiry_msec,
 static gint64
 calc_pre_expiry_rs_msec(NMNDisc *ndisc)
 {
-    NMNDiscPrivate      *priv        = NM_NDISC_GET_PRIVATE(ndisc);
-    NMNDiscDataInternal *rdata       = &priv->rdata;
-    gint64               expiry_msec = NM_NDISC_EXPIRY_INFINITY;
-    guint                i;
+    NMNDiscPrivate  *priv        = NM_NDISC_GET_PRIVATE(ndisc);
+    gint64           expiry_msec = NM_NDISC_EXPIRY_INFINITY;
+    const ItemEntry *entry;
 
-    for (i = 0; i < rdata->gateways->len; i++) {
-        _calc_pre_expiry_rs_msec_worker(
-            &expiry_msec,
-            priv->last_rs_msec,
-            nm_g_array_index(rdata->gateways, NMNDiscGateway, i).expiry_msec);
-    }
-
-    for (i = 0; i < rdata->addresses->len; i++) {
-        _calc_pre_expiry_rs_msec_worker(
-            &expiry_msec,
-            priv->last_rs_msec,
-            nm_g_array_index(rdata->addresses, NMNDiscAddress, i).expiry_msec);
-    }
-
-    for (i = 0; i < rdata->routes->len; i++) {
-        _calc_pre_expiry_rs_msec_worker(
-            &expiry_msec,
-            priv->last_rs_msec,
-            nm_g_array_index(rdata->routes, NMNDiscRoute, i).expiry_msec);
-    }
-
-    for (i = 0; i < rdata->dns_servers->len; i++) {
-        _calc_pre_expiry_rs_msec_worker(
-            &expiry_msec,
-            priv->last_rs_msec,
-            nm_g_array_index(rdata->dns_servers, NMNDiscDNSServer, i).expiry_msec);
-    }
-
-    for (i = 0; i < rdata->dns_domains->len; i++) {
-        _calc_pre_expiry_rs_msec_worker(
-            &expiry_msec,
-            priv->last_rs_msec,
-            nm_g_array_index(rdata->dns_domains, NMNDiscDNSDomain, i).expiry_msec);
+    nm_prioq_for_each (&priv->expiry_queue, entry) {
+        _calc_pre_expiry_rs_msec_worker(&expiry_msec, priv->last_rs_msec, entry->expiry_msec);
     }
 
     return expiry_msec - solicit_retransmit_time_jitter(NM_NDISC_PRE_EXPIRY_TIME_MSEC);
@@ -1894,6 +2032,7 @@ nm_ndisc_init(NMNDisc *ndisc)
 {
     NMNDiscPrivate      *priv;
     NMNDiscDataInternal *rdata;
+    ItemType             type;
 
     priv         = G_TYPE_INSTANCE_GET_PRIVATE(ndisc, NM_TYPE_NDISC, NMNDiscPrivate);
     ndisc->_priv = priv;
@@ -1907,6 +2046,14 @@ nm_ndisc_init(NMNDisc *ndisc)
     rdata->dns_domains = g_array_new(FALSE, FALSE, sizeof(NMNDiscDNSDomain));
     g_array_set_clear_func(rdata->dns_domains, dns_domain_free);
     priv->rdata.public.hop_limit = 64;
+
+    priv->ra_prioq_idx    = NM_PRIOQ_IDX_NULL;
+    priv->ra_data_changed = TRUE;
+
+    for (type = 0; type < _ITEM_TYPE_NUM; type++)
+        priv->entries[type] = g_ptr_array_new_with_free_func(g_free);
+    priv->entries_idx = g_hash_table_new(_entry_hash, _entry_equal);
+    nm_prioq_init(&priv->expiry_queue, _entry_cmp_expiry);
 }
 
 static void
@@ -1917,7 +2064,7 @@ dispose(GObject *object)
 
     nm_clear_g_source_inst(&priv->ra_timeout_source);
     nm_clear_g_source_inst(&priv->solicit_timer_source);
-    nm_clear_g_source(&priv->send_ra_id);
+    _ra_unschedule(ndisc);
     nm_clear_g_free(&priv->last_error);
 
     nm_clear_g_source_inst(&priv->timeout_expire_source);
@@ -1931,6 +2078,12 @@ finalize(GObject *object)
     NMNDisc             *ndisc = NM_NDISC(object);
     NMNDiscPrivate      *priv  = NM_NDISC_GET_PRIVATE(ndisc);
     NMNDiscDataInternal *rdata = &priv->rdata;
+    ItemType             type;
+
+    nm_prioq_destroy(&priv->expiry_queue);
+    g_hash_table_unref(priv->entries_idx);
+    for (type = 0; type < _ITEM_TYPE_NUM; type++)
+        g_ptr_array_unref(priv->entries[type]);
 
     g_array_unref(rdata->gateways);
     g_array_unref(rdata->addresses);
@@ -218,7 +218,7 @@ typedef struct {
     void (*start)(NMNDisc *ndisc);
     void (*stop)(NMNDisc *ndisc);
     gboolean (*send_rs)(NMNDisc *ndisc, GError **error);
-    gboolean (*send_ra)(NMNDisc *ndisc, GError **error);
+    gboolean (*send_ra)(NMNDisc *ndisc, gboolean data_changed, GError **error);
 } NMNDiscClass;
 
 GType nm_ndisc_get_type(void);
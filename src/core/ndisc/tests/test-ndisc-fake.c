@@ -18,7 +18,7 @@
 /*****************************************************************************/
 
 static NMFakeNDisc *
-ndisc_new(void)
+ndisc_new_full(NMNDiscNodeType node_type)
 {
     gs_unref_object NML3Cfg *l3cfg = NULL;
     NMNDisc                 *ndisc;
@@ -27,7 +27,7 @@ ndisc_new(void)
 
     l3cfg = nm_netns_l3cfg_acquire(NM_NETNS_GET, ifindex);
 
-    ndisc = nm_fake_ndisc_new(l3cfg);
+    ndisc = nm_fake_ndisc_new(l3cfg, node_type);
     g_assert(ndisc);
 
     memset(&iid, 0, sizeof(iid));
@@ -37,6 +37,12 @@ ndisc_new(void)
     return NM_FAKE_NDISC(ndisc);
 }
 
+static NMFakeNDisc *
+ndisc_new(void)
+{
+    return ndisc_new_full(NM_NDISC_NODE_TYPE_HOST);
+}
+
 /*****************************************************************************/
 
 static void
@@ -656,6 +662,130 @@ test_dns_solicit_loop(void)
 
 /*****************************************************************************/
 
+static void
+test_expiry_changed(NMNDisc              *ndisc,
+                    const NMNDiscData    *rdata,
+                    guint                 changed_i,
+                    const NML3ConfigData *l3cd,
+                    TestData             *data)
+{
+    NMNDiscConfigMap changed = changed_i;
+
+    switch (data->counter++) {
+    case 0:
+        g_assert(changed & NM_NDISC_CONFIG_DNS_DOMAINS);
+        g_assert_cmpint(rdata->dns_servers_n, ==, 1);
+        g_assert_cmpint(rdata->dns_domains_n, ==, 2);
+        g_assert(nm_fake_ndisc_done(NM_FAKE_NDISC(ndisc)));
+        break;
+    case 1:
+        /* only the data that expired is reported as changed. */
+        g_assert_cmpint(changed, ==, NM_NDISC_CONFIG_DNS_DOMAINS);
+        g_assert_cmpint(rdata->gateways_n, ==, 1);
+        g_assert_cmpint(rdata->routes_n, ==, 1);
+        g_assert_cmpint(rdata->dns_servers_n, ==, 1);
+        g_assert_cmpint(rdata->dns_domains_n, ==, 1);
+        match_dns_domain(rdata, 0, "foobar2.com", data->timestamp_msec_1 + 10000);
+        break;
+    case 2:
+        g_assert_cmpint(changed, ==, NM_NDISC_CONFIG_DNS_SERVERS);
+        g_assert_cmpint(rdata->gateways_n, ==, 1);
+        g_assert_cmpint(rdata->routes_n, ==, 1);
+        g_assert_cmpint(rdata->dns_servers_n, ==, 0);
+        g_assert_cmpint(rdata->dns_domains_n, ==, 1);
+        g_main_loop_quit(data->loop);
+        break;
+    default:
+        g_assert_not_reached();
+    }
+}
+
+static void
+test_expiry(void)
+{
+    nm_auto_unref_gmainloop GMainLoop *loop     = g_main_loop_new(NULL, FALSE);
+    gs_unref_object NMFakeNDisc       *ndisc    = ndisc_new();
+    const gint64                       now_msec = nm_utils_get_monotonic_timestamp_msec();
+    TestData                           data     = {
+                                      .loop             = loop,
+                                      .timestamp_msec_1 = now_msec,
+    };
+    guint id;
+
+    id = nm_fake_ndisc_add_ra(ndisc, 1, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+    g_assert(id);
+
+    nm_fake_ndisc_add_gateway(ndisc, id, "fe80::1", now_msec + 10000, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+    nm_fake_ndisc_add_prefix(ndisc,
+                             id,
+                             "2001:db8:a:a::",
+                             64,
+                             "fe80::1",
+                             now_msec + 10000,
+                             now_msec + 10000,
+                             10);
+    nm_fake_ndisc_add_dns_server(ndisc, id, "2001:db8:c:c::1", now_msec + 2500);
+    nm_fake_ndisc_add_dns_domain(ndisc, id, "foobar.com", now_msec + 1500);
+    nm_fake_ndisc_add_dns_domain(ndisc, id, "foobar2.com", now_msec + 10000);
+
+    g_signal_connect(ndisc, NM_NDISC_CONFIG_RECEIVED, G_CALLBACK(test_expiry_changed), &data);
+
+    nm_ndisc_start(NM_NDISC(ndisc));
+    nmtst_main_loop_run_assert(data.loop, 15000);
+    g_assert_cmpint(data.counter, ==, 3);
+}
+
+/*****************************************************************************/
+
+static void
+_test_router_ra_sent(NMNDisc *ndisc, guint *counter)
+{
+    (*counter)++;
+}
+
+static void
+test_router_shared_timer(void)
+{
+    gs_unref_object NMFakeNDisc *ndisc_a   = ndisc_new_full(NM_NDISC_NODE_TYPE_ROUTER);
+    gs_unref_object NMFakeNDisc *ndisc_b   = ndisc_new_full(NM_NDISC_NODE_TYPE_ROUTER);
+    guint                        counter_a = 0;
+    guint                        counter_b = 0;
+
+    /* All router mode instances are queued on one timer. Removing an instance
+     * from the queue must not lose the timer for the others. */
+
+    g_signal_connect(ndisc_a, NM_FAKE_NDISC_RA_SENT, G_CALLBACK(_test_router_ra_sent), &counter_a);
+    g_signal_connect(ndisc_b, NM_FAKE_NDISC_RA_SENT, G_CALLBACK(_test_router_ra_sent), &counter_b);
+
+    /* Both instances get their initial announcement. */
+    nm_ndisc_start(NM_NDISC(ndisc_a));
+    nm_ndisc_start(NM_NDISC(ndisc_b));
+    nmtst_main_context_iterate_until_assert(NULL, 5000, counter_a > 0 && counter_b > 0);
+    g_assert_cmpint(counter_a, ==, 1);
+    g_assert_cmpint(counter_b, ==, 1);
+
+    /* Stopping a queued instance leaves the other scheduled. */
+    nm_ndisc_stop(NM_NDISC(ndisc_a));
+    nm_ndisc_stop(NM_NDISC(ndisc_b));
+    nm_ndisc_start(NM_NDISC(ndisc_a));
+    nm_ndisc_start(NM_NDISC(ndisc_b));
+    nm_ndisc_stop(NM_NDISC(ndisc_a));
+    nmtst_main_context_iterate_until_assert(NULL, 5000, counter_b > 1);
+    g_assert_cmpint(counter_a, ==, 1);
+    g_assert_cmpint(counter_b, ==, 2);
+
+    /* Disposing a queued instance leaves the other scheduled. */
+    nm_ndisc_start(NM_NDISC(ndisc_a));
+    g_clear_object(&ndisc_b);
+    nmtst_main_context_iterate_until_assert(NULL, 5000, counter_a > 1);
+    g_assert_cmpint(counter_a, ==, 2);
+    g_assert_cmpint(counter_b, ==, 2);
+
+    nm_ndisc_stop(NM_NDISC(ndisc_a));
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE();
 
 int
@@ -676,6 +806,8 @@ main(int argc, char **argv)
     g_test_add_func("/ndisc/preference-order", test_preference_order);
     g_test_add_func("/ndisc/preference-changed", test_preference_changed);
     g_test_add_func("/ndisc/dns-solicit-loop", test_dns_solicit_loop);
+    g_test_add_func("/ndisc/expiry", test_expiry);
+    g_test_add_func("/ndisc/router-shared-timer", test_router_shared_timer);
 
     return g_test_run();
 }
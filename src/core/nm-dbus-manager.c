@@ -18,6 +18,7 @@
 #include "libnm-core-intern/nm-core-internal.h"
 #include "libnm-std-aux/nm-dbus-compat.h"
 #include "nm-dbus-object.h"
+#include "nm-config.h"
 #include "NetworkManagerUtils.h"
 #include "libnm-core-aux-intern/nm-auth-subject.h"
 
@@ -43,12 +44,19 @@ typedef struct {
 
 typedef struct {
     GVariant *value;
+
+    /* Whether the property changed, and a PropertiesChanged signal is
+     * pending. */
+    bool dirty : 1;
 } PropertyCacheData;
 
 typedef struct {
     CList              registration_lst;
+    CList              notify_dirty_lst;
     NMDBusObject      *obj;
     NMDBusObjectClass *klass;
+    GHashTable        *property_index;
+    GVariant          *properties_snapshot;
     guint              info_idx;
     guint              registration_id;
     PropertyCacheData  property_cache[];
@@ -80,6 +88,14 @@ typedef struct {
 
     CList caller_info_lst_head;
 
+    NMConfig *config;
+
+    /* RegistrationData with pending PropertiesChanged signals. */
+    CList    notify_dirty_lst_head;
+    GSource *notify_source;
+    gint64   notify_last_msec;
+    guint    notify_interval_msec;
+
     guint objmgr_registration_id;
     bool  started : 1;
     bool  shutting_down : 1;
@@ -111,6 +127,7 @@ static const GDBusInterfaceInfo interface_info_objmgr;
 static const GDBusSignalInfo    signal_info_objmgr_interfaces_added;
 static const GDBusSignalInfo    signal_info_objmgr_interfaces_removed;
 static GVariantBuilder *_obj_collect_properties_all(NMDBusObject *obj, GVariantBuilder *builder);
+static void             _obj_notify_flush_obj(NMDBusManager *self, NMDBusObject *obj);
 
 /*****************************************************************************/
 
@@ -983,6 +1000,9 @@ _obj_register(NMDBusManager *self, NMDBusObject *obj)
             reg_data->klass           = g_type_class_ref(G_TYPE_FROM_CLASS(klass));
             reg_data->info_idx        = i;
             reg_data->registration_id = registration_id;
+            reg_data->property_index =
+                nm_dbus_utils_interface_info_get_property_index(interface_info);
+            c_list_init(&reg_data->notify_dirty_lst);
             c_list_link_tail(&obj->internal.registration_lst_head, &reg_data->registration_lst);
         }
     }
@@ -992,6 +1012,11 @@ _obj_register(NMDBusManager *self, NMDBusObject *obj)
 
     nm_assert(!c_list_is_empty(&obj->internal.registration_lst_head));
 
+    /* We don't flush the pending PropertiesChanged signals here. InterfacesAdded is
+     * sent right away, while the values of pending changes are only collected when
+     * they get flushed. A PropertiesChanged signal that references the path of @obj
+     * is therefore always sent after @obj's InterfacesAdded. */
+
     /* Currently, the interfaces of an object do not changed and strictly depend on the object glib type.
      * We don't need more flexibility, and it simplifies the code. Hence, now emit interface-added
      * signal for the new object.
@@ -1029,6 +1054,9 @@ _obj_unregister(NMDBusManager *self, NMDBusObject *obj)
     nm_assert(priv->started);
     nm_assert(!c_list_is_empty(&obj->internal.registration_lst_head));
 
+    /* Send the pending changes of @obj, before it goes away. */
+    _obj_notify_flush_obj(self, obj);
+
     g_variant_builder_init(&builder, G_VARIANT_TYPE("as"));
 
     while ((reg_data = c_list_last_entry(&obj->internal.registration_lst_head,
@@ -1039,6 +1067,7 @@ _obj_unregister(NMDBusManager *self, NMDBusObject *obj)
 
         g_variant_builder_add(&builder, "s", interface_info->parent.name);
         c_list_unlink_stale(&reg_data->registration_lst);
+        nm_assert(!c_list_is_linked(&reg_data->notify_dirty_lst));
         if (!g_dbus_connection_unregister_object(priv->main_dbus_connection,
                                                  reg_data->registration_id))
             nm_assert_not_reached();
@@ -1047,6 +1076,7 @@ _obj_unregister(NMDBusManager *self, NMDBusObject *obj)
             for (i = 0; interface_info->parent.properties[i]; i++)
                 nm_clear_g_variant(&reg_data->property_cache[i].value);
         }
+        nm_clear_g_variant(&reg_data->properties_snapshot);
 
         g_type_class_unref(reg_data->klass);
         g_free(reg_data);
@@ -1147,13 +1177,132 @@ _nm_dbus_manager_obj_unexport(NMDBusObject *obj)
     c_list_unlink(&obj->internal.objects_lst);
 }
 
+static void
+_obj_notify_emit(NMDBusManager *self, RegistrationData *reg_data)
+{
+    NMDBusManagerPrivate              *priv           = NM_DBUS_MANAGER_GET_PRIVATE(self);
+    const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info(reg_data);
+    gboolean                           has_properties = FALSE;
+    GVariantBuilder                    builder;
+    GVariantBuilder                    invalidated_builder;
+    GVariant                          *args;
+    guint                              i;
+
+    /* The order in which properties are added to the GVariant is strictly defined
+     * to be the order in which the D-Bus property-info is declared. */
+    for (i = 0; interface_info->parent.properties[i]; i++) {
+        const NMDBusPropertyInfoExtended *property_info =
+            (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+        gs_unref_variant GVariant *value = NULL;
+
+        if (!reg_data->property_cache[i].dirty)
+            continue;
+        reg_data->property_cache[i].dirty = FALSE;
+
+        value = _obj_get_property(reg_data, i, FALSE);
+
+        if (!has_properties) {
+            has_properties = TRUE;
+            g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+        }
+        g_variant_builder_add(&builder, "{sv}", property_info->parent.name, value);
+    }
+
+    if (!has_properties)
+        return;
+
+    args = g_variant_builder_end(&builder);
+
+    g_variant_builder_init(&invalidated_builder, G_VARIANT_TYPE("as"));
+    g_dbus_connection_emit_signal(
+        priv->main_dbus_connection,
+        NULL,
+        reg_data->obj->internal.path,
+        DBUS_INTERFACE_PROPERTIES,
+        "PropertiesChanged",
+        g_variant_new("(s@a{sv}as)", interface_info->parent.name, args, &invalidated_builder),
+        NULL);
+}
+
+static void
+_obj_notify_flush(NMDBusManager *self)
+{
+    NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE(self);
+    RegistrationData     *reg_data;
+
+    nm_clear_g_source_inst(&priv->notify_source);
+
+    while ((reg_data = c_list_first_entry(&priv->notify_dirty_lst_head,
+                                          RegistrationData,
+                                          notify_dirty_lst))) {
+        c_list_unlink(&reg_data->notify_dirty_lst);
+        _obj_notify_emit(self, reg_data);
+    }
+}
+
+static void
+_obj_notify_flush_obj(NMDBusManager *self, NMDBusObject *obj)
+{
+    NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE(self);
+    RegistrationData     *reg_data;
+
+    c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
+        if (!c_list_is_linked(&reg_data->notify_dirty_lst))
+            continue;
+        c_list_unlink(&reg_data->notify_dirty_lst);
+        _obj_notify_emit(self, reg_data);
+    }
+
+    if (c_list_is_empty(&priv->notify_dirty_lst_head))
+        nm_clear_g_source_inst(&priv->notify_source);
+}
+
+static gboolean
+_obj_notify_flush_cb(gpointer user_data)
+{
+    NMDBusManager        *self = user_data;
+    NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE(self);
+
+    priv->notify_last_msec = nm_utils_get_monotonic_timestamp_msec();
+    _obj_notify_flush(self);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+_obj_notify_schedule(NMDBusManager *self)
+{
+    NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE(self);
+    gint64                timeout_msec;
+
+    if (priv->notify_source)
+        return;
+
+    if (priv->notify_interval_msec == 0) {
+        /* By default, the changes are sent once per main loop iteration. Use
+         * the default priority, so that we don't wait until NetworkManager
+         * becomes idle, which might not happen while being busy. */
+        priv->notify_source = nm_g_source_attach(
+            nm_g_idle_source_new(G_PRIORITY_DEFAULT, _obj_notify_flush_cb, self, NULL),
+            NULL);
+        return;
+    }
+
+    timeout_msec = priv->notify_last_msec + priv->notify_interval_msec
+                   - nm_utils_get_monotonic_timestamp_msec();
+    priv->notify_source =
+        nm_g_timeout_add_source(NM_CLAMP(timeout_msec, 0, (gint64) priv->notify_interval_msec),
+                                _obj_notify_flush_cb,
+                                self);
+}
+
 void
 _nm_dbus_manager_obj_notify(NMDBusObject *obj, guint n_pspecs, const GParamSpec *const *pspecs)
 {
     NMDBusManager        *self;
     NMDBusManagerPrivate *priv;
     RegistrationData     *reg_data;
-    guint                 i, p;
+    gboolean              any_dirty = FALSE;
+    guint                 p;
 
     nm_assert(NM_IS_DBUS_OBJECT(obj));
     nm_assert(obj->internal.path);
@@ -1170,59 +1319,41 @@ _nm_dbus_manager_obj_notify(NMDBusObject *obj, guint n_pspecs, const GParamSpec
     if (G_UNLIKELY(!priv->started))
         return;
 
-    /* do a naive search for the matching NMDBusPropertyInfoExtended infos. Since the number of
-     * (interfaces x properties) is static and possibly small, this naive search is effectively
-     * O(1). We might wanna introduce some index to lookup the properties in question faster.
+    /* Each interface has an index from the GObject property name to the D-Bus property,
+     * so the cost only depends on the number of interfaces and changed properties.
      *
-     * The nice part of this implementation is however, that the order in which properties
-     * are added to the GVariant is strictly defined to be the order in which the D-Bus property-info
-     * is declared. Getting a defined ordering with some smart lookup would be hard. */
+     * We only mark the properties as dirty. The PropertiesChanged signals are sent later
+     * by _obj_notify_flush(), so that many changes of the same object (during one main loop
+     * iteration, or within the configured interval) result in one signal per interface.
+     * The cached value is dropped right away, so that a "Get" call in the meantime returns
+     * the current value. */
     c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
-        const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info(reg_data);
-        gboolean                           has_properties = FALSE;
-        GVariantBuilder                    builder;
-        GVariantBuilder                    invalidated_builder;
-        GVariant                          *args;
-
-        if (!interface_info->parent.properties)
-            continue;
-
-        for (i = 0; interface_info->parent.properties[i]; i++) {
-            const NMDBusPropertyInfoExtended *property_info =
-                (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+        gboolean has_properties = FALSE;
 
-            for (p = 0; p < n_pspecs; p++) {
-                const GParamSpec          *pspec = pspecs[p];
-                gs_unref_variant GVariant *value = NULL;
+        for (p = 0; p < n_pspecs; p++) {
+            int i;
 
-                if (!nm_streq(property_info->property_name, pspec->name))
-                    continue;
-
-                value = _obj_get_property(reg_data, i, TRUE);
+            i = nm_dbus_utils_property_index_lookup(reg_data->property_index, pspecs[p]->name);
+            if (i < 0)
+                continue;
 
-                if (!has_properties) {
-                    has_properties = TRUE;
-                    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
-                }
-                g_variant_builder_add(&builder, "{sv}", property_info->parent.name, value);
-            }
+            nm_clear_g_variant(&reg_data->property_cache[i].value);
+            reg_data->property_cache[i].dirty = TRUE;
+            has_properties                    = TRUE;
         }
 
         if (!has_properties)
             continue;
 
-        args = g_variant_builder_end(&builder);
+        nm_clear_g_variant(&reg_data->properties_snapshot);
 
-        g_variant_builder_init(&invalidated_builder, G_VARIANT_TYPE("as"));
-        g_dbus_connection_emit_signal(
-            priv->main_dbus_connection,
-            NULL,
-            obj->internal.path,
-            DBUS_INTERFACE_PROPERTIES,
-            "PropertiesChanged",
-            g_variant_new("(s@a{sv}as)", interface_info->parent.name, args, &invalidated_builder),
-            NULL);
+        any_dirty = TRUE;
+        if (!c_list_is_linked(&reg_data->notify_dirty_lst))
+            c_list_link_tail(&priv->notify_dirty_lst_head, &reg_data->notify_dirty_lst);
     }
+
+    if (any_dirty)
+        _obj_notify_schedule(self);
 }
 
 void
@@ -1247,6 +1378,10 @@ _nm_dbus_manager_obj_emit_signal(NMDBusObject                      *obj,
         return;
     }
 
+    /* Signals like "StateChanged" usually go along with property changes. Send
+     * the pending PropertiesChanged signals of @obj first, to keep the order. */
+    _obj_notify_flush_obj(self, obj);
+
     g_dbus_connection_emit_signal(priv->main_dbus_connection,
                                   NULL,
                                   obj->internal.path,
@@ -1258,15 +1393,21 @@ _nm_dbus_manager_obj_emit_signal(NMDBusObject                      *obj,
 
 /*****************************************************************************/
 
-static GVariantBuilder *
-_obj_collect_properties_per_interface(NMDBusObject     *obj,
-                                      RegistrationData *reg_data,
-                                      GVariantBuilder  *builder)
+static GVariant *
+_obj_collect_properties_per_interface(RegistrationData *reg_data)
 {
     const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info(reg_data);
+    GVariantBuilder                    builder;
     guint                              i;
 
-    g_variant_builder_init(builder, G_VARIANT_TYPE("a{sv}"));
+    /* The "a{sv}" with all properties of the interface is cached until the next
+     * property change. Like the per-property cache, that relies on the notify signal.
+     * InterfacesAdded and GetManagedObjects then only take references to the
+     * snapshots, instead of serializing all properties of all objects anew. */
+    if (reg_data->properties_snapshot)
+        return reg_data->properties_snapshot;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
     if (interface_info->parent.properties) {
         for (i = 0; interface_info->parent.properties[i]; i++) {
             const NMDBusPropertyInfoExtended *property_info =
@@ -1274,10 +1415,12 @@ _obj_collect_properties_per_interface(NMDBusObject     *obj,
             gs_unref_variant GVariant *variant = NULL;
 
             variant = _obj_get_property(reg_data, i, FALSE);
-            g_variant_builder_add(builder, "{sv}", property_info->parent.name, variant);
+            g_variant_builder_add(&builder, "{sv}", property_info->parent.name, variant);
         }
     }
-    return builder;
+
+    reg_data->properties_snapshot = g_variant_ref_sink(g_variant_builder_end(&builder));
+    return reg_data->properties_snapshot;
 }
 
 static GVariantBuilder *
@@ -1288,13 +1431,10 @@ _obj_collect_properties_all(NMDBusObject *obj, GVariantBuilder *builder)
     g_variant_builder_init(builder, G_VARIANT_TYPE("a{sa{sv}}"));
 
     c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
-        GVariantBuilder properties_builder;
-
-        g_variant_builder_add(
-            builder,
-            "{sa{sv}}",
-            _reg_data_get_interface_info(reg_data)->parent.name,
-            _obj_collect_properties_per_interface(obj, reg_data, &properties_builder));
+        g_variant_builder_add(builder,
+                              "{s@a{sv}}",
+                              _reg_data_get_interface_info(reg_data)->parent.name,
+                              _obj_collect_properties_per_interface(reg_data));
     }
 
     return builder;
@@ -1382,6 +1522,32 @@ nm_dbus_manager_get_dbus_connection(NMDBusManager *self)
     return NM_DBUS_MANAGER_GET_PRIVATE(self)->main_dbus_connection;
 }
 
+static void
+_config_read(NMDBusManager *self)
+{
+    NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE(self);
+
+    priv->notify_interval_msec =
+        nm_config_data_get_value_int64(nm_config_get_data(priv->config),
+                                       NM_CONFIG_KEYFILE_GROUP_MAIN,
+                                       NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_NOTIFY_INTERVAL,
+                                       10,
+                                       0,
+                                       60000,
+                                       0);
+}
+
+static void
+_config_changed_cb(NMConfig           *config,
+                   NMConfigData       *config_data,
+                   NMConfigChangeFlags changes,
+                   NMConfigData       *old_data,
+                   NMDBusManager      *self)
+{
+    if (NM_FLAGS_HAS(changes, NM_CONFIG_CHANGE_VALUES))
+        _config_read(self);
+}
+
 void
 nm_dbus_manager_start(NMDBusManager                  *self,
                       NMDBusManagerSetPropertyHandler set_property_handler,
@@ -1405,6 +1571,13 @@ nm_dbus_manager_start(NMDBusManager                  *self,
     priv->set_property_handler_data = set_property_handler_data;
     priv->started                   = TRUE;
 
+    priv->config = g_object_ref(nm_config_get());
+    _config_read(self);
+    g_signal_connect(priv->config,
+                     NM_CONFIG_SIGNAL_CONFIG_CHANGED,
+                     G_CALLBACK(_config_changed_cb),
+                     self);
+
     c_list_for_each_entry (obj, &priv->objects_lst_head, internal.objects_lst)
         _obj_register(self, obj);
 }
@@ -1461,29 +1634,14 @@ nm_dbus_manager_request_name_sync(NMDBusManager *self)
     return TRUE;
 }
 
-gboolean
-nm_dbus_manager_setup(NMDBusManager *self)
+static gboolean
+_setup_connection(NMDBusManager *self, GDBusConnection *connection)
 {
-    NMDBusManagerPrivate *priv;
+    NMDBusManagerPrivate *priv  = NM_DBUS_MANAGER_GET_PRIVATE(self);
     gs_free_error GError *error = NULL;
     guint                 registration_id;
 
-    g_return_val_if_fail(NM_IS_DBUS_MANAGER(self), FALSE);
-
-    priv = NM_DBUS_MANAGER_GET_PRIVATE(self);
-
-    g_return_val_if_fail(!priv->main_dbus_connection, FALSE);
-
-    /* Create the D-Bus connection and registering the name synchronously.
-     * That is necessary because we need to exit right away if we can't
-     * acquire the name despite connecting to the bus successfully.
-     * It means that something is gravely broken -- such as another NetworkManager
-     * instance running. */
-    priv->main_dbus_connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
-    if (!priv->main_dbus_connection) {
-        _LOGE("cannot connect to D-Bus: %s", error->message);
-        return FALSE;
-    }
+    priv->main_dbus_connection = connection;
 
     g_dbus_connection_set_exit_on_close(priv->main_dbus_connection, FALSE);
 
@@ -1507,6 +1665,43 @@ nm_dbus_manager_setup(NMDBusManager *self)
     return TRUE;
 }
 
+gboolean
+nm_dbus_manager_setup(NMDBusManager *self)
+{
+    NMDBusManagerPrivate *priv;
+    gs_free_error GError *error = NULL;
+    GDBusConnection      *connection;
+
+    g_return_val_if_fail(NM_IS_DBUS_MANAGER(self), FALSE);
+
+    priv = NM_DBUS_MANAGER_GET_PRIVATE(self);
+
+    g_return_val_if_fail(!priv->main_dbus_connection, FALSE);
+
+    /* Create the D-Bus connection and registering the name synchronously.
+     * That is necessary because we need to exit right away if we can't
+     * acquire the name despite connecting to the bus successfully.
+     * It means that something is gravely broken -- such as another NetworkManager
+     * instance running. */
+    connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    if (!connection) {
+        _LOGE("cannot connect to D-Bus: %s", error->message);
+        return FALSE;
+    }
+
+    return _setup_connection(self, connection);
+}
+
+gboolean
+_nm_dbus_manager_setup_for_connection(NMDBusManager *self, GDBusConnection *connection)
+{
+    g_return_val_if_fail(NM_IS_DBUS_MANAGER(self), FALSE);
+    g_return_val_if_fail(G_IS_DBUS_CONNECTION(connection), FALSE);
+    g_return_val_if_fail(!NM_DBUS_MANAGER_GET_PRIVATE(self)->main_dbus_connection, FALSE);
+
+    return _setup_connection(self, g_object_ref(connection));
+}
+
 void
 nm_dbus_manager_stop(NMDBusManager *self)
 {
@@ -1514,6 +1709,16 @@ nm_dbus_manager_stop(NMDBusManager *self)
 
     priv->shutting_down = TRUE;
 
+    /* From now on, send property changes right away. The main loop might not
+     * iterate much longer. */
+    priv->notify_interval_msec = 0;
+    _obj_notify_flush(self);
+
+    if (priv->config) {
+        g_signal_handlers_disconnect_by_func(priv->config, _config_changed_cb, self);
+        g_clear_object(&priv->config);
+    }
+
     /* during shutdown we also clear the set-property-handler. It's no longer
      * possible to set a property, because doing so would require authorization,
      * which is async, which is just complicated to get right. No more property
@@ -1542,6 +1747,7 @@ nm_dbus_manager_init(NMDBusManager *self)
         g_hash_table_new((GHashFunc) _objects_by_path_hash, (GEqualFunc) _objects_by_path_equal);
 
     c_list_init(&priv->caller_info_lst_head);
+    c_list_init(&priv->notify_dirty_lst_head);
 }
 
 static void
@@ -1559,6 +1765,14 @@ dispose(GObject *object)
 
     nm_clear_pointer(&priv->objects_by_path, g_hash_table_destroy);
 
+    nm_assert(c_list_is_empty(&priv->notify_dirty_lst_head));
+    nm_clear_g_source_inst(&priv->notify_source);
+
+    if (priv->config) {
+        g_signal_handlers_disconnect_by_func(priv->config, _config_changed_cb, self);
+        g_clear_object(&priv->config);
+    }
+
     c_list_for_each_entry_safe (s, s_safe, &priv->private_servers_lst_head, private_servers_lst)
         private_server_free(s);
 
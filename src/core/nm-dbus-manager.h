@@ -96,4 +96,7 @@ NMAuthSubject *nm_dbus_manager_new_auth_subject_from_context(GDBusMethodInvocati
 NMAuthSubject *nm_dbus_manager_new_auth_subject_from_message(GDBusConnection *connection,
                                                              GDBusMessage    *message);
 
+/* For testing only */
+gboolean _nm_dbus_manager_setup_for_connection(NMDBusManager *self, GDBusConnection *connection);
+
 #endif /* __NM_DBUS_MANAGER_H__ */
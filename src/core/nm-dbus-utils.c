@@ -49,6 +49,54 @@ nm_dbus_utils_interface_info_lookup_property(const GDBusInterfaceInfo *interface
     return NULL;
 }
 
+/**
+ * nm_dbus_utils_interface_info_get_property_index:
+ * @interface_info: the (static) interface info.
+ *
+ * Returns: (transfer none): an index from the GObject property name
+ *   (NMDBusPropertyInfoExtended.property_name) to the index of the D-Bus
+ *   property in @interface_info. Look it up with
+ *   nm_dbus_utils_property_index_lookup().
+ *   The index is created on first use, and kept for the lifetime of the
+ *   process, like the static interface info itself.
+ */
+GHashTable *
+nm_dbus_utils_interface_info_get_property_index(const NMDBusInterfaceInfoExtended *interface_info)
+{
+    static GHashTable *indexes = NULL;
+    GHashTable        *property_index;
+    guint              i;
+
+    nm_assert(interface_info);
+    NM_ASSERT_ON_MAIN_THREAD();
+
+    if (G_UNLIKELY(!indexes))
+        indexes = g_hash_table_new(nm_direct_hash, NULL);
+    else {
+        property_index = g_hash_table_lookup(indexes, interface_info);
+        if (property_index)
+            return property_index;
+    }
+
+    property_index = g_hash_table_new(nm_str_hash, g_str_equal);
+    if (interface_info->parent.properties) {
+        for (i = 0; interface_info->parent.properties[i]; i++) {
+            const NMDBusPropertyInfoExtended *property_info =
+                (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+
+            /* Each GObject property is exposed at most once per interface. */
+            nm_assert(!g_hash_table_contains(property_index, property_info->property_name));
+
+            g_hash_table_insert(property_index,
+                                (gpointer) property_info->property_name,
+                                GUINT_TO_POINTER(i + 1u));
+        }
+    }
+
+    g_hash_table_insert(indexes, (gpointer) interface_info, property_index);
+    return property_index;
+}
+
 GDBusMethodInfo *
 nm_dbus_utils_interface_info_lookup_method(const GDBusInterfaceInfo *interface_info,
                                            const char               *method_name)
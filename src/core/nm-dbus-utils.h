@@ -135,6 +135,15 @@ nm_dbus_utils_interface_info_lookup_property(const GDBusInterfaceInfo *interface
                                              const char               *property_name,
                                              guint                    *property_idx);
 
+GHashTable *
+nm_dbus_utils_interface_info_get_property_index(const NMDBusInterfaceInfoExtended *interface_info);
+
+static inline int
+nm_dbus_utils_property_index_lookup(GHashTable *property_index, const char *property_name)
+{
+    return ((int) GPOINTER_TO_UINT(g_hash_table_lookup(property_index, property_name))) - 1;
+}
+
 GDBusMethodInfo *
 nm_dbus_utils_interface_info_lookup_method(const GDBusInterfaceInfo *interface_info,
                                            const char               *method_name);
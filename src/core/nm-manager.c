@@ -1199,8 +1199,7 @@ _get_activatable_connections_filter(NMSettings           *settings,
                          | NM_SETTINGS_CONNECTION_INT_FLAGS_EXTERNAL))
         return FALSE;
 
-    multi_connect =
-        _nm_connection_get_multi_connect(nm_settings_connection_get_connection(sett_conn));
+    multi_connect = nm_settings_connection_get_multi_connect(sett_conn);
     if (multi_connect == NM_CONNECTION_MULTI_CONNECT_MULTIPLE
         || (multi_connect == NM_CONNECTION_MULTI_CONNECT_MANUAL_MULTIPLE
             && !d->for_auto_activation))
@@ -2572,7 +2571,7 @@ nm_manager_iface_for_uuid(NMManager *self, const char *uuid)
     if (!sett_conn)
         return NULL;
 
-    return nm_connection_get_interface_name(nm_settings_connection_get_connection(sett_conn));
+    return nm_settings_connection_get_interface_name(sett_conn);
 }
 
 NMDevice *
@@ -3345,10 +3344,9 @@ fail_on_idle:
 static gboolean
 new_activation_allowed_for_connection(NMManager *self, NMSettingsConnection *connection)
 {
-    if (NM_IN_SET(
-            _nm_connection_get_multi_connect(nm_settings_connection_get_connection(connection)),
-            NM_CONNECTION_MULTI_CONNECT_MANUAL_MULTIPLE,
-            NM_CONNECTION_MULTI_CONNECT_MULTIPLE))
+    if (NM_IN_SET(nm_settings_connection_get_multi_connect(connection),
+                  NM_CONNECTION_MULTI_CONNECT_MANUAL_MULTIPLE,
+                  NM_CONNECTION_MULTI_CONNECT_MULTIPLE))
         return TRUE;
 
     return !active_connection_find(self,
@@ -5970,8 +5968,7 @@ _internal_activate_device(NMManager *self, NMActiveConnection *active, GError **
                        nm_active_connection_get_activation_reason(active)
                            == NM_ACTIVATION_REASON_USER_REQUEST);
 
-    multi_connect =
-        _nm_connection_get_multi_connect(nm_settings_connection_get_connection(sett_conn));
+    multi_connect = nm_settings_connection_get_multi_connect(sett_conn);
     if (multi_connect == NM_CONNECTION_MULTI_CONNECT_MULTIPLE
         || (multi_connect == NM_CONNECTION_MULTI_CONNECT_MANUAL_MULTIPLE
             && NM_IN_SET(nm_active_connection_get_activation_reason(active),
@@ -1374,18 +1374,16 @@ _auto_activate_device(NMPolicy *self, NMDevice *device)
     for (i = 0; i < len; i++) {
         NMSettingsConnection *candidate = connections[i];
         NMConnection         *cand_conn;
-        NMSettingConnection  *s_con;
         const char           *permission;
 
         if (nm_manager_devcon_autoconnect_is_blocked(priv->manager, device, candidate))
             continue;
 
-        cand_conn = nm_settings_connection_get_connection(candidate);
-
-        s_con = nm_connection_get_setting_connection(cand_conn);
-        if (!nm_setting_connection_get_autoconnect(s_con))
+        if (!nm_settings_connection_get_autoconnect(candidate))
             continue;
 
+        cand_conn = nm_settings_connection_get_connection(candidate);
+
         permission = nm_utils_get_shared_wifi_permission(cand_conn);
         if (permission && !nm_settings_connection_check_permission(candidate, permission))
             continue;
@@ -25,6 +25,7 @@
 #include "nm-audit-manager.h"
 #include "nm-settings.h"
 #include "nm-manager.h"
+#include "nm-active-connection.h"
 #include "nm-dbus-manager.h"
 #include "settings/plugins/keyfile/nms-keyfile-storage.h"
 
@@ -134,6 +135,27 @@ typedef struct _NMSettingsConnectionPrivate {
 
     NMConnection *connection;
 
+    /* A few properties of the profile that are always kept resident, so
+     * that profiles can be looked up, sorted and filtered without
+     * accessing (and, in lazy mode, re-creating) @connection. */
+    struct {
+        char                    *id;
+        char                    *connection_type;
+        char                    *interface_name;
+        const char             **permission_users;
+        gint32                   autoconnect_priority;
+        NMConnectionMultiConnect multi_connect : 4;
+        bool                     autoconnect : 1;
+        bool                     has_permissions : 1;
+    } index;
+
+    /* With "main.lazy-load-connections", a profile that is not in use
+     * only keeps the serialized form of its settings (including secrets).
+     * @connection is then released and re-created on demand. */
+    struct {
+        GVariant *variant;
+    } lazy;
+
     struct {
         NMConnectionSerializationOptions options;
         GVariant                        *variant;
@@ -338,7 +360,7 @@ _getsettings_cached_get(NMSettingsConnection *self, const NMConnectionSerializat
 #if NM_MORE_ASSERTS > 10
             gs_unref_variant GVariant *variant2 = NULL;
 
-            variant = nm_connection_to_dbus_full(priv->connection,
+            variant = nm_connection_to_dbus_full(nm_settings_connection_get_connection(self),
                                                  NM_CONNECTION_SERIALIZE_WITH_NON_SECRET,
                                                  options);
             nm_assert(variant);
@@ -352,7 +374,7 @@ _getsettings_cached_get(NMSettingsConnection *self, const NMConnectionSerializat
 
     nm_assert(!priv->getsettings_cached.options.seen_bssids);
 
-    variant = nm_connection_to_dbus_full(priv->connection,
+    variant = nm_connection_to_dbus_full(nm_settings_connection_get_connection(self),
                                          NM_CONNECTION_SERIALIZE_WITH_NON_SECRET,
                                          options);
     nm_assert(variant);
@@ -368,12 +390,137 @@ _getsettings_cached_get(NMSettingsConnection *self, const NMConnectionSerializat
 
 /*****************************************************************************/
 
+static gboolean
+_lazy_is_in_use(NMSettingsConnection *self)
+{
+    NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE(self);
+    NMActiveConnection          *ac;
+    NMManager                   *manager;
+    const CList                 *tmp_lst;
+
+    /* somebody else holds a reference to our connection. Keep it. */
+    if (G_OBJECT(priv->connection)->ref_count > 1)
+        return TRUE;
+
+    if (!c_list_is_empty(&priv->call_ids_lst_head) || !c_list_is_empty(&priv->auth_lst_head))
+        return TRUE;
+
+    manager = nm_settings_connection_get_manager(self);
+    if (manager) {
+        nm_manager_for_each_active_connection (manager, ac, tmp_lst) {
+            if (_nm_active_connection_get_settings_connection(ac) == self)
+                return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+gboolean
+_nm_settings_connection_lazy_release(NMSettingsConnection *self)
+{
+    NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE(self);
+
+    if (!priv->connection)
+        return TRUE;
+
+    if (_lazy_is_in_use(self))
+        return FALSE;
+
+    if (!priv->lazy.variant) {
+        priv->lazy.variant = g_variant_ref_sink(
+            nm_connection_to_dbus(priv->connection, NM_CONNECTION_SERIALIZE_ALL));
+    }
+
+    _LOGT("lazy: release connection (%" G_GSIZE_FORMAT " bytes serialized)",
+          g_variant_get_size(priv->lazy.variant));
+
+    _getsettings_cached_clear(priv);
+    g_clear_object(&priv->connection);
+    return TRUE;
+}
+
+static void
+_lazy_materialize(NMSettingsConnection *self)
+{
+    NMSettingsConnectionPrivate *priv  = NM_SETTINGS_CONNECTION_GET_PRIVATE(self);
+    gs_free_error GError        *error = NULL;
+
+    nm_assert(!priv->connection);
+    nm_assert(priv->lazy.variant);
+
+    priv->connection = _nm_simple_connection_new_from_dbus(priv->lazy.variant,
+                                                           NM_SETTING_PARSE_FLAGS_BEST_EFFORT,
+                                                           &error);
+    if (!priv->connection) {
+        /* This cannot happen, the variant was created from a valid connection. */
+        _LOGE("lazy: failure to re-create connection: %s", error->message);
+        nm_assert_not_reached();
+        priv->connection = nm_simple_connection_new();
+    } else
+        _LOGT("lazy: re-created connection");
+
+    nm_assert_connection_unchanging(priv->connection);
+}
+
+static void
+_index_update(NMSettingsConnection *self)
+{
+    NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE(self);
+    NMSettingConnection         *s_con;
+    gs_unref_ptrarray GPtrArray *users = NULL;
+    guint                        num;
+    guint                        i;
+
+    s_con = nm_connection_get_setting_connection(priv->connection);
+
+    nm_strdup_reset(&priv->index.id, nm_setting_connection_get_id(s_con));
+    nm_strdup_reset(&priv->index.connection_type,
+                    nm_setting_connection_get_connection_type(s_con));
+    nm_strdup_reset(&priv->index.interface_name, nm_setting_connection_get_interface_name(s_con));
+
+    priv->index.autoconnect          = nm_setting_connection_get_autoconnect(s_con);
+    priv->index.autoconnect_priority = nm_setting_connection_get_autoconnect_priority(s_con);
+    priv->index.multi_connect        = _nm_connection_get_multi_connect(priv->connection);
+
+    nm_clear_g_free((gpointer *) &priv->index.permission_users);
+
+    num                         = nm_setting_connection_get_num_permissions(s_con);
+    priv->index.has_permissions = (num > 0);
+    for (i = 0; i < num; i++) {
+        const char *ptype;
+        const char *user;
+
+        if (!nm_setting_connection_get_permission(s_con, i, &ptype, &user, NULL))
+            continue;
+        if (!nm_streq(ptype, NM_SETTINGS_CONNECTION_PERMISSION_USER))
+            continue;
+        if (!users)
+            users = g_ptr_array_new();
+        g_ptr_array_add(users, (gpointer) user);
+    }
+    if (users) {
+        priv->index.permission_users =
+            nm_strv_dup_packed((const char *const *) users->pdata, users->len);
+    }
+}
+
 NMConnection *
 nm_settings_connection_get_connection(NMSettingsConnection *self)
 {
+    NMSettingsConnectionPrivate *priv;
+
     g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), NULL);
 
-    return NM_SETTINGS_CONNECTION_GET_PRIVATE(self)->connection;
+    priv = NM_SETTINGS_CONNECTION_GET_PRIVATE(self);
+
+    if (G_UNLIKELY(!priv->connection) && priv->lazy.variant)
+        _lazy_materialize(self);
+
+    if (priv->connection)
+        _nm_settings_lazy_touch(priv->settings, self);
+
+    return priv->connection;
 }
 
 gpointer
@@ -383,7 +530,7 @@ nm_settings_connection_get_setting(NMSettingsConnection *self, NMMetaSettingType
 
     nm_assert(NM_IS_SETTINGS_CONNECTION(self));
 
-    connection = NM_SETTINGS_CONNECTION_GET_PRIVATE(self)->connection;
+    connection = nm_settings_connection_get_connection(self);
 
     nm_assert(NM_IS_SIMPLE_CONNECTION(connection));
 
@@ -398,6 +545,7 @@ _nm_settings_connection_set_connection(NMSettingsConnection            *self,
 {
     NMSettingsConnectionPrivate  *priv           = NM_SETTINGS_CONNECTION_GET_PRIVATE(self);
     gs_unref_object NMConnection *connection_old = NULL;
+    NMConnection                 *connection;
 
     nm_assert(NM_IS_CONNECTION(new_connection));
     nm_assert(NM_IS_SETTINGS_STORAGE(priv->storage));
@@ -405,14 +553,17 @@ _nm_settings_connection_set_connection(NMSettingsConnection            *self,
                         nm_connection_get_uuid(new_connection)));
     nm_assert(!out_connection_old || !*out_connection_old);
 
-    if (!priv->connection
-        || !nm_connection_compare(priv->connection,
-                                  new_connection,
-                                  NM_SETTING_COMPARE_FLAG_EXACT)) {
+    connection = nm_settings_connection_get_connection(self);
+
+    if (!connection
+        || !nm_connection_compare(connection, new_connection, NM_SETTING_COMPARE_FLAG_EXACT)) {
         connection_old   = priv->connection;
         priv->connection = g_object_ref(new_connection);
         nm_assert_connection_unchanging(priv->connection);
 
+        nm_clear_pointer(&priv->lazy.variant, g_variant_unref);
+        _index_update(self);
+
         _getsettings_cached_clear(priv);
         _nm_settings_notify_sorted_by_autoconnect_priority_maybe_changed(priv->settings);
 
@@ -431,6 +582,8 @@ _nm_settings_connection_set_connection(NMSettingsConnection            *self,
         update_agent_secrets_cache(self, NULL);
     else if (NM_FLAGS_HAS(update_reason, NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_AGENT_SECRETS))
         update_agent_secrets_cache(self, priv->connection);
+
+    _nm_settings_lazy_touch(priv->settings, self);
 }
 
 /*****************************************************************************/
@@ -468,29 +621,23 @@ gboolean
 nm_settings_connection_check_visibility(NMSettingsConnection *self,
                                         NMSessionMonitor     *session_monitor)
 {
-    NMSettingConnection *s_con;
-    guint32              num, i;
+    NMSettingsConnectionPrivate *priv;
+    guint                        i;
 
     g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), FALSE);
 
     nm_assert(NM_IS_SESSION_MONITOR(session_monitor));
 
-    s_con = nm_connection_get_setting_connection(nm_settings_connection_get_connection(self));
+    priv = NM_SETTINGS_CONNECTION_GET_PRIVATE(self);
 
     /* Check every user in the ACL for a session */
-    num = nm_setting_connection_get_num_permissions(s_con);
-    if (num == 0)
+    if (!priv->index.has_permissions)
         return TRUE;
 
-    for (i = 0; i < num; i++) {
-        const char *ptype;
-        const char *user;
+    for (i = 0; priv->index.permission_users && priv->index.permission_users[i]; i++) {
+        const char *user = priv->index.permission_users[i];
         uid_t       uid;
 
-        if (!nm_setting_connection_get_permission(s_con, i, &ptype, &user, NULL))
-            continue;
-        if (!nm_streq(ptype, NM_SETTINGS_CONNECTION_PERMISSION_USER))
-            continue;
         if (!nm_utils_name_to_uid(user, &uid))
             continue;
         if (!nm_session_monitor_session_exists(session_monitor, uid, FALSE))
@@ -512,9 +659,7 @@ gboolean
 nm_settings_connection_check_permission(NMSettingsConnection *self, const char *permission)
 {
     NMSettingsConnectionPrivate *priv;
-    NMSettingConnection         *s_con;
-    guint32                      num, i;
-    const char                  *puser;
+    guint                        i;
 
     g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), FALSE);
 
@@ -524,17 +669,14 @@ nm_settings_connection_check_permission(NMSettingsConnection *self, const char *
                       NM_SETTINGS_CONNECTION_INT_FLAGS_VISIBLE))
         return FALSE;
 
-    s_con = nm_connection_get_setting_connection(nm_settings_connection_get_connection(self));
-
     /* Check every user in the ACL for a session */
-    num = nm_setting_connection_get_num_permissions(s_con);
-    if (num == 0) {
+    if (!priv->index.has_permissions) {
         /* Visible to all so it's OK to auto-activate */
         return TRUE;
     }
 
-    for (i = 0; i < num; i++) {
-        const char *ptype;
+    for (i = 0; priv->index.permission_users && priv->index.permission_users[i]; i++) {
+        const char *puser = priv->index.permission_users[i];
 
         /* For each user get their secret agent and check if that agent has the
          * required permission.
@@ -543,11 +685,6 @@ nm_settings_connection_check_permission(NMSettingsConnection *self, const char *
          * name or a PID but if the user isn't running an agent they won't have
          * either.
          */
-        if (!nm_setting_connection_get_permission(s_con, i, &ptype, &puser, NULL))
-            continue;
-        if (!nm_streq(ptype, NM_SETTINGS_CONNECTION_PERMISSION_USER))
-            continue;
-
         if (nm_agent_manager_has_agent_with_permission(priv->agent_mgr, puser, permission))
             return TRUE;
     }
@@ -1374,20 +1511,21 @@ auth_start(NMSettingsConnection  *self,
 
 /**** DBus method handlers ************************************/
 
-static void
-get_settings_auth_cb(NMSettingsConnection  *self,
-                     GDBusMethodInvocation *context,
-                     NMAuthSubject         *subject,
-                     GError                *error,
-                     gpointer               data)
+/**
+ * nm_settings_connection_get_settings_dbus:
+ * @self: the #NMSettingsConnection
+ *
+ * Returns: (transfer none): the settings as returned by GetSettings(), a
+ *   variant of type "(a{sa{sv}})". The result is cached until the
+ *   connection changes.
+ */
+GVariant *
+nm_settings_connection_get_settings_dbus(NMSettingsConnection *self)
 {
     const char                      *seen_bssids_strv[SEEN_BSSIDS_MAX + 1];
     NMConnectionSerializationOptions options = {};
 
-    if (error) {
-        g_dbus_method_invocation_return_gerror(context, error);
-        return;
-    }
+    g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), NULL);
 
     /* Timestamp is not updated in connection's 'timestamp' property,
      * because it would force updating the connection and in turn
@@ -1410,7 +1548,22 @@ get_settings_auth_cb(NMSettingsConnection  *self,
      * protected against leakage of secrets to unprivileged callers.
      */
 
-    g_dbus_method_invocation_return_value(context, _getsettings_cached_get(self, &options));
+    return _getsettings_cached_get(self, &options);
+}
+
+static void
+get_settings_auth_cb(NMSettingsConnection  *self,
+                     GDBusMethodInvocation *context,
+                     NMAuthSubject         *subject,
+                     GError                *error,
+                     gpointer               data)
+{
+    if (error) {
+        g_dbus_method_invocation_return_gerror(context, error);
+        return;
+    }
+
+    g_dbus_method_invocation_return_value(context, nm_settings_connection_get_settings_dbus(self));
 }
 
 static void
@@ -2234,6 +2387,20 @@ _cmp_last_resort(NMSettingsConnection *a, NMSettingsConnection *b)
     return nm_assert_unreachable_val(0);
 }
 
+/* Same as nm_utils_cmp_connection_by_autoconnect_priority(), but only based on
+ * the resident index, so that it does not require the full connections. */
+static int
+_cmp_autoconnect_priority(NMSettingsConnection *a, NMSettingsConnection *b)
+{
+    NMSettingsConnectionPrivate *a_priv = NM_SETTINGS_CONNECTION_GET_PRIVATE(a);
+    NMSettingsConnectionPrivate *b_priv = NM_SETTINGS_CONNECTION_GET_PRIVATE(b);
+
+    NM_CMP_FIELD_BOOL(b_priv, a_priv, index.autoconnect);
+    if (a_priv->index.autoconnect)
+        NM_CMP_FIELD(b_priv, a_priv, index.autoconnect_priority);
+    return 0;
+}
+
 /* sorting for "best" connections.
  * The function sorts connections in descending timestamp order.
  * That means an older connection (lower timestamp) goes after
@@ -2245,9 +2412,7 @@ nm_settings_connection_cmp_timestamp(NMSettingsConnection *a, NMSettingsConnecti
     NM_CMP_SELF(a, b);
 
     NM_CMP_RETURN(_cmp_timestamp(a, b));
-    NM_CMP_RETURN(
-        nm_utils_cmp_connection_by_autoconnect_priority(nm_settings_connection_get_connection(a),
-                                                        nm_settings_connection_get_connection(b)));
+    NM_CMP_RETURN(_cmp_autoconnect_priority(a, b));
     return _cmp_last_resort(a, b);
 }
 
@@ -2265,9 +2430,7 @@ nm_settings_connection_cmp_autoconnect_priority(NMSettingsConnection *a, NMSetti
 {
     if (a == b)
         return 0;
-    NM_CMP_RETURN(
-        nm_utils_cmp_connection_by_autoconnect_priority(nm_settings_connection_get_connection(a),
-                                                        nm_settings_connection_get_connection(b)));
+    NM_CMP_RETURN(_cmp_autoconnect_priority(a, b));
     NM_CMP_RETURN(_cmp_timestamp(a, b));
     return _cmp_last_resort(a, b);
 }
@@ -2647,7 +2810,9 @@ nm_settings_connection_get_filename(NMSettingsConnection *self)
 const char *
 nm_settings_connection_get_id(NMSettingsConnection *self)
 {
-    return nm_connection_get_id(nm_settings_connection_get_connection(self));
+    g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), NULL);
+
+    return NM_SETTINGS_CONNECTION_GET_PRIVATE(self)->index.id;
 }
 
 const char *
@@ -2662,9 +2827,9 @@ nm_settings_connection_get_uuid(NMSettingsConnection *self)
 
     uuid = nm_settings_storage_get_uuid(priv->storage);
 
-    nm_assert(
-        uuid
-        && nm_streq0(uuid, nm_connection_get_uuid(nm_settings_connection_get_connection(self))));
+    nm_assert(uuid
+              && (!priv->connection
+                  || nm_streq0(uuid, nm_connection_get_uuid(priv->connection))));
 
     return uuid;
 }
@@ -2689,7 +2854,33 @@ nm_settings_connection_bump_version_id(NMSettingsConnection *self)
 const char *
 nm_settings_connection_get_connection_type(NMSettingsConnection *self)
 {
-    return nm_connection_get_connection_type(nm_settings_connection_get_connection(self));
+    g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), NULL);
+
+    return NM_SETTINGS_CONNECTION_GET_PRIVATE(self)->index.connection_type;
+}
+
+const char *
+nm_settings_connection_get_interface_name(NMSettingsConnection *self)
+{
+    g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), NULL);
+
+    return NM_SETTINGS_CONNECTION_GET_PRIVATE(self)->index.interface_name;
+}
+
+gboolean
+nm_settings_connection_get_autoconnect(NMSettingsConnection *self)
+{
+    g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), FALSE);
+
+    return NM_SETTINGS_CONNECTION_GET_PRIVATE(self)->index.autoconnect;
+}
+
+NMConnectionMultiConnect
+nm_settings_connection_get_multi_connect(NMSettingsConnection *self)
+{
+    g_return_val_if_fail(NM_IS_SETTINGS_CONNECTION(self), NM_CONNECTION_MULTI_CONNECT_DEFAULT);
+
+    return NM_SETTINGS_CONNECTION_GET_PRIVATE(self)->index.multi_connect;
 }
 
 /*****************************************************************************/
@@ -2746,6 +2937,7 @@ nm_settings_connection_init(NMSettingsConnection *self)
 
     c_list_init(&self->_connections_lst);
     c_list_init(&self->devcon_con_lst_head);
+    c_list_init(&self->_lazy.lst);
     c_list_init(&priv->seen_bssids_lst_head);
     c_list_init(&priv->call_ids_lst_head);
     c_list_init(&priv->auth_lst_head);
@@ -2790,6 +2982,8 @@ dispose(GObject *object)
     g_clear_object(&priv->agent_mgr);
 
     g_clear_object(&priv->connection);
+    c_list_unlink(&self->_lazy.lst);
+    nm_clear_pointer(&priv->lazy.variant, g_variant_unref);
 
     _getsettings_cached_clear(priv);
 
@@ -2802,6 +2996,11 @@ dispose(GObject *object)
 
     nm_clear_g_free(&priv->filename);
 
+    nm_clear_g_free(&priv->index.id);
+    nm_clear_g_free(&priv->index.connection_type);
+    nm_clear_g_free(&priv->index.interface_name);
+    nm_clear_g_free((gpointer *) &priv->index.permission_users);
+
     g_clear_object(&priv->settings);
 }
 
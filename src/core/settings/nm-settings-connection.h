@@ -198,10 +198,18 @@ typedef struct _NMSettingsConnectionClass NMSettingsConnectionClass;
 
 struct _NMSettingsConnectionPrivate;
 
+/* The position of a profile in the list of profiles that have their settings
+ * loaded, with "main.lazy-load-connections". The list is owned by NMSettings. */
+typedef struct {
+    CList  lst;
+    gint64 last_used_msec;
+} NMSettingsLazyEntry;
+
 struct _NMSettingsConnection {
     NMDBusObject                         parent;
     CList                                _connections_lst;
     CList                                devcon_con_lst_head;
+    NMSettingsLazyEntry                  _lazy;
     struct _NMSettingsConnectionPrivate *_priv;
 };
 
@@ -217,6 +225,8 @@ NMConnection *nm_settings_connection_get_connection(NMSettingsConnection *self);
 gpointer      nm_settings_connection_get_setting(NMSettingsConnection *self,
                                                  NMMetaSettingType     meta_type);
 
+GVariant *nm_settings_connection_get_settings_dbus(NMSettingsConnection *self);
+
 void _nm_settings_connection_set_connection(NMSettingsConnection            *self,
                                             NMConnection                    *new_connection,
                                             NMConnection                   **out_old_connection,
@@ -226,6 +236,8 @@ NMSettingsStorage *nm_settings_connection_get_storage(NMSettingsConnection *self
 
 void _nm_settings_connection_set_storage(NMSettingsConnection *self, NMSettingsStorage *storage);
 
+gboolean _nm_settings_connection_lazy_release(NMSettingsConnection *self);
+
 gboolean nm_settings_connection_still_valid(NMSettingsConnection *self);
 
 const char *nm_settings_connection_get_filename(NMSettingsConnection *self);
@@ -361,6 +373,11 @@ nm_settings_connection_autoconnect_blocked_reason_set(NMSettingsConnection
 const char *nm_settings_connection_get_id(NMSettingsConnection *connection);
 const char *nm_settings_connection_get_uuid(NMSettingsConnection *connection);
 const char *nm_settings_connection_get_connection_type(NMSettingsConnection *connection);
+const char *nm_settings_connection_get_interface_name(NMSettingsConnection *connection);
+
+gboolean nm_settings_connection_get_autoconnect(NMSettingsConnection *connection);
+
+NMConnectionMultiConnect nm_settings_connection_get_multi_connect(NMSettingsConnection *connection);
 
 /*****************************************************************************/
 
@@ -67,6 +67,8 @@
 #include "nm-dispatcher.h"
 #include "nm-hostname-manager.h"
 
+#define LAZY_RELEASE_TIMEOUT_MSEC (30 * NM_UTILS_MSEC_PER_SEC)
+
 /*****************************************************************************/
 
 static NM_CACHED_QUARK_FCN("default-wired-connection", _default_wired_connection_quark);
@@ -81,6 +83,12 @@ typedef struct _StorageData {
     NMSettingsStorage *storage;
     NMConnection      *connection;
     bool               prioritize : 1;
+
+    /* With "main.lazy-load-connections", the storage that provides the
+     * exposed profile does not keep a reference to the connection. It is
+     * only tracked by the NMSettingsConnection (which may release it while
+     * the profile is not in use). @connection is then %NULL. */
+    bool connection_lazy : 1;
 } StorageData;
 
 static StorageData *
@@ -88,13 +96,27 @@ _storage_data_new_stale(NMSettingsStorage *storage, NMConnection *connection)
 {
     StorageData *sd;
 
-    sd             = g_slice_new(StorageData);
-    sd->storage    = g_object_ref(storage);
-    sd->connection = nm_g_object_ref(connection);
-    sd->prioritize = FALSE;
+    sd                  = g_slice_new(StorageData);
+    sd->storage         = g_object_ref(storage);
+    sd->connection      = nm_g_object_ref(connection);
+    sd->prioritize      = FALSE;
+    sd->connection_lazy = FALSE;
     return sd;
 }
 
+static void
+_storage_data_set_connection(StorageData *sd, NMConnection *connection)
+{
+    nm_g_object_ref_set(&sd->connection, connection);
+    sd->connection_lazy = FALSE;
+}
+
+static gboolean
+_storage_data_has_connection(const StorageData *sd)
+{
+    return sd->connection || sd->connection_lazy;
+}
+
 static void
 _storage_data_destroy(StorageData *sd)
 {
@@ -137,6 +159,7 @@ nm_assert_storage_data_lst(CList *head)
 
         nm_assert(NM_IS_SETTINGS_STORAGE(sd->storage));
         nm_assert(!sd->connection || NM_IS_CONNECTION(sd->connection));
+        nm_assert(!sd->connection || !sd->connection_lazy);
         u = nm_settings_storage_get_uuid(sd->storage);
         if (!uuid) {
             uuid = u;
@@ -160,7 +183,7 @@ _storage_data_is_alive(StorageData *sd)
      *
      * Meta-data storages are special: they never track a connection.
      * We need to check them specially to know when to drop them. */
-    return sd->connection || nm_settings_storage_is_meta_data_alive(sd->storage);
+    return _storage_data_has_connection(sd) || nm_settings_storage_is_meta_data_alive(sd->storage);
 }
 
 /*****************************************************************************/
@@ -266,7 +289,7 @@ _sett_conn_entry_storage_find_conflicting_storage(SettConnEntry     *sett_conn_e
     c_list_for_each_entry (sd, &sett_conn_entry->sd_lst_head, sd_lst) {
         nm_assert(NM_IS_SETTINGS_STORAGE(sd->storage));
 
-        if (!sd->connection) {
+        if (!_storage_data_has_connection(sd)) {
             /* We only consider storages with connection. In particular,
              * tombstones are not relevant, because we can delete them to
              * resolve the conflict. */
@@ -316,7 +339,7 @@ _sett_conn_entry_find_shadowed_storage(SettConnEntry     *sett_conn_entry,
     c_list_for_each_entry (sd, &sett_conn_entry->sd_lst_head, sd_lst) {
         nm_assert(NM_IS_SETTINGS_STORAGE(sd->storage));
 
-        if (!sd->connection)
+        if (!_storage_data_has_connection(sd))
             continue;
 
         if (blacklisted_storage == sd->storage)
@@ -396,6 +419,11 @@ typedef struct {
     GSource *kf_db_flush_idle_source_timestamps;
     GSource *kf_db_flush_idle_source_seen_bssids;
 
+    /* With "main.lazy-load-connections", the NMSettingsConnections that have
+     * their settings loaded, least recently used first. */
+    CList    lazy_lst_head;
+    GSource *lazy_sweep_source;
+
     guint connections_len;
 
     guint connections_generation;
@@ -405,6 +433,8 @@ typedef struct {
 
     bool started : 1;
 
+    bool lazy_load_connections : 1;
+
     /* Whether NMSettingsConnections changed in a way that affects the comparison
      * with nm_settings_connection_cmp_autoconnect_priority_with_data(). In that case,
      * we may need to re-sort the connections_cached_list_sorted_by_autoconnect_priority
@@ -983,7 +1013,7 @@ _sett_conn_entry_sds_update(NMSettings *self, SettConnEntry *sett_conn_entry)
             continue;
         }
 
-        nm_g_object_ref_set(&sd->connection, sd_dirty->connection);
+        _storage_data_set_connection(sd, sd_dirty->connection);
         sd->prioritize = sd_dirty->prioritize;
 
         _storage_data_destroy(sd_dirty);
@@ -1273,10 +1303,23 @@ _connection_changed_process_one(NMSettings                      *self,
                                 gboolean                         override_sett_flags,
                                 NMSettingsConnectionUpdateReason update_reason)
 {
-    StorageData *sd_best;
+    NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE(self);
+    StorageData       *sd_best;
+    StorageData       *sd;
 
     c_list_unlink(&sett_conn_entry->sce_dirty_lst);
 
+    /* The storages might get reordered. Give the storage that provided the exposed
+     * profile its connection back, before re-evaluating which one wins. */
+    c_list_for_each_entry (sd, &sett_conn_entry->sd_lst_head, sd_lst) {
+        if (!sd->connection_lazy)
+            continue;
+        nm_assert(sett_conn_entry->sett_conn);
+        _storage_data_set_connection(
+            sd,
+            nm_settings_connection_get_connection(sett_conn_entry->sett_conn));
+    }
+
     _sett_conn_entry_sds_update(self, sett_conn_entry);
 
     sd_best = c_list_first_entry(&sett_conn_entry->sd_lst_head, StorageData, sd_lst);
@@ -1337,6 +1380,13 @@ _connection_changed_process_one(NMSettings                      *self,
                                sett_flags,
                                sett_mask,
                                update_reason);
+
+    if (priv->lazy_load_connections) {
+        /* The NMSettingsConnection now tracks the (same) connection. Don't keep
+         * a second reference, so that it can be released while not in use. */
+        g_clear_object(&sd_best->connection);
+        sd_best->connection_lazy = TRUE;
+    }
 }
 
 static void
@@ -1434,7 +1484,7 @@ _connection_changed_track(NMSettings        *self,
      * and leave existing ones at their position. */
     sd = _storage_data_find_in_lst(&sett_conn_entry->dirty_sd_lst_head, storage);
     if (sd)
-        nm_g_object_ref_set(&sd->connection, connection);
+        _storage_data_set_connection(sd, connection);
     else {
         sd = _storage_data_new_stale(storage, connection);
         c_list_link_tail(&sett_conn_entry->dirty_sd_lst_head, &sd->sd_lst);
@@ -3042,6 +3092,122 @@ impl_settings_reload_connections(NMDBusObject                      *obj,
 
 /*****************************************************************************/
 
+gboolean
+_nm_settings_get_lazy_load_connections(NMSettings *self)
+{
+    return NM_SETTINGS_GET_PRIVATE(self)->lazy_load_connections;
+}
+
+void
+_nm_settings_lazy_entry_touch(CList *lazy_lst_head, NMSettingsLazyEntry *entry, gint64 now_msec)
+{
+    entry->last_used_msec = now_msec;
+    nm_c_list_move_tail(lazy_lst_head, &entry->lst);
+}
+
+/**
+ * _nm_settings_lazy_sweep:
+ * @lazy_lst_head: the list of #NMSettingsLazyEntry, least recently used first.
+ * @now_msec: the current timestamp.
+ * @timeout_msec: how long an entry must be unused before it gets released.
+ * @release_func: releases an entry. Returns %FALSE if the entry is still in use.
+ * @user_data: user data for @release_func.
+ *
+ * Releases the entries that were not used for @timeout_msec, and unlinks them.
+ * The entries that are still in use are checked again after another @timeout_msec.
+ *
+ * Returns: the time when the next entry expires, or 0 if the list is empty.
+ */
+gint64
+_nm_settings_lazy_sweep(CList                    *lazy_lst_head,
+                        gint64                    now_msec,
+                        gint64                    timeout_msec,
+                        NMSettingsLazyReleaseFunc release_func,
+                        gpointer                  user_data)
+{
+    NMSettingsLazyEntry *entry;
+
+    nm_assert(timeout_msec > 0);
+
+    while ((entry = c_list_first_entry(lazy_lst_head, NMSettingsLazyEntry, lst))) {
+        if (entry->last_used_msec + timeout_msec > now_msec)
+            return entry->last_used_msec + timeout_msec;
+
+        c_list_unlink(&entry->lst);
+        if (!release_func(entry, user_data))
+            _nm_settings_lazy_entry_touch(lazy_lst_head, entry, now_msec);
+    }
+
+    return 0;
+}
+
+static gboolean
+_lazy_release_func(NMSettingsLazyEntry *entry, gpointer user_data)
+{
+    return _nm_settings_connection_lazy_release(
+        c_list_entry(&entry->lst, NMSettingsConnection, _lazy.lst));
+}
+
+static gboolean _lazy_sweep_cb(gpointer user_data);
+
+static void
+_lazy_sweep_schedule(NMSettings *self, gint64 expiry_msec)
+{
+    NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE(self);
+    gint64             timeout_msec;
+
+    nm_assert(!priv->lazy_sweep_source);
+
+    if (expiry_msec == 0)
+        return;
+
+    /* One timer for all profiles. The second granularity lets profiles that
+     * were used around the same time get released together. */
+    timeout_msec = NM_MAX(expiry_msec - nm_utils_get_monotonic_timestamp_msec(), 0);
+    priv->lazy_sweep_source =
+        nm_g_timeout_add_seconds_source(NM_DIV_ROUND_UP(timeout_msec, NM_UTILS_MSEC_PER_SEC),
+                                        _lazy_sweep_cb,
+                                        self);
+}
+
+static gboolean
+_lazy_sweep_cb(gpointer user_data)
+{
+    NMSettings        *self = user_data;
+    NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE(self);
+    gint64             expiry_msec;
+
+    nm_clear_g_source_inst(&priv->lazy_sweep_source);
+
+    expiry_msec = _nm_settings_lazy_sweep(&priv->lazy_lst_head,
+                                          nm_utils_get_monotonic_timestamp_msec(),
+                                          LAZY_RELEASE_TIMEOUT_MSEC,
+                                          _lazy_release_func,
+                                          NULL);
+    _lazy_sweep_schedule(self, expiry_msec);
+    return G_SOURCE_CONTINUE;
+}
+
+void
+_nm_settings_lazy_touch(NMSettings *self, NMSettingsConnection *sett_conn)
+{
+    NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE(self);
+
+    if (!priv->lazy_load_connections)
+        return;
+
+    _nm_settings_lazy_entry_touch(&priv->lazy_lst_head,
+                                  &sett_conn->_lazy,
+                                  nm_utils_get_monotonic_timestamp_msec());
+
+    if (!priv->lazy_sweep_source) {
+        NMSettingsLazyEntry *first;
+
+        first = c_list_first_entry(&priv->lazy_lst_head, NMSettingsLazyEntry, lst);
+        _lazy_sweep_schedule(self, first->last_used_msec + LAZY_RELEASE_TIMEOUT_MSEC);
+    }
+}
+
 void
 _nm_settings_notify_sorted_by_autoconnect_priority_maybe_changed(NMSettings *self)
 {
@@ -3178,6 +3344,57 @@ error:
     g_dbus_method_invocation_take_error(invocation, error);
 }
 
+static void
+impl_settings_get_settings_many(NMDBusObject                      *obj,
+                                const NMDBusInterfaceInfoExtended *interface_info,
+                                const NMDBusMethodInfoExtended    *method_info,
+                                GDBusConnection                   *dbus_connection,
+                                const char                        *sender,
+                                GDBusMethodInvocation             *invocation,
+                                GVariant                          *parameters)
+{
+    NMSettings                    *self    = NM_SETTINGS(obj);
+    gs_unref_object NMAuthSubject *subject = NULL;
+    gs_free const char           **paths   = NULL;
+    GVariantBuilder                builder;
+    gsize                          i;
+
+    g_variant_get(parameters, "(^a&o)", &paths);
+
+    subject = nm_dbus_manager_new_auth_subject_from_context(invocation);
+    if (!subject) {
+        g_dbus_method_invocation_return_error_literal(invocation,
+                                                      NM_SETTINGS_ERROR,
+                                                      NM_SETTINGS_ERROR_PERMISSION_DENIED,
+                                                      NM_UTILS_ERROR_MSG_REQ_UID_UKNOWN);
+        return;
+    }
+
+    /* Like GetSettings() on each connection, but in one round trip. Connections
+     * that don't exist or that are not visible to the caller are silently
+     * omitted from the result. */
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{oa{sa{sv}}}"));
+    for (i = 0; paths[i]; i++) {
+        gs_unref_variant GVariant *settings = NULL;
+        NMSettingsConnection      *sett_conn;
+
+        sett_conn = nm_settings_get_connection_by_path(self, paths[i]);
+        if (!sett_conn)
+            continue;
+
+        if (!nm_auth_is_subject_in_acl(nm_settings_connection_get_connection(sett_conn),
+                                       subject,
+                                       NULL))
+            continue;
+
+        settings =
+            g_variant_get_child_value(nm_settings_connection_get_settings_dbus(sett_conn), 0);
+        g_variant_builder_add(&builder, "{o@a{sa{sv}}}", paths[i], settings);
+    }
+
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{oa{sa{sv}}})", &builder));
+}
+
 /**
  * nm_settings_get_connections:
  * @self: the #NMSettings
@@ -4198,6 +4415,7 @@ nm_settings_init(NMSettings *self)
 
     c_list_init(&priv->auth_lst_head);
     c_list_init(&priv->connections_lst_head);
+    c_list_init(&priv->lazy_lst_head);
     c_list_init(&priv->startup_complete_scd_lst_head);
 
     c_list_init(&priv->sce_dirty_lst_head);
@@ -4208,6 +4426,12 @@ nm_settings_init(NMSettings *self)
 
     priv->config = g_object_ref(nm_config_get());
 
+    priv->lazy_load_connections =
+        nm_config_data_get_value_boolean(nm_config_get_data(priv->config),
+                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+                                         NM_CONFIG_KEYFILE_KEY_MAIN_LAZY_LOAD_CONNECTIONS,
+                                         FALSE);
+
     priv->agent_mgr = g_object_ref(nm_agent_manager_get());
 
     priv->platform = g_object_ref(NM_PLATFORM_GET);
@@ -4241,6 +4465,10 @@ dispose(GObject *object)
     nm_clear_pointer(&priv->startup_complete_idx, g_hash_table_destroy);
     nm_assert(c_list_is_empty(&priv->startup_complete_scd_lst_head));
 
+    nm_clear_g_source_inst(&priv->lazy_sweep_source);
+    while ((iter = c_list_first(&priv->lazy_lst_head)))
+        c_list_unlink(iter);
+
     while ((iter = c_list_first(&priv->auth_lst_head)))
         nm_auth_chain_destroy(nm_auth_chain_parent_lst_entry(iter));
 
@@ -4341,6 +4569,14 @@ static const NMDBusInterfaceInfoExtended interface_info_settings = {
                     .out_args =
                         NM_DEFINE_GDBUS_ARG_INFOS(NM_DEFINE_GDBUS_ARG_INFO("connection", "o"), ), ),
                 .handle = impl_settings_get_connection_by_uuid, ),
+            NM_DEFINE_DBUS_METHOD_INFO_EXTENDED(
+                NM_DEFINE_GDBUS_METHOD_INFO_INIT(
+                    "GetSettingsMany",
+                    .in_args =
+                        NM_DEFINE_GDBUS_ARG_INFOS(NM_DEFINE_GDBUS_ARG_INFO("connections", "ao"), ),
+                    .out_args = NM_DEFINE_GDBUS_ARG_INFOS(
+                        NM_DEFINE_GDBUS_ARG_INFO("settings", "a{oa{sa{sv}}}"), ), ),
+                .handle = impl_settings_get_settings_many, ),
             NM_DEFINE_DBUS_METHOD_INFO_EXTENDED(
                 NM_DEFINE_GDBUS_METHOD_INFO_INIT(
                     "AddConnection",
@@ -137,4 +137,20 @@ void nm_settings_kf_db_write(NMSettings *settings);
 
 void _nm_settings_notify_sorted_by_autoconnect_priority_maybe_changed(NMSettings *self);
 
+gboolean _nm_settings_get_lazy_load_connections(NMSettings *self);
+
+void _nm_settings_lazy_touch(NMSettings *self, NMSettingsConnection *sett_conn);
+
+/* For testing only */
+typedef gboolean (*NMSettingsLazyReleaseFunc)(NMSettingsLazyEntry *entry, gpointer user_data);
+
+void
+_nm_settings_lazy_entry_touch(CList *lazy_lst_head, NMSettingsLazyEntry *entry, gint64 now_msec);
+
+gint64 _nm_settings_lazy_sweep(CList                    *lazy_lst_head,
+                               gint64                    now_msec,
+                               gint64                    timeout_msec,
+                               NMSettingsLazyReleaseFunc release_func,
+                               gpointer                  user_data);
+
 #endif /* __NM_SETTINGS_H__ */
@@ -2870,6 +2870,92 @@ test_nmmeta(void)
 
 /*****************************************************************************/
 
+static NMConnection *
+_read_corpus_keyfile(GKeyFile *kf)
+{
+    return nm_keyfile_read(kf, TEST_KEYFILES_DIR, NM_KEYFILE_HANDLER_FLAGS_NONE, NULL, NULL, NULL);
+}
+
+static void
+test_read_corpus(void)
+{
+    gs_unref_ptrarray GPtrArray *keyfiles = NULL;
+    gs_free_error GError        *error    = NULL;
+    GDir                        *dir;
+    const char                  *name;
+    guint                        n_read = 0;
+    guint                        i, j;
+
+    /* Read every keyfile of the test corpus twice. By the second read, the
+     * per-setting property tables are cached, and it must give the same
+     * connection. */
+
+    keyfiles = g_ptr_array_new_with_free_func((GDestroyNotify) g_key_file_unref);
+
+    dir = g_dir_open(TEST_KEYFILES_DIR, 0, &error);
+    nmtst_assert_success(dir, error);
+    while ((name = g_dir_read_name(dir))) {
+        gs_free char *full_filename = g_build_filename(TEST_KEYFILES_DIR, name, NULL);
+        GKeyFile     *kf;
+
+        if (!g_file_test(full_filename, G_FILE_TEST_IS_REGULAR))
+            continue;
+
+        kf = g_key_file_new();
+        if (!g_key_file_load_from_file(kf, full_filename, G_KEY_FILE_NONE, NULL)) {
+            g_key_file_unref(kf);
+            continue;
+        }
+        g_ptr_array_add(keyfiles, kf);
+    }
+    g_dir_close(dir);
+
+    g_assert_cmpint(keyfiles->len, >, 0);
+
+    for (j = 0; j < keyfiles->len; j++) {
+        gs_unref_object NMConnection *connection1 = NULL;
+        gs_unref_object NMConnection *connection2 = NULL;
+
+        connection1 = _read_corpus_keyfile(keyfiles->pdata[j]);
+        connection2 = _read_corpus_keyfile(keyfiles->pdata[j]);
+
+        g_assert(!connection1 == !connection2);
+        if (!connection1)
+            continue;
+
+        nmtst_assert_connection_equals(connection1, FALSE, connection2, FALSE);
+        n_read++;
+    }
+
+    g_assert_cmpint(n_read, >, 0);
+
+    if (nmtst_is_debug()) {
+        const guint n_iterations = 200;
+        gint64      t_start;
+        gint64      t_total;
+
+        /* With NMTST_DEBUG=debug, also report the throughput of nm_keyfile_read(). */
+        t_start = nm_utils_get_monotonic_timestamp_nsec();
+        for (i = 0; i < n_iterations; i++) {
+            for (j = 0; j < keyfiles->len; j++) {
+                gs_unref_object NMConnection *connection = NULL;
+
+                connection = _read_corpus_keyfile(keyfiles->pdata[j]);
+            }
+        }
+        t_total = nm_utils_get_monotonic_timestamp_nsec() - t_start;
+
+        g_test_message("read %u keyfiles %u times in %" G_GINT64_FORMAT
+                       " usec: %.1f usec per keyfile",
+                       keyfiles->len,
+                       n_iterations,
+                       t_total / 1000,
+                       ((double) t_total / 1000.0) / (double) (keyfiles->len * n_iterations));
+    }
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE();
 
 int
@@ -2989,5 +3075,7 @@ main(int argc, char **argv)
 
     g_test_add_func("/keyfile/test_nmmeta", test_nmmeta);
 
+    g_test_add_func("/keyfile/test_read_corpus", test_read_corpus);
+
     return g_test_run();
 }
@@ -109,6 +109,9 @@ typedef struct _NMSupplicantInterfacePrivate {
     GHashTable *bss_idx;
     CList       bss_lst_head;
     CList       bss_initializing_lst_head;
+    CList       bss_changed_lst_head;
+
+    GSource *bss_changed_idle_source;
 
     NMRefString *current_bss;
 
@@ -139,6 +142,8 @@ typedef struct _NMSupplicantInterfacePrivate {
 
     guint32 max_scan_ssids;
 
+    guint8 signal_hysteresis_dbm;
+
     gint32 disconnect_reason;
 
     NMSupplicantInterfaceState state;
@@ -583,6 +588,7 @@ static void
 _bss_info_destroy(NMSupplicantBssInfo *bss_info)
 {
     c_list_unlink_stale(&bss_info->_bss_lst);
+    c_list_unlink_stale(&bss_info->_bss_changed_lst);
     nm_clear_g_cancellable(&bss_info->_init_cancellable);
     g_bytes_unref(bss_info->ssid);
     nm_ref_string_unref(bss_info->bss_path);
@@ -598,26 +604,92 @@ _bss_info_changed_emit(NMSupplicantInterface *self,
     g_signal_emit(self, signals[BSS_CHANGED], 0, bss_info, is_present);
 }
 
+static gboolean
+_bss_info_changed_idle_cb(gpointer user_data)
+{
+    NMSupplicantInterface        *self = user_data;
+    NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE(self);
+    NMSupplicantBssInfo          *bss_info;
+
+    nm_clear_g_source_inst(&priv->bss_changed_idle_source);
+
+    while ((bss_info = c_list_first_entry(&priv->bss_changed_lst_head,
+                                          NMSupplicantBssInfo,
+                                          _bss_changed_lst))) {
+        c_list_unlink(&bss_info->_bss_changed_lst);
+        _bss_info_changed_emit(self, bss_info, TRUE);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+_bss_info_changed_schedule(NMSupplicantInterface *self, NMSupplicantBssInfo *bss_info)
+{
+    NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE(self);
+
+    /* wpa_supplicant sends a PropertiesChanged signal per BSS (and often
+     * several, while scanning). Collect the changes and emit them once all
+     * pending D-Bus messages are processed. */
+    if (c_list_is_linked(&bss_info->_bss_changed_lst))
+        return;
+
+    c_list_link_tail(&priv->bss_changed_lst_head, &bss_info->_bss_changed_lst);
+    if (!priv->bss_changed_idle_source)
+        priv->bss_changed_idle_source = nm_g_idle_add_source(_bss_info_changed_idle_cb, self);
+}
+
+/**
+ * nm_supplicant_bss_info_set_signal:
+ * @bss_info: the BSS
+ * @signal_dbm: the signal level reported by the supplicant
+ * @hysteresis_dbm: the minimal change of the signal level that is taken
+ *   into account. Zero takes every change into account.
+ * @initial: whether this is the first signal level of the BSS
+ *
+ * The signal level fluctuates constantly. This is the only filter for
+ * that, the signal strength of the AP follows @bss_info.
+ *
+ * Returns: whether the signal level of @bss_info changed.
+ */
+gboolean
+nm_supplicant_bss_info_set_signal(NMSupplicantBssInfo *bss_info,
+                                  gint16               signal_dbm,
+                                  guint                hysteresis_dbm,
+                                  gboolean             initial)
+{
+    if (!initial) {
+        if (signal_dbm == bss_info->_signal_dbm)
+            return FALSE;
+        if (ABS((int) signal_dbm - (int) bss_info->_signal_dbm) < (int) hysteresis_dbm)
+            return FALSE;
+    }
+
+    bss_info->_signal_dbm    = signal_dbm;
+    bss_info->signal_percent = nm_wifi_utils_level_to_quality(signal_dbm);
+    return TRUE;
+}
+
 static void
 _bss_info_properties_changed(NMSupplicantInterface *self,
                              NMSupplicantBssInfo   *bss_info,
                              GVariant              *properties,
                              gboolean               initial)
 {
-    gboolean       v_b;
-    GVariant      *v_v;
-    const char    *v_s;
-    gint16         v_i16;
-    guint16        v_u16;
-    guint32        v_u32;
-    NM80211ApFlags p_ap_flags;
-    _NM80211Mode   p_mode;
-    guint8         p_signal_percent;
-    const guint8  *arr_data;
-    gsize          arr_len;
-    guint32        p_max_rate;
-    gboolean       p_max_rate_has;
-    gint64         now_msec = 0;
+    NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE(self);
+    gboolean                      v_b;
+    GVariant                     *v_v;
+    const char                   *v_s;
+    gint16                        v_i16;
+    guint16                       v_u16;
+    guint32                       v_u32;
+    NM80211ApFlags                p_ap_flags;
+    _NM80211Mode                  p_mode;
+    const guint8                 *arr_data;
+    gsize                         arr_len;
+    guint32                       p_max_rate;
+    gboolean                      p_max_rate_has;
+    gint64                        now_msec = 0;
 
     if (nm_g_variant_lookup(properties, "Age", "u", &v_u32)) {
         bss_info->last_seen_msec =
@@ -676,12 +748,9 @@ _bss_info_properties_changed(NMSupplicantInterface *self,
     }
 
     if (nm_g_variant_lookup(properties, "Signal", "n", &v_i16))
-        p_signal_percent = nm_wifi_utils_level_to_quality(v_i16);
+        nm_supplicant_bss_info_set_signal(bss_info, v_i16, priv->signal_hysteresis_dbm, initial);
     else if (initial)
-        p_signal_percent = 0;
-    else
-        p_signal_percent = bss_info->signal_percent;
-    bss_info->signal_percent = p_signal_percent;
+        bss_info->signal_percent = 0;
 
     if (nm_g_variant_lookup(properties, "Frequency", "q", &v_u16))
         bss_info->frequency = v_u16;
@@ -790,7 +859,14 @@ _bss_info_properties_changed(NMSupplicantInterface *self,
     if (p_max_rate_has)
         bss_info->max_rate = p_max_rate / 1000u;
 
-    _bss_info_changed_emit(self, bss_info, TRUE);
+    if (initial) {
+        _bss_info_changed_emit(self, bss_info, TRUE);
+        return;
+    }
+
+    /* Also an update that only carries the age is reported. The time when the
+     * BSS was last seen tells whether it is still around. */
+    _bss_info_changed_schedule(self, bss_info);
 }
 
 static void
@@ -844,6 +920,7 @@ _bss_info_add(NMSupplicantInterface *self, const char *object_path)
         .bss_path          = g_steal_pointer(&bss_path),
         ._init_cancellable = g_cancellable_new(),
     };
+    c_list_init(&bss_info->_bss_changed_lst);
     c_list_link_tail(&priv->bss_initializing_lst_head, &bss_info->_bss_lst);
     g_hash_table_add(priv->bss_idx, bss_info);
 
@@ -1493,6 +1570,14 @@ nm_supplicant_interface_set_bridge(NMSupplicantInterface *self, const char *brid
                                 nm_utils_user_data_pack(self, g_strdup(bridge)));
 }
 
+void
+nm_supplicant_interface_set_signal_hysteresis(NMSupplicantInterface *self, guint dbm)
+{
+    NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE(self);
+
+    priv->signal_hysteresis_dbm = NM_MIN(dbm, (guint) G_MAXUINT8);
+}
+
 void
 nm_supplicant_interface_set_global_capabilities(NMSupplicantInterface *self, NMSupplCapMask value)
 {
@@ -3390,6 +3475,9 @@ nm_supplicant_interface_init(NMSupplicantInterface *self)
 
     c_list_init(&priv->bss_lst_head);
     c_list_init(&priv->bss_initializing_lst_head);
+    c_list_init(&priv->bss_changed_lst_head);
+
+    priv->signal_hysteresis_dbm = NM_SUPPLICANT_INTERFACE_SIGNAL_HYSTERESIS_DEFAULT_DBM;
 
     G_STATIC_ASSERT_EXPR(G_STRUCT_OFFSET(NMSupplicantPeerInfo, peer_path) == 0);
     priv->peer_idx = g_hash_table_new(nm_pdirect_hash, nm_pdirect_equal);
@@ -3568,6 +3656,9 @@ dispose(GObject *object)
 
     nm_assert(!priv->assoc_data);
 
+    nm_assert(c_list_is_empty(&priv->bss_changed_lst_head));
+    nm_clear_g_source_inst(&priv->bss_changed_idle_source);
+
     nm_clear_pointer(&priv->bss_idx, g_hash_table_destroy);
     nm_clear_pointer(&priv->peer_idx, g_hash_table_destroy);
 
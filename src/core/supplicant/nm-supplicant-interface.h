@@ -196,4 +196,13 @@ NMSupplicantAuthState nm_supplicant_interface_get_auth_state(NMSupplicantInterfa
 
 void nm_supplicant_interface_set_bridge(NMSupplicantInterface *self, const char *bridge);
 
+#define NM_SUPPLICANT_INTERFACE_SIGNAL_HYSTERESIS_DEFAULT_DBM 3
+
+void nm_supplicant_interface_set_signal_hysteresis(NMSupplicantInterface *self, guint dbm);
+
+gboolean nm_supplicant_bss_info_set_signal(NMSupplicantBssInfo *bss_info,
+                                           gint16               signal_dbm,
+                                           guint                hysteresis_dbm,
+                                           gboolean             initial);
+
 #endif /* __NM_SUPPLICANT_INTERFACE_H__ */
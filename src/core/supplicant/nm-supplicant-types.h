@@ -166,6 +166,7 @@ typedef struct _NMSupplicantBssInfo {
 
     NMSupplicantInterface *_self;
     CList                  _bss_lst;
+    CList                  _bss_changed_lst;
     GCancellable          *_init_cancellable;
 
     GBytes *ssid;
@@ -183,6 +184,9 @@ typedef struct _NMSupplicantBssInfo {
 
     guint8 signal_percent;
 
+    /* The signal level in dBm from which @signal_percent was calculated. */
+    gint16 _signal_dbm;
+
     NMEtherAddr bssid;
 
     NM80211ApFlags ap_flags : 5;
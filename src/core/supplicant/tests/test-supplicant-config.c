@@ -17,6 +17,7 @@
 #include "libnm-core-intern/nm-core-internal.h"
 
 #include "supplicant/nm-supplicant-config.h"
+#include "supplicant/nm-supplicant-interface.h"
 #include "supplicant/nm-supplicant-settings-verify.h"
 
 #include "nm-test-utils-core.h"
@@ -912,6 +913,37 @@ test_suppl_cap_mask(void)
 
 /*****************************************************************************/
 
+static void
+test_bss_info_set_signal(void)
+{
+    NMSupplicantBssInfo bss_info = {};
+
+    g_assert(nm_supplicant_bss_info_set_signal(&bss_info, -70, 3, TRUE));
+    g_assert_cmpint(bss_info.signal_percent, ==, nm_wifi_utils_level_to_quality(-70));
+
+    /* Changes below the hysteresis are ignored, also when they add up. */
+    g_assert(!nm_supplicant_bss_info_set_signal(&bss_info, -68, 3, FALSE));
+    g_assert(!nm_supplicant_bss_info_set_signal(&bss_info, -72, 3, FALSE));
+    g_assert(!nm_supplicant_bss_info_set_signal(&bss_info, -68, 3, FALSE));
+    g_assert_cmpint(bss_info.signal_percent, ==, nm_wifi_utils_level_to_quality(-70));
+
+    g_assert(nm_supplicant_bss_info_set_signal(&bss_info, -67, 3, FALSE));
+    g_assert_cmpint(bss_info.signal_percent, ==, nm_wifi_utils_level_to_quality(-67));
+    g_assert(nm_supplicant_bss_info_set_signal(&bss_info, -70, 3, FALSE));
+    g_assert_cmpint(bss_info.signal_percent, ==, nm_wifi_utils_level_to_quality(-70));
+
+    /* The initial level is always taken. */
+    g_assert(nm_supplicant_bss_info_set_signal(&bss_info, -69, 3, TRUE));
+    g_assert_cmpint(bss_info.signal_percent, ==, nm_wifi_utils_level_to_quality(-69));
+
+    /* Without hysteresis, every change counts. */
+    g_assert(nm_supplicant_bss_info_set_signal(&bss_info, -70, 0, FALSE));
+    g_assert_cmpint(bss_info.signal_percent, ==, nm_wifi_utils_level_to_quality(-70));
+    g_assert(!nm_supplicant_bss_info_set_signal(&bss_info, -70, 0, FALSE));
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE();
 
 int
@@ -928,6 +960,7 @@ main(int argc, char **argv)
     g_test_add_func("/supplicant-config/wifi-sae", test_wifi_sae);
     g_test_add_func("/supplicant-config/test_suppl_cap_mask", test_suppl_cap_mask);
     g_test_add_func("/supplicant-config/wifi-eap-suite-b-192", test_wifi_eap_suite_b_generation);
+    g_test_add_func("/supplicant-config/bss-info-set-signal", test_bss_info_set_signal);
 
     return g_test_run();
 }
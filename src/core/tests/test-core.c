@@ -17,8 +17,12 @@
 #include "nm-core-utils.h"
 
 #include "dns/nm-dns-manager.h"
+#include "devices/nm-device-ethernet.h"
+#include "nm-dbus-object.h"
+#include "nm-dbus-utils.h"
 #include "nm-connectivity.h"
 #include "nm-firewall-utils.h"
+#include "settings/nm-settings.h"
 
 #include "nm-test-utils-core.h"
 
@@ -2751,6 +2755,200 @@ test_nm_firewall_nft_stdio_mlag(void)
 
 /*****************************************************************************/
 
+static int
+_dbus_property_lookup_naive(const NMDBusInterfaceInfoExtended *interface_info,
+                            const char                        *property_name)
+{
+    guint i;
+
+    for (i = 0; interface_info->parent.properties && interface_info->parent.properties[i]; i++) {
+        const NMDBusPropertyInfoExtended *property_info =
+            (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+
+        if (nm_streq(property_info->property_name, property_name))
+            return i;
+    }
+    return -1;
+}
+
+static void
+test_dbus_property_index(void)
+{
+    gs_unref_ptrarray GPtrArray *interface_infos = g_ptr_array_new();
+    gs_free GParamSpec         **pspecs          = NULL;
+    gs_free GHashTable         **indexes         = NULL;
+    GObjectClass                *object_class;
+    GType                        gtype;
+    guint                        n_pspecs;
+    guint                        n_found = 0;
+    guint                        i, j, k;
+
+    /* Resolve all properties of NMDeviceEthernet against the D-Bus interfaces of the
+     * type, like _nm_dbus_manager_obj_notify() does for a notify storm. Check that the
+     * index agrees with a linear search. */
+
+    object_class = g_type_class_ref(NM_TYPE_DEVICE_ETHERNET);
+
+    for (gtype = NM_TYPE_DEVICE_ETHERNET; gtype != NM_TYPE_DBUS_OBJECT;
+         gtype = g_type_parent(gtype)) {
+        NMDBusObjectClass *klass = g_type_class_peek(gtype);
+
+        if (!klass->interface_infos)
+            continue;
+        for (i = 0; klass->interface_infos[i]; i++) {
+            if (!g_ptr_array_find(interface_infos, klass->interface_infos[i], NULL))
+                g_ptr_array_add(interface_infos, (gpointer) klass->interface_infos[i]);
+        }
+    }
+    g_assert_cmpint(interface_infos->len, >=, 2);
+
+    indexes = g_new(GHashTable *, interface_infos->len);
+    for (k = 0; k < interface_infos->len; k++) {
+        indexes[k] = nm_dbus_utils_interface_info_get_property_index(interface_infos->pdata[k]);
+        g_assert(indexes[k]
+                 == nm_dbus_utils_interface_info_get_property_index(interface_infos->pdata[k]));
+    }
+
+    pspecs = g_object_class_list_properties(object_class, &n_pspecs);
+    g_assert_cmpint(n_pspecs, >, 0);
+
+    for (k = 0; k < interface_infos->len; k++) {
+        for (j = 0; j < n_pspecs; j++) {
+            int idx = _dbus_property_lookup_naive(interface_infos->pdata[k], pspecs[j]->name);
+
+            g_assert_cmpint(idx,
+                            ==,
+                            nm_dbus_utils_property_index_lookup(indexes[k], pspecs[j]->name));
+            if (idx >= 0)
+                n_found++;
+        }
+    }
+    g_assert_cmpint(n_found, >, 0);
+    g_assert_cmpint(nm_dbus_utils_property_index_lookup(indexes[0], "no-such-property"), ==, -1);
+
+    if (nmtst_is_debug()) {
+        const guint  n_iterations = 10000;
+        const gint64 n_lookups    = (gint64) n_iterations * n_pspecs * interface_infos->len;
+        gint64       t_start;
+        gint64       t_naive;
+        gint64       t_index;
+
+        /* With NMTST_DEBUG=debug, also report the time of both. */
+        n_found = 0;
+        t_start = nm_utils_get_monotonic_timestamp_nsec();
+        for (i = 0; i < n_iterations; i++) {
+            for (k = 0; k < interface_infos->len; k++) {
+                for (j = 0; j < n_pspecs; j++) {
+                    if (_dbus_property_lookup_naive(interface_infos->pdata[k], pspecs[j]->name)
+                        >= 0)
+                        n_found++;
+                }
+            }
+        }
+        t_naive = nm_utils_get_monotonic_timestamp_nsec() - t_start;
+
+        t_start = nm_utils_get_monotonic_timestamp_nsec();
+        for (i = 0; i < n_iterations; i++) {
+            for (k = 0; k < interface_infos->len; k++) {
+                for (j = 0; j < n_pspecs; j++) {
+                    if (nm_dbus_utils_property_index_lookup(indexes[k], pspecs[j]->name) >= 0)
+                        n_found--;
+                }
+            }
+        }
+        t_index = nm_utils_get_monotonic_timestamp_nsec() - t_start;
+
+        g_assert_cmpint(n_found, ==, 0);
+
+        g_test_message("resolved %" G_GINT64_FORMAT " properties (%u interfaces, %u pspecs): "
+                       "linear search %.1f nsec, index %.1f nsec per lookup",
+                       n_lookups,
+                       interface_infos->len,
+                       n_pspecs,
+                       (double) t_naive / (double) n_lookups,
+                       (double) t_index / (double) n_lookups);
+    }
+
+    g_type_class_unref(object_class);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    NMSettingsLazyEntry entries[3];
+    guint               in_use;
+    guint               released;
+} LazySweepData;
+
+static gboolean
+_lazy_sweep_release(NMSettingsLazyEntry *entry, gpointer user_data)
+{
+    LazySweepData *data = user_data;
+    guint          idx  = entry - data->entries;
+
+    g_assert_cmpint(idx, <, G_N_ELEMENTS(data->entries));
+    g_assert(!c_list_is_linked(&entry->lst));
+
+    if (NM_FLAGS_HAS(data->in_use, 1u << idx))
+        return FALSE;
+    data->released |= (1u << idx);
+    return TRUE;
+}
+
+static void
+test_settings_lazy_sweep(void)
+{
+    CList         lst_head = C_LIST_INIT(lst_head);
+    LazySweepData data     = {};
+    guint         i;
+
+    for (i = 0; i < G_N_ELEMENTS(data.entries); i++)
+        c_list_init(&data.entries[i].lst);
+
+    _nm_settings_lazy_entry_touch(&lst_head, &data.entries[0], 0);
+    _nm_settings_lazy_entry_touch(&lst_head, &data.entries[1], 10);
+    _nm_settings_lazy_entry_touch(&lst_head, &data.entries[2], 20);
+
+    /* nothing expired yet. The next sweep is due when the oldest entry expires. */
+    g_assert_cmpint(_nm_settings_lazy_sweep(&lst_head, 500, 1000, _lazy_sweep_release, &data),
+                    ==,
+                    1000);
+    g_assert_cmpint(data.released, ==, 0);
+
+    /* using an entry moves it to the end. */
+    _nm_settings_lazy_entry_touch(&lst_head, &data.entries[0], 600);
+    g_assert(c_list_last(&lst_head) == &data.entries[0].lst);
+
+    g_assert_cmpint(_nm_settings_lazy_sweep(&lst_head, 1015, 1000, _lazy_sweep_release, &data),
+                    ==,
+                    1020);
+    g_assert_cmpint(data.released, ==, 1u << 1);
+    g_assert(!c_list_is_linked(&data.entries[1].lst));
+
+    /* an entry that is still in use is kept, and checked again after another timeout. */
+    data.in_use = (1u << 2);
+    g_assert_cmpint(_nm_settings_lazy_sweep(&lst_head, 1020, 1000, _lazy_sweep_release, &data),
+                    ==,
+                    1600);
+    g_assert_cmpint(data.released, ==, 1u << 1);
+    g_assert(c_list_last(&lst_head) == &data.entries[2].lst);
+    g_assert_cmpint(data.entries[2].last_used_msec, ==, 1020);
+
+    data.in_use = 0;
+    g_assert_cmpint(_nm_settings_lazy_sweep(&lst_head, 1600, 1000, _lazy_sweep_release, &data),
+                    ==,
+                    2020);
+    g_assert_cmpint(data.released, ==, (1u << 0) | (1u << 1));
+
+    g_assert_cmpint(_nm_settings_lazy_sweep(&lst_head, 2020, 1000, _lazy_sweep_release, &data),
+                    ==,
+                    0);
+    g_assert_cmpint(data.released, ==, (1u << 0) | (1u << 1) | (1u << 2));
+    g_assert(c_list_is_empty(&lst_head));
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE();
 
 int
@@ -2814,6 +3012,10 @@ main(int argc, char **argv)
 
     g_test_add_func("/general/test_dns_create_resolv_conf", test_dns_create_resolv_conf);
 
+    g_test_add_func("/general/dbus-property-index", test_dbus_property_index);
+
+    g_test_add_func("/general/settings-lazy-sweep", test_settings_lazy_sweep);
+
     g_test_add_data_func("/general/nm_utils_dhcp_client_id_systemd_node_specific/0",
                          GINT_TO_POINTER(0),
                          test_nm_utils_dhcp_client_id_systemd_node_specific);
@@ -0,0 +1,366 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "src/core/nm-default-daemon.h"
+
+#include <sys/socket.h>
+
+#include "nm-config.h"
+#include "nm-dbus-manager.h"
+#include "nm-dbus-object.h"
+
+#include "nm-test-utils-core.h"
+
+#define TEST_CONFIG_DIR NM_BUILD_SRCDIR "/src/core/tests/config"
+
+/*****************************************************************************/
+
+static NMConfig *
+_setup_config(void)
+{
+    gs_unref_ptrarray GPtrArray *args  = g_ptr_array_new();
+    gs_free_error GError        *error = NULL;
+    GOptionContext              *context;
+    NMConfigCmdLineOptions      *cli;
+    NMConfig                    *config;
+    char                       **argv;
+    int                          argc;
+
+    /* The manager reads the notify interval from the NMConfig singleton. */
+    g_ptr_array_add(args, "test-dbus-manager");
+    g_ptr_array_add(args, "--config");
+    g_ptr_array_add(args, TEST_CONFIG_DIR "/NetworkManager.conf");
+    g_ptr_array_add(args, "--intern-config");
+    g_ptr_array_add(args, "");
+    g_ptr_array_add(args, "--config-dir");
+    g_ptr_array_add(args, "/no/such/dir");
+    g_ptr_array_add(args, "--system-config-dir");
+    g_ptr_array_add(args, "");
+
+    argv = (char **) args->pdata;
+    argc = args->len;
+
+    cli = nm_config_cmd_line_options_new(FALSE);
+
+    context = g_option_context_new(NULL);
+    nm_config_cmd_line_options_add_to_entries(cli, context);
+    g_assert(g_option_context_parse(context, &argc, &argv, NULL));
+    g_option_context_free(context);
+
+    config = nm_config_setup(cli, NULL, &error);
+    nmtst_assert_success(config, error);
+
+    nm_config_cmd_line_options_free(cli);
+    return config;
+}
+
+/*****************************************************************************/
+
+#define NM_TYPE_TEST_DBUS_OBJECT (nm_test_dbus_object_get_type())
+#define NM_TEST_DBUS_OBJECT(obj) \
+    (G_TYPE_CHECK_INSTANCE_CAST((obj), NM_TYPE_TEST_DBUS_OBJECT, NMTestDBusObject))
+
+typedef struct {
+    NMDBusObject  parent;
+    NMDBusObject *peer;
+    guint         value;
+} NMTestDBusObject;
+
+typedef struct {
+    NMDBusObjectClass parent;
+} NMTestDBusObjectClass;
+
+GType nm_test_dbus_object_get_type(void);
+
+G_DEFINE_TYPE(NMTestDBusObject, nm_test_dbus_object, NM_TYPE_DBUS_OBJECT)
+
+NM_GOBJECT_PROPERTIES_DEFINE(NMTestDBusObject, PROP_VALUE, PROP_PEER, );
+
+static void
+nm_test_dbus_object_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    NMTestDBusObject *self = NM_TEST_DBUS_OBJECT(object);
+    const char       *path = NULL;
+
+    switch (prop_id) {
+    case PROP_VALUE:
+        g_value_set_uint(value, self->value);
+        break;
+    case PROP_PEER:
+        if (self->peer)
+            path = nm_dbus_object_get_path(self->peer);
+        g_value_set_string(value, path ?: "/");
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+nm_test_dbus_object_init(NMTestDBusObject *self)
+{}
+
+static const GDBusSignalInfo signal_info_test_ping = NM_DEFINE_GDBUS_SIGNAL_INFO_INIT("Ping", );
+
+static const NMDBusInterfaceInfoExtended interface_info_test = {
+    .parent = NM_DEFINE_GDBUS_INTERFACE_INFO_INIT(
+        NM_DBUS_INTERFACE ".Test",
+        .signals    = NM_DEFINE_GDBUS_SIGNAL_INFOS(&signal_info_test_ping, ),
+        .properties = NM_DEFINE_GDBUS_PROPERTY_INFOS(
+            NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE("Value", "u", "value"),
+            NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE("Peer", "o", "peer"), ), ),
+};
+
+static void
+nm_test_dbus_object_class_init(NMTestDBusObjectClass *klass)
+{
+    GObjectClass      *object_class      = G_OBJECT_CLASS(klass);
+    NMDBusObjectClass *dbus_object_class = NM_DBUS_OBJECT_CLASS(klass);
+
+    dbus_object_class->export_path     = NM_DBUS_EXPORT_PATH_NUMBERED(NM_DBUS_PATH "/Test");
+    dbus_object_class->interface_infos = NM_DBUS_INTERFACE_INFOS(&interface_info_test);
+
+    object_class->get_property = nm_test_dbus_object_get_property;
+
+    obj_properties[PROP_VALUE] = g_param_spec_uint("value",
+                                                   "",
+                                                   "",
+                                                   0,
+                                                   G_MAXUINT32,
+                                                   0,
+                                                   G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_PEER] = g_param_spec_string("peer",
+                                                    "",
+                                                    "",
+                                                    NULL,
+                                                    G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_properties(object_class, _PROPERTY_ENUMS_LAST, obj_properties);
+}
+
+static void
+_dbus_connection_new_cb(GObject *source, GAsyncResult *result, gpointer user_data)
+{
+    GDBusConnection     **p_connection = user_data;
+    gs_free_error GError *error        = NULL;
+
+    *p_connection = g_dbus_connection_new_finish(result, &error);
+    g_assert_no_error(error);
+}
+
+static void
+_dbus_connection_pair_new(GDBusConnection **out_server, GDBusConnection **out_client)
+{
+    gs_free_error GError      *error    = NULL;
+    gs_free char              *guid     = g_dbus_generate_guid();
+    gs_unref_object GSocket   *socket_s = NULL;
+    gs_unref_object GSocket   *socket_c = NULL;
+    gs_unref_object GIOStream *stream_s = NULL;
+    gs_unref_object GIOStream *stream_c = NULL;
+    int                        fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        g_assert_not_reached();
+
+    socket_s = g_socket_new_from_fd(fds[0], &error);
+    g_assert_no_error(error);
+    socket_c = g_socket_new_from_fd(fds[1], &error);
+    g_assert_no_error(error);
+
+    stream_s = G_IO_STREAM(g_socket_connection_factory_create_connection(socket_s));
+    stream_c = G_IO_STREAM(g_socket_connection_factory_create_connection(socket_c));
+
+    *out_server = NULL;
+    *out_client = NULL;
+
+    /* A peer-to-peer connection. The manager emits its signals without destination,
+     * so the client receives all of them, in the order they were sent. */
+    g_dbus_connection_new(stream_s,
+                          guid,
+                          G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_SERVER
+                              | G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_ALLOW_ANONYMOUS,
+                          NULL,
+                          NULL,
+                          _dbus_connection_new_cb,
+                          out_server);
+    g_dbus_connection_new(stream_c,
+                          NULL,
+                          G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
+                          NULL,
+                          NULL,
+                          _dbus_connection_new_cb,
+                          out_client);
+
+    nmtst_main_context_iterate_until_assert(NULL, 5000, *out_server && *out_client);
+}
+
+static void
+_dbus_signal_cb(GDBusConnection *connection,
+                const char      *sender_name,
+                const char      *object_path,
+                const char      *interface_name,
+                const char      *signal_name,
+                GVariant        *parameters,
+                gpointer         user_data)
+{
+    GPtrArray   *signals = user_data;
+    GString     *str;
+    GVariantIter iter;
+    const char  *name;
+    GVariant    *value;
+
+    str = g_string_new(signal_name);
+
+    if (NM_IN_STRSET(signal_name, "InterfacesAdded", "InterfacesRemoved")) {
+        const char *path;
+
+        /* Record the path of the object that the signal is about. */
+        g_variant_get_child(parameters, 0, "&o", &path);
+        g_string_append_printf(str, ":%s", path);
+    } else
+        g_string_append_printf(str, ":%s", object_path);
+
+    if (nm_streq(signal_name, "PropertiesChanged")) {
+        gs_unref_variant GVariant *changed = g_variant_get_child_value(parameters, 1);
+
+        g_variant_iter_init(&iter, changed);
+        while (g_variant_iter_next(&iter, "{&sv}", &name, &value)) {
+            if (g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32))
+                g_string_append_printf(str, ":%s=%u", name, g_variant_get_uint32(value));
+            else
+                g_string_append_printf(str, ":%s=%s", name, g_variant_get_string(value, NULL));
+            g_variant_unref(value);
+        }
+    }
+
+    g_ptr_array_add(signals, g_string_free(str, FALSE));
+}
+
+#define _dbus_assert_signals(signals, ...)                                                  \
+    G_STMT_START                                                                            \
+    {                                                                                       \
+        const char *const _expected[] = {__VA_ARGS__};                                      \
+        guint             _i;                                                               \
+                                                                                            \
+        nmtst_main_context_iterate_until_assert(NULL,                                       \
+                                                5000,                                       \
+                                                (signals)->len >= G_N_ELEMENTS(_expected)); \
+        for (_i = 0; _i < G_N_ELEMENTS(_expected); _i++)                                    \
+            g_assert_cmpstr((signals)->pdata[_i], ==, _expected[_i]);                       \
+        g_assert_cmpint((signals)->len, ==, G_N_ELEMENTS(_expected));                       \
+        g_ptr_array_set_size((signals), 0);                                                 \
+    }                                                                                       \
+    G_STMT_END
+
+static void
+test_dbus_manager_notify(void)
+{
+    gs_unref_object NMConfig         *config  = NULL;
+    gs_unref_object GDBusConnection  *server  = NULL;
+    gs_unref_object GDBusConnection  *client  = NULL;
+    gs_unref_ptrarray GPtrArray      *signals = g_ptr_array_new_with_free_func(g_free);
+    gs_unref_object NMTestDBusObject *a       = NULL;
+    gs_unref_object NMTestDBusObject *b       = NULL;
+    gs_unref_object NMTestDBusObject *c       = NULL;
+    NMDBusManager                    *manager;
+    gs_free char                     *path_a  = NULL;
+    gs_free char                     *path_b  = NULL;
+    gs_free char                     *path_c  = NULL;
+    gs_free char                     *path_c2 = NULL;
+    guint                             subscription_id;
+
+    config = _setup_config();
+
+    _dbus_connection_pair_new(&server, &client);
+
+    subscription_id = g_dbus_connection_signal_subscribe(client,
+                                                         NULL,
+                                                         NULL,
+                                                         NULL,
+                                                         NULL,
+                                                         NULL,
+                                                         G_DBUS_SIGNAL_FLAGS_NONE,
+                                                         _dbus_signal_cb,
+                                                         signals,
+                                                         NULL);
+
+    manager = nm_dbus_manager_get();
+    g_assert(_nm_dbus_manager_setup_for_connection(manager, server));
+    nm_dbus_manager_start(manager, NULL, NULL);
+
+    a = g_object_new(NM_TYPE_TEST_DBUS_OBJECT, NULL);
+    b = g_object_new(NM_TYPE_TEST_DBUS_OBJECT, NULL);
+    c = g_object_new(NM_TYPE_TEST_DBUS_OBJECT, NULL);
+
+    path_a = g_strdup(nm_dbus_object_export(a));
+    path_b = g_strdup(nm_dbus_object_export(b));
+    _dbus_assert_signals(signals,
+                         nm_sprintf_bufa(200, "InterfacesAdded:%s", path_a),
+                         nm_sprintf_bufa(200, "InterfacesAdded:%s", path_b));
+
+    /* Changes are coalesced. A signal of @a only sends the pending changes of @a,
+     * those of @b follow with the next flush. */
+    a->value = 1;
+    _notify(a, PROP_VALUE);
+    b->value = 1;
+    _notify(b, PROP_VALUE);
+    a->value = 2;
+    _notify(a, PROP_VALUE);
+    nm_dbus_object_emit_signal(NM_DBUS_OBJECT(a),
+                               &interface_info_test,
+                               &signal_info_test_ping,
+                               "()");
+    _dbus_assert_signals(signals,
+                         nm_sprintf_bufa(200, "PropertiesChanged:%s:Value=2", path_a),
+                         nm_sprintf_bufa(200, "Ping:%s", path_a),
+                         nm_sprintf_bufa(200, "PropertiesChanged:%s:Value=1", path_b));
+
+    /* A pending change that references an object which gets exported afterwards is
+     * sent after the object's InterfacesAdded. */
+    a->peer = NM_DBUS_OBJECT(c);
+    _notify(a, PROP_PEER);
+    path_c = g_strdup(nm_dbus_object_export(c));
+    _dbus_assert_signals(signals,
+                         nm_sprintf_bufa(200, "InterfacesAdded:%s", path_c),
+                         nm_sprintf_bufa(200, "PropertiesChanged:%s:Peer=%s", path_a, path_c));
+
+    /* Exporting another object does not flush the pending changes of @a either. */
+    a->value = 3;
+    _notify(a, PROP_VALUE);
+    nm_dbus_object_unexport(c);
+    path_c2 = g_strdup(nm_dbus_object_export(c));
+    _dbus_assert_signals(signals,
+                         nm_sprintf_bufa(200, "InterfacesRemoved:%s", path_c),
+                         nm_sprintf_bufa(200, "InterfacesAdded:%s", path_c2),
+                         nm_sprintf_bufa(200, "PropertiesChanged:%s:Value=3", path_a));
+
+    /* On unexport, the pending changes of the object itself are sent first. */
+    b->value = 2;
+    _notify(b, PROP_VALUE);
+    nm_dbus_object_unexport(b);
+    _dbus_assert_signals(signals,
+                         nm_sprintf_bufa(200, "PropertiesChanged:%s:Value=2", path_b),
+                         nm_sprintf_bufa(200, "InterfacesRemoved:%s", path_b));
+
+    a->peer = NULL;
+    nm_dbus_object_unexport(c);
+    nm_dbus_object_unexport(a);
+
+    nm_dbus_manager_stop(manager);
+    g_dbus_connection_signal_unsubscribe(client, subscription_id);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE();
+
+int
+main(int argc, char **argv)
+{
+    nmtst_init_assert_logging(&argc, &argv, "INFO", "DEFAULT");
+
+    g_test_add_func("/dbus-manager/notify", test_dbus_manager_notify);
+
+    return g_test_run();
+}
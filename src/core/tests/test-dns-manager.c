@@ -0,0 +1,180 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "src/core/nm-default-daemon.h"
+
+#include "dns/nm-dns-manager.h"
+#include "nm-config.h"
+#include "nm-l3-config-data.h"
+
+#include "nm-test-utils-core.h"
+
+#define TEST_CONFIG_DIR NM_BUILD_SRCDIR "/src/core/tests/config"
+
+/*****************************************************************************/
+
+static NMConfig *
+_setup_config(void)
+{
+    gs_unref_ptrarray GPtrArray *args  = g_ptr_array_new();
+    gs_free_error GError        *error = NULL;
+    GOptionContext              *context;
+    NMConfigCmdLineOptions      *cli;
+    NMConfig                    *config;
+    char                       **argv;
+    int                          argc;
+
+    /* With dns=none, the manager has no plugin and never touches resolv.conf. */
+    g_ptr_array_add(args, "test-dns-manager");
+    g_ptr_array_add(args, "--config");
+    g_ptr_array_add(args, TEST_CONFIG_DIR "/dns-none.conf");
+    g_ptr_array_add(args, "--intern-config");
+    g_ptr_array_add(args, "");
+    g_ptr_array_add(args, "--config-dir");
+    g_ptr_array_add(args, "/no/such/dir");
+    g_ptr_array_add(args, "--system-config-dir");
+    g_ptr_array_add(args, "");
+
+    argv = (char **) args->pdata;
+    argc = args->len;
+
+    cli = nm_config_cmd_line_options_new(FALSE);
+
+    context = g_option_context_new(NULL);
+    nm_config_cmd_line_options_add_to_entries(cli, context);
+    g_assert(g_option_context_parse(context, &argc, &argv, NULL));
+    g_option_context_free(context);
+
+    config = nm_config_setup(cli, NULL, &error);
+    nmtst_assert_success(config, error);
+
+    nm_config_cmd_line_options_free(cli);
+    return config;
+}
+
+/*****************************************************************************/
+
+static NML3ConfigData *
+_l3cd_new(NMDedupMultiIndex *multi_idx,
+          int                ifindex,
+          int                dns_priority,
+          gboolean           default_route,
+          const char *const *searches)
+{
+    NML3ConfigData *l3cd;
+    gsize           i;
+
+    l3cd = nm_l3_config_data_new(multi_idx, ifindex, NM_IP_CONFIG_SOURCE_UNKNOWN);
+
+    nm_l3_config_data_add_nameserver(l3cd, AF_INET, "192.0.2.1");
+    nm_l3_config_data_set_dns_priority(l3cd, AF_INET, dns_priority);
+    for (i = 0; searches && searches[i]; i++)
+        nm_l3_config_data_add_search(l3cd, AF_INET, searches[i]);
+
+    if (default_route) {
+        nm_l3_config_data_add_route_4(
+            l3cd,
+            NM_PLATFORM_IP4_ROUTE_INIT(.ifindex = ifindex,
+                                       .gateway = nmtst_inet4_from_string("192.0.2.254"),
+                                       .metric  = 100, ));
+    }
+
+    nm_l3_config_data_seal(l3cd);
+    return l3cd;
+}
+
+#define _set_ip_config(self, l3cd, ip_config_type)                                     \
+    nm_dns_manager_set_ip_config((self),                                               \
+                                 AF_INET,                                              \
+                                 GINT_TO_POINTER(nm_l3_config_data_get_ifindex(l3cd)), \
+                                 (l3cd),                                               \
+                                 (ip_config_type),                                     \
+                                 TRUE)
+
+#define _assert_domains(self, expected)                               \
+    G_STMT_START                                                      \
+    {                                                                 \
+        gs_free char *_domains = nmtst_dns_manager_get_domains(self); \
+                                                                      \
+        g_assert_cmpstr(_domains, ==, (expected));                    \
+    }                                                                 \
+    G_STMT_END
+
+static void
+test_dns_manager_domains(void)
+{
+    nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = nm_dedup_multi_index_new();
+    gs_unref_object NMConfig                          *config    = _setup_config();
+    gs_unref_object NMDnsManager                      *self      = NULL;
+    nm_auto_unref_l3cd const NML3ConfigData           *l3cd_1    = NULL;
+    nm_auto_unref_l3cd const NML3ConfigData           *l3cd_2    = NULL;
+    nm_auto_unref_l3cd const NML3ConfigData           *l3cd_3    = NULL;
+    nm_auto_unref_l3cd const NML3ConfigData           *l3cd_4    = NULL;
+    nm_auto_unref_l3cd const NML3ConfigData           *l3cd_4b   = NULL;
+    nm_auto_unref_l3cd const NML3ConfigData           *l3cd_5    = NULL;
+
+    self = g_object_new(NM_TYPE_DNS_MANAGER, NULL);
+
+    l3cd_1  = _l3cd_new(multi_idx, 1, 50, FALSE, NM_MAKE_STRV("example.com"));
+    l3cd_2  = _l3cd_new(multi_idx, 2, 100, FALSE, NM_MAKE_STRV("sub.example.com", "example.com"));
+    l3cd_3  = _l3cd_new(multi_idx, 3, -10, FALSE, NM_MAKE_STRV("~example.com"));
+    l3cd_4  = _l3cd_new(multi_idx, 4, 100, FALSE, NM_MAKE_STRV("sub.example.com", "other.org"));
+    l3cd_4b = _l3cd_new(multi_idx, 4, 100, TRUE, NM_MAKE_STRV("sub.example.com", "other.org"));
+    l3cd_5  = _l3cd_new(multi_idx, 5, -10, FALSE, NM_MAKE_STRV("example.com", "sub.example.com"));
+
+    _assert_domains(self, "");
+
+    /* The parent domain has a positive priority and doesn't shadow the child.
+     * The parent itself is only used by the ip_data with the lowest priority,
+     * and so is the automatic wildcard domain of the non-VPN ip_data. */
+    _set_ip_config(self, l3cd_1, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
+    _set_ip_config(self, l3cd_2, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
+    _assert_domains(self, "1: example.com,<auto-default>; 2: sub.example.com");
+
+    /* On a tie of the priority, all ip_data keep the domain. */
+    _set_ip_config(self, l3cd_4, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
+    _assert_domains(self,
+                    "1: example.com,<auto-default>; 2: sub.example.com; "
+                    "4: sub.example.com,other.org");
+
+    /* A parent domain with negative priority shadows its children with higher
+     * priority, but not the unrelated domains. */
+    _set_ip_config(self, l3cd_3, NM_DNS_IP_CONFIG_TYPE_VPN);
+    _assert_domains(self, "3: ~example.com; 1: <auto-default>; 2:; 4: other.org");
+
+    /* A child with the same negative priority as the parent is not shadowed,
+     * and the parent domain is kept by both ip_data. */
+    _set_ip_config(self, l3cd_5, NM_DNS_IP_CONFIG_TYPE_VPN);
+    _assert_domains(self,
+                    "3: ~example.com; 5: example.com,sub.example.com; 1: <auto-default>; 2:; "
+                    "4: other.org");
+
+    /* Removing the ip_data drops their nodes from the trie again, until we are
+     * back to the previous result. */
+    _set_ip_config(self, l3cd_3, NM_DNS_IP_CONFIG_TYPE_REMOVED);
+    _assert_domains(self, "5: example.com,sub.example.com; 1: <auto-default>; 2:; 4: other.org");
+    _set_ip_config(self, l3cd_5, NM_DNS_IP_CONFIG_TYPE_REMOVED);
+    _assert_domains(self,
+                    "1: example.com,<auto-default>; 2: sub.example.com; "
+                    "4: sub.example.com,other.org");
+
+    /* Once an ip_data has a default route, only that one gets the automatic
+     * wildcard domain. */
+    _set_ip_config(self, l3cd_4b, NM_DNS_IP_CONFIG_TYPE_DEFAULT);
+    _assert_domains(self,
+                    "1: example.com; 2: sub.example.com; "
+                    "4: sub.example.com,other.org,<auto-default>");
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE();
+
+int
+main(int argc, char **argv)
+{
+    nmtst_init_assert_logging(&argc, &argv, "INFO", "DEFAULT");
+
+    g_test_add_func("/dns-manager/domains", test_dns_manager_domains);
+
+    return g_test_run();
+}
@@ -424,8 +424,9 @@ _notify_update_prop_hw_address(NMClient               *client,
     NMAccessPoint        *self = NM_ACCESS_POINT(dbobj->nmobj);
     NMAccessPointPrivate *priv = NM_ACCESS_POINT_GET_PRIVATE(self);
 
-    g_free(priv->bssid);
-    priv->bssid = value ? g_variant_dup_string(value, NULL) : 0u;
+    if (!nm_strdup_reset(&priv->bssid, value ? g_variant_get_string(value, NULL) : NULL))
+        return NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NONE;
+
     _notify(self, PROP_HW_ADDRESS);
     return NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NOTIFY;
 }
@@ -540,9 +540,9 @@ finalize(GObject *object)
 {
     NMActiveConnectionPrivate *priv = NM_ACTIVE_CONNECTION_GET_PRIVATE(object);
 
-    g_free(priv->id);
+    nml_intern_str_clear(&priv->id);
     g_free(priv->uuid);
-    g_free(priv->type);
+    nml_intern_str_clear(&priv->type);
     nm_ref_string_unref(priv->specific_object_path);
 
     G_OBJECT_CLASS(nm_active_connection_parent_class)->finalize(object);
@@ -649,7 +649,7 @@ const NMLDBusMetaIface _nml_dbus_meta_iface_nm_connection_active = NML_DBUS_META
                                            NMActiveConnectionPrivate,
                                            property_o[PROPERTY_O_IDX_DHCP6_CONFIG],
                                            nm_dhcp6_config_get_type),
-        NML_DBUS_META_PROPERTY_INIT_S("Id", PROP_ID, NMActiveConnectionPrivate, id),
+        NML_DBUS_META_PROPERTY_INIT_S_INTERN("Id", PROP_ID, NMActiveConnectionPrivate, id),
         NML_DBUS_META_PROPERTY_INIT_O_PROP("Ip4Config",
                                            PROP_IP4_CONFIG,
                                            NMActiveConnectionPrivate,
@@ -675,7 +675,7 @@ const NMLDBusMetaIface _nml_dbus_meta_iface_nm_connection_active = NML_DBUS_META
                                       PROP_STATE_FLAGS,
                                       NMActiveConnectionPrivate,
                                       state_flags),
-        NML_DBUS_META_PROPERTY_INIT_S("Type", PROP_TYPE, NMActiveConnectionPrivate, type),
+        NML_DBUS_META_PROPERTY_INIT_S_INTERN("Type", PROP_TYPE, NMActiveConnectionPrivate, type),
         NML_DBUS_META_PROPERTY_INIT_S("Uuid", PROP_UUID, NMActiveConnectionPrivate, uuid),
         NML_DBUS_META_PROPERTY_INIT_B("Vpn", PROP_VPN, NMActiveConnectionPrivate, is_vpn), ),
     .base_struct_offset = G_STRUCT_OFFSET(NMActiveConnection, _priv), );
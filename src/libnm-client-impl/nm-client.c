@@ -190,6 +190,7 @@ NM_GOBJECT_PROPERTIES_DEFINE(NMClient,
                              PROP_DBUS_NAME_OWNER,
                              PROP_VERSION,
                              PROP_INSTANCE_FLAGS,
+                             PROP_INTERFACE_ALLOWLIST,
                              PROP_STATE,
                              PROP_STARTUP,
                              PROP_NM_RUNNING,
@@ -281,6 +282,8 @@ typedef struct {
     guint8       *permissions;
     GCancellable *permissions_cancellable;
 
+    char **interface_allowlist;
+
     char *name_owner;
     guint name_owner_changed_id;
     guint dbsid_nm_object_manager;
@@ -2392,10 +2395,31 @@ _nml_dbus_notify_update_prop_o(NMClient               *self,
                                               meta_iface,
                                               &meta_iface->dbus_properties[dbus_property_idx]);
 
-    if (!nm_streq0(nm_ref_string_get_str(*p_property), path)) {
-        nm_ref_string_unref(*p_property);
-        *p_property = nm_ref_string_new(path);
-    }
+    if (nm_streq0(nm_ref_string_get_str(*p_property), path))
+        return NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NONE;
+
+    nm_ref_string_unref(*p_property);
+    *p_property = nm_ref_string_new(path);
+    return NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NOTIFY;
+}
+
+NMLDBusNotifyUpdatePropFlags
+_nml_dbus_notify_update_prop_s_intern(NMClient               *self,
+                                      NMLDBusObject          *dbobj,
+                                      const NMLDBusMetaIface *meta_iface,
+                                      guint                   dbus_property_idx,
+                                      GVariant               *value)
+{
+    char **p_property;
+
+    p_property =
+        nml_dbus_object_get_property_location(dbobj,
+                                              meta_iface,
+                                              &meta_iface->dbus_properties[dbus_property_idx]);
+
+    if (!nml_intern_str_reset(p_property, value ? g_variant_get_string(value, NULL) : NULL))
+        return NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NONE;
+
     return NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NOTIFY;
 }
 
@@ -2525,12 +2549,11 @@ _obj_handle_dbus_prop_changes(NMClient            *self,
         break;
     case 's':
         nm_assert(dbus_type_s[1] == '\0');
-        nm_clear_g_free((char **) p_property);
-        if (value)
-            *((char **) p_property) = g_variant_dup_string(value, NULL);
-        else {
-            nm_assert(nm_utils_g_param_spec_is_default(param_spec));
-            *((char **) p_property) = NULL;
+        nm_assert(value || nm_utils_g_param_spec_is_default(param_spec));
+        if (!nm_strdup_reset((char **) p_property,
+                             value ? g_variant_get_string(value, NULL) : NULL)) {
+            /* Don't reallocate or notify if the value is unchanged. */
+            notify_update_prop_flags = NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NONE;
         }
         break;
     case 'o':
@@ -2954,6 +2977,40 @@ _dbus_handle_changes(NMClient   *self,
     _dbus_handle_changes_commit(self, allow_init_start_check_complete);
 }
 
+static gboolean
+_dbus_iface_is_tracked(NMClient *self, const char *interface_name)
+{
+    NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE(self);
+    gsize            i;
+
+    if (NM_FLAGS_HAS(priv->instance_flags, NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS)
+        && nm_streq(interface_name, NM_DBUS_INTERFACE_SETTINGS_CONNECTION))
+        return FALSE;
+
+    if (!priv->interface_allowlist)
+        return TRUE;
+
+    /* The interfaces of the main objects are always tracked. NMClient itself
+     * represents them. */
+    if (NM_IN_STRSET(interface_name,
+                     NM_DBUS_INTERFACE,
+                     NM_DBUS_INTERFACE_SETTINGS,
+                     NM_DBUS_INTERFACE_DNS_MANAGER))
+        return TRUE;
+
+    for (i = 0; priv->interface_allowlist[i]; i++) {
+        const char *allowed = priv->interface_allowlist[i];
+        gsize       l       = strlen(allowed);
+
+        /* An entry also allows the interfaces below it, so that
+         * "org.freedesktop.NetworkManager.Device" covers all device types. */
+        if (strncmp(interface_name, allowed, l) == 0 && NM_IN_SET(interface_name[l], '\0', '.'))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 static gboolean
 _dbus_handle_properties_changed(NMClient       *self,
                                 const char     *log_context,
@@ -2970,6 +3027,12 @@ _dbus_handle_properties_changed(NMClient       *self,
     nm_assert(!changed_properties
               || g_variant_is_of_type(changed_properties, G_VARIANT_TYPE("a{sv}")));
 
+    if (!_dbus_iface_is_tracked(self, interface_name)) {
+        /* The user is not interested in this interface. Don't even create
+         * the NMLDBusObject. */
+        return FALSE;
+    }
+
     {
         gs_free char *ss = NULL;
 
@@ -3055,6 +3118,14 @@ _dbus_handle_properties_changed(NMClient       *self,
                 continue;
             }
 
+            if (db_iface_data->dbus_iface.meta == &_nml_dbus_meta_iface_nm_settings
+                && nm_streq(property_name, "Connections")
+                && NM_FLAGS_HAS(NM_CLIENT_GET_PRIVATE(self)->instance_flags,
+                                NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS)) {
+                /* The profiles are not tracked. Don't watch the paths either. */
+                continue;
+            }
+
             db_propdata = &db_iface_data->prop_datas[property_idx];
 
             NML_NMCLIENT_LOG_T(self,
@@ -3136,6 +3207,9 @@ _dbus_handle_interface_removed(NMClient          *self,
         NMLDBusObjIfaceData *db_iface_data;
         const char          *interface_name = removed_interfaces[i];
 
+        if (!_dbus_iface_is_tracked(self, interface_name))
+            continue;
+
         db_iface_data = nml_dbus_object_iface_data_get(dbobj, interface_name, FALSE);
         if (!db_iface_data) {
             NML_NMCLIENT_LOG_E(
@@ -3356,9 +3430,19 @@ _nm_client_get_settings_call_cb(GObject *source, GAsyncResult *result, gpointer
         g_variant_get(ret, "(@a{sa{sv}})", &settings);
     }
 
+    _nm_client_get_settings_commit(self, remote_connection, settings);
+}
+
+void
+_nm_client_get_settings_commit(NMClient           *self,
+                               NMRemoteConnection *remote_connection,
+                               GVariant           *settings)
+{
     _nm_remote_settings_get_settings_commit(remote_connection, settings);
 
     _dbus_handle_changes_commit(self, TRUE);
+
+    _nm_remote_settings_get_settings_return(remote_connection);
 }
 
 void
@@ -3415,6 +3499,12 @@ _dbus_settings_updated_cb(GDBusConnection *connection,
 
     NML_NMCLIENT_LOG_T(self, "%s: [%s] Updated signal received", log_context, object_path);
 
+    if (_nm_remote_settings_get_settings_needs_fetch(NM_REMOTE_CONNECTION(dbobj->nmobj))) {
+        /* With lazy fetching, the settings were never requested. There is
+         * nothing to update. */
+        return;
+    }
+
     _nm_client_get_settings_call(self, dbobj);
 }
 
@@ -5644,6 +5734,316 @@ nm_client_get_connection_by_uuid(NMClient *client, const char *uuid)
 
 /*****************************************************************************/
 
+/* The number of profiles per GetSettingsMany() call. The reply must stay
+ * well below the maximum message size of the bus. */
+#define ENSURE_SETTINGS_CHUNK_SIZE 100u
+
+typedef struct {
+    GError *error;
+    guint   n_pending;
+} EnsureSettingsData;
+
+typedef struct {
+    GTask *task;
+
+    /* The profiles of one GetSettingsMany() call, and the cancellables of
+     * _nm_remote_settings_get_settings_prepare() for them. */
+    GPtrArray *connections;
+    GPtrArray *cancellables;
+} EnsureSettingsChunk;
+
+static void
+_ensure_settings_data_free(gpointer user_data)
+{
+    EnsureSettingsData *data = user_data;
+
+    g_clear_error(&data->error);
+    nm_g_slice_free(data);
+}
+
+static void
+_ensure_settings_chunk_free(EnsureSettingsChunk *chunk)
+{
+    g_object_unref(chunk->task);
+    g_ptr_array_unref(chunk->connections);
+    g_ptr_array_unref(chunk->cancellables);
+    nm_g_slice_free(chunk);
+}
+
+static void
+_ensure_connection_settings_done(GTask *task)
+{
+    EnsureSettingsData *data = g_task_get_task_data(task);
+
+    nm_assert(data->n_pending > 0);
+    if (--data->n_pending > 0)
+        return;
+
+    if (g_task_return_error_if_cancelled(task))
+        return;
+
+    if (data->error) {
+        g_task_return_error(task, g_steal_pointer(&data->error));
+        return;
+    }
+
+    g_task_return_boolean(task, TRUE);
+}
+
+static void
+_ensure_connection_settings_one_cb(GObject *source, GAsyncResult *result, gpointer user_data)
+{
+    gs_unref_object GTask *task = user_data;
+
+    /* A failure to fetch the settings makes the profile invisible. That is not
+     * an error for the caller, which asked to fetch a set of profiles. */
+    nm_remote_connection_ensure_settings_finish(NM_REMOTE_CONNECTION(source), result, NULL);
+
+    _ensure_connection_settings_done(task);
+}
+
+static void
+_ensure_connection_settings_many_cb(GObject *source, GAsyncResult *result, gpointer user_data)
+{
+    EnsureSettingsChunk           *chunk     = user_data;
+    gs_unref_object GTask         *task      = g_object_ref(chunk->task);
+    gs_unref_variant GVariant     *ret       = NULL;
+    gs_unref_hashtable GHashTable *fetching  = NULL;
+    gs_unref_ptrarray GPtrArray   *committed = NULL;
+    GError                        *error     = NULL;
+    EnsureSettingsData            *data;
+    NMClient                      *self;
+    GVariantIter                  *iter;
+    GHashTableIter                 h_iter;
+    NMRemoteConnection            *remote_connection;
+    const char                    *path;
+    GVariant                      *settings;
+    guint                          i;
+
+    ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+
+    self = g_task_get_source_object(task);
+    data = g_task_get_task_data(task);
+
+    if (!ret) {
+        for (i = 0; i < chunk->connections->len; i++) {
+            _nm_remote_settings_get_settings_abort(chunk->connections->pdata[i],
+                                                   chunk->cancellables->pdata[i]);
+        }
+
+        if (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+            /* The daemon is too old to support GetSettingsMany(). Fetch the
+             * profiles one by one. */
+            NML_NMCLIENT_LOG_T(self, "GetSettingsMany() not supported, fall back to GetSettings()");
+            g_error_free(error);
+            for (i = 0; i < chunk->connections->len; i++) {
+                data->n_pending++;
+                nm_remote_connection_ensure_settings_async(chunk->connections->pdata[i],
+                                                           g_task_get_cancellable(task),
+                                                           _ensure_connection_settings_one_cb,
+                                                           g_object_ref(task));
+            }
+        } else {
+            g_dbus_error_strip_remote_error(error);
+            if (!data->error)
+                data->error = error;
+            else
+                g_error_free(error);
+        }
+
+        _ensure_settings_chunk_free(chunk);
+        _ensure_connection_settings_done(task);
+        return;
+    }
+
+    NML_NMCLIENT_LOG_T(self, "GetSettingsMany() completed with success");
+
+    /* Only commit the profiles, for which no later fetch started in the
+     * meantime. That one commits more recent settings. */
+    fetching = g_hash_table_new(nm_direct_hash, NULL);
+    for (i = 0; i < chunk->connections->len; i++) {
+        remote_connection = chunk->connections->pdata[i];
+        if (_nm_object_get_client(remote_connection) == self
+            && _nm_remote_settings_get_settings_is_current(remote_connection,
+                                                           chunk->cancellables->pdata[i]))
+            g_hash_table_add(fetching, remote_connection);
+    }
+
+    committed = g_ptr_array_new();
+
+    g_variant_get(ret, "(a{oa{sa{sv}}})", &iter);
+    while (g_variant_iter_next(iter, "{&o@a{sa{sv}}}", &path, &settings)) {
+        NMLDBusObject *dbobj;
+
+        dbobj = _dbobjs_dbobj_get_s(self, path);
+        if (dbobj && dbobj->nmobj && g_hash_table_remove(fetching, dbobj->nmobj)) {
+            _nm_remote_settings_get_settings_commit(NM_REMOTE_CONNECTION(dbobj->nmobj), settings);
+            g_ptr_array_add(committed, dbobj->nmobj);
+        }
+        g_variant_unref(settings);
+    }
+    g_variant_iter_free(iter);
+
+    /* Profiles that are gone or that are not visible to the user are omitted
+     * from the reply. */
+    g_hash_table_iter_init(&h_iter, fetching);
+    while (g_hash_table_iter_next(&h_iter, (gpointer *) &remote_connection, NULL)) {
+        _nm_remote_settings_get_settings_commit(remote_connection, NULL);
+        g_ptr_array_add(committed, remote_connection);
+    }
+
+    _dbus_handle_changes_commit(self, TRUE);
+
+    /* The chunk still holds a reference to the committed profiles. */
+    for (i = 0; i < committed->len; i++)
+        _nm_remote_settings_get_settings_return(committed->pdata[i]);
+
+    _ensure_settings_chunk_free(chunk);
+    _ensure_connection_settings_done(task);
+}
+
+/**
+ * nm_client_ensure_connection_settings_async:
+ * @client: the %NMClient
+ * @connections: (element-type NMRemoteConnection) (allow-none): the
+ *   #NMRemoteConnection instances whose settings are requested, or %NULL
+ *   for all profiles of nm_client_get_connections().
+ * @cancellable: a #GCancellable, or %NULL
+ * @callback: callback to be called when the settings are fetched
+ * @user_data: caller-specific data passed to @callback
+ *
+ * With %NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS the settings of the
+ * profiles are not fetched upfront. This requests the settings of all
+ * @connections that were not fetched yet, with one D-Bus call per 100
+ * profiles. Profiles whose settings cannot be fetched become invisible.
+ *
+ * Without %NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS, or if all settings
+ * are already fetched, the operation completes right away.
+ *
+ * Since: 1.46
+ **/
+void
+nm_client_ensure_connection_settings_async(NMClient           *client,
+                                           const GPtrArray    *connections,
+                                           GCancellable       *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer            user_data)
+{
+    gs_unref_object GTask       *task  = NULL;
+    gs_unref_ptrarray GPtrArray *fetch = NULL;
+    EnsureSettingsData          *data;
+    guint                        start;
+    guint                        i;
+
+    g_return_if_fail(NM_IS_CLIENT(client));
+    g_return_if_fail(!cancellable || G_IS_CANCELLABLE(cancellable));
+
+    task = nm_g_task_new(client,
+                         cancellable,
+                         nm_client_ensure_connection_settings_async,
+                         callback,
+                         user_data);
+
+    if (!connections)
+        connections = nm_client_get_connections(client);
+
+    data  = g_slice_new(EnsureSettingsData);
+    *data = (EnsureSettingsData){
+        .n_pending = 1,
+    };
+    g_task_set_task_data(task, data, _ensure_settings_data_free);
+
+    fetch = g_ptr_array_new_with_free_func(g_object_unref);
+    for (i = 0; i < connections->len; i++) {
+        NMRemoteConnection *remote_connection = connections->pdata[i];
+
+        nm_assert(NM_IS_REMOTE_CONNECTION(remote_connection));
+
+        if (_nm_object_get_client(remote_connection) != client
+            || !_nm_remote_settings_get_settings_needs_fetch(remote_connection))
+            continue;
+
+        g_ptr_array_add(fetch, g_object_ref(remote_connection));
+    }
+
+    if (fetch->len == 0) {
+        g_task_return_boolean(task, TRUE);
+        return;
+    }
+
+    if (!NM_CLIENT_GET_PRIVATE(client)->name_owner) {
+        g_task_return_error(task, _nm_client_new_error_nm_not_running());
+        return;
+    }
+
+    /* A single call for many profiles could exceed the maximum message size
+     * of the bus. Split them in chunks. */
+    for (start = 0; start < fetch->len; start += ENSURE_SETTINGS_CHUNK_SIZE) {
+        guint                n = NM_MIN(ENSURE_SETTINGS_CHUNK_SIZE, fetch->len - start);
+        EnsureSettingsChunk *chunk;
+        GVariantBuilder      builder;
+
+        chunk  = g_slice_new(EnsureSettingsChunk);
+        *chunk = (EnsureSettingsChunk){
+            .task         = g_object_ref(task),
+            .connections  = g_ptr_array_new_full(n, g_object_unref),
+            .cancellables = g_ptr_array_new_full(n, g_object_unref),
+        };
+
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
+        for (i = start; i < start + n; i++) {
+            NMRemoteConnection *remote_connection = fetch->pdata[i];
+
+            /* Like every fetch, this supersedes one that is in flight. */
+            g_ptr_array_add(chunk->connections, g_object_ref(remote_connection));
+            g_ptr_array_add(
+                chunk->cancellables,
+                g_object_ref(_nm_remote_settings_get_settings_prepare(remote_connection)));
+            g_variant_builder_add(&builder, "o", _nm_object_get_path(remote_connection));
+        }
+
+        data->n_pending++;
+        _nm_client_dbus_call_simple(client,
+                                    cancellable,
+                                    NM_DBUS_PATH_SETTINGS,
+                                    NM_DBUS_INTERFACE_SETTINGS,
+                                    "GetSettingsMany",
+                                    g_variant_new("(ao)", &builder),
+                                    G_VARIANT_TYPE("(a{oa{sa{sv}}})"),
+                                    G_DBUS_CALL_FLAGS_NONE,
+                                    NM_DBUS_DEFAULT_TIMEOUT_MSEC,
+                                    _ensure_connection_settings_many_cb,
+                                    chunk);
+    }
+
+    _ensure_connection_settings_done(task);
+}
+
+/**
+ * nm_client_ensure_connection_settings_finish:
+ * @client: the %NMClient
+ * @result: the result passed to the #GAsyncReadyCallback
+ * @error: location for a #GError, or %NULL
+ *
+ * Gets the result of a call to nm_client_ensure_connection_settings_async().
+ *
+ * Returns: %TRUE on success, %FALSE on error.
+ *
+ * Since: 1.46
+ **/
+gboolean
+nm_client_ensure_connection_settings_finish(NMClient *client, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail(NM_IS_CLIENT(client), FALSE);
+    g_return_val_if_fail(
+        nm_g_task_is_valid(result, client, nm_client_ensure_connection_settings_async),
+        FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/*****************************************************************************/
+
 static void
 _add_connection_cb(GObject      *source,
                    GAsyncResult *result,
@@ -6971,17 +7371,19 @@ _init_fetch_all(NMClient *self)
                                                                self,
                                                                NULL);
 
-    priv->dbsid_nm_settings_connection_updated =
-        g_dbus_connection_signal_subscribe(priv->dbus_connection,
-                                           priv->name_owner,
-                                           NM_DBUS_INTERFACE_SETTINGS_CONNECTION,
-                                           "Updated",
-                                           NULL,
-                                           NULL,
-                                           G_DBUS_SIGNAL_FLAGS_NONE,
-                                           _dbus_settings_updated_cb,
-                                           self,
-                                           NULL);
+    if (!NM_FLAGS_HAS(priv->instance_flags, NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS)) {
+        priv->dbsid_nm_settings_connection_updated =
+            g_dbus_connection_signal_subscribe(priv->dbus_connection,
+                                               priv->name_owner,
+                                               NM_DBUS_INTERFACE_SETTINGS_CONNECTION,
+                                               "Updated",
+                                               NULL,
+                                               NULL,
+                                               G_DBUS_SIGNAL_FLAGS_NONE,
+                                               _dbus_settings_updated_cb,
+                                               self,
+                                               NULL);
+    }
 
     priv->dbsid_nm_connection_active_state_changed =
         g_dbus_connection_signal_subscribe(priv->dbus_connection,
@@ -7521,6 +7923,9 @@ get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
     case PROP_INSTANCE_FLAGS:
         g_value_set_uint(value, priv->instance_flags);
         break;
+    case PROP_INTERFACE_ALLOWLIST:
+        g_value_set_boxed(value, priv->interface_allowlist);
+        break;
     case PROP_DBUS_CONNECTION:
         g_value_set_object(value, priv->dbus_connection);
         break;
@@ -7703,6 +8108,11 @@ set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *ps
         priv->dbus_connection = g_value_dup_object(value);
         break;
 
+    case PROP_INTERFACE_ALLOWLIST:
+        /* construct-only */
+        priv->interface_allowlist = g_value_dup_boxed(value);
+        break;
+
     case PROP_NETWORKING_ENABLED:
         b = g_value_get_boolean(value);
         if (priv->nm.networking_enabled != b) {
@@ -8030,6 +8440,8 @@ dispose(GObject *object)
 
     nm_clear_g_free(&priv->name_owner);
 
+    nm_clear_pointer(&priv->interface_allowlist, g_strfreev);
+
     _init_release_all(self);
 
     nm_assert(c_list_is_empty(&priv->dbus_objects_lst_head_watched_only));
@@ -8281,6 +8693,31 @@ nm_client_class_init(NMClientClass *client_class)
         0,
         G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS);
 
+    /**
+     * NMClient:interface-allowlist:
+     *
+     * If set, #NMClient only tracks D-Bus objects that implement one of the
+     * listed D-Bus interfaces. An entry also covers the interfaces below it, so
+     * "org.freedesktop.NetworkManager.Device" covers all device types. Note that
+     * objects usually implement several interfaces, and only the listed ones are
+     * tracked. Other objects are neither fetched nor instantiated, and properties
+     * that reference them are %NULL. The properties of #NMClient itself are always
+     * tracked.
+     *
+     * By default, all objects are tracked. Operations that would return an
+     * object that is not tracked fail. This is a construct-only property.
+     *
+     * See also %NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS.
+     *
+     * Since: 1.46
+     */
+    obj_properties[PROP_INTERFACE_ALLOWLIST] = g_param_spec_boxed(
+        NM_CLIENT_INTERFACE_ALLOWLIST,
+        "",
+        "",
+        G_TYPE_STRV,
+        G_PARAM_READABLE | G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
     /**
      * NMClient:dbus-name-owner:
      *
@@ -342,13 +342,13 @@ finalize(GObject *object)
 
     nm_clear_pointer(&priv->lldp_neighbors, g_ptr_array_unref);
 
-    g_free(priv->interface);
-    g_free(priv->ip_interface);
+    nml_intern_str_clear(&priv->interface);
+    nml_intern_str_clear(&priv->ip_interface);
     g_free(priv->udi);
     g_free(priv->path);
-    g_free(priv->driver);
-    g_free(priv->driver_version);
-    g_free(priv->firmware_version);
+    nml_intern_str_clear(&priv->driver);
+    nml_intern_str_clear(&priv->driver_version);
+    nml_intern_str_clear(&priv->firmware_version);
     g_free(priv->product);
     g_free(priv->vendor);
     g_free(priv->short_vendor);
@@ -356,7 +356,7 @@ finalize(GObject *object)
     g_free(priv->bus_name);
     g_free(priv->type_description);
     g_free(priv->physical_port_id);
-    g_free(priv->hw_address);
+    nml_intern_str_clear(&priv->hw_address);
 
     nm_clear_pointer(&priv->udev, udev_unref);
 
@@ -540,24 +540,27 @@ const NMLDBusMetaIface _nml_dbus_meta_iface_nm_device = NML_DBUS_META_IFACE_INIT
                                            NMDevicePrivate,
                                            property_o[PROPERTY_O_IDX_DHCP6_CONFIG],
                                            nm_dhcp6_config_get_type),
-        NML_DBUS_META_PROPERTY_INIT_S("Driver", PROP_DRIVER, NMDevicePrivate, driver),
-        NML_DBUS_META_PROPERTY_INIT_S("DriverVersion",
-                                      PROP_DRIVER_VERSION,
-                                      NMDevicePrivate,
-                                      driver_version),
+        NML_DBUS_META_PROPERTY_INIT_S_INTERN("Driver", PROP_DRIVER, NMDevicePrivate, driver),
+        NML_DBUS_META_PROPERTY_INIT_S_INTERN("DriverVersion",
+                                             PROP_DRIVER_VERSION,
+                                             NMDevicePrivate,
+                                             driver_version),
         NML_DBUS_META_PROPERTY_INIT_B("FirmwareMissing",
                                       PROP_FIRMWARE_MISSING,
                                       NMDevicePrivate,
                                       firmware_missing),
-        NML_DBUS_META_PROPERTY_INIT_S("FirmwareVersion",
-                                      PROP_FIRMWARE_VERSION,
-                                      NMDevicePrivate,
-                                      firmware_version),
+        NML_DBUS_META_PROPERTY_INIT_S_INTERN("FirmwareVersion",
+                                             PROP_FIRMWARE_VERSION,
+                                             NMDevicePrivate,
+                                             firmware_version),
         NML_DBUS_META_PROPERTY_INIT_FCN("HwAddress",
                                         0,
                                         "s",
                                         _nm_device_notify_update_prop_hw_address),
-        NML_DBUS_META_PROPERTY_INIT_S("Interface", PROP_INTERFACE, NMDevicePrivate, interface),
+        NML_DBUS_META_PROPERTY_INIT_S_INTERN("Interface",
+                                             PROP_INTERFACE,
+                                             NMDevicePrivate,
+                                             interface),
         NML_DBUS_META_PROPERTY_INIT_U("InterfaceFlags",
                                       PROP_INTERFACE_FLAGS,
                                       NMDevicePrivate,
@@ -581,10 +584,10 @@ const NMLDBusMetaIface _nml_dbus_meta_iface_nm_device = NML_DBUS_META_IFACE_INIT
                                       PROP_IP6_CONNECTIVITY,
                                       NMDevicePrivate,
                                       ip6_connectivity),
-        NML_DBUS_META_PROPERTY_INIT_S("IpInterface",
-                                      PROP_IP_INTERFACE,
-                                      NMDevicePrivate,
-                                      ip_interface),
+        NML_DBUS_META_PROPERTY_INIT_S_INTERN("IpInterface",
+                                             PROP_IP_INTERFACE,
+                                             NMDevicePrivate,
+                                             ip_interface),
         NML_DBUS_META_PROPERTY_INIT_FCN("LldpNeighbors",
                                         PROP_LLDP_NEIGHBORS,
                                         "aa{sv}",
@@ -1316,15 +1319,15 @@ _nm_device_notify_update_prop_hw_address(NMClient               *client,
     }
 
     if (!value) {
-        if (nm_clear_g_free(&priv->hw_address))
+        if (nml_intern_str_clear(&priv->hw_address))
             changed = TRUE;
         goto out;
     }
 
     priv->hw_address_is_new = is_new;
 
-    nm_strdup_reset(&priv->hw_address,
-                    _nml_coerce_property_str_not_empty(g_variant_get_string(value, NULL)));
+    nml_intern_str_reset(&priv->hw_address,
+                         _nml_coerce_property_str_not_empty(g_variant_get_string(value, NULL)));
 
     /* always emit a changed signal here, even if "priv->hw_address" might be unchanged.
      * We want to emit the signal because we received a PropertiesChanged signal on D-Bus,
@@ -163,6 +163,21 @@ _nml_coerce_property_str_not_empty(const char *str)
     return str && str[0] ? str : NULL;
 }
 
+/* Sets *p_str to an interned copy of @str. The buffer is owned by an
+ * NMRefString, so that objects with the same value (for example, the same
+ * driver name) share one allocation. Returns %TRUE if the value changed. */
+static inline gboolean
+nml_intern_str_reset(char **p_str, const char *str)
+{
+    return nm_ref_string_reset_str_upcast((const char **) p_str, str);
+}
+
+static inline gboolean
+nml_intern_str_clear(char **p_str)
+{
+    return nml_intern_str_reset(p_str, NULL);
+}
+
 static inline const char *
 _nml_coerce_property_object_path(NMRefString *path)
 {
@@ -238,7 +253,9 @@ typedef enum {
 #define NM_CLIENT_INSTANCE_FLAGS_ALL                                             \
     ((NMClientInstanceFlags) (NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_PERMISSIONS \
                               | NM_CLIENT_INSTANCE_FLAGS_INITIALIZED_GOOD        \
-                              | NM_CLIENT_INSTANCE_FLAGS_INITIALIZED_BAD))
+                              | NM_CLIENT_INSTANCE_FLAGS_INITIALIZED_BAD         \
+                              | NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS             \
+                              | NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS))
 
 #define NM_CLIENT_INSTANCE_FLAGS_ALL_WRITABLE                                                       \
     ((NMClientInstanceFlags) (NM_CLIENT_INSTANCE_FLAGS_ALL                                          \
@@ -341,6 +358,12 @@ NMLDBusNotifyUpdatePropFlags _nml_dbus_notify_update_prop_o(NMClient
                                                             guint     dbus_property_idx,
                                                             GVariant *value);
 
+NMLDBusNotifyUpdatePropFlags _nml_dbus_notify_update_prop_s_intern(NMClient      *client,
+                                                                   NMLDBusObject *dbobj,
+                                                                   const NMLDBusMetaIface *meta_iface,
+                                                                   guint     dbus_property_idx,
+                                                                   GVariant *value);
+
 NMLDBusNotifyUpdatePropFlags nml_dbus_property_ao_notify(NMClient               *self,
                                                          NMLDBusPropertyAO      *pr_ao,
                                                          NMLDBusObject          *dbobj,
@@ -418,6 +441,21 @@ typedef struct {
 #define NML_DBUS_META_PROPERTY_INIT_AY(...) \
     _NML_DBUS_META_PROPERTY_INIT_DEFAULT("ay", GBytes *, __VA_ARGS__)
 
+/* Like NML_DBUS_META_PROPERTY_INIT_S(), but the string is interned via
+ * nml_intern_str_reset(). Use it for values that repeat across many
+ * objects, like driver names. The field must be released with
+ * nml_intern_str_clear(). */
+#define NML_DBUS_META_PROPERTY_INIT_S_INTERN(v_dbus_property_name,                        \
+                                             v_obj_properties_idx,                        \
+                                             v_container,                                 \
+                                             v_field)                                     \
+    NML_DBUS_META_PROPERTY_INIT(                                                          \
+        v_dbus_property_name,                                                             \
+        "s",                                                                              \
+        v_obj_properties_idx,                                                             \
+        .prop_struct_offset = NM_STRUCT_OFFSET_ENSURE_TYPE(char *, v_container, v_field), \
+        .notify_update_prop = _nml_dbus_notify_update_prop_s_intern)
+
 #define NML_DBUS_META_PROPERTY_INIT_O(v_dbus_property_name,                                      \
                                       v_obj_properties_idx,                                      \
                                       v_container,                                               \
@@ -1041,10 +1079,23 @@ void _nm_client_set_property_sync_legacy(NMClient   *self,
 
 void _nm_client_get_settings_call(NMClient *self, NMLDBusObject *dbobj);
 
+void _nm_client_get_settings_commit(NMClient           *self,
+                                    NMRemoteConnection *remote_connection,
+                                    GVariant           *settings);
+
 GCancellable *_nm_remote_settings_get_settings_prepare(NMRemoteConnection *self);
 
+gboolean _nm_remote_settings_get_settings_is_current(NMRemoteConnection *self,
+                                                     GCancellable       *cancellable);
+
+void _nm_remote_settings_get_settings_abort(NMRemoteConnection *self, GCancellable *cancellable);
+
+void _nm_remote_settings_get_settings_return(NMRemoteConnection *self);
+
 void _nm_remote_settings_get_settings_commit(NMRemoteConnection *self, GVariant *settings);
 
+gboolean _nm_remote_settings_get_settings_needs_fetch(NMRemoteConnection *self);
+
 /*****************************************************************************/
 
 void
@@ -37,6 +37,10 @@ NM_GOBJECT_PROPERTIES_DEFINE(NMRemoteConnection,
 typedef struct {
     GCancellable *get_settings_cancellable;
 
+    /* The tasks of nm_remote_connection_ensure_settings_async(), that wait
+     * for the settings to get committed. */
+    GPtrArray *ensure_tasks;
+
     char   *filename;
     guint64 version_id;
     guint32 flags;
@@ -44,6 +48,7 @@ typedef struct {
 
     bool visible : 1;
     bool is_initialized : 1;
+    bool settings_fetched : 1;
 } NMRemoteConnectionPrivate;
 
 struct _NMRemoteConnection {
@@ -646,6 +651,219 @@ nm_remote_connection_get_visible(NMRemoteConnection *connection)
 
 /*****************************************************************************/
 
+/**
+ * nm_remote_connection_ensure_settings:
+ * @connection: the #NMRemoteConnection
+ * @cancellable: a #GCancellable, or %NULL
+ * @error: location for a #GError, or %NULL
+ *
+ * With %NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS, the settings of the
+ * profile are not fetched upfront. This fetches them, unless that already
+ * happened. On failure, the profile becomes invisible.
+ *
+ * Returns: %TRUE on success, %FALSE on error.
+ *
+ * Warning: this function performs a (pseudo) blocking D-Bus call. Prefer
+ *   nm_remote_connection_ensure_settings_async() or
+ *   nm_client_ensure_connection_settings_async().
+ *
+ * Since: 1.46
+ **/
+gboolean
+nm_remote_connection_ensure_settings(NMRemoteConnection *connection,
+                                     GCancellable       *cancellable,
+                                     GError            **error)
+{
+    gs_unref_variant GVariant *ret      = NULL;
+    gs_unref_variant GVariant *settings = NULL;
+    GError                    *local    = NULL;
+    GCancellable              *fetch_cancellable;
+    NMClient                  *client;
+
+    g_return_val_if_fail(NM_IS_REMOTE_CONNECTION(connection), FALSE);
+    g_return_val_if_fail(!cancellable || G_IS_CANCELLABLE(cancellable), FALSE);
+
+    if (!_nm_remote_settings_get_settings_needs_fetch(connection))
+        return TRUE;
+
+    client = _nm_object_get_client(connection);
+    if (!client) {
+        /* The profile was removed. */
+        g_propagate_error(error, _nm_client_new_error_nm_not_cached());
+        return FALSE;
+    }
+
+    /* This supersedes a fetch that might be in flight. The blocking call
+     * doesn't iterate the main context, so nothing can supersede us. */
+    fetch_cancellable = _nm_remote_settings_get_settings_prepare(connection);
+
+    ret = _nm_client_dbus_call_sync(client,
+                                    cancellable,
+                                    _nm_object_get_path(connection),
+                                    NM_DBUS_INTERFACE_SETTINGS_CONNECTION,
+                                    "GetSettings",
+                                    g_variant_new("()"),
+                                    G_VARIANT_TYPE("(a{sa{sv}})"),
+                                    G_DBUS_CALL_FLAGS_NONE,
+                                    NM_DBUS_DEFAULT_TIMEOUT_MSEC,
+                                    TRUE,
+                                    &local);
+    if (!ret) {
+        if (nm_utils_error_is_cancelled(local))
+            _nm_remote_settings_get_settings_abort(connection, fetch_cancellable);
+        else
+            _nm_client_get_settings_commit(client, connection, NULL);
+        g_propagate_error(error, local);
+        return FALSE;
+    }
+
+    g_variant_get(ret, "(@a{sa{sv}})", &settings);
+    _nm_client_get_settings_commit(client, connection, settings);
+    return TRUE;
+}
+
+static void
+_ensure_task_disconnect_cancelled(GTask *task)
+{
+    gulong *p_cancelled_id;
+
+    p_cancelled_id = g_task_get_task_data(task);
+    if (p_cancelled_id) {
+        g_signal_handler_disconnect(g_task_get_cancellable(task), *p_cancelled_id);
+        g_task_set_task_data(task, NULL, NULL);
+    }
+}
+
+static void
+_ensure_task_cancelled_cb(GCancellable *cancellable, gpointer user_data)
+{
+    GTask                     *task0 = user_data;
+    gs_unref_object GTask     *task  = NULL;
+    NMRemoteConnection        *self  = g_task_get_source_object(task0);
+    NMRemoteConnectionPrivate *priv  = NM_REMOTE_CONNECTION_GET_PRIVATE(self);
+    gs_free_error GError      *error = NULL;
+    guint                      idx;
+
+    if (!priv->ensure_tasks || !g_ptr_array_find(priv->ensure_tasks, task0, &idx))
+        g_return_if_reached();
+
+    /* The fetch stays in flight. Other callers might wait for it, and
+     * otherwise it still commits the settings. */
+    task = g_ptr_array_remove_index(priv->ensure_tasks, idx);
+
+    _ensure_task_disconnect_cancelled(task);
+
+    nm_utils_error_set_cancelled(&error, FALSE, NULL);
+    g_task_return_error(task, g_steal_pointer(&error));
+}
+
+/**
+ * nm_remote_connection_ensure_settings_async:
+ * @connection: the #NMRemoteConnection
+ * @cancellable: a #GCancellable, or %NULL
+ * @callback: callback to be called when the settings are fetched
+ * @user_data: caller-specific data passed to @callback
+ *
+ * Asynchronously fetches the settings of a profile of a #NMClient with
+ * %NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS. If the settings are
+ * already fetched, the operation completes right away. If a fetch is
+ * already in flight, the operation completes together with it. To fetch
+ * many profiles, prefer nm_client_ensure_connection_settings_async().
+ *
+ * Since: 1.46
+ **/
+void
+nm_remote_connection_ensure_settings_async(NMRemoteConnection *connection,
+                                           GCancellable       *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer            user_data)
+{
+    NMRemoteConnectionPrivate *priv;
+    gs_unref_object GTask     *task = NULL;
+    NMClient                  *client;
+
+    g_return_if_fail(NM_IS_REMOTE_CONNECTION(connection));
+    g_return_if_fail(!cancellable || G_IS_CANCELLABLE(cancellable));
+
+    priv = NM_REMOTE_CONNECTION_GET_PRIVATE(connection);
+
+    task = nm_g_task_new(connection,
+                         cancellable,
+                         nm_remote_connection_ensure_settings_async,
+                         callback,
+                         user_data);
+
+    if (!_nm_remote_settings_get_settings_needs_fetch(connection)) {
+        g_task_return_boolean(task, TRUE);
+        return;
+    }
+
+    client = _nm_object_get_client(connection);
+    if (!client) {
+        g_task_return_error(task, _nm_client_new_error_nm_not_cached());
+        return;
+    }
+
+    if (!priv->ensure_tasks)
+        priv->ensure_tasks = g_ptr_array_new();
+    g_ptr_array_add(priv->ensure_tasks, g_object_ref(task));
+
+    if (cancellable) {
+        gulong cancelled_id;
+
+        cancelled_id =
+            g_cancellable_connect(cancellable, G_CALLBACK(_ensure_task_cancelled_cb), task, NULL);
+        if (cancelled_id == 0) {
+            /* Already cancelled. The callback returned the task synchronously. */
+            return;
+        }
+        g_task_set_task_data(task, nm_memdup(&cancelled_id, sizeof(cancelled_id)), g_free);
+    }
+
+    /* All fetches go through _nm_remote_settings_get_settings_prepare(), so
+     * that a later one supersedes an earlier one. Don't start another fetch
+     * if one is in flight already. */
+    if (!priv->get_settings_cancellable)
+        _nm_client_get_settings_call(client, _nm_object_get_dbobj(connection));
+}
+
+/**
+ * nm_remote_connection_ensure_settings_finish:
+ * @connection: the #NMRemoteConnection
+ * @result: the result passed to the #GAsyncReadyCallback
+ * @error: location for a #GError, or %NULL
+ *
+ * Gets the result of a call to nm_remote_connection_ensure_settings_async().
+ *
+ * Returns: %TRUE on success, %FALSE on error.
+ *
+ * Since: 1.46
+ **/
+gboolean
+nm_remote_connection_ensure_settings_finish(NMRemoteConnection *connection,
+                                            GAsyncResult       *result,
+                                            GError            **error)
+{
+    g_return_val_if_fail(NM_IS_REMOTE_CONNECTION(connection), FALSE);
+    g_return_val_if_fail(
+        nm_g_task_is_valid(result, connection, nm_remote_connection_ensure_settings_async),
+        FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/*****************************************************************************/
+
+gboolean
+_nm_remote_settings_get_settings_needs_fetch(NMRemoteConnection *self)
+{
+    NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE(self);
+
+    /* Without lazy fetching, the object only gets initialized after the
+     * settings were fetched. */
+    return priv->is_initialized && !priv->settings_fetched;
+}
+
 GCancellable *
 _nm_remote_settings_get_settings_prepare(NMRemoteConnection *self)
 {
@@ -656,6 +874,77 @@ _nm_remote_settings_get_settings_prepare(NMRemoteConnection *self)
     return priv->get_settings_cancellable;
 }
 
+/* Whether the fetch that got @cancellable from
+ * _nm_remote_settings_get_settings_prepare() is still the latest one. Only
+ * then it may commit. */
+gboolean
+_nm_remote_settings_get_settings_is_current(NMRemoteConnection *self, GCancellable *cancellable)
+{
+    NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE(self);
+
+    return cancellable && priv->get_settings_cancellable == cancellable
+           && !g_cancellable_is_cancelled(cancellable);
+}
+
+/* The fetch that got @cancellable did not complete. If tasks wait for the
+ * settings, start another fetch for them. */
+void
+_nm_remote_settings_get_settings_abort(NMRemoteConnection *self, GCancellable *cancellable)
+{
+    NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE(self);
+    NMClient                  *client;
+
+    if (!_nm_remote_settings_get_settings_is_current(self, cancellable))
+        return;
+
+    g_clear_object(&priv->get_settings_cancellable);
+
+    client = _nm_object_get_client(self);
+    if (client && priv->ensure_tasks && priv->ensure_tasks->len > 0)
+        _nm_client_get_settings_call(client, _nm_object_get_dbobj(self));
+}
+
+static void
+_ensure_tasks_return(NMRemoteConnection *self, GError *error_take)
+{
+    NMRemoteConnectionPrivate   *priv  = NM_REMOTE_CONNECTION_GET_PRIVATE(self);
+    gs_free_error GError        *error = error_take;
+    gs_unref_ptrarray GPtrArray *tasks = NULL;
+    guint                        i;
+
+    tasks = g_steal_pointer(&priv->ensure_tasks);
+    if (!tasks)
+        return;
+
+    for (i = 0; i < tasks->len; i++) {
+        gs_unref_object GTask *task = tasks->pdata[i];
+
+        _ensure_task_disconnect_cancelled(task);
+
+        if (error)
+            g_task_return_error(task, g_error_copy(error));
+        else if (!priv->visible) {
+            g_task_return_new_error(task,
+                                    NM_CLIENT_ERROR,
+                                    NM_CLIENT_ERROR_FAILED,
+                                    _("The settings of the profile are not available"));
+        } else
+            g_task_return_boolean(task, TRUE);
+    }
+}
+
+/* Completes the waiting nm_remote_connection_ensure_settings_async() calls.
+ * Call this after the commit, once the changes are emitted. */
+void
+_nm_remote_settings_get_settings_return(NMRemoteConnection *self)
+{
+    if (NM_REMOTE_CONNECTION_GET_PRIVATE(self)->get_settings_cancellable) {
+        /* Another fetch started in the meantime. */
+        return;
+    }
+    _ensure_tasks_return(self, NULL);
+}
+
 void
 _nm_remote_settings_get_settings_commit(NMRemoteConnection *self, GVariant *settings)
 {
@@ -666,6 +955,8 @@ _nm_remote_settings_get_settings_commit(NMRemoteConnection *self, GVariant *sett
 
     g_clear_object(&priv->get_settings_cancellable);
 
+    priv->settings_fetched = TRUE;
+
     if (!priv->is_initialized) {
         changed              = TRUE;
         priv->is_initialized = TRUE;
@@ -718,6 +1009,18 @@ register_client(NMObject *nmobj, NMClient *client, NMLDBusObject *dbobj)
 {
     NM_OBJECT_CLASS(nm_remote_connection_parent_class)->register_client(nmobj, client, dbobj);
     _nm_connection_set_path_rstr(NM_CONNECTION(nmobj), dbobj->dbus_path);
+
+    if (NM_FLAGS_HAS(nm_client_get_instance_flags(client),
+                     NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS)) {
+        NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE(nmobj);
+
+        /* The settings are only fetched on request. Until then, the profile
+         * is considered visible. */
+        priv->is_initialized = TRUE;
+        priv->visible        = TRUE;
+        return;
+    }
+
     _nm_client_get_settings_call(client, dbobj);
 }
 
@@ -725,6 +1028,7 @@ static void
 unregister_client(NMObject *nmobj, NMClient *client, NMLDBusObject *dbobj)
 {
     nm_clear_g_cancellable(&NM_REMOTE_CONNECTION_GET_PRIVATE(nmobj)->get_settings_cancellable);
+    _ensure_tasks_return(NM_REMOTE_CONNECTION(nmobj), _nm_client_new_error_nm_not_cached());
     NM_OBJECT_CLASS(nm_remote_connection_parent_class)->unregister_client(nmobj, client, dbobj);
 }
 
@@ -1586,6 +1586,167 @@ test_client_wait_shutdown(void)
 
 /*****************************************************************************/
 
+static void
+test_client_no_settings(void)
+{
+    nmtstc_auto_service_cleanup NMTstcServiceInfo *sinfo           = NULL;
+    gs_unref_object NMClient                      *client          = NULL;
+    gs_unref_object NMClient                      *client_all      = NULL;
+    gs_unref_object NMClient                      *client_profiles = NULL;
+    gs_unref_object NMConnection                  *connection      = NULL;
+    const char *const allowlist[] = {
+        NM_DBUS_INTERFACE_SETTINGS_CONNECTION,
+        NULL,
+    };
+
+    sinfo = nmtstc_service_init();
+    if (!nmtstc_service_available(sinfo))
+        return;
+
+    connection = nmtst_create_minimal_connection("test-no-settings",
+                                                 NULL,
+                                                 NM_SETTING_WIRED_SETTING_NAME,
+                                                 NULL);
+    nmtstc_service_add_connection(sinfo, connection, TRUE, NULL);
+
+    client_all = nmtstc_client_new(TRUE);
+    g_assert_cmpint(nm_client_get_connections(client_all)->len, ==, 1);
+
+    client = nmtstc_context_object_new(NM_TYPE_CLIENT,
+                                       TRUE,
+                                       NM_CLIENT_INSTANCE_FLAGS,
+                                       (guint) NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS,
+                                       NULL);
+    g_assert(NM_FLAGS_HAS(nm_client_get_instance_flags(client),
+                          NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS));
+    g_assert_cmpint(nm_client_get_connections(client)->len, ==, 0);
+
+    /* Devices are still tracked. */
+    nmtstc_service_add_device(sinfo, client, "AddWiredDevice", "eth0");
+    g_assert_cmpint(nm_client_get_devices(client)->len, ==, 1);
+    g_assert_cmpint(nm_client_get_connections(client)->len, ==, 0);
+
+    /* With an allow-list, only the profiles are tracked. */
+    client_profiles = nmtstc_context_object_new(NM_TYPE_CLIENT,
+                                                TRUE,
+                                                NM_CLIENT_INTERFACE_ALLOWLIST,
+                                                allowlist,
+                                                NULL);
+    g_assert_cmpint(nm_client_get_connections(client_profiles)->len, ==, 1);
+    g_assert_cmpint(nm_client_get_devices(client_profiles)->len, ==, 0);
+    g_assert_cmpint(nm_client_get_all_devices(client_profiles)->len, ==, 0);
+    g_assert(nm_client_get_nm_running(client_profiles));
+}
+
+static void
+_ensure_connection_settings_cb(GObject *source, GAsyncResult *result, gpointer user_data)
+{
+    int                  *done  = user_data;
+    gs_free_error GError *error = NULL;
+
+    g_assert(nm_client_ensure_connection_settings_finish(NM_CLIENT(source), result, &error));
+    g_assert_no_error(error);
+    (*done)++;
+}
+
+static void
+test_client_lazy_fetch_settings(void)
+{
+    nmtstc_auto_service_cleanup NMTstcServiceInfo *sinfo       = NULL;
+    gs_unref_object NMClient                      *client      = NULL;
+    gs_unref_object NMConnection                  *connection1 = NULL;
+    gs_unref_object NMConnection                  *connection2 = NULL;
+    gs_free_error GError                          *error       = NULL;
+    const GPtrArray                               *connections;
+    NMRemoteConnection                            *remote;
+    int                                            done = 0;
+    guint                                          i;
+
+    sinfo = nmtstc_service_init();
+    if (!nmtstc_service_available(sinfo))
+        return;
+
+    connection1 = nmtst_create_minimal_connection("test-lazy-1",
+                                                  NULL,
+                                                  NM_SETTING_WIRED_SETTING_NAME,
+                                                  NULL);
+    nmtstc_service_add_connection(sinfo, connection1, TRUE, NULL);
+    connection2 = nmtst_create_minimal_connection("test-lazy-2",
+                                                  NULL,
+                                                  NM_SETTING_WIRED_SETTING_NAME,
+                                                  NULL);
+    nmtstc_service_add_connection(sinfo, connection2, TRUE, NULL);
+
+    client = nmtstc_context_object_new(NM_TYPE_CLIENT,
+                                       TRUE,
+                                       NM_CLIENT_INSTANCE_FLAGS,
+                                       (guint) NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS,
+                                       NULL);
+
+    /* The profiles are known, but their settings were not fetched yet. */
+    connections = nm_client_get_connections(client);
+    g_assert_cmpint(connections->len, ==, 2);
+    for (i = 0; i < connections->len; i++) {
+        remote = connections->pdata[i];
+        g_assert(nm_remote_connection_get_visible(remote));
+        g_assert(!nm_connection_get_id(NM_CONNECTION(remote)));
+    }
+
+    remote = connections->pdata[0];
+    g_assert(nm_remote_connection_ensure_settings(remote, NULL, &error));
+    g_assert_no_error(error);
+    g_assert(g_str_has_prefix(nm_connection_get_id(NM_CONNECTION(remote)), "test-lazy-"));
+    g_assert(!nm_connection_get_id(NM_CONNECTION(connections->pdata[1])));
+
+    nm_client_ensure_connection_settings_async(client,
+                                               NULL,
+                                               NULL,
+                                               _ensure_connection_settings_cb,
+                                               &done);
+    nmtst_main_context_iterate_until_assert(NULL, 5000, done == 1);
+
+    connections = nm_client_get_connections(client);
+    g_assert_cmpint(connections->len, ==, 2);
+    for (i = 0; i < connections->len; i++) {
+        remote = connections->pdata[i];
+        g_assert(nm_remote_connection_get_visible(remote));
+        g_assert(g_str_has_prefix(nm_connection_get_id(NM_CONNECTION(remote)), "test-lazy-"));
+    }
+    g_assert(nm_client_get_connection_by_id(client, "test-lazy-1"));
+    g_assert(nm_client_get_connection_by_id(client, "test-lazy-2"));
+}
+
+static void
+test_client_interned_strings(void)
+{
+    nmtstc_auto_service_cleanup NMTstcServiceInfo *sinfo  = NULL;
+    gs_unref_object NMClient                      *client = NULL;
+    NMDevice                                      *eth0;
+    NMDevice                                      *eth1;
+    const char                                    *driver;
+
+    sinfo = nmtstc_service_init();
+    if (!nmtstc_service_available(sinfo))
+        return;
+
+    client = nmtstc_client_new(TRUE);
+
+    eth0 = nmtstc_service_add_device(sinfo, client, "AddWiredDevice", "eth0");
+    eth1 = nmtstc_service_add_device(sinfo, client, "AddWiredDevice", "eth1");
+
+    /* Both devices have the same driver. The string is shared. */
+    driver = nm_device_get_driver(eth0);
+    g_assert(driver);
+    g_assert(driver == nm_device_get_driver(eth1));
+    g_assert(NM_REF_STRING_UPCAST(driver) == nmtst_ref_string_find(driver));
+
+    g_assert_cmpstr(nm_device_get_iface(eth0), ==, "eth0");
+    g_assert(NM_REF_STRING_UPCAST(nm_device_get_iface(eth0))
+             == nmtst_ref_string_find(nm_device_get_iface(eth0)));
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE();
 
 int
@@ -1613,6 +1774,9 @@ main(int argc, char **argv)
     g_test_add_func("/libnm/device-connection-compatibility", test_device_connection_compatibility);
     g_test_add_func("/libnm/connection/invalid", test_connection_invalid);
     g_test_add_func("/libnm/test_client_wait_shutdown", test_client_wait_shutdown);
+    g_test_add_func("/libnm/client-no-settings", test_client_no_settings);
+    g_test_add_func("/libnm/client-lazy-fetch-settings", test_client_lazy_fetch_settings);
+    g_test_add_func("/libnm/client-interned-strings", test_client_interned_strings);
 
     return g_test_run();
 }
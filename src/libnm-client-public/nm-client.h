@@ -29,6 +29,22 @@ G_BEGIN_DECLS
  * @NM_CLIENT_INSTANCE_FLAGS_INITIALIZED_BAD: like @NM_CLIENT_INSTANCE_FLAGS_INITIALIZED_GOOD
  *   indicates that the instance completed initialization with failure. In that
  *   case the instance is unusable. Since: 1.42.
+ * @NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS: don't track connection profiles.
+ *   The objects of the "org.freedesktop.NetworkManager.Settings.Connection"
+ *   interface are neither fetched nor instantiated, and their settings are
+ *   never requested. nm_client_get_connections() returns an empty list and
+ *   properties that reference a profile, like nm_active_connection_get_connection(),
+ *   are %NULL. This is useful for clients that are only interested in devices
+ *   and active connections, because on a host with many profiles, fetching them
+ *   is expensive. The flag can only be set during construction. Since: 1.46.
+ * @NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS: don't fetch the settings of
+ *   connection profiles upfront. The #NMRemoteConnection objects are created
+ *   and considered visible, but they contain no settings until they are
+ *   requested via nm_remote_connection_ensure_settings_async() or
+ *   nm_client_ensure_connection_settings_async(). Once fetched, the settings
+ *   are kept up to date like without this flag. Note that lookups like
+ *   nm_client_get_connection_by_uuid() only find profiles whose settings are
+ *   fetched. The flag can only be set during construction. Since: 1.46.
  *
  * Since: 1.24
  */
@@ -37,6 +53,8 @@ typedef enum /*< flags >*/ {
     NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_PERMISSIONS = 0x1,
     NM_CLIENT_INSTANCE_FLAGS_INITIALIZED_GOOD          = 0x2,
     NM_CLIENT_INSTANCE_FLAGS_INITIALIZED_BAD           = 0x4,
+    NM_CLIENT_INSTANCE_FLAGS_NO_SETTINGS               = 0x8,
+    NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS       = 0x10,
 } NMClientInstanceFlags;
 
 #define NM_TYPE_CLIENT            (nm_client_get_type())
@@ -46,14 +64,15 @@ typedef enum /*< flags >*/ {
 #define NM_IS_CLIENT_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), NM_TYPE_CLIENT))
 #define NM_CLIENT_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), NM_TYPE_CLIENT, NMClientClass))
 
-#define NM_CLIENT_VERSION         "version"
-#define NM_CLIENT_VERSION_INFO    "version-info"
-#define NM_CLIENT_STATE           "state"
-#define NM_CLIENT_STARTUP         "startup"
-#define NM_CLIENT_NM_RUNNING      "nm-running"
-#define NM_CLIENT_DBUS_CONNECTION "dbus-connection"
-#define NM_CLIENT_DBUS_NAME_OWNER "dbus-name-owner"
-#define NM_CLIENT_INSTANCE_FLAGS  "instance-flags"
+#define NM_CLIENT_VERSION             "version"
+#define NM_CLIENT_VERSION_INFO        "version-info"
+#define NM_CLIENT_STATE               "state"
+#define NM_CLIENT_STARTUP             "startup"
+#define NM_CLIENT_NM_RUNNING          "nm-running"
+#define NM_CLIENT_DBUS_CONNECTION     "dbus-connection"
+#define NM_CLIENT_DBUS_NAME_OWNER     "dbus-name-owner"
+#define NM_CLIENT_INSTANCE_FLAGS      "instance-flags"
+#define NM_CLIENT_INTERFACE_ALLOWLIST "interface-allowlist"
 
 _NM_DEPRECATED_SYNC_WRITABLE_PROPERTY
 #define NM_CLIENT_NETWORKING_ENABLED "networking-enabled"
@@ -362,6 +381,16 @@ NMRemoteConnection *nm_client_get_connection_by_id(NMClient *client, const char
 NMRemoteConnection *nm_client_get_connection_by_path(NMClient *client, const char *path);
 NMRemoteConnection *nm_client_get_connection_by_uuid(NMClient *client, const char *uuid);
 
+NM_AVAILABLE_IN_1_46
+void nm_client_ensure_connection_settings_async(NMClient           *client,
+                                                const GPtrArray    *connections,
+                                                GCancellable       *cancellable,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
+NM_AVAILABLE_IN_1_46
+gboolean
+nm_client_ensure_connection_settings_finish(NMClient *client, GAsyncResult *result, GError **error);
+
 void nm_client_add_connection_async(NMClient           *client,
                                     NMConnection       *connection,
                                     gboolean            save_to_disk,
@@ -124,6 +124,22 @@ gboolean nm_remote_connection_get_visible(NMRemoteConnection *connection);
 NM_AVAILABLE_IN_1_44
 guint64 nm_remote_connection_get_version_id(NMRemoteConnection *connection);
 
+NM_AVAILABLE_IN_1_46
+gboolean nm_remote_connection_ensure_settings(NMRemoteConnection *connection,
+                                              GCancellable       *cancellable,
+                                              GError            **error);
+
+NM_AVAILABLE_IN_1_46
+void nm_remote_connection_ensure_settings_async(NMRemoteConnection *connection,
+                                                GCancellable       *cancellable,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
+
+NM_AVAILABLE_IN_1_46
+gboolean nm_remote_connection_ensure_settings_finish(NMRemoteConnection *connection,
+                                                     GAsyncResult       *result,
+                                                     GError            **error);
+
 G_END_DECLS
 
 #endif /* __NM_REMOTE_CONNECTION__ */
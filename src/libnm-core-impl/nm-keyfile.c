@@ -3308,33 +3308,104 @@ _parse_info_find(NMSetting                *setting,
 
 /*****************************************************************************/
 
+/* How the reader handles one property of a setting. This only depends on the
+ * setting type and is resolved once per type by _read_prop_infos_get(),
+ * instead of looking up the ParseInfoProperty and dispatching on the GType
+ * of the property for every key of every profile. */
+typedef enum _nm_packed {
+    READ_PROP_KIND_SKIP,
+    READ_PROP_KIND_PARSER_FULL,
+    READ_PROP_KIND_PARSER,
+    READ_PROP_KIND_GOBJECT,
+    READ_PROP_KIND_DIRECT_BOOL,
+    READ_PROP_KIND_DIRECT_INT32,
+    READ_PROP_KIND_DIRECT_UINT32,
+    READ_PROP_KIND_DIRECT_INT64,
+    READ_PROP_KIND_DIRECT_UINT64,
+    READ_PROP_KIND_DIRECT_STRING,
+    READ_PROP_KIND_DIRECT_STRV,
+} ReadPropKind;
+
+typedef struct {
+    const ParseInfoProperty *pip;
+    ReadPropKind             kind;
+    bool                     check_key : 1;
+} ReadPropInfo;
+
+static ReadPropKind
+_read_prop_kind_direct(const NMSettInfoProperty *property_info)
+{
+    GType type = G_PARAM_SPEC_VALUE_TYPE(property_info->param_spec);
+
+    /* Only take the shortcut if the direct type matches the GType of the
+     * property. Otherwise (for example, enums and flags), the value must
+     * be validated by GObject. */
+    switch (property_info->property_type->direct_type) {
+    case NM_VALUE_TYPE_BOOL:
+        if (type == G_TYPE_BOOLEAN)
+            return READ_PROP_KIND_DIRECT_BOOL;
+        break;
+    case NM_VALUE_TYPE_INT32:
+        if (type == G_TYPE_INT)
+            return READ_PROP_KIND_DIRECT_INT32;
+        break;
+    case NM_VALUE_TYPE_UINT32:
+        if (type == G_TYPE_UINT)
+            return READ_PROP_KIND_DIRECT_UINT32;
+        break;
+    case NM_VALUE_TYPE_INT64:
+        if (type == G_TYPE_INT64)
+            return READ_PROP_KIND_DIRECT_INT64;
+        break;
+    case NM_VALUE_TYPE_UINT64:
+        if (type == G_TYPE_UINT64)
+            return READ_PROP_KIND_DIRECT_UINT64;
+        break;
+    case NM_VALUE_TYPE_STRING:
+        if (type == G_TYPE_STRING)
+            return READ_PROP_KIND_DIRECT_STRING;
+        break;
+    case NM_VALUE_TYPE_STRV:
+        if (type == G_TYPE_STRV)
+            return READ_PROP_KIND_DIRECT_STRV;
+        break;
+    default:
+        break;
+    }
+    return READ_PROP_KIND_GOBJECT;
+}
+
 static void
-read_one_setting_value(KeyfileReaderInfo        *info,
-                       NMSetting                *setting,
-                       const NMSettInfoProperty *property_info)
+_read_prop_info_init(ReadPropInfo             *rpi,
+                     const ParseInfoSetting   *pis,
+                     const NMSettInfoProperty *property_info)
 {
-    GKeyFile                *keyfile = info->keyfile;
-    gs_free_error GError    *err     = NULL;
-    const NMMetaSettingInfo *setting_info;
-    const ParseInfoProperty *pip;
-    gs_free char            *tmp_str = NULL;
-    const char              *key;
-    GType                    type;
-    guint64                  u64;
-    gint64                   i64;
+    const ParseInfoProperty *pip = NULL;
 
-    nm_assert(!info->error);
     nm_assert(!property_info->param_spec
               || nm_streq(property_info->param_spec->name, property_info->name));
 
-    key = property_info->name;
+    if (pis && pis->properties) {
+        const char *property_name = property_info->name;
+        gssize      idx;
 
-    _parse_info_find(setting, key, &setting_info, NULL, &pip);
+        idx = nm_ptrarray_find_bsearch((gconstpointer *) pis->properties,
+                                       NM_PTRARRAY_LEN(pis->properties),
+                                       &property_name,
+                                       nm_strcmp_p_with_data,
+                                       NULL);
+        if (idx >= 0)
+            pip = pis->properties[idx];
+    }
 
-    nm_assert(setting_info);
+    *rpi = (ReadPropInfo){
+        .pip       = pip,
+        .kind      = READ_PROP_KIND_SKIP,
+        .check_key = (!pip || !pip->parser_no_check_key),
+    };
 
     if (!pip) {
-        if (nm_streq(key, NM_SETTING_NAME))
+        if (nm_streq(property_info->name, NM_SETTING_NAME))
             return;
         if (!property_info->param_spec)
             return;
@@ -3345,11 +3416,214 @@ read_one_setting_value(KeyfileReaderInfo        *info,
         if (pip->parser_skip)
             return;
         if (pip->has_parser_full) {
-            pip->parser_full(info, setting_info, property_info, pip, setting);
+            rpi->kind = READ_PROP_KIND_PARSER_FULL;
             return;
         }
     }
 
+    nm_assert(property_info->param_spec);
+    nm_assert((property_info->param_spec->flags & (G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY))
+              == G_PARAM_WRITABLE);
+
+    if (pip && pip->parser)
+        rpi->kind = READ_PROP_KIND_PARSER;
+    else
+        rpi->kind = _read_prop_kind_direct(property_info);
+}
+
+static const ReadPropInfo *
+_read_prop_infos_get(const NMMetaSettingInfo *setting_info, const NMSettInfoSetting *sett_info)
+{
+    static const ReadPropInfo *read_prop_infos[_NM_META_SETTING_TYPE_NUM];
+    const ReadPropInfo       **p_rpis;
+    const ReadPropInfo        *rpis;
+    ReadPropInfo              *rpis_new;
+    guint                      i;
+
+    nm_assert(setting_info);
+    nm_assert(_NM_INT_NOT_NEGATIVE(setting_info->meta_type));
+    nm_assert(setting_info->meta_type < G_N_ELEMENTS(read_prop_infos));
+
+    p_rpis = &read_prop_infos[setting_info->meta_type];
+
+again:
+    rpis = g_atomic_pointer_get(p_rpis);
+    if (G_LIKELY(rpis))
+        return rpis;
+
+    rpis_new = g_new(ReadPropInfo, NM_MAX(sett_info->property_infos_len, 1u));
+    for (i = 0; i < sett_info->property_infos_len; i++) {
+        _read_prop_info_init(&rpis_new[i],
+                             parse_infos[setting_info->meta_type],
+                             &sett_info->property_infos[i]);
+    }
+
+    if (!g_atomic_pointer_compare_and_exchange(p_rpis, NULL, rpis_new)) {
+        g_free(rpis_new);
+        goto again;
+    }
+    return rpis_new;
+}
+
+static gboolean
+_read_direct_uint64(KeyfileReaderInfo *info,
+                    const char        *setting_name,
+                    const char        *key,
+                    guint64            max,
+                    guint64           *out_val,
+                    GError           **error)
+{
+    gs_free char *tmp_str = NULL;
+    guint64       u64;
+
+    tmp_str = nm_keyfile_plugin_kf_get_value(info->keyfile, setting_name, key, error);
+    if (!tmp_str)
+        return FALSE;
+
+    u64 = _nm_utils_ascii_str_to_uint64(tmp_str, 0, 0, max, G_MAXUINT64);
+    if (u64 == G_MAXUINT64 && errno != 0) {
+        g_set_error_literal(error,
+                            G_KEY_FILE_ERROR,
+                            G_KEY_FILE_ERROR_INVALID_VALUE,
+                            _("value cannot be interpreted as integer"));
+        return FALSE;
+    }
+
+    *out_val = u64;
+    return TRUE;
+}
+
+static gboolean
+_read_direct_int64(KeyfileReaderInfo *info,
+                   const char        *setting_name,
+                   const char        *key,
+                   gint64             min,
+                   gint64             max,
+                   gint64            *out_val,
+                   GError           **error)
+{
+    gs_free char *tmp_str = NULL;
+    gint64        i64;
+    gint64        fallback;
+
+    tmp_str = nm_keyfile_plugin_kf_get_value(info->keyfile, setting_name, key, error);
+    if (!tmp_str)
+        return FALSE;
+
+    fallback = (max == G_MAXINT64) ? G_MAXINT64 : G_MININT64;
+    i64      = _nm_utils_ascii_str_to_int64(tmp_str, 0, min, max, fallback);
+    if (i64 == fallback && errno != 0) {
+        g_set_error_literal(error,
+                            G_KEY_FILE_ERROR,
+                            G_KEY_FILE_ERROR_INVALID_VALUE,
+                            _("value cannot be interpreted as integer"));
+        return FALSE;
+    }
+
+    *out_val = i64;
+    return TRUE;
+}
+
+static void
+read_one_setting_value_direct(KeyfileReaderInfo        *info,
+                              const NMMetaSettingInfo  *setting_info,
+                              const NMSettInfoSetting  *sett_info,
+                              NMSetting                *setting,
+                              const NMSettInfoProperty *property_info,
+                              ReadPropKind              kind,
+                              GError                  **error)
+{
+    const char *setting_name = setting_info->setting_name;
+    const char *key          = property_info->name;
+    guint64     u64;
+    gint64      i64;
+
+    switch (kind) {
+    case READ_PROP_KIND_DIRECT_BOOL:
+    {
+        gboolean v;
+
+        v = nm_keyfile_plugin_kf_get_boolean(info->keyfile, setting_name, key, error);
+        if (*error)
+            return;
+        _nm_setting_property_set_direct_int(setting, sett_info, property_info, v, error);
+        return;
+    }
+    case READ_PROP_KIND_DIRECT_INT32:
+        if (_read_direct_int64(info, setting_name, key, G_MININT, G_MAXINT, &i64, error))
+            _nm_setting_property_set_direct_int(setting, sett_info, property_info, i64, error);
+        return;
+    case READ_PROP_KIND_DIRECT_INT64:
+        if (_read_direct_int64(info, setting_name, key, G_MININT64, G_MAXINT64, &i64, error))
+            _nm_setting_property_set_direct_int(setting, sett_info, property_info, i64, error);
+        return;
+    case READ_PROP_KIND_DIRECT_UINT32:
+        if (_read_direct_uint64(info, setting_name, key, G_MAXUINT, &u64, error))
+            _nm_setting_property_set_direct_uint(setting, sett_info, property_info, u64, error);
+        return;
+    case READ_PROP_KIND_DIRECT_UINT64:
+        if (_read_direct_uint64(info, setting_name, key, G_MAXUINT64, &u64, error))
+            _nm_setting_property_set_direct_uint(setting, sett_info, property_info, u64, error);
+        return;
+    case READ_PROP_KIND_DIRECT_STRING:
+    {
+        gs_free char *str_val = NULL;
+
+        str_val = nm_keyfile_plugin_kf_get_string(info->keyfile, setting_name, key, error);
+        if (!*error)
+            _nm_setting_property_set_direct_string(setting, sett_info, property_info, str_val);
+        return;
+    }
+    case READ_PROP_KIND_DIRECT_STRV:
+    {
+        gs_strfreev char **sa = NULL;
+        gsize              length;
+
+        sa = nm_keyfile_plugin_kf_get_string_list(info->keyfile, setting_name, key, &length, NULL);
+        _nm_setting_property_set_direct_strv(setting,
+                                             sett_info,
+                                             property_info,
+                                             (const char *const *) sa);
+        return;
+    }
+    default:
+        nm_assert_not_reached();
+        return;
+    }
+}
+
+static void
+read_one_setting_value(KeyfileReaderInfo        *info,
+                       const NMMetaSettingInfo  *setting_info,
+                       const NMSettInfoSetting  *sett_info,
+                       NMSetting                *setting,
+                       const NMSettInfoProperty *property_info,
+                       const ReadPropInfo       *rpi)
+{
+    GKeyFile                *keyfile = info->keyfile;
+    gs_free_error GError    *err     = NULL;
+    const ParseInfoProperty *pip     = rpi->pip;
+    gs_free char            *tmp_str = NULL;
+    const char              *key;
+    GType                    type;
+    guint64                  u64;
+    gint64                   i64;
+
+    nm_assert(!info->error);
+    nm_assert(setting_info);
+
+    key = property_info->name;
+
+    switch (rpi->kind) {
+    case READ_PROP_KIND_SKIP:
+        return;
+    case READ_PROP_KIND_PARSER_FULL:
+        pip->parser_full(info, setting_info, property_info, pip, setting);
+        return;
+    default:
+        break;
+    }
+
     nm_assert(property_info->param_spec);
     nm_assert((property_info->param_spec->flags & (G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY))
               == G_PARAM_WRITABLE);
@@ -3359,7 +3633,7 @@ read_one_setting_value(KeyfileReaderInfo        *info,
      * like IP addresses and routes where more than one value is actually
      * encoded by the setting property, this won't be true.
      */
-    if ((!pip || !pip->parser_no_check_key)
+    if (rpi->check_key
         && !nm_keyfile_plugin_kf_has_key(keyfile, setting_info->setting_name, key, &err)) {
         /* Key doesn't exist or an error occurred, thus nothing to do. */
         if (err) {
@@ -3374,14 +3648,22 @@ read_one_setting_value(KeyfileReaderInfo        *info,
         return;
     }
 
-    if (pip && pip->parser) {
+    if (rpi->kind == READ_PROP_KIND_PARSER) {
         pip->parser(info, setting, key);
         return;
     }
 
     type = G_PARAM_SPEC_VALUE_TYPE(property_info->param_spec);
 
-    if (type == G_TYPE_STRING) {
+    if (rpi->kind != READ_PROP_KIND_GOBJECT) {
+        read_one_setting_value_direct(info,
+                                      setting_info,
+                                      sett_info,
+                                      setting,
+                                      property_info,
+                                      rpi->kind,
+                                      &err);
+    } else if (type == G_TYPE_STRING) {
         gs_free char *str_val = NULL;
 
         str_val = nm_keyfile_plugin_kf_get_string(keyfile, setting_info->setting_name, key, &err);
@@ -3552,6 +3834,8 @@ static void
 _read_setting(KeyfileReaderInfo *info)
 {
     const NMSettInfoSetting   *sett_info;
+    const NMMetaSettingInfo   *setting_info;
+    const ReadPropInfo        *rpis;
     gs_unref_object NMSetting *setting = NULL;
     const char                *alias;
     GType                      type;
@@ -3666,8 +3950,16 @@ _read_setting(KeyfileReaderInfo *info)
         }
     }
 
+    setting_info = NM_SETTING_GET_CLASS(setting)->setting_info;
+    rpis         = _read_prop_infos_get(setting_info, sett_info);
+
     for (i = 0; i < sett_info->property_infos_len; i++) {
-        read_one_setting_value(info, setting, &sett_info->property_infos[i]);
+        read_one_setting_value(info,
+                               setting_info,
+                               sett_info,
+                               setting,
+                               &sett_info->property_infos[i],
+                               &rpis[i]);
         if (info->error)
             goto out;
     }
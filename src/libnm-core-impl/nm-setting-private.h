@@ -379,6 +379,28 @@ void _nm_setting_property_set_property_direct(GObject      *object,
                                               const GValue *value,
                                               GParamSpec   *pspec);
 
+gboolean _nm_setting_property_set_direct_int(NMSetting                *setting,
+                                             const NMSettInfoSetting  *sett_info,
+                                             const NMSettInfoProperty *property_info,
+                                             gint64                    value,
+                                             GError                  **error);
+
+gboolean _nm_setting_property_set_direct_uint(NMSetting                *setting,
+                                              const NMSettInfoSetting  *sett_info,
+                                              const NMSettInfoProperty *property_info,
+                                              guint64                   value,
+                                              GError                  **error);
+
+void _nm_setting_property_set_direct_string(NMSetting                *setting,
+                                            const NMSettInfoSetting  *sett_info,
+                                            const NMSettInfoProperty *property_info,
+                                            const char               *value);
+
+void _nm_setting_property_set_direct_strv(NMSetting                *setting,
+                                          const NMSettInfoSetting  *sett_info,
+                                          const NMSettInfoProperty *property_info,
+                                          const char *const        *value);
+
 GVariant *_nm_setting_property_to_dbus_fcn_ignore(_NM_SETT_INFO_PROP_TO_DBUS_FCN_ARGS _nm_nil);
 
 GVariant *_nm_setting_property_to_dbus_fcn_gprop(_NM_SETT_INFO_PROP_TO_DBUS_FCN_ARGS _nm_nil);
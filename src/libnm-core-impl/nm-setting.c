@@ -1014,6 +1014,187 @@ out_fail:
 
 /*****************************************************************************/
 
+/* The following setters are for parsers (like the keyfile reader) that
+ * want to set a "direct" property without going through GObject property
+ * lookup and GValue boxing. They validate the value against the GParamSpec
+ * and notify, exactly like _nm_setting_property_set_property_direct(). */
+
+static gboolean
+_property_direct_set_out_of_range(const NMSettInfoProperty *property_info,
+                                  const char               *value_str,
+                                  GError                  **error)
+{
+    const char *type_name = g_type_name(property_info->param_spec->value_type);
+
+    g_set_error(error,
+                NM_UTILS_ERROR,
+                NM_UTILS_ERROR_UNKNOWN,
+                _("value \"%s\" of type '%s' is invalid or out of range for property '%s' of "
+                  "type '%s'"),
+                value_str,
+                type_name,
+                property_info->param_spec->name,
+                type_name);
+    return FALSE;
+}
+
+static void
+_property_direct_notify(NMSetting *setting, const NMSettInfoProperty *property_info)
+{
+    nm_assert(NM_FLAGS_HAS(property_info->param_spec->flags, G_PARAM_EXPLICIT_NOTIFY));
+
+    nm_gobject_notify_together_by_pspec(setting,
+                                        property_info->param_spec,
+                                        property_info->direct_also_notify);
+}
+
+gboolean
+_nm_setting_property_set_direct_int(NMSetting                *setting,
+                                    const NMSettInfoSetting  *sett_info,
+                                    const NMSettInfoProperty *property_info,
+                                    gint64                    value,
+                                    GError                  **error)
+{
+    char sbuf[64];
+
+    nm_assert(property_info->param_spec);
+
+    switch (property_info->property_type->direct_type) {
+    case NM_VALUE_TYPE_BOOL:
+    {
+        bool *p_val = _nm_setting_get_private_field(setting, sett_info, property_info);
+
+        value = !!value;
+        if (*p_val == value)
+            return TRUE;
+        *p_val = value;
+        break;
+    }
+    case NM_VALUE_TYPE_INT32:
+    {
+        const GParamSpecInt *param_spec;
+        gint32              *p_val;
+
+        param_spec = NM_G_PARAM_SPEC_CAST_INT(property_info->param_spec);
+        p_val      = _nm_setting_get_private_field(setting, sett_info, property_info);
+
+        if (value < param_spec->minimum || value > param_spec->maximum)
+            goto out_of_range;
+        if (*p_val == value)
+            return TRUE;
+        *p_val = value;
+        break;
+    }
+    case NM_VALUE_TYPE_INT64:
+    {
+        const GParamSpecInt64 *param_spec;
+        gint64                *p_val;
+
+        param_spec = NM_G_PARAM_SPEC_CAST_INT64(property_info->param_spec);
+        p_val      = _nm_setting_get_private_field(setting, sett_info, property_info);
+
+        if (value < param_spec->minimum || value > param_spec->maximum)
+            goto out_of_range;
+        if (*p_val == value)
+            return TRUE;
+        *p_val = value;
+        break;
+    }
+    default:
+        return nm_assert_unreachable_val(FALSE);
+    }
+
+    _property_direct_notify(setting, property_info);
+    return TRUE;
+
+out_of_range:
+    return _property_direct_set_out_of_range(property_info,
+                                             nm_sprintf_buf(sbuf, "%" G_GINT64_FORMAT, value),
+                                             error);
+}
+
+gboolean
+_nm_setting_property_set_direct_uint(NMSetting                *setting,
+                                     const NMSettInfoSetting  *sett_info,
+                                     const NMSettInfoProperty *property_info,
+                                     guint64                   value,
+                                     GError                  **error)
+{
+    char sbuf[64];
+
+    nm_assert(property_info->param_spec);
+
+    switch (property_info->property_type->direct_type) {
+    case NM_VALUE_TYPE_UINT32:
+    {
+        const GParamSpecUInt *param_spec;
+        guint32              *p_val;
+
+        param_spec = NM_G_PARAM_SPEC_CAST_UINT(property_info->param_spec);
+        p_val      = _nm_setting_get_private_field(setting, sett_info, property_info);
+
+        if (value < param_spec->minimum || value > param_spec->maximum)
+            goto out_of_range;
+        if (*p_val == value)
+            return TRUE;
+        *p_val = value;
+        break;
+    }
+    case NM_VALUE_TYPE_UINT64:
+    {
+        const GParamSpecUInt64 *param_spec;
+        guint64                *p_val;
+
+        param_spec = NM_G_PARAM_SPEC_CAST_UINT64(property_info->param_spec);
+        p_val      = _nm_setting_get_private_field(setting, sett_info, property_info);
+
+        if (value < param_spec->minimum || value > param_spec->maximum)
+            goto out_of_range;
+        if (*p_val == value)
+            return TRUE;
+        *p_val = value;
+        break;
+    }
+    default:
+        return nm_assert_unreachable_val(FALSE);
+    }
+
+    _property_direct_notify(setting, property_info);
+    return TRUE;
+
+out_of_range:
+    return _property_direct_set_out_of_range(property_info,
+                                             nm_sprintf_buf(sbuf, "%" G_GUINT64_FORMAT, value),
+                                             error);
+}
+
+void
+_nm_setting_property_set_direct_string(NMSetting                *setting,
+                                       const NMSettInfoSetting  *sett_info,
+                                       const NMSettInfoProperty *property_info,
+                                       const char               *value)
+{
+    nm_assert(property_info->param_spec);
+
+    if (_property_direct_set_string(sett_info, property_info, setting, value))
+        _property_direct_notify(setting, property_info);
+}
+
+void
+_nm_setting_property_set_direct_strv(NMSetting                *setting,
+                                     const NMSettInfoSetting  *sett_info,
+                                     const NMSettInfoProperty *property_info,
+                                     const char *const        *value)
+{
+    nm_assert(property_info->param_spec);
+    nm_assert(property_info->property_type->direct_type == NM_VALUE_TYPE_STRV);
+
+    if (_property_direct_set_strv(sett_info, property_info, setting, value))
+        _property_direct_notify(setting, property_info);
+}
+
+/*****************************************************************************/
+
 static void
 _init_direct(NMSetting *setting)
 {
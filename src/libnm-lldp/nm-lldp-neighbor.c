@@ -832,6 +832,9 @@ nm_lldp_neighbor_unlink(NMLldpNeighbor *n)
         }
     }
 
+    if (g_hash_table_lookup(n->lldp_rx->neighbor_by_raw, n) == n)
+        g_hash_table_remove(n->lldp_rx->neighbor_by_raw, n);
+
     nm_prioq_remove(&n->lldp_rx->neighbor_by_expiry, n, &n->prioq_idx);
 
     n->lldp_rx = NULL;
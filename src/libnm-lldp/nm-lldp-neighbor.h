@@ -24,6 +24,9 @@ struct _NMLldpNeighbor {
     /* The raw packet size. The data is appended to the object, accessible via LLDP_NEIGHBOR_RAW() */
     size_t raw_size;
 
+    /* Hash of the raw packet, for finding an unchanged neighbor before parsing. */
+    guint raw_hash;
+
     /* The current read index for the iterative TLV interface */
     size_t rindex;
 
@@ -9,7 +9,7 @@
 #include <netinet/if_ether.h>
 
 int
-nm_lldp_network_bind_raw_socket(int ifindex)
+nm_lldp_network_open_raw_socket(void)
 {
     static const struct sock_filter filter[] = {
         BPF_STMT(BPF_LD + BPF_W + BPF_ABS,
@@ -32,40 +32,74 @@ nm_lldp_network_bind_raw_socket(int ifindex)
         .len    = G_N_ELEMENTS(filter),
         .filter = (struct sock_filter *) filter,
     };
+    nm_auto_close int fd = -1;
+
+    fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, htobe16(NM_ETHERTYPE_LLDP));
+    if (fd < 0)
+        return -errno;
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0)
+        return -errno;
+
+    return nm_steal_fd(&fd);
+}
+
+int
+nm_lldp_network_set_membership(int fd, int ifindex, gboolean add)
+{
+    static const guint8 addr_last[] = {
+        0x00, /* customer bridge */
+        0x03, /* non TPMR bridge */
+        0x0E, /* nearest bridge */
+    };
     struct packet_mreq mreq = {
         .mr_ifindex = ifindex,
         .mr_type    = PACKET_MR_MULTICAST,
         .mr_alen    = ETH_ALEN,
         .mr_address = {0x01, 0x80, 0xC2, 0x00, 0x00, 0x00},
     };
+    int r = 0;
+    int i;
+
+    assert(fd >= 0);
+    assert(ifindex > 0);
+
+    for (i = 0; i < (int) G_N_ELEMENTS(addr_last); i++) {
+        mreq.mr_address[ETH_ALEN - 1] = addr_last[i];
+        if (setsockopt(fd,
+                       SOL_PACKET,
+                       add ? PACKET_ADD_MEMBERSHIP : PACKET_DROP_MEMBERSHIP,
+                       &mreq,
+                       sizeof(mreq))
+            < 0) {
+            if (add)
+                return -errno;
+            r = -errno;
+        }
+    }
+
+    return r;
+}
+
+int
+nm_lldp_network_bind_raw_socket(int ifindex)
+{
     struct sockaddr_ll saddrll = {
         .sll_family  = AF_PACKET,
         .sll_ifindex = ifindex,
     };
     nm_auto_close int fd = -1;
+    int               r;
 
     assert(ifindex > 0);
 
-    fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, htobe16(NM_ETHERTYPE_LLDP));
+    fd = nm_lldp_network_open_raw_socket();
     if (fd < 0)
-        return -errno;
+        return fd;
 
-    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0)
-        return -errno;
-
-    /* customer bridge */
-    if (setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
-        return -errno;
-
-    /* non TPMR bridge */
-    mreq.mr_address[ETH_ALEN - 1] = 0x03;
-    if (setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
-        return -errno;
-
-    /* nearest bridge */
-    mreq.mr_address[ETH_ALEN - 1] = 0x0E;
-    if (setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
-        return -errno;
+    r = nm_lldp_network_set_membership(fd, ifindex, TRUE);
+    if (r < 0)
+        return r;
 
     if (bind(fd, (const struct sockaddr *) &saddrll, sizeof(saddrll)) < 0)
         return -errno;
@@ -4,6 +4,8 @@
 
 #define NM_ETHERTYPE_LLDP 0x88cc
 
+int nm_lldp_network_open_raw_socket(void);
+int nm_lldp_network_set_membership(int fd, int ifindex, gboolean add);
 int nm_lldp_network_bind_raw_socket(int ifindex);
 
 #endif /* __NM_LLDP_NETWORK_H__ */
@@ -21,7 +21,14 @@ struct _NMLldpRX {
     GSource *timer_event_source;
 
     GHashTable *neighbor_by_id;
+    GHashTable *neighbor_by_raw;
     NMPrioq     neighbor_by_expiry;
+
+    /* If set, the instance receives via the socket shared by all instances. */
+    struct _NMLldpRXSocket *socket;
+
+    /* How many received frames were parsed. Unchanged frames are not. */
+    guint parsed_num;
 };
 
 /*****************************************************************************/
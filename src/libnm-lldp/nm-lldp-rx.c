@@ -5,6 +5,7 @@
 #include "nm-lldp-rx.h"
 
 #include <arpa/inet.h>
+#include <linux/if_packet.h>
 #include <linux/sockios.h>
 #include <sys/ioctl.h>
 
@@ -15,6 +16,26 @@
 #include "nm-lldp-rx-internal.h"
 
 #define LLDP_DEFAULT_NEIGHBORS_MAX 128U
+#define LLDP_DEFAULT_RAW_SIZE_MAX  9216U
+
+/* How many frames to read from the shared socket in one go. */
+#define LLDP_SOCKET_RECV_BURST 32
+
+/*****************************************************************************/
+
+/* Instances of the same GMainContext share one packet socket, which is not
+ * bound to an interface. It joins the LLDP multicast groups on the interfaces
+ * of the instances, and frames get dispatched by their incoming ifindex. An
+ * instance that cannot use the shared socket falls back to its own socket. */
+typedef struct _NMLldpRXSocket {
+    int           ref_count;
+    int           fd;
+    GMainContext *main_context;
+    GSource      *io_event_source;
+    GHashTable   *lldp_rx_by_ifindex;
+} NMLldpRXSocket;
+
+static NMLldpRXSocket *_lldp_rx_socket;
 
 /*****************************************************************************/
 
@@ -178,6 +199,8 @@ lldp_rx_add_neighbor(NMLldpRX *lldp_rx, NMLldpNeighbor *n)
 
     if (!g_hash_table_add(lldp_rx->neighbor_by_id, n))
         nm_assert_not_reached();
+    if (!g_hash_table_add(lldp_rx->neighbor_by_raw, n))
+        nm_assert_not_reached();
 
     nm_prioq_put(&lldp_rx->neighbor_by_expiry, n, &n->prioq_idx);
 
@@ -187,6 +210,63 @@ lldp_rx_add_neighbor(NMLldpRX *lldp_rx, NMLldpNeighbor *n)
     lldp_rx_callback(lldp_rx, old ? NM_LLDP_RX_EVENT_UPDATED : NM_LLDP_RX_EVENT_ADDED, n);
 }
 
+static void
+lldp_rx_process_datagram(NMLldpRX *lldp_rx, int fd, NMLldpNeighbor *n)
+{
+    struct timespec ts;
+    gint64          ts_usec;
+    gint64          now_usec;
+    gint64          now_usec_rt;
+    gint64          now_usec_bt;
+    NMLldpNeighbor *old;
+    int             r;
+
+    /* Try to get the timestamp of this packet if it is known */
+    if (ioctl(fd, SIOCGSTAMPNS, &ts) >= 0
+        && (ts_usec = nm_utils_timespec_to_usec(&ts)) < G_MAXINT64
+        && (now_usec_bt = nm_utils_clock_gettime_usec(CLOCK_BOOTTIME)) >= 0
+        && (now_usec_rt = nm_utils_clock_gettime_usec(CLOCK_REALTIME)) >= 0) {
+        gint64 t;
+
+        now_usec = nm_utils_monotonic_timestamp_from_boottime(now_usec_bt, 1000);
+        ts_usec  = nm_time_map_clock(ts_usec, now_usec_rt, now_usec_bt);
+
+        t = now_usec;
+        if (ts_usec >= 0) {
+            ts_usec = nm_utils_monotonic_timestamp_from_boottime(ts_usec, 1000);
+            if (ts_usec > NM_UTILS_USEC_PER_SEC && ts_usec < now_usec)
+                t = ts_usec;
+        }
+
+        n->timestamp_usec = t;
+    } else
+        n->timestamp_usec = nm_utils_get_monotonic_timestamp_usec();
+
+    /* Neighbors usually re-send the very same frame. In that case, only
+     * restart the TTL counter without parsing the frame again. */
+    n->raw_hash = nm_hash_mem(1217446843u, NM_LLDP_NEIGHBOR_RAW(n), n->raw_size);
+    old         = g_hash_table_lookup(lldp_rx->neighbor_by_raw, n);
+    if (old) {
+        nm_auto(nm_lldp_neighbor_unrefp) NMLldpNeighbor *old_alive = nm_lldp_neighbor_ref(old);
+
+        _LOG2T(lldp_rx, "Received unchanged LLDP datagram.");
+        old->timestamp_usec = n->timestamp_usec;
+        lldp_rx_start_timer(lldp_rx, old);
+        lldp_rx_callback(lldp_rx, NM_LLDP_RX_EVENT_REFRESHED, old);
+        return;
+    }
+
+    lldp_rx->parsed_num++;
+    r = nm_lldp_neighbor_parse(n);
+    if (r < 0) {
+        _LOG2D(lldp_rx, "Failure parsing invalid LLDP datagram.");
+        return;
+    }
+
+    _LOG2D(lldp_rx, "Successfully processed LLDP datagram.");
+    lldp_rx_add_neighbor(lldp_rx, n);
+}
+
 static gboolean
 lldp_rx_receive_datagram(int fd, GIOCondition condition, gpointer user_data)
 
@@ -195,12 +275,6 @@ lldp_rx_receive_datagram(int fd, GIOCondition condition, gpointer user_data)
     nm_auto(nm_lldp_neighbor_unrefp) NMLldpNeighbor *n       = NULL;
     ssize_t                                          space;
     ssize_t                                          length;
-    struct timespec                                  ts;
-    gint64                                           ts_usec;
-    gint64                                           now_usec;
-    gint64                                           now_usec_rt;
-    gint64                                           now_usec_bt;
-    int                                              r;
 
     nm_assert_is_lldp_rx(lldp_rx);
     nm_assert(lldp_rx->fd == fd);
@@ -217,6 +291,12 @@ lldp_rx_receive_datagram(int fd, GIOCondition condition, gpointer user_data)
         return G_SOURCE_CONTINUE;
     }
 
+    if ((size_t) space > lldp_rx->config.raw_size_max) {
+        _LOG2D(lldp_rx, "Packet too large (%zd bytes), ignoring", space);
+        (void) recv(lldp_rx->fd, NULL, 0, MSG_DONTWAIT);
+        return G_SOURCE_CONTINUE;
+    }
+
     n = nm_lldp_neighbor_new(space);
 
     length = recv(lldp_rx->fd, NM_LLDP_NEIGHBOR_RAW(n), n->raw_size, MSG_DONTWAIT);
@@ -234,49 +314,176 @@ lldp_rx_receive_datagram(int fd, GIOCondition condition, gpointer user_data)
         return G_SOURCE_CONTINUE;
     }
 
-    /* Try to get the timestamp of this packet if it is known */
-    if (ioctl(lldp_rx->fd, SIOCGSTAMPNS, &ts) >= 0
-        && (ts_usec = nm_utils_timespec_to_usec(&ts)) < G_MAXINT64
-        && (now_usec_bt = nm_utils_clock_gettime_usec(CLOCK_BOOTTIME)) >= 0
-        && (now_usec_rt = nm_utils_clock_gettime_usec(CLOCK_REALTIME)) >= 0) {
-        gint64 t;
+    lldp_rx_process_datagram(lldp_rx, lldp_rx->fd, n);
 
-        now_usec = nm_utils_monotonic_timestamp_from_boottime(now_usec_bt, 1000);
-        ts_usec  = nm_time_map_clock(ts_usec, now_usec_rt, now_usec_bt);
+    return G_SOURCE_CONTINUE;
+}
 
-        t = now_usec;
-        if (ts_usec >= 0) {
-            ts_usec = nm_utils_monotonic_timestamp_from_boottime(ts_usec, 1000);
-            if (ts_usec > NM_UTILS_USEC_PER_SEC && ts_usec < now_usec)
-                t = ts_usec;
+/*****************************************************************************/
+
+static void
+lldp_rx_socket_unref(NMLldpRXSocket *lldp_socket)
+{
+    nm_assert(lldp_socket);
+    nm_assert(lldp_socket->ref_count > 0);
+
+    if (--lldp_socket->ref_count > 0)
+        return;
+
+    nm_assert(g_hash_table_size(lldp_socket->lldp_rx_by_ifindex) == 0);
+
+    if (_lldp_rx_socket == lldp_socket)
+        _lldp_rx_socket = NULL;
+
+    nm_clear_g_source_inst(&lldp_socket->io_event_source);
+    nm_clear_fd(&lldp_socket->fd);
+    g_hash_table_unref(lldp_socket->lldp_rx_by_ifindex);
+    g_main_context_unref(lldp_socket->main_context);
+    nm_g_slice_free(lldp_socket);
+}
+
+static gboolean
+lldp_rx_socket_receive(int fd, GIOCondition condition, gpointer user_data)
+{
+    NMLldpRXSocket *lldp_socket = user_data;
+    guint           i;
+
+    /* Keep the socket alive, while the callbacks run. */
+    lldp_socket->ref_count++;
+
+    for (i = 0; i < LLDP_SOCKET_RECV_BURST && lldp_socket->fd >= 0; i++) {
+        nm_auto(nm_lldp_neighbor_unrefp) NMLldpNeighbor *n       = NULL;
+        nm_auto(nm_lldp_rx_unrefp) NMLldpRX             *lldp_rx = NULL;
+        struct sockaddr_ll                               sll;
+        socklen_t                                        sll_len = sizeof(sll);
+        ssize_t                                          space;
+        ssize_t                                          length;
+
+        space = nm_fd_next_datagram_size(fd);
+        if (space < 0)
+            break;
+
+        n = nm_lldp_neighbor_new(NM_MIN((size_t) space, (size_t) LLDP_DEFAULT_RAW_SIZE_MAX));
+
+        length = recvfrom(fd,
+                          NM_LLDP_NEIGHBOR_RAW(n),
+                          n->raw_size,
+                          MSG_DONTWAIT,
+                          (struct sockaddr *) &sll,
+                          &sll_len);
+        if (length < 0)
+            break;
+
+        lldp_rx = nm_lldp_rx_ref(
+            g_hash_table_lookup(lldp_socket->lldp_rx_by_ifindex, GINT_TO_POINTER(sll.sll_ifindex)));
+        if (!lldp_rx) {
+            /* LLDP is not enabled on this interface. */
+            continue;
         }
 
-        n->timestamp_usec = t;
-    } else
-        n->timestamp_usec = nm_utils_get_monotonic_timestamp_usec();
+        _LOG2T(lldp_rx, "shared fd ready");
 
-    r = nm_lldp_neighbor_parse(n);
+        if ((size_t) space > lldp_rx->config.raw_size_max) {
+            _LOG2D(lldp_rx, "Packet too large (%zd bytes), ignoring", space);
+            continue;
+        }
+
+        if ((size_t) length != (size_t) space) {
+            _LOG2D(lldp_rx, "Packet size mismatch, ignoring");
+            continue;
+        }
+
+        lldp_rx_process_datagram(lldp_rx, fd, n);
+    }
+
+    lldp_rx_socket_unref(lldp_socket);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+lldp_rx_socket_attach(NMLldpRX *lldp_rx)
+{
+    NMLldpRXSocket *lldp_socket = _lldp_rx_socket;
+    int             r;
+
+    nm_assert(!lldp_rx->socket);
+
+    if (lldp_socket) {
+        if (lldp_socket->main_context != lldp_rx->main_context)
+            return FALSE;
+        if (g_hash_table_contains(lldp_socket->lldp_rx_by_ifindex,
+                                  GINT_TO_POINTER(lldp_rx->config.ifindex)))
+            return FALSE;
+        lldp_socket->ref_count++;
+    } else {
+        r = nm_lldp_network_open_raw_socket();
+        if (r < 0) {
+            _LOG2D(lldp_rx, "failed to open shared socket (%s)", nm_strerror_native(-r));
+            return FALSE;
+        }
+
+        lldp_socket  = g_slice_new(NMLldpRXSocket);
+        *lldp_socket = (NMLldpRXSocket){
+            .ref_count          = 1,
+            .fd                 = r,
+            .main_context       = g_main_context_ref(lldp_rx->main_context),
+            .lldp_rx_by_ifindex = g_hash_table_new(nm_direct_hash, NULL),
+        };
+        lldp_socket->io_event_source =
+            nm_g_source_attach(nm_g_unix_fd_source_new(lldp_socket->fd,
+                                                       G_IO_IN,
+                                                       G_PRIORITY_DEFAULT,
+                                                       lldp_rx_socket_receive,
+                                                       lldp_socket,
+                                                       NULL),
+                               lldp_socket->main_context);
+        _lldp_rx_socket = lldp_socket;
+    }
+
+    r = nm_lldp_network_set_membership(lldp_socket->fd, lldp_rx->config.ifindex, TRUE);
     if (r < 0) {
-        _LOG2D(lldp_rx, "Failure parsing invalid LLDP datagram.");
-        return G_SOURCE_CONTINUE;
+        _LOG2D(lldp_rx, "failed to join multicast groups (%s)", nm_strerror_native(-r));
+        nm_lldp_network_set_membership(lldp_socket->fd, lldp_rx->config.ifindex, FALSE);
+        lldp_rx_socket_unref(lldp_socket);
+        return FALSE;
     }
 
-    _LOG2D(lldp_rx, "Successfully processed LLDP datagram.");
-    lldp_rx_add_neighbor(lldp_rx, n);
+    g_hash_table_insert(lldp_socket->lldp_rx_by_ifindex,
+                        GINT_TO_POINTER(lldp_rx->config.ifindex),
+                        lldp_rx);
+    lldp_rx->socket = lldp_socket;
+    return TRUE;
+}
 
-    return G_SOURCE_CONTINUE;
+static void
+lldp_rx_socket_detach(NMLldpRX *lldp_rx)
+{
+    NMLldpRXSocket *lldp_socket = g_steal_pointer(&lldp_rx->socket);
+
+    if (!lldp_socket)
+        return;
+
+    nm_lldp_network_set_membership(lldp_socket->fd, lldp_rx->config.ifindex, FALSE);
+    if (!g_hash_table_remove(lldp_socket->lldp_rx_by_ifindex,
+                             GINT_TO_POINTER(lldp_rx->config.ifindex)))
+        nm_assert_not_reached();
+    lldp_rx_socket_unref(lldp_socket);
 }
 
+/*****************************************************************************/
+
 static void
 lldp_rx_reset(NMLldpRX *lldp_rx)
 {
     nm_clear_g_source_inst(&lldp_rx->timer_event_source);
     nm_clear_g_source_inst(&lldp_rx->io_event_source);
     nm_clear_fd(&lldp_rx->fd);
+    lldp_rx_socket_detach(lldp_rx);
 
     lldp_rx_make_space(lldp_rx, TRUE, 0);
 
     nm_assert(g_hash_table_size(lldp_rx->neighbor_by_id) == 0);
+    nm_assert(g_hash_table_size(lldp_rx->neighbor_by_raw) == 0);
     nm_assert(nm_prioq_size(&lldp_rx->neighbor_by_expiry) == 0);
 }
 
@@ -286,7 +493,7 @@ nm_lldp_rx_is_running(NMLldpRX *lldp_rx)
     if (!lldp_rx)
         return FALSE;
 
-    return lldp_rx->fd >= 0;
+    return lldp_rx->fd >= 0 || lldp_rx->socket;
 }
 
 int
@@ -303,6 +510,11 @@ nm_lldp_rx_start(NMLldpRX *lldp_rx)
 
     nm_assert(!lldp_rx->io_event_source);
 
+    if (lldp_rx_socket_attach(lldp_rx)) {
+        _LOG2D(lldp_rx, "started (shared fd %d)", lldp_rx->socket->fd);
+        return 1;
+    }
+
     r = nm_lldp_network_bind_raw_socket(lldp_rx->config.ifindex);
     if (r < 0) {
         _LOG2D(lldp_rx, "start failed to bind socket (%s)", nm_strerror_native(-r));
@@ -387,6 +599,18 @@ neighbor_compare_func(gconstpointer p_a, gconstpointer p_b, gpointer user_data)
     return nm_lldp_neighbor_id_cmp(&(*a)->id, &(*b)->id);
 }
 
+static guint
+neighbor_raw_hash(const NMLldpNeighbor *n)
+{
+    return n->raw_hash;
+}
+
+static gboolean
+neighbor_raw_equal(const NMLldpNeighbor *a, const NMLldpNeighbor *b)
+{
+    return nm_lldp_neighbor_equal(a, b);
+}
+
 NMLldpNeighbor **
 nm_lldp_rx_get_neighbors(NMLldpRX *lldp_rx, guint *out_len)
 {
@@ -396,6 +620,14 @@ nm_lldp_rx_get_neighbors(NMLldpRX *lldp_rx, guint *out_len)
         nm_utils_hash_keys_to_array(lldp_rx->neighbor_by_id, neighbor_compare_func, NULL, out_len);
 }
 
+guint
+nmtst_lldp_rx_get_parsed_num(NMLldpRX *lldp_rx)
+{
+    g_return_val_if_fail(lldp_rx, 0);
+
+    return lldp_rx->parsed_num;
+}
+
 /*****************************************************************************/
 
 NMLldpRX *
@@ -418,11 +650,16 @@ nm_lldp_rx_new(const NMLldpRXConfig *config)
         .config         = *config,
         .neighbor_by_id = g_hash_table_new((GHashFunc) nm_lldp_neighbor_id_hash,
                                            (GEqualFunc) nm_lldp_neighbor_id_equal),
+        .neighbor_by_raw =
+            g_hash_table_new((GHashFunc) neighbor_raw_hash, (GEqualFunc) neighbor_raw_equal),
     };
     lldp_rx->config.log_ifname = g_strdup(lldp_rx->config.log_ifname);
     lldp_rx->config.log_uuid   = g_strdup(lldp_rx->config.log_uuid);
     if (lldp_rx->config.neighbors_max == 0)
         lldp_rx->config.neighbors_max = LLDP_DEFAULT_NEIGHBORS_MAX;
+    if (lldp_rx->config.raw_size_max == 0
+        || lldp_rx->config.raw_size_max > LLDP_DEFAULT_RAW_SIZE_MAX)
+        lldp_rx->config.raw_size_max = LLDP_DEFAULT_RAW_SIZE_MAX;
     if (!lldp_rx->config.has_capability_mask && lldp_rx->config.capability_mask == 0)
         lldp_rx->config.capability_mask = UINT16_MAX;
 
@@ -458,6 +695,7 @@ nm_lldp_rx_unref(NMLldpRX *lldp_rx)
     lldp_rx_reset(lldp_rx);
 
     g_hash_table_unref(lldp_rx->neighbor_by_id);
+    g_hash_table_unref(lldp_rx->neighbor_by_raw);
     nm_prioq_destroy(&lldp_rx->neighbor_by_expiry);
 
     free((char *) lldp_rx->config.log_ifname);
@@ -39,6 +39,9 @@ typedef void (*NMLldpRXCallback)(NMLldpRX       *lldp_rx,
 typedef struct {
     int              ifindex;
     guint            neighbors_max;
+    /* Frames larger than this are dropped. Together with neighbors_max, this
+     * bounds the memory used per interface. */
+    guint            raw_size_max;
     const char      *log_ifname;
     const char      *log_uuid;
     NMLldpRXCallback callback;
@@ -66,6 +69,8 @@ gboolean nm_lldp_rx_is_running(NMLldpRX *lldp_rx);
 
 NMLldpNeighbor **nm_lldp_rx_get_neighbors(NMLldpRX *lldp_rx, guint *out_len);
 
+guint nmtst_lldp_rx_get_parsed_num(NMLldpRX *lldp_rx);
+
 /*****************************************************************************/
 
 NMLldpNeighbor *nm_lldp_neighbor_new_from_raw(const void *raw, size_t raw_size);
@@ -0,0 +1,1586 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "libnm-glib-aux/nm-default-glib-i18n-prog.h"
+
+#include "nm-dns-stub-server.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "c-list/src/c-list.h"
+#include "libnm-std-aux/unaligned.h"
+#include "libnm-glib-aux/nm-logging-base.h"
+#include "libnm-glib-aux/nm-random-utils.h"
+#include "libnm-glib-aux/nm-time-utils.h"
+
+/*****************************************************************************/
+
+#define _NMLOG(level, ...)                              \
+    G_STMT_START                                        \
+    {                                                   \
+        const NMLogLevel _level = (level);              \
+                                                        \
+        if (_nm_logging_enabled(_level)) {              \
+            _nm_log_simple_printf(_level, __VA_ARGS__); \
+        }                                               \
+    }                                                   \
+    G_STMT_END
+
+/*****************************************************************************/
+
+#define DNS_HEADER_SIZE   12
+#define DNS_NAME_WIRE_MAX 255
+#define DNS_MSG_MAX       65535
+
+/* The size of a UDP message, that any client accepts. */
+#define DNS_UDP_MSG_MAX 512
+
+#define DNS_FLAG_QR        0x8000u
+#define DNS_FLAG_TC        0x0200u
+#define DNS_FLAG_RA        0x0080u
+#define DNS_FLAG_CD        0x0010u
+#define DNS_OPCODE_MASK    0x7800u
+#define DNS_RCODE_MASK     0x000Fu
+#define DNS_RCODE_NOERR    0
+#define DNS_RCODE_FMTERR   1
+#define DNS_RCODE_SRVFAIL  2
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_RCODE_NOTIMP   4
+
+#define DNS_TYPE_OPT 41
+
+/* How long to wait for an upstream before trying the next one. */
+#define PENDING_TIMEOUT_MSEC 2000
+
+/* Upper bound for in-flight queries. Beyond that, new queries fail right away.
+ * Every in-flight query has its own socket, so this also bounds the number
+ * of file descriptors. */
+#define PENDING_MAX 512u
+
+/* Upper bound for client connections on the TCP listener, and how long an
+ * idle one is kept open. */
+#define TCP_CONN_MAX               64u
+#define TCP_CONN_IDLE_TIMEOUT_MSEC 10000
+
+/* Upper bound for replies queued for a slow TCP client. */
+#define TCP_CONN_OUT_MAX (256u * 1024u)
+
+/* Upper bound for how long an answer is cached, regardless of its TTL. */
+#define CACHE_MAX_TTL_SEC 3600u
+
+/* How many datagrams to process per wakeup before yielding to the mainloop. */
+#define RECV_BURST 64
+
+/*****************************************************************************/
+
+typedef struct {
+    /* The lower-cased wire format name of the question, followed by
+     * qtype, qclass and a byte of flags that affect the answer (CD, EDNS, DO). */
+    guint16 len;
+    guint8  data[DNS_NAME_WIRE_MAX + 5];
+} CacheKey;
+
+typedef struct {
+    CacheKey key;
+    CList    lru_lst;
+    gint64   inserted_msec;
+    gint64   expiry_msec;
+    guint16 *ttl_offsets;
+    guint    n_ttl_offsets;
+    guint16  msg_len;
+
+    /* The answer was received over TCP and is too large for UDP clients. */
+    bool tcp_only;
+
+    guint8 msg[];
+} CacheEntry;
+
+typedef struct {
+    char   **domains;
+    char    *ifname;
+    NMIPAddr addr;
+    union {
+        struct sockaddr     sa;
+        struct sockaddr_in  in;
+        struct sockaddr_in6 in6;
+    } sa;
+    socklen_t sa_len;
+    int       addr_family;
+    int       ifindex;
+    guint16   port;
+    bool      is_default;
+    char      addr_str[NM_INET_ADDRSTRLEN + 20];
+} Upstream;
+
+/* A client connection on the TCP listener. The queries are length-prefixed,
+ * and so are the replies in @out. */
+typedef struct {
+    CList            conn_lst;
+    NMDnsStubServer *server;
+    GSource         *source;
+    GSource         *idle_source;
+    GByteArray      *in;
+    GByteArray      *out;
+    gint64           last_active_msec;
+    int              fd;
+    guint            n_pending;
+    GIOCondition     source_condition;
+    bool             read_closed;
+} TcpConn;
+
+/* Where to send the reply to. @conn is NULL for a query received over UDP. */
+typedef struct {
+    struct sockaddr_in sa;
+    TcpConn           *conn;
+} DnsClient;
+
+typedef struct {
+    CList            pending_lst;
+    NMDnsStubServer *server;
+    Upstream        *upstream;
+    GSource         *source;
+    GByteArray      *tcp_in;
+    gint64           expiry_msec;
+    DnsClient        client;
+    CacheKey         key;
+    char             qname[DNS_NAME_WIRE_MAX + 1];
+    guint            attempt;
+    guint            tcp_out_pos;
+    int              fd;
+    guint16          id;
+    guint16          client_id;
+    guint16          question_end;
+    guint16          query_len;
+    bool             cacheable;
+
+    /* Queries from TCP clients are forwarded over TCP. */
+    bool tcp;
+
+    guint8 query[];
+} PendingQuery;
+
+typedef struct {
+    CacheKey key;
+    char     qname[DNS_NAME_WIRE_MAX + 1];
+    gsize    question_end;
+    guint16  id;
+    guint16  flags;
+    bool     cacheable;
+} DnsQuery;
+
+struct _NMDnsStubServer {
+    GSource       *listen_source;
+    GSource       *listen_tcp_source;
+    GSource       *timeout_source;
+    GHashTable    *cache_idx;
+    GPtrArray     *upstreams;
+    CList          cache_lru_lst_head;
+    CList          pending_lst_head;
+    CList          tcp_conn_lst_head;
+    NMDnsStubStats stats;
+    guint          cache_size;
+    guint          n_pending;
+    guint          n_tcp_conns;
+    int            listen_fd;
+    int            listen_tcp_fd;
+    guint16        port;
+
+    /* Large enough for a message with the 2 bytes length prefix of TCP. */
+    guint8 buf[2 + DNS_MSG_MAX];
+};
+
+/*****************************************************************************/
+
+static guint
+_cache_key_hash(gconstpointer ptr)
+{
+    const CacheKey *key = ptr;
+
+    return nm_hash_mem(1847202569u, key->data, key->len);
+}
+
+static gboolean
+_cache_key_equal(gconstpointer a, gconstpointer b)
+{
+    const CacheKey *key_a = a;
+    const CacheKey *key_b = b;
+
+    return key_a->len == key_b->len && memcmp(key_a->data, key_b->data, key_a->len) == 0;
+}
+
+/*****************************************************************************/
+
+static gboolean
+_dns_skip_name(const guint8 *msg, gsize len, gsize *p_pos)
+{
+    gsize pos = *p_pos;
+
+    while (TRUE) {
+        guint8 l;
+
+        if (pos >= len)
+            return FALSE;
+        l = msg[pos];
+        if (l == 0) {
+            pos++;
+            break;
+        }
+        if ((l & 0xC0) == 0xC0) {
+            if (pos + 2 > len)
+                return FALSE;
+            pos += 2;
+            break;
+        }
+        if (l & 0xC0)
+            return FALSE;
+        pos += 1 + l;
+    }
+
+    *p_pos = pos;
+    return TRUE;
+}
+
+/* Walks @n_rr resource records starting at *@p_pos. For every record that is
+ * not an OPT pseudo-record, the offset of the TTL is appended to @ttl_offsets
+ * and the minimal TTL is tracked in @p_min_ttl. For an OPT record, @p_has_edns
+ * and @p_do_bit are set. */
+static gboolean
+_dns_scan_rrs(const guint8 *msg,
+              gsize         len,
+              gsize        *p_pos,
+              guint         n_rr,
+              GArray       *ttl_offsets,
+              guint32      *p_min_ttl,
+              gboolean     *p_has_edns,
+              gboolean     *p_do_bit)
+{
+    gsize pos = *p_pos;
+    guint i;
+
+    for (i = 0; i < n_rr; i++) {
+        guint16 rr_type;
+        guint16 rdlen;
+
+        if (!_dns_skip_name(msg, len, &pos))
+            return FALSE;
+        if (pos + 10 > len)
+            return FALSE;
+
+        rr_type = unaligned_read_be16(&msg[pos]);
+        rdlen   = unaligned_read_be16(&msg[pos + 8]);
+
+        if (rr_type == DNS_TYPE_OPT) {
+            if (p_has_edns)
+                *p_has_edns = TRUE;
+            if (p_do_bit)
+                *p_do_bit = !!(msg[pos + 6] & 0x80);
+        } else {
+            if (ttl_offsets) {
+                guint16 off = pos + 4;
+
+                g_array_append_val(ttl_offsets, off);
+            }
+            if (p_min_ttl)
+                *p_min_ttl = NM_MIN(*p_min_ttl, unaligned_read_be32(&msg[pos + 4]));
+        }
+
+        pos += 10 + rdlen;
+        if (pos > len)
+            return FALSE;
+    }
+
+    *p_pos = pos;
+    return TRUE;
+}
+
+static guint8
+_dns_parse_query(const guint8 *msg, gsize len, DnsQuery *q)
+{
+    gsize    pos      = DNS_HEADER_SIZE;
+    gsize    n_key    = 0;
+    gsize    n_name   = 0;
+    gboolean has_edns = FALSE;
+    gboolean do_bit   = FALSE;
+    guint16  qtype;
+    guint16  qclass;
+
+    q->id    = unaligned_read_be16(&msg[0]);
+    q->flags = unaligned_read_be16(&msg[2]);
+
+    if ((q->flags & DNS_OPCODE_MASK) != 0)
+        return DNS_RCODE_NOTIMP;
+    if (unaligned_read_be16(&msg[4]) != 1)
+        return DNS_RCODE_FMTERR;
+
+    /* The question must not use name compression, as there is nothing before
+     * it that could be referenced. */
+    while (TRUE) {
+        guint8 l;
+        guint8 j;
+
+        if (pos >= len)
+            return DNS_RCODE_FMTERR;
+        l = msg[pos];
+        if (l & 0xC0)
+            return DNS_RCODE_FMTERR;
+        if (n_key + 1 + l > DNS_NAME_WIRE_MAX || pos + 1 + l > len)
+            return DNS_RCODE_FMTERR;
+
+        q->key.data[n_key++] = l;
+        pos++;
+        if (l == 0)
+            break;
+
+        if (n_name > 0)
+            q->qname[n_name++] = '.';
+        for (j = 0; j < l; j++) {
+            guint8 ch = g_ascii_tolower(msg[pos + j]);
+
+            q->key.data[n_key++] = ch;
+            q->qname[n_name++]   = ch;
+        }
+        pos += l;
+    }
+    q->qname[n_name] = '\0';
+
+    if (pos + 4 > len)
+        return DNS_RCODE_FMTERR;
+    qtype  = unaligned_read_be16(&msg[pos]);
+    qclass = unaligned_read_be16(&msg[pos + 2]);
+    pos += 4;
+    q->question_end = pos;
+
+    /* Find out about EDNS, as the answer differs depending on that. If the
+     * rest of the message does not parse, forward it as is, without caching. */
+    q->cacheable = _dns_scan_rrs(msg,
+                                 len,
+                                 &pos,
+                                 (guint) unaligned_read_be16(&msg[6])
+                                     + unaligned_read_be16(&msg[8])
+                                     + unaligned_read_be16(&msg[10]),
+                                 NULL,
+                                 NULL,
+                                 &has_edns,
+                                 &do_bit);
+
+    unaligned_write_be16(&q->key.data[n_key], qtype);
+    unaligned_write_be16(&q->key.data[n_key + 2], qclass);
+    q->key.data[n_key + 4] =
+        (!!(q->flags & DNS_FLAG_CD) << 0) | (!!has_edns << 1) | (!!do_bit << 2);
+    q->key.len = n_key + 5;
+
+    return DNS_RCODE_NOERR;
+}
+
+/*****************************************************************************/
+
+static gboolean _tcp_conn_cb(int fd, GIOCondition condition, gpointer user_data);
+
+static void
+_tcp_conn_update_source(TcpConn *conn)
+{
+    GIOCondition condition = 0;
+
+    if (!conn->read_closed)
+        condition |= G_IO_IN;
+    if (conn->out->len > 0)
+        condition |= G_IO_OUT;
+
+    if (conn->source && condition == conn->source_condition)
+        return;
+
+    nm_clear_g_source_inst(&conn->source);
+    conn->source_condition = condition;
+    if (condition != 0)
+        conn->source = nm_g_unix_fd_add_source(conn->fd, condition, _tcp_conn_cb, conn);
+}
+
+static void
+_tcp_conn_flush(TcpConn *conn)
+{
+    gssize n;
+
+    if (conn->out->len == 0)
+        return;
+
+    n = send(conn->fd, conn->out->data, conn->out->len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0) {
+        int errsv = errno;
+
+        if (NM_IN_SET(errsv, EAGAIN, EINTR))
+            return;
+
+        /* The client is gone. Drop the output. The shutdown lets the
+         * next read see EOF, which closes the connection. */
+        _LOGD("failed to send reply to TCP client: %s", nm_strerror_native(errsv));
+        g_byte_array_set_size(conn->out, 0);
+        shutdown(conn->fd, SHUT_RDWR);
+        return;
+    }
+
+    g_byte_array_remove_range(conn->out, 0, n);
+}
+
+static void
+_tcp_conn_send(TcpConn *conn, const guint8 *msg, gsize len)
+{
+    guint8 len_be[2];
+
+    if (conn->out->len + 2 + len > TCP_CONN_OUT_MAX) {
+        _LOGD("drop reply to TCP client that does not read");
+        return;
+    }
+
+    unaligned_write_be16(len_be, len);
+    g_byte_array_append(conn->out, len_be, 2);
+    g_byte_array_append(conn->out, msg, len);
+    _tcp_conn_flush(conn);
+    _tcp_conn_update_source(conn);
+}
+
+static void
+_tcp_conn_free(TcpConn *conn)
+{
+    nm_assert(conn->n_pending == 0);
+
+    conn->server->n_tcp_conns--;
+    c_list_unlink_stale(&conn->conn_lst);
+    nm_clear_g_source_inst(&conn->source);
+    nm_clear_g_source_inst(&conn->idle_source);
+    g_byte_array_unref(conn->in);
+    g_byte_array_unref(conn->out);
+    nm_close(conn->fd);
+    g_free(conn);
+}
+
+/* Closes @conn if the client is done with it. Must not be called while
+ * @conn is still used further up the stack. */
+static gboolean
+_tcp_conn_check_done(TcpConn *conn)
+{
+    if (!conn->read_closed || conn->n_pending > 0 || conn->out->len > 0)
+        return FALSE;
+
+    _tcp_conn_free(conn);
+    return TRUE;
+}
+
+static void
+_send_to_client(NMDnsStubServer *self, const DnsClient *client, const guint8 *msg, gsize len)
+{
+    if (client->conn) {
+        _tcp_conn_send(client->conn, msg, len);
+        return;
+    }
+
+    if (sendto(self->listen_fd,
+               msg,
+               len,
+               MSG_NOSIGNAL,
+               (const struct sockaddr *) &client->sa,
+               sizeof(client->sa))
+        < 0) {
+        int errsv = errno;
+
+        _LOGD("failed to send reply to client: %s", nm_strerror_native(errsv));
+    }
+}
+
+static void
+_reply_error(NMDnsStubServer *self,
+             const DnsClient *client,
+             const guint8    *query,
+             gsize            question_end,
+             guint8           rcode)
+{
+    guint8  msg[DNS_HEADER_SIZE + DNS_NAME_WIRE_MAX + 4];
+    guint16 flags;
+
+    nm_assert(question_end >= DNS_HEADER_SIZE && question_end <= sizeof(msg));
+
+    memcpy(msg, query, question_end);
+
+    flags = unaligned_read_be16(&msg[2]);
+    flags = (flags & ~DNS_RCODE_MASK & ~DNS_FLAG_TC) | DNS_FLAG_QR | DNS_FLAG_RA | rcode;
+    unaligned_write_be16(&msg[2], flags);
+    unaligned_write_be16(&msg[4], question_end > DNS_HEADER_SIZE ? 1 : 0);
+    unaligned_write_be16(&msg[6], 0);
+    unaligned_write_be16(&msg[8], 0);
+    unaligned_write_be16(&msg[10], 0);
+
+    _send_to_client(self, client, msg, question_end);
+}
+
+/*****************************************************************************/
+
+static void
+_cache_entry_remove(NMDnsStubServer *self, CacheEntry *entry)
+{
+    if (!g_hash_table_remove(self->cache_idx, &entry->key))
+        nm_assert_not_reached();
+    c_list_unlink_stale(&entry->lru_lst);
+    g_free(entry->ttl_offsets);
+    g_free(entry);
+}
+
+static void
+_cache_trim(NMDnsStubServer *self, guint max_entries)
+{
+    while (g_hash_table_size(self->cache_idx) > max_entries) {
+        _cache_entry_remove(
+            self,
+            c_list_last_entry(&self->cache_lru_lst_head, CacheEntry, lru_lst));
+    }
+}
+
+void
+nm_dns_stub_server_flush_cache(NMDnsStubServer *self)
+{
+    g_return_if_fail(self);
+
+    _cache_trim(self, 0);
+}
+
+static gboolean
+_cache_reply(NMDnsStubServer *self,
+             const DnsClient *client,
+             const guint8    *query,
+             const DnsQuery  *q,
+             gint64           now_msec)
+{
+    CacheEntry *entry;
+    guint32     elapsed_sec;
+    guint       i;
+
+    entry = g_hash_table_lookup(self->cache_idx, &q->key);
+    if (!entry)
+        return FALSE;
+
+    if (entry->expiry_msec <= now_msec) {
+        _cache_entry_remove(self, entry);
+        return FALSE;
+    }
+    if (entry->tcp_only && !client->conn)
+        return FALSE;
+
+    c_list_unlink_stale(&entry->lru_lst);
+    c_list_link_front(&self->cache_lru_lst_head, &entry->lru_lst);
+
+    /* Reuse the buffer for the reply. The client's question has the same length
+     * as the cached one (the key matched), but possibly a different case. */
+    memcpy(self->buf, entry->msg, entry->msg_len);
+    unaligned_write_be16(&self->buf[0], q->id);
+    memcpy(&self->buf[DNS_HEADER_SIZE],
+           &query[DNS_HEADER_SIZE],
+           q->question_end - DNS_HEADER_SIZE);
+
+    elapsed_sec = (now_msec - entry->inserted_msec) / 1000;
+    for (i = 0; i < entry->n_ttl_offsets; i++) {
+        guint8 *p   = &self->buf[entry->ttl_offsets[i]];
+        guint32 ttl = unaligned_read_be32(p);
+
+        unaligned_write_be32(p, ttl > elapsed_sec ? ttl - elapsed_sec : 0);
+    }
+
+    _send_to_client(self, client, self->buf, entry->msg_len);
+    return TRUE;
+}
+
+static void
+_cache_add(NMDnsStubServer *self,
+           const CacheKey  *key,
+           const guint8    *msg,
+           gsize            len,
+           gsize            question_end,
+           gboolean         via_tcp)
+{
+    gs_unref_array GArray *ttl_offsets = NULL;
+    CacheEntry            *entry;
+    guint32                min_ttl = G_MAXUINT32;
+    guint16                flags;
+    guint8                 rcode;
+    gsize                  pos;
+    gint64                 now_msec;
+
+    if (self->cache_size == 0)
+        return;
+
+    flags = unaligned_read_be16(&msg[2]);
+    rcode = flags & DNS_RCODE_MASK;
+    if (flags & DNS_FLAG_TC)
+        return;
+    if (!NM_IN_SET(rcode, DNS_RCODE_NOERR, DNS_RCODE_NXDOMAIN))
+        return;
+
+    /* Negative answers are cached for the TTL of the SOA record in the
+     * authority section. Without any records, we don't know for how long
+     * the answer is valid, so it is not cached. */
+    ttl_offsets = g_array_new(FALSE, FALSE, sizeof(guint16));
+    pos         = question_end;
+    if (!_dns_scan_rrs(msg,
+                       len,
+                       &pos,
+                       (guint) unaligned_read_be16(&msg[6]) + unaligned_read_be16(&msg[8])
+                           + unaligned_read_be16(&msg[10]),
+                       ttl_offsets,
+                       &min_ttl,
+                       NULL,
+                       NULL))
+        return;
+    if (ttl_offsets->len == 0 || min_ttl == 0)
+        return;
+
+    min_ttl  = NM_MIN(min_ttl, CACHE_MAX_TTL_SEC);
+    now_msec = nm_utils_get_monotonic_timestamp_msec();
+
+    entry = g_hash_table_lookup(self->cache_idx, key);
+    if (entry)
+        _cache_entry_remove(self, entry);
+
+    entry  = g_malloc(sizeof(CacheEntry) + len);
+    *entry = (CacheEntry){
+        .key           = *key,
+        .inserted_msec = now_msec,
+        .expiry_msec   = now_msec + ((gint64) min_ttl) * 1000,
+        .n_ttl_offsets = ttl_offsets->len,
+        .ttl_offsets   = (guint16 *) g_array_free(g_steal_pointer(&ttl_offsets), FALSE),
+        .msg_len       = len,
+        .tcp_only      = via_tcp && len > DNS_UDP_MSG_MAX,
+    };
+    memcpy(entry->msg, msg, len);
+
+    if (!g_hash_table_add(self->cache_idx, entry))
+        nm_assert_not_reached();
+    c_list_link_front(&self->cache_lru_lst_head, &entry->lru_lst);
+
+    _cache_trim(self, self->cache_size);
+}
+
+void
+nm_dns_stub_server_set_cache_size(NMDnsStubServer *self, guint cache_size)
+{
+    g_return_if_fail(self);
+
+    self->cache_size = cache_size;
+    _cache_trim(self, cache_size);
+}
+
+/*****************************************************************************/
+
+static Upstream *
+_upstream_select(NMDnsStubServer *self, const char *qname, guint skip)
+{
+    Upstream *best_upstreams[64];
+    gsize     qname_len = strlen(qname);
+    gsize     best      = 0;
+    guint     n_best    = 0;
+    guint     i;
+
+    /* Pick the upstreams with the longest matching domain. Among those with
+     * the same match, the earlier ones (with better priority) win. With @skip,
+     * we fail over to the next one. */
+    for (i = 0; i < self->upstreams->len; i++) {
+        Upstream *u     = self->upstreams->pdata[i];
+        gsize     score = u->is_default ? 1 : 0;
+        guint     j;
+
+        for (j = 0; u->domains && u->domains[j]; j++) {
+            const char *d     = u->domains[j];
+            gsize       d_len = strlen(d);
+
+            if (d_len == 0)
+                continue;
+            if (qname_len < d_len || !nm_streq(&qname[qname_len - d_len], d))
+                continue;
+            if (qname_len > d_len && qname[qname_len - d_len - 1] != '.')
+                continue;
+            score = NM_MAX(score, d_len + 2);
+        }
+
+        if (score == 0 || score < best)
+            continue;
+        if (score > best) {
+            best   = score;
+            n_best = 0;
+        }
+        if (n_best < G_N_ELEMENTS(best_upstreams))
+            best_upstreams[n_best++] = u;
+    }
+
+    if (skip >= n_best)
+        return NULL;
+    return best_upstreams[skip];
+}
+
+/*****************************************************************************/
+
+static void _pending_timeout_reschedule(NMDnsStubServer *self);
+
+static void
+_pending_close_socket(PendingQuery *pq)
+{
+    nm_clear_g_source_inst(&pq->source);
+    nm_clear_fd(&pq->fd);
+    nm_clear_pointer(&pq->tcp_in, g_byte_array_unref);
+    pq->tcp_out_pos = 0;
+}
+
+static void
+_pending_free(NMDnsStubServer *self, PendingQuery *pq)
+{
+    TcpConn *conn = pq->client.conn;
+
+    nm_assert(self->n_pending > 0);
+
+    self->n_pending--;
+    c_list_unlink_stale(&pq->pending_lst);
+    _pending_close_socket(pq);
+    g_free(pq);
+
+    if (conn) {
+        nm_assert(conn->n_pending > 0);
+        conn->n_pending--;
+        _tcp_conn_check_done(conn);
+    }
+}
+
+static void
+_pending_fail(NMDnsStubServer *self, PendingQuery *pq)
+{
+    unaligned_write_be16(&pq->query[0], pq->client_id);
+    _reply_error(self, &pq->client, pq->query, pq->question_end, DNS_RCODE_SRVFAIL);
+    _pending_free(self, pq);
+}
+
+static gboolean _pending_udp_cb(int fd, GIOCondition condition, gpointer user_data);
+static gboolean _pending_tcp_cb(int fd, GIOCondition condition, gpointer user_data);
+
+/* Every query gets a new socket, and thus a new source port that the kernel
+ * picks at random. Together with the random ID, that makes it hard to spoof
+ * a reply. */
+static gboolean
+_pending_connect(NMDnsStubServer *self, PendingQuery *pq, Upstream *upstream)
+{
+    nm_auto_close int fd = -1;
+    int               errsv;
+
+    fd = socket(upstream->addr_family,
+                (pq->tcp ? SOCK_STREAM : SOCK_DGRAM) | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                0);
+    if (fd < 0) {
+        errsv = errno;
+        _LOGD("cannot create socket for %s: %s", upstream->addr_str, nm_strerror_native(errsv));
+        return FALSE;
+    }
+
+    if (upstream->ifname) {
+        if (setsockopt(fd,
+                       SOL_SOCKET,
+                       SO_BINDTODEVICE,
+                       upstream->ifname,
+                       strlen(upstream->ifname) + 1)
+            < 0) {
+            errsv = errno;
+            _LOGT("cannot bind socket for %s to interface: %s",
+                  upstream->addr_str,
+                  nm_strerror_native(errsv));
+        }
+    }
+
+    /* A connected UDP socket only receives datagrams from the upstream. */
+    if (connect(fd, &upstream->sa.sa, upstream->sa_len) < 0) {
+        errsv = errno;
+        if (!pq->tcp || errsv != EINPROGRESS) {
+            _LOGD("cannot connect socket to %s: %s",
+                  upstream->addr_str,
+                  nm_strerror_native(errsv));
+            return FALSE;
+        }
+    }
+
+    if (pq->tcp) {
+        /* The query is sent once the connection is established. */
+        pq->source = nm_g_unix_fd_add_source(fd, G_IO_OUT, _pending_tcp_cb, pq);
+    } else {
+        if (send(fd, pq->query, pq->query_len, MSG_NOSIGNAL) < 0) {
+            errsv = errno;
+            _LOGD("failed to forward query to %s: %s",
+                  upstream->addr_str,
+                  nm_strerror_native(errsv));
+            return FALSE;
+        }
+        pq->source = nm_g_unix_fd_add_source(fd, G_IO_IN, _pending_udp_cb, pq);
+    }
+
+    pq->fd = nm_steal_fd(&fd);
+    return TRUE;
+}
+
+static gboolean
+_pending_send(NMDnsStubServer *self, PendingQuery *pq, gint64 now_msec)
+{
+    Upstream *upstream;
+
+    _pending_close_socket(pq);
+    pq->upstream = NULL;
+
+    while ((upstream = _upstream_select(self, pq->qname, pq->attempt++))) {
+        if (!_pending_connect(self, pq, upstream))
+            continue;
+
+        _LOGT("forward query #%u for \"%s\" to %s%s",
+              pq->id,
+              pq->qname[0] ? pq->qname : ".",
+              upstream->addr_str,
+              pq->tcp ? " over TCP" : "");
+        pq->upstream    = upstream;
+        pq->expiry_msec = now_msec + PENDING_TIMEOUT_MSEC;
+        c_list_unlink(&pq->pending_lst);
+        c_list_link_tail(&self->pending_lst_head, &pq->pending_lst);
+        self->stats.forwarded++;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* The upstream failed without waiting for the timeout. Try the next one. */
+static void
+_pending_retry(NMDnsStubServer *self, PendingQuery *pq)
+{
+    if (!_pending_send(self, pq, nm_utils_get_monotonic_timestamp_msec())) {
+        _pending_fail(self, pq);
+        return;
+    }
+    _pending_timeout_reschedule(self);
+}
+
+static gboolean
+_pending_reply_matches(const PendingQuery *pq, const guint8 *msg, gsize len)
+{
+    gsize i;
+
+    if (len < DNS_HEADER_SIZE)
+        return FALSE;
+    if (!(unaligned_read_be16(&msg[2]) & DNS_FLAG_QR))
+        return FALSE;
+    if (unaligned_read_be16(&msg[0]) != pq->id)
+        return FALSE;
+
+    /* Only accept the reply, if it answers the question we asked. */
+    if (len < pq->question_end)
+        return FALSE;
+    for (i = DNS_HEADER_SIZE; i < pq->question_end; i++) {
+        if (g_ascii_tolower(msg[i]) != g_ascii_tolower(pq->query[i]))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Passes the reply on to the client. @msg is modified and must not point
+ * into @pq, which gets freed. */
+static void
+_pending_complete(NMDnsStubServer *self, PendingQuery *pq, guint8 *msg, gsize len)
+{
+    _LOGT("reply #%u for \"%s\" from %s (%zu bytes%s)",
+          pq->id,
+          pq->qname[0] ? pq->qname : ".",
+          pq->upstream->addr_str,
+          len,
+          unaligned_read_be16(&msg[2]) & DNS_FLAG_TC ? ", truncated" : "");
+
+    /* A truncated reply is passed on as is. A client that wants the full
+     * answer retries over TCP. */
+    if (pq->cacheable)
+        _cache_add(self, &pq->key, msg, len, pq->question_end, pq->tcp);
+
+    unaligned_write_be16(&msg[0], pq->client_id);
+    _send_to_client(self, &pq->client, msg, len);
+    _pending_free(self, pq);
+}
+
+static gboolean
+_pending_udp_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    PendingQuery    *pq   = user_data;
+    NMDnsStubServer *self = pq->server;
+    guint            n;
+
+    for (n = 0; n < RECV_BURST; n++) {
+        gssize len;
+
+        len = recv(fd, self->buf, sizeof(self->buf), MSG_DONTWAIT);
+        if (len < 0) {
+            int errsv = errno;
+
+            if (NM_IN_SET(errsv, EAGAIN, EINTR))
+                break;
+
+            /* e.g. ECONNREFUSED as ICMP error from the send(). */
+            _LOGT("receive from %s failed: %s", pq->upstream->addr_str, nm_strerror_native(errsv));
+            _pending_retry(self, pq);
+            return G_SOURCE_CONTINUE;
+        }
+
+        if (!_pending_reply_matches(pq, self->buf, len))
+            continue;
+
+        _pending_complete(self, pq, self->buf, len);
+        break;
+    }
+
+    if (c_list_is_empty(&self->pending_lst_head))
+        nm_clear_g_source_inst(&self->timeout_source);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_pending_tcp_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    PendingQuery    *pq   = user_data;
+    NMDnsStubServer *self = pq->server;
+    gsize            msg_len;
+    gssize           n;
+
+    if (!pq->tcp_in) {
+        gsize out_len = 2 + pq->query_len;
+
+        unaligned_write_be16(&self->buf[0], pq->query_len);
+        memcpy(&self->buf[2], pq->query, pq->query_len);
+
+        n = send(fd,
+                 &self->buf[pq->tcp_out_pos],
+                 out_len - pq->tcp_out_pos,
+                 MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            int errsv = errno;
+
+            if (NM_IN_SET(errsv, EAGAIN, EINTR))
+                return G_SOURCE_CONTINUE;
+            _LOGT("send to %s failed: %s", pq->upstream->addr_str, nm_strerror_native(errsv));
+            _pending_retry(self, pq);
+            return G_SOURCE_CONTINUE;
+        }
+
+        pq->tcp_out_pos += n;
+        if (pq->tcp_out_pos < out_len)
+            return G_SOURCE_CONTINUE;
+
+        pq->tcp_in = g_byte_array_sized_new(512);
+        nm_clear_g_source_inst(&pq->source);
+        pq->source = nm_g_unix_fd_add_source(fd, G_IO_IN, _pending_tcp_cb, pq);
+        return G_SOURCE_CONTINUE;
+    }
+
+    n = recv(fd, self->buf, sizeof(self->buf), MSG_DONTWAIT);
+    if (n < 0) {
+        int errsv = errno;
+
+        if (NM_IN_SET(errsv, EAGAIN, EINTR))
+            return G_SOURCE_CONTINUE;
+        _LOGT("receive from %s failed: %s", pq->upstream->addr_str, nm_strerror_native(errsv));
+        _pending_retry(self, pq);
+        return G_SOURCE_CONTINUE;
+    }
+    if (n == 0) {
+        _LOGT("%s closed the connection", pq->upstream->addr_str);
+        _pending_retry(self, pq);
+        return G_SOURCE_CONTINUE;
+    }
+
+    g_byte_array_append(pq->tcp_in, self->buf, n);
+    if (pq->tcp_in->len < 2)
+        return G_SOURCE_CONTINUE;
+    msg_len = unaligned_read_be16(pq->tcp_in->data);
+    if (pq->tcp_in->len < 2 + msg_len)
+        return G_SOURCE_CONTINUE;
+
+    memcpy(self->buf, &pq->tcp_in->data[2], msg_len);
+    if (!_pending_reply_matches(pq, self->buf, msg_len)) {
+        _LOGT("invalid reply from %s", pq->upstream->addr_str);
+        _pending_retry(self, pq);
+        return G_SOURCE_CONTINUE;
+    }
+
+    _pending_complete(self, pq, self->buf, msg_len);
+
+    if (c_list_is_empty(&self->pending_lst_head))
+        nm_clear_g_source_inst(&self->timeout_source);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_pending_timeout_cb(gpointer user_data)
+{
+    NMDnsStubServer *self = user_data;
+    PendingQuery    *pq;
+    PendingQuery    *pq_safe;
+    CList            expired_lst_head = C_LIST_INIT(expired_lst_head);
+    gint64           now_msec;
+
+    nm_clear_g_source_inst(&self->timeout_source);
+
+    now_msec = nm_utils_get_monotonic_timestamp_msec();
+
+    /* The list is sorted by expiry. Move expired entries aside first, because
+     * _pending_send() re-appends them to the tail of the pending list. */
+    c_list_for_each_entry_safe (pq, pq_safe, &self->pending_lst_head, pending_lst) {
+        if (pq->expiry_msec > now_msec)
+            break;
+        c_list_unlink(&pq->pending_lst);
+        c_list_link_tail(&expired_lst_head, &pq->pending_lst);
+    }
+
+    c_list_for_each_entry_safe (pq, pq_safe, &expired_lst_head, pending_lst) {
+        self->stats.timeouts++;
+        _LOGD("query #%u for \"%s\" to %s timed out",
+              pq->id,
+              pq->qname[0] ? pq->qname : ".",
+              pq->upstream ? pq->upstream->addr_str : "(none)");
+        if (!_pending_send(self, pq, now_msec))
+            _pending_fail(self, pq);
+    }
+
+    _pending_timeout_reschedule(self);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+_pending_timeout_reschedule(NMDnsStubServer *self)
+{
+    PendingQuery *pq;
+    gint64        now_msec;
+
+    if (self->timeout_source)
+        return;
+
+    pq = c_list_first_entry(&self->pending_lst_head, PendingQuery, pending_lst);
+    if (!pq)
+        return;
+
+    now_msec             = nm_utils_get_monotonic_timestamp_msec();
+    self->timeout_source = nm_g_timeout_add_source(NM_MAX(pq->expiry_msec - now_msec, 0),
+                                                   _pending_timeout_cb,
+                                                   self);
+}
+
+static void
+_pending_fail_all(NMDnsStubServer *self)
+{
+    PendingQuery *pq;
+
+    while ((pq = c_list_first_entry(&self->pending_lst_head, PendingQuery, pending_lst)))
+        _pending_fail(self, pq);
+    nm_clear_g_source_inst(&self->timeout_source);
+}
+
+/*****************************************************************************/
+
+static void
+_upstream_free(Upstream *upstream)
+{
+    g_strfreev(upstream->domains);
+    g_free(upstream->ifname);
+    g_free(upstream);
+}
+
+static char **
+_upstream_normalize_domains(const char *const *domains, bool *out_is_default)
+{
+    GPtrArray *arr;
+    gsize      i;
+
+    *out_is_default = !domains || !domains[0];
+
+    arr = g_ptr_array_new();
+    for (i = 0; domains && domains[i]; i++) {
+        const char *d = domains[i];
+        char       *s;
+        gsize       l;
+
+        if (d[0] == '~')
+            d++;
+        s = g_ascii_strdown(d, -1);
+        l = strlen(s);
+        while (l > 0 && s[l - 1] == '.')
+            s[--l] = '\0';
+        if (l == 0) {
+            *out_is_default = TRUE;
+            g_free(s);
+            continue;
+        }
+        g_ptr_array_add(arr, s);
+    }
+    g_ptr_array_add(arr, NULL);
+    return (char **) g_ptr_array_free(arr, FALSE);
+}
+
+static Upstream *
+_upstream_new(const NMDnsStubUpstream *config)
+{
+    Upstream *upstream;
+    char      buf[NM_INET_ADDRSTRLEN];
+
+    nm_assert_addr_family(config->addr_family);
+
+    upstream  = g_new(Upstream, 1);
+    *upstream = (Upstream){
+        .addr        = config->addr,
+        .addr_family = config->addr_family,
+        .port        = config->port ?: NM_DNS_STUB_DEFAULT_PORT,
+        .ifindex     = config->ifindex,
+        .ifname      = g_strdup(config->ifname),
+    };
+    upstream->domains = _upstream_normalize_domains(config->domains, &upstream->is_default);
+
+    g_snprintf(upstream->addr_str,
+               sizeof(upstream->addr_str),
+               "%s%s%s#%u",
+               nm_inet_ntop(config->addr_family, &config->addr, buf),
+               config->ifname ? "%" : "",
+               config->ifname ?: "",
+               upstream->port);
+
+    if (config->addr_family == AF_INET) {
+        upstream->sa.in = (struct sockaddr_in){
+            .sin_family = AF_INET,
+            .sin_port   = htons(upstream->port),
+            .sin_addr   = config->addr.addr4_struct,
+        };
+        upstream->sa_len = sizeof(upstream->sa.in);
+    } else {
+        upstream->sa.in6 = (struct sockaddr_in6){
+            .sin6_family   = AF_INET6,
+            .sin6_port     = htons(upstream->port),
+            .sin6_addr     = config->addr.addr6,
+            .sin6_scope_id = IN6_IS_ADDR_LINKLOCAL(&config->addr.addr6) ? config->ifindex : 0,
+        };
+        upstream->sa_len = sizeof(upstream->sa.in6);
+    }
+
+    _LOGD("upstream %s%s", upstream->addr_str, upstream->is_default ? " (default)" : "");
+    return upstream;
+}
+
+static gboolean
+_upstream_equal(const Upstream *upstream, const NMDnsStubUpstream *config)
+{
+    gs_strfreev char **domains = NULL;
+    bool               is_default;
+
+    if (upstream->addr_family != config->addr_family
+        || upstream->port != (config->port ?: NM_DNS_STUB_DEFAULT_PORT)
+        || upstream->ifindex != config->ifindex || !nm_streq0(upstream->ifname, config->ifname)
+        || memcmp(&upstream->addr, &config->addr, nm_utils_addr_family_to_size(config->addr_family))
+               != 0)
+        return FALSE;
+
+    domains = _upstream_normalize_domains(config->domains, &is_default);
+    return upstream->is_default == is_default
+           && nm_strv_equal((const char *const *) upstream->domains,
+                            (const char *const *) domains);
+}
+
+void
+nm_dns_stub_server_set_upstreams(NMDnsStubServer         *self,
+                                 const NMDnsStubUpstream *upstreams,
+                                 guint                    n_upstreams)
+{
+    guint i;
+
+    g_return_if_fail(self);
+    g_return_if_fail(n_upstreams == 0 || upstreams);
+
+    if (self->upstreams->len == n_upstreams) {
+        for (i = 0; i < n_upstreams; i++) {
+            if (!_upstream_equal(self->upstreams->pdata[i], &upstreams[i]))
+                break;
+        }
+        if (i == n_upstreams) {
+            _LOGT("upstreams unchanged");
+            return;
+        }
+    }
+
+    /* The routing changed. In-flight queries refer to the old upstreams and the
+     * cached answers may no longer be what the new upstreams would answer. */
+    _pending_fail_all(self);
+    nm_dns_stub_server_flush_cache(self);
+
+    g_ptr_array_set_size(self->upstreams, 0);
+    for (i = 0; i < n_upstreams; i++)
+        g_ptr_array_add(self->upstreams, _upstream_new(&upstreams[i]));
+}
+
+/*****************************************************************************/
+
+static void
+_handle_query(NMDnsStubServer *self, const DnsClient *client, const guint8 *msg, gsize len)
+{
+    DnsQuery      q;
+    PendingQuery *pq;
+    guint8        rcode;
+    gint64        now_msec;
+
+    self->stats.queries++;
+
+    rcode = _dns_parse_query(msg, len, &q);
+    if (rcode != DNS_RCODE_NOERR) {
+        _reply_error(self, client, msg, DNS_HEADER_SIZE, rcode);
+        return;
+    }
+
+    now_msec = nm_utils_get_monotonic_timestamp_msec();
+
+    if (q.cacheable && _cache_reply(self, client, msg, &q, now_msec)) {
+        _LOGT("cache hit for \"%s\"", q.qname[0] ? q.qname : ".");
+        self->stats.cache_hits++;
+        return;
+    }
+    self->stats.cache_misses++;
+
+    if (self->n_pending >= PENDING_MAX) {
+        _reply_error(self, client, msg, q.question_end, DNS_RCODE_SRVFAIL);
+        return;
+    }
+
+    pq  = g_malloc(sizeof(PendingQuery) + len);
+    *pq = (PendingQuery){
+        .pending_lst  = C_LIST_INIT(pq->pending_lst),
+        .server       = self,
+        .client       = *client,
+        .key          = q.key,
+        .fd           = -1,
+        .id           = nm_random_u64_range(G_MAXUINT16 + 1u),
+        .client_id    = q.id,
+        .question_end = q.question_end,
+        .query_len    = len,
+        .cacheable    = q.cacheable,
+        .tcp          = !!client->conn,
+    };
+    memcpy(pq->qname, q.qname, sizeof(q.qname));
+    memcpy(pq->query, msg, len);
+    unaligned_write_be16(&pq->query[0], pq->id);
+
+    self->n_pending++;
+    if (client->conn)
+        client->conn->n_pending++;
+
+    if (!_pending_send(self, pq, now_msec)) {
+        _LOGT("no upstream for \"%s\"", q.qname[0] ? q.qname : ".");
+        _pending_fail(self, pq);
+        return;
+    }
+
+    _pending_timeout_reschedule(self);
+}
+
+static gboolean
+_listen_recv_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    NMDnsStubServer *self = user_data;
+    guint            n;
+
+    for (n = 0; n < RECV_BURST; n++) {
+        DnsClient client        = {};
+        socklen_t client_sa_len = sizeof(client.sa);
+        gssize    len;
+
+        len = recvfrom(fd,
+                       self->buf,
+                       sizeof(self->buf),
+                       MSG_DONTWAIT,
+                       (struct sockaddr *) &client.sa,
+                       &client_sa_len);
+        if (len < 0) {
+            int errsv = errno;
+
+            if (NM_IN_SET(errsv, EAGAIN, EINTR))
+                break;
+            _LOGD("receive failed: %s", nm_strerror_native(errsv));
+            continue;
+        }
+        if (len < DNS_HEADER_SIZE || client_sa_len != sizeof(client.sa))
+            continue;
+        if (unaligned_read_be16(&self->buf[2]) & DNS_FLAG_QR)
+            continue;
+
+        /* _handle_query() reuses the buffer for cached replies, so pass a copy. */
+        {
+            gs_free guint8 *query = nm_memdup(self->buf, len);
+
+            _handle_query(self, &client, query, len);
+        }
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+static void
+_tcp_conn_process_input(TcpConn *conn)
+{
+    NMDnsStubServer *self   = conn->server;
+    const DnsClient  client = {.conn = conn};
+
+    while (conn->in->len >= 2) {
+        gs_free guint8 *query = NULL;
+        gsize           len;
+
+        len = unaligned_read_be16(conn->in->data);
+        if (conn->in->len < 2 + len)
+            break;
+
+        if (len < DNS_HEADER_SIZE || (unaligned_read_be16(&conn->in->data[4]) & DNS_FLAG_QR)) {
+            _LOGD("invalid message from TCP client");
+            g_byte_array_set_size(conn->in, 0);
+            conn->read_closed = TRUE;
+            break;
+        }
+
+        query = nm_memdup(&conn->in->data[2], len);
+        g_byte_array_remove_range(conn->in, 0, 2 + len);
+        _handle_query(self, &client, query, len);
+    }
+}
+
+static gboolean
+_tcp_conn_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    TcpConn         *conn = user_data;
+    NMDnsStubServer *self = conn->server;
+
+    if (condition & (G_IO_OUT | G_IO_HUP | G_IO_ERR))
+        _tcp_conn_flush(conn);
+
+    if (!conn->read_closed && (condition & (G_IO_IN | G_IO_HUP | G_IO_ERR))) {
+        gssize n;
+
+        n = recv(fd, self->buf, sizeof(self->buf), MSG_DONTWAIT);
+        if (n < 0) {
+            int errsv = errno;
+
+            if (!NM_IN_SET(errsv, EAGAIN, EINTR)) {
+                _LOGD("receive from TCP client failed: %s", nm_strerror_native(errsv));
+                conn->read_closed = TRUE;
+            }
+        } else if (n == 0)
+            conn->read_closed = TRUE;
+        else {
+            conn->last_active_msec = nm_utils_get_monotonic_timestamp_msec();
+            g_byte_array_append(conn->in, self->buf, n);
+            _tcp_conn_process_input(conn);
+        }
+    }
+
+    if (!_tcp_conn_check_done(conn))
+        _tcp_conn_update_source(conn);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_tcp_conn_idle_cb(gpointer user_data)
+{
+    TcpConn *conn = user_data;
+
+    if (conn->n_pending > 0 || conn->out->len > 0
+        || nm_utils_get_monotonic_timestamp_msec()
+               < conn->last_active_msec + TCP_CONN_IDLE_TIMEOUT_MSEC)
+        return G_SOURCE_CONTINUE;
+
+    _tcp_conn_free(conn);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_listen_tcp_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    NMDnsStubServer *self = user_data;
+    guint            n;
+
+    for (n = 0; n < RECV_BURST; n++) {
+        nm_auto_close int conn_fd = -1;
+        TcpConn          *conn;
+
+        conn_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (conn_fd < 0) {
+            int errsv = errno;
+
+            if (!NM_IN_SET(errsv, EAGAIN, EINTR))
+                _LOGD("accept failed: %s", nm_strerror_native(errsv));
+            break;
+        }
+
+        if (self->n_tcp_conns >= TCP_CONN_MAX) {
+            _LOGD("too many TCP connections, reject client");
+            continue;
+        }
+
+        conn  = g_new(TcpConn, 1);
+        *conn = (TcpConn){
+            .server           = self,
+            .in               = g_byte_array_new(),
+            .out              = g_byte_array_new(),
+            .fd               = nm_steal_fd(&conn_fd),
+            .last_active_msec = nm_utils_get_monotonic_timestamp_msec(),
+        };
+        c_list_link_tail(&self->tcp_conn_lst_head, &conn->conn_lst);
+        self->n_tcp_conns++;
+
+        conn->idle_source =
+            nm_g_timeout_add_source(TCP_CONN_IDLE_TIMEOUT_MSEC, _tcp_conn_idle_cb, conn);
+        _tcp_conn_update_source(conn);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+guint16
+nm_dns_stub_server_get_port(NMDnsStubServer *self)
+{
+    g_return_val_if_fail(self, 0);
+
+    return self->port;
+}
+
+void
+nm_dns_stub_server_get_stats(NMDnsStubServer *self, NMDnsStubStats *out_stats)
+{
+    g_return_if_fail(self);
+    g_return_if_fail(out_stats);
+
+    *out_stats               = self->stats;
+    out_stats->cache_entries = g_hash_table_size(self->cache_idx);
+}
+
+NMDnsStubServer *
+nm_dns_stub_server_new(const NMIPAddr *listen_addr4, guint16 port, guint cache_size, GError **error)
+{
+    nm_auto_close int  fd     = -1;
+    nm_auto_close int  fd_tcp = -1;
+    NMDnsStubServer   *self;
+    struct sockaddr_in sa;
+    socklen_t          sa_len;
+    const int          one = 1;
+    int                errsv;
+
+    g_return_val_if_fail(listen_addr4, NULL);
+    g_return_val_if_fail(!error || !*error, NULL);
+
+    fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot create socket: %s",
+                    nm_strerror_native(errsv));
+        return NULL;
+    }
+
+    sa = (struct sockaddr_in){
+        .sin_family = AF_INET,
+        .sin_port   = htons(port),
+        .sin_addr   = listen_addr4->addr4_struct,
+    };
+    if (bind(fd, (struct sockaddr *) &sa, sizeof(sa)) < 0) {
+        char buf[NM_INET_ADDRSTRLEN];
+
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot bind to %s:%u: %s",
+                    nm_inet4_ntop(listen_addr4->addr4, buf),
+                    port,
+                    nm_strerror_native(errsv));
+        return NULL;
+    }
+
+    sa_len = sizeof(sa);
+    if (getsockname(fd, (struct sockaddr *) &sa, &sa_len) < 0) {
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot get socket address: %s",
+                    nm_strerror_native(errsv));
+        return NULL;
+    }
+
+    /* Clients retry over TCP when they get a truncated reply. Listen on the
+     * same port, which is now known even if @port was zero. */
+    fd_tcp = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_tcp < 0) {
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot create TCP socket: %s",
+                    nm_strerror_native(errsv));
+        return NULL;
+    }
+    (void) setsockopt(fd_tcp, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd_tcp, (struct sockaddr *) &sa, sizeof(sa)) < 0 || listen(fd_tcp, 16) < 0) {
+        char buf[NM_INET_ADDRSTRLEN];
+
+        errsv = errno;
+        g_set_error(error,
+                    NM_UTILS_ERROR,
+                    NM_UTILS_ERROR_UNKNOWN,
+                    "cannot listen on TCP %s:%u: %s",
+                    nm_inet4_ntop(listen_addr4->addr4, buf),
+                    ntohs(sa.sin_port),
+                    nm_strerror_native(errsv));
+        return NULL;
+    }
+
+    self  = g_new(NMDnsStubServer, 1);
+    *self = (NMDnsStubServer){
+        .cache_idx          = g_hash_table_new(_cache_key_hash, _cache_key_equal),
+        .upstreams          = g_ptr_array_new_with_free_func((GDestroyNotify) _upstream_free),
+        .cache_lru_lst_head = C_LIST_INIT(self->cache_lru_lst_head),
+        .pending_lst_head   = C_LIST_INIT(self->pending_lst_head),
+        .tcp_conn_lst_head  = C_LIST_INIT(self->tcp_conn_lst_head),
+        .cache_size         = cache_size,
+        .listen_fd          = nm_steal_fd(&fd),
+        .listen_tcp_fd      = nm_steal_fd(&fd_tcp),
+        .port               = ntohs(sa.sin_port),
+    };
+
+    self->listen_source = nm_g_unix_fd_add_source(self->listen_fd, G_IO_IN, _listen_recv_cb, self);
+    self->listen_tcp_source =
+        nm_g_unix_fd_add_source(self->listen_tcp_fd, G_IO_IN, _listen_tcp_cb, self);
+
+    return self;
+}
+
+void
+nm_dns_stub_server_free(NMDnsStubServer *self)
+{
+    TcpConn *conn;
+
+    if (!self)
+        return;
+
+    _pending_fail_all(self);
+    nm_dns_stub_server_flush_cache(self);
+
+    while ((conn = c_list_first_entry(&self->tcp_conn_lst_head, TcpConn, conn_lst)))
+        _tcp_conn_free(conn);
+
+    nm_clear_g_source_inst(&self->listen_source);
+    nm_clear_g_source_inst(&self->listen_tcp_source);
+    nm_clear_g_source_inst(&self->timeout_source);
+    g_ptr_array_unref(self->upstreams);
+    g_hash_table_unref(self->cache_idx);
+    nm_close(self->listen_fd);
+    nm_close(self->listen_tcp_fd);
+    g_free(self);
+}
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#ifndef __NM_DNS_STUB_SERVER_H__
+#define __NM_DNS_STUB_SERVER_H__
+
+#include "libnm-glib-aux/nm-inet-utils.h"
+
+/*****************************************************************************/
+
+#define NM_DNS_STUB_DEFAULT_LISTEN_ADDRESS "127.0.0.2"
+#define NM_DNS_STUB_DEFAULT_PORT           53
+#define NM_DNS_STUB_DEFAULT_CACHE_SIZE     1000u
+
+typedef struct {
+    NMIPAddr addr;
+    int      addr_family;
+    guint16  port;
+
+    /* The ifindex is only used to scope IPv6 link-local addresses. */
+    int ifindex;
+
+    /* Optional. If set, the socket for this upstream is bound to the interface. */
+    const char *ifname;
+
+    /* The domains that are routed to this upstream. "." (or "~.") makes the
+     * upstream a default server. An upstream without any domains is also
+     * used as default server. */
+    const char *const *domains;
+} NMDnsStubUpstream;
+
+typedef struct {
+    guint64 queries;
+    guint64 cache_hits;
+    guint64 cache_misses;
+    guint64 forwarded;
+    guint64 timeouts;
+    guint   cache_entries;
+} NMDnsStubStats;
+
+typedef struct _NMDnsStubServer NMDnsStubServer;
+
+NMDnsStubServer *nm_dns_stub_server_new(const NMIPAddr *listen_addr4,
+                                        guint16         port,
+                                        guint           cache_size,
+                                        GError        **error);
+
+void nm_dns_stub_server_free(NMDnsStubServer *self);
+
+NM_AUTO_DEFINE_FCN0(NMDnsStubServer *, _nm_auto_free_dns_stub_server, nm_dns_stub_server_free);
+#define nm_auto_free_dns_stub_server nm_auto(_nm_auto_free_dns_stub_server)
+
+guint16 nm_dns_stub_server_get_port(NMDnsStubServer *self);
+
+void nm_dns_stub_server_set_cache_size(NMDnsStubServer *self, guint cache_size);
+
+void nm_dns_stub_server_set_upstreams(NMDnsStubServer         *self,
+                                      const NMDnsStubUpstream *upstreams,
+                                      guint                    n_upstreams);
+
+void nm_dns_stub_server_flush_cache(NMDnsStubServer *self);
+
+void nm_dns_stub_server_get_stats(NMDnsStubServer *self, NMDnsStubStats *out_stats);
+
+#endif /* __NM_DNS_STUB_SERVER_H__ */
@@ -0,0 +1,273 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "libnm-glib-aux/nm-default-glib-i18n-prog.h"
+
+#include <signal.h>
+
+#include "libnm-glib-aux/nm-logging-base.h"
+#include "nm-dns-stub-server.h"
+
+/*****************************************************************************/
+
+/* Serves only the purpose to mark environment variables that are honored by
+ * the application. You can search for this macro, and find what options are supported. */
+#define _ENV(var) ("" var "")
+
+#define _nm_log(level, ...) _nm_log_simple_printf((level), __VA_ARGS__)
+
+#define _NMLOG(level, ...)                 \
+    G_STMT_START                           \
+    {                                      \
+        const NMLogLevel _level = (level); \
+                                           \
+        if (_nm_logging_enabled(_level)) { \
+            _nm_log(_level, __VA_ARGS__);  \
+        }                                  \
+    }                                      \
+    G_STMT_END
+
+/*****************************************************************************/
+
+typedef struct {
+    NMDnsStubServer *server;
+    const char      *config_file;
+    GSource         *source_sigterm;
+    GSource         *source_sigint;
+    GSource         *source_sighup;
+    bool             quitting;
+} GlobalData;
+
+/*****************************************************************************/
+
+/* The configuration is written by NetworkManager. It looks like:
+ *
+ *   [main]
+ *   listen=127.0.0.2
+ *   port=53
+ *   cache-size=1000
+ *
+ *   [upstream-0]
+ *   address=192.168.1.1
+ *   interface=eth0
+ *   ifindex=3
+ *   domains=example.com;~.;
+ *
+ * The upstream groups are ordered by priority. "listen" and "port" are only
+ * read on startup, the rest is reloaded on SIGHUP. */
+
+static gboolean
+_config_load(const char *config_file,
+             NMIPAddr   *out_listen_addr4,
+             guint16    *out_port,
+             guint      *out_cache_size,
+             GArray    **out_upstreams,
+             GError    **error)
+{
+    nm_auto_unref_keyfile GKeyFile *keyfile    = NULL;
+    gs_unref_array GArray          *upstreams  = NULL;
+    gs_strfreev char              **groups     = NULL;
+    gs_free char                   *listen_str = NULL;
+    gsize                           i;
+
+    keyfile = g_key_file_new();
+    if (!g_key_file_load_from_file(keyfile, config_file, G_KEY_FILE_NONE, error))
+        return FALSE;
+
+    if (out_listen_addr4) {
+        listen_str = g_key_file_get_string(keyfile, "main", "listen", NULL);
+        if (!nm_inet_parse_bin(AF_INET,
+                               listen_str ?: NM_DNS_STUB_DEFAULT_LISTEN_ADDRESS,
+                               NULL,
+                               out_listen_addr4)) {
+            g_set_error(error,
+                        NM_UTILS_ERROR,
+                        NM_UTILS_ERROR_INVALID_ARGUMENT,
+                        "invalid listen address \"%s\"",
+                        listen_str);
+            return FALSE;
+        }
+    }
+
+    if (out_port) {
+        gs_free char *s = g_key_file_get_string(keyfile, "main", "port", NULL);
+
+        *out_port = _nm_utils_ascii_str_to_int64(s, 10, 0, G_MAXUINT16, NM_DNS_STUB_DEFAULT_PORT);
+    }
+
+    {
+        gs_free char *s = g_key_file_get_string(keyfile, "main", "cache-size", NULL);
+
+        *out_cache_size =
+            _nm_utils_ascii_str_to_int64(s, 10, 0, G_MAXINT32, NM_DNS_STUB_DEFAULT_CACHE_SIZE);
+    }
+
+    upstreams = g_array_new(FALSE, TRUE, sizeof(NMDnsStubUpstream));
+    groups    = g_key_file_get_groups(keyfile, NULL);
+    for (i = 0; groups[i]; i++) {
+        gs_free char      *addr_str    = NULL;
+        gs_free char      *port_str    = NULL;
+        gs_free char      *ifindex_str = NULL;
+        NMDnsStubUpstream *u;
+        NMIPAddr           addr;
+        int                addr_family;
+
+        if (!g_str_has_prefix(groups[i], "upstream-"))
+            continue;
+
+        addr_str = g_key_file_get_string(keyfile, groups[i], "address", NULL);
+        if (!addr_str || !nm_inet_parse_bin(AF_UNSPEC, addr_str, &addr_family, &addr)) {
+            _LOGW("config: skip [%s] with invalid address", groups[i]);
+            continue;
+        }
+
+        port_str    = g_key_file_get_string(keyfile, groups[i], "port", NULL);
+        ifindex_str = g_key_file_get_string(keyfile, groups[i], "ifindex", NULL);
+
+        g_array_set_size(upstreams, upstreams->len + 1);
+        u  = &nm_g_array_last(upstreams, NMDnsStubUpstream);
+        *u = (NMDnsStubUpstream){
+            .addr        = addr,
+            .addr_family = addr_family,
+            .port        = _nm_utils_ascii_str_to_int64(port_str, 10, 1, G_MAXUINT16, 0),
+            .ifindex     = _nm_utils_ascii_str_to_int64(ifindex_str, 10, 1, G_MAXINT32, 0),
+            .ifname      = g_key_file_get_string(keyfile, groups[i], "interface", NULL),
+            .domains     = (const char *const *)
+                g_key_file_get_string_list(keyfile, groups[i], "domains", NULL, NULL),
+        };
+    }
+
+    /* The strings in @upstreams are owned by the caller, which frees them
+     * with _upstreams_free(). */
+    *out_upstreams = g_steal_pointer(&upstreams);
+    return TRUE;
+}
+
+static void
+_upstreams_free(GArray *upstreams)
+{
+    guint i;
+
+    for (i = 0; i < upstreams->len; i++) {
+        NMDnsStubUpstream *u = &nm_g_array_index(upstreams, NMDnsStubUpstream, i);
+
+        g_free((char *) u->ifname);
+        g_strfreev((char **) u->domains);
+    }
+    g_array_unref(upstreams);
+}
+
+static void
+_config_reload(GlobalData *gl)
+{
+    gs_free_error GError *error = NULL;
+    GArray               *upstreams;
+    guint                 cache_size;
+
+    if (!_config_load(gl->config_file, NULL, NULL, &cache_size, &upstreams, &error)) {
+        _LOGW("config: failed to reload \"%s\": %s", gl->config_file, error->message);
+        return;
+    }
+
+    _LOGD("config: reloaded with %u upstreams", upstreams->len);
+
+    nm_dns_stub_server_set_cache_size(gl->server, cache_size);
+    nm_dns_stub_server_set_upstreams(gl->server,
+                                     (const NMDnsStubUpstream *) upstreams->data,
+                                     upstreams->len);
+    _upstreams_free(upstreams);
+}
+
+/*****************************************************************************/
+
+static gboolean
+_signal_callback_term(gpointer user_data)
+{
+    GlobalData *gl = user_data;
+
+    _LOGD("termination signal received");
+    gl->quitting = TRUE;
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_signal_callback_hup(gpointer user_data)
+{
+    GlobalData    *gl = user_data;
+    NMDnsStubStats stats;
+
+    nm_dns_stub_server_get_stats(gl->server, &stats);
+    _LOGD("SIGHUP received (queries=%" G_GUINT64_FORMAT ", cache-hits=%" G_GUINT64_FORMAT
+          ", forwarded=%" G_GUINT64_FORMAT ", timeouts=%" G_GUINT64_FORMAT
+          ", cache-entries=%u)",
+          stats.queries,
+          stats.cache_hits,
+          stats.forwarded,
+          stats.timeouts,
+          stats.cache_entries);
+
+    _config_reload(gl);
+    return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+    GlobalData            _gl   = {};
+    GlobalData *const     gl    = &_gl;
+    gs_free_error GError *error = NULL;
+    GArray               *upstreams;
+    NMIPAddr              listen_addr4;
+    guint16               port;
+    guint                 cache_size;
+
+    _nm_logging_enabled_init(g_getenv(_ENV("NM_DNS_STUB_LOG")));
+
+    if (argc != 2) {
+        g_printerr("Usage: %s CONFIG-FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    gl->config_file = argv[1];
+
+    /* NetworkManager sends SIGHUP as soon as the configuration changes, possibly
+     * right after spawning us. Install the handlers first, so that the signal
+     * doesn't terminate us before we are up. They are only dispatched by the
+     * main loop, and then reload the configuration that we are about to load. */
+    signal(SIGPIPE, SIG_IGN);
+    gl->source_sigterm = nm_g_unix_signal_add_source(SIGTERM, _signal_callback_term, gl);
+    gl->source_sigint  = nm_g_unix_signal_add_source(SIGINT, _signal_callback_term, gl);
+    gl->source_sighup  = nm_g_unix_signal_add_source(SIGHUP, _signal_callback_hup, gl);
+
+    _LOGD("starting nm-dns-stub (%s)", NM_DIST_VERSION);
+
+    if (!_config_load(gl->config_file, &listen_addr4, &port, &cache_size, &upstreams, &error)) {
+        _LOGE("config: failed to load \"%s\": %s", gl->config_file, error->message);
+        return EXIT_FAILURE;
+    }
+
+    gl->server = nm_dns_stub_server_new(&listen_addr4, port, cache_size, &error);
+    if (!gl->server) {
+        _LOGE("failed to start: %s", error->message);
+        _upstreams_free(upstreams);
+        return EXIT_FAILURE;
+    }
+
+    nm_dns_stub_server_set_upstreams(gl->server,
+                                     (const NMDnsStubUpstream *) upstreams->data,
+                                     upstreams->len);
+    _upstreams_free(upstreams);
+
+    while (!gl->quitting)
+        g_main_context_iteration(NULL, TRUE);
+
+    _LOGD("shutdown: cleanup");
+
+    nm_clear_pointer(&gl->server, nm_dns_stub_server_free);
+    nm_clear_g_source_inst(&gl->source_sigterm);
+    nm_clear_g_source_inst(&gl->source_sigint);
+    nm_clear_g_source_inst(&gl->source_sighup);
+
+    _LOGD("exit");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,543 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "libnm-glib-aux/nm-default-glib-i18n-prog.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "libnm-std-aux/unaligned.h"
+#include "libnm-glib-aux/nm-logging-base.h"
+#include "nm-dns-stub/nm-dns-stub-server.h"
+
+#include "libnm-glib-aux/nm-test-utils.h"
+
+/*****************************************************************************/
+
+/* A fake upstream nameserver on 127.0.0.1, that answers every A query with
+ * a fixed address and a TTL of 300 seconds. It also listens on TCP on the
+ * same port, and serves one connection at a time. */
+typedef struct {
+    GSource  *source;
+    GSource  *tcp_source;
+    GSource  *tcp_conn_source;
+    int       fd;
+    int       tcp_fd;
+    int       tcp_conn_fd;
+    guint16   port;
+    in_addr_t answer;
+    guint     n_queries;
+    guint     n_tcp_queries;
+    guint16   src_ports[16];
+    guint8    tcp_buf[514];
+    gsize     tcp_buf_len;
+    bool      drop;
+
+    /* Answer over UDP with the TC bit set, and without records. */
+    bool truncate;
+} FakeUpstream;
+
+static gsize
+_fake_upstream_reply(FakeUpstream *fu, guint8 *buf, gsize len, gsize buf_size, gboolean truncate)
+{
+    gsize pos;
+
+    /* Skip over the question. */
+    pos = 12;
+    while (pos < len && buf[pos] != 0)
+        pos += 1 + buf[pos];
+    pos += 1 + 4;
+    g_assert_cmpint(pos, <=, len);
+
+    unaligned_write_be16(&buf[2], truncate ? 0x8380 : 0x8180);
+    unaligned_write_be16(&buf[6], truncate ? 0 : 1);
+    unaligned_write_be16(&buf[8], 0);
+    unaligned_write_be16(&buf[10], 0);
+    if (truncate)
+        return pos;
+
+    g_assert_cmpint(pos + 16, <=, buf_size);
+    unaligned_write_be16(&buf[pos], 0xC00C);
+    unaligned_write_be16(&buf[pos + 2], 1);
+    unaligned_write_be16(&buf[pos + 4], 1);
+    unaligned_write_be32(&buf[pos + 6], 300);
+    unaligned_write_be16(&buf[pos + 10], 4);
+    memcpy(&buf[pos + 12], &fu->answer, 4);
+    return pos + 16;
+}
+
+static gboolean
+_fake_upstream_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    FakeUpstream      *fu = user_data;
+    guint8             buf[512];
+    struct sockaddr_in sa;
+    socklen_t          sa_len = sizeof(sa);
+    gssize             len;
+    gsize              pos;
+
+    len = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr *) &sa, &sa_len);
+    if (len < 12)
+        return G_SOURCE_CONTINUE;
+
+    if (fu->n_queries < G_N_ELEMENTS(fu->src_ports))
+        fu->src_ports[fu->n_queries] = ntohs(sa.sin_port);
+    fu->n_queries++;
+    if (fu->drop)
+        return G_SOURCE_CONTINUE;
+
+    pos = _fake_upstream_reply(fu, buf, len, sizeof(buf), fu->truncate);
+    g_assert_cmpint(sendto(fd, buf, pos, 0, (struct sockaddr *) &sa, sa_len), ==, pos);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_fake_upstream_tcp_conn_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    FakeUpstream *fu = user_data;
+    guint8        reply[514];
+    gssize        n;
+    gsize         len;
+
+    n = recv(fd,
+             &fu->tcp_buf[fu->tcp_buf_len],
+             sizeof(fu->tcp_buf) - fu->tcp_buf_len,
+             MSG_DONTWAIT);
+    if (n <= 0) {
+        if (n == 0 || errno != EAGAIN) {
+            nm_clear_g_source_inst(&fu->tcp_conn_source);
+            nm_clear_fd(&fu->tcp_conn_fd);
+        }
+        return G_SOURCE_CONTINUE;
+    }
+    fu->tcp_buf_len += n;
+
+    if (fu->tcp_buf_len < 2)
+        return G_SOURCE_CONTINUE;
+    len = unaligned_read_be16(fu->tcp_buf);
+    g_assert_cmpint(len, >=, 12);
+    g_assert_cmpint(2 + len, <=, sizeof(fu->tcp_buf));
+    if (fu->tcp_buf_len < 2 + len)
+        return G_SOURCE_CONTINUE;
+
+    fu->n_tcp_queries++;
+
+    memcpy(&reply[2], &fu->tcp_buf[2], len);
+    fu->tcp_buf_len = 0;
+    len             = _fake_upstream_reply(fu, &reply[2], len, sizeof(reply) - 2, FALSE);
+    unaligned_write_be16(reply, len);
+    g_assert_cmpint(send(fd, reply, 2 + len, MSG_NOSIGNAL), ==, 2 + len);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_fake_upstream_tcp_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    FakeUpstream *fu = user_data;
+    int           conn_fd;
+
+    conn_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (conn_fd < 0)
+        return G_SOURCE_CONTINUE;
+
+    nm_clear_g_source_inst(&fu->tcp_conn_source);
+    nm_clear_fd(&fu->tcp_conn_fd);
+    fu->tcp_conn_fd = conn_fd;
+    fu->tcp_buf_len = 0;
+    fu->tcp_conn_source =
+        nm_g_unix_fd_add_source(conn_fd, G_IO_IN, _fake_upstream_tcp_conn_cb, fu);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+_fake_upstream_start(FakeUpstream *fu, const char *answer)
+{
+    struct sockaddr_in sa = {
+        .sin_family      = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t sa_len = sizeof(sa);
+
+    *fu = (FakeUpstream){
+        .answer      = nmtst_inet4_from_string(answer),
+        .tcp_conn_fd = -1,
+    };
+
+    fu->fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    g_assert_cmpint(fu->fd, >=, 0);
+    g_assert_cmpint(bind(fu->fd, (struct sockaddr *) &sa, sizeof(sa)), ==, 0);
+    g_assert_cmpint(getsockname(fu->fd, (struct sockaddr *) &sa, &sa_len), ==, 0);
+    fu->port   = ntohs(sa.sin_port);
+    fu->source = nm_g_unix_fd_add_source(fu->fd, G_IO_IN, _fake_upstream_cb, fu);
+
+    fu->tcp_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    g_assert_cmpint(fu->tcp_fd, >=, 0);
+    g_assert_cmpint(bind(fu->tcp_fd, (struct sockaddr *) &sa, sizeof(sa)), ==, 0);
+    g_assert_cmpint(listen(fu->tcp_fd, 4), ==, 0);
+    fu->tcp_source = nm_g_unix_fd_add_source(fu->tcp_fd, G_IO_IN, _fake_upstream_tcp_cb, fu);
+}
+
+static void
+_fake_upstream_stop(FakeUpstream *fu)
+{
+    nm_clear_g_source_inst(&fu->source);
+    nm_clear_g_source_inst(&fu->tcp_source);
+    nm_clear_g_source_inst(&fu->tcp_conn_source);
+    nm_close(fu->fd);
+    nm_close(fu->tcp_fd);
+    nm_clear_fd(&fu->tcp_conn_fd);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    /* Over TCP, the reply is prefixed with its length. */
+    guint8 buf[514];
+    gsize  buf_len;
+    gssize reply_len;
+    bool   tcp;
+} Client;
+
+static gboolean
+_client_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    Client *client = user_data;
+    gssize  n;
+
+    if (!client->tcp) {
+        client->reply_len = recv(fd, client->buf, sizeof(client->buf), MSG_DONTWAIT);
+        return G_SOURCE_CONTINUE;
+    }
+
+    n = recv(fd,
+             &client->buf[client->buf_len],
+             sizeof(client->buf) - client->buf_len,
+             MSG_DONTWAIT);
+    g_assert_cmpint(n, >, 0);
+    client->buf_len += n;
+    if (client->buf_len >= 2 && client->buf_len >= 2u + unaligned_read_be16(client->buf)) {
+        client->reply_len = unaligned_read_be16(client->buf);
+        memmove(client->buf, &client->buf[2], client->reply_len);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/* Returns the flags of the reply. */
+static guint16
+_client_query_full(NMDnsStubServer *server,
+                   gboolean         tcp,
+                   const char      *name,
+                   guint16          id,
+                   guint8           expected_rcode,
+                   const char      *expected_answer)
+{
+    nm_auto_destroy_and_unref_gsource GSource *source = NULL;
+    nm_auto_close int                          fd     = -1;
+    gs_strfreev char                         **labels = NULL;
+    Client                                     client = {.reply_len = -1, .tcp = tcp};
+    guint8                                    *reply  = client.buf;
+    struct sockaddr_in                         sa;
+    guint8                                     query[302];
+    guint16                                    flags;
+    gsize                                      pos;
+    gsize                                      i;
+    in_addr_t                                  a;
+
+    sa = (struct sockaddr_in){
+        .sin_family      = AF_INET,
+        .sin_port        = htons(nm_dns_stub_server_get_port(server)),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+
+    /* Leave room for the length prefix of TCP in front. */
+    memset(&query[2], 0, 12);
+    unaligned_write_be16(&query[2], id);
+    unaligned_write_be16(&query[4], 0x0100);
+    unaligned_write_be16(&query[6], 1);
+    pos    = 12;
+    labels = g_strsplit(name, ".", -1);
+    for (i = 0; labels[i]; i++) {
+        gsize l = strlen(labels[i]);
+
+        query[2 + pos++] = l;
+        memcpy(&query[2 + pos], labels[i], l);
+        pos += l;
+    }
+    query[2 + pos++] = 0;
+    unaligned_write_be16(&query[2 + pos], 1);
+    unaligned_write_be16(&query[2 + pos + 2], 1);
+    pos += 4;
+    unaligned_write_be16(&query[0], pos);
+
+    fd = socket(AF_INET, (tcp ? SOCK_STREAM : SOCK_DGRAM) | SOCK_CLOEXEC, 0);
+    g_assert_cmpint(fd, >=, 0);
+    g_assert_cmpint(connect(fd, (struct sockaddr *) &sa, sizeof(sa)), ==, 0);
+    source = nm_g_unix_fd_add_source(fd, G_IO_IN, _client_cb, &client);
+
+    if (tcp)
+        g_assert_cmpint(send(fd, query, 2 + pos, 0), ==, 2 + pos);
+    else
+        g_assert_cmpint(send(fd, &query[2], pos, 0), ==, pos);
+
+    if (!nmtst_main_context_iterate_until(NULL, 5000, client.reply_len >= 0))
+        g_assert_not_reached();
+
+    g_assert_cmpint(client.reply_len, >=, pos);
+    g_assert_cmpint(unaligned_read_be16(&reply[0]), ==, id);
+    flags = unaligned_read_be16(&reply[2]);
+    g_assert_cmpint(flags & 0x000F, ==, expected_rcode);
+
+    /* The reply carries the question as the client sent it. */
+    g_assert(memcmp(&reply[12], &query[2 + 12], pos - 12) == 0);
+
+    if (!expected_answer)
+        return flags;
+
+    g_assert_cmpint(unaligned_read_be16(&reply[6]), ==, 1);
+    g_assert_cmpint(client.reply_len, ==, pos + 16);
+    g_assert_cmpint(unaligned_read_be32(&reply[pos + 6]), <=, 300);
+    memcpy(&a, &reply[pos + 12], 4);
+    nmtst_assert_ip4_address(a, expected_answer);
+    return flags;
+}
+
+static void
+_client_query(NMDnsStubServer *server,
+              const char      *name,
+              guint16          id,
+              guint8           expected_rcode,
+              const char      *expected_answer)
+{
+    _client_query_full(server, FALSE, name, id, expected_rcode, expected_answer);
+}
+
+/*****************************************************************************/
+
+static void
+test_forward_and_cache(void)
+{
+    nm_auto_free_dns_stub_server NMDnsStubServer *server = NULL;
+    gs_free_error GError                         *error  = NULL;
+    FakeUpstream                                  fu;
+    NMDnsStubUpstream                             upstream;
+    NMDnsStubStats                                stats;
+    NMIPAddr                                      listen_addr = NM_IP_ADDR_INIT;
+
+    _fake_upstream_start(&fu, "192.0.2.1");
+
+    listen_addr.addr4 = htonl(INADDR_LOOPBACK);
+    server            = nm_dns_stub_server_new(&listen_addr, 0, 10, &error);
+    nmtst_assert_success(server, error);
+
+    upstream = (NMDnsStubUpstream){
+        .addr.addr4  = htonl(INADDR_LOOPBACK),
+        .addr_family = AF_INET,
+        .port        = fu.port,
+    };
+    nm_dns_stub_server_set_upstreams(server, &upstream, 1);
+
+    _client_query(server, "www.example.com", 0x1234, 0, "192.0.2.1");
+    g_assert_cmpint(fu.n_queries, ==, 1);
+
+    /* Served from the cache, regardless of the case of the name. */
+    _client_query(server, "WWW.Example.com", 0x4321, 0, "192.0.2.1");
+    g_assert_cmpint(fu.n_queries, ==, 1);
+
+    _client_query(server, "other.example.com", 0x1111, 0, "192.0.2.1");
+    g_assert_cmpint(fu.n_queries, ==, 2);
+
+    nm_dns_stub_server_get_stats(server, &stats);
+    g_assert_cmpint(stats.queries, ==, 3);
+    g_assert_cmpint(stats.cache_hits, ==, 1);
+    g_assert_cmpint(stats.forwarded, ==, 2);
+    g_assert_cmpint(stats.cache_entries, ==, 2);
+
+    /* Setting the same upstreams again keeps the cache. */
+    nm_dns_stub_server_set_upstreams(server, &upstream, 1);
+    nm_dns_stub_server_get_stats(server, &stats);
+    g_assert_cmpint(stats.cache_entries, ==, 2);
+
+    /* The cache is bounded. */
+    nm_dns_stub_server_set_cache_size(server, 1);
+    nm_dns_stub_server_get_stats(server, &stats);
+    g_assert_cmpint(stats.cache_entries, ==, 1);
+
+    /* "other" was used last, and is still cached. */
+    _client_query(server, "other.example.com", 0x2222, 0, "192.0.2.1");
+    g_assert_cmpint(fu.n_queries, ==, 2);
+
+    nm_clear_pointer(&server, nm_dns_stub_server_free);
+    _fake_upstream_stop(&fu);
+}
+
+static void
+test_split_dns(void)
+{
+    nm_auto_free_dns_stub_server NMDnsStubServer *server = NULL;
+    gs_free_error GError                         *error  = NULL;
+    FakeUpstream                                  fu_default;
+    FakeUpstream                                  fu_corp;
+    FakeUpstream                                  fu_dead;
+    NMDnsStubUpstream                             upstreams[3];
+    NMIPAddr                                      listen_addr = NM_IP_ADDR_INIT;
+
+    _fake_upstream_start(&fu_default, "192.0.2.1");
+    _fake_upstream_start(&fu_corp, "198.51.100.1");
+    _fake_upstream_start(&fu_dead, "203.0.113.1");
+    fu_dead.drop = TRUE;
+
+    listen_addr.addr4 = htonl(INADDR_LOOPBACK);
+    server            = nm_dns_stub_server_new(&listen_addr, 0, 10, &error);
+    nmtst_assert_success(server, error);
+
+    upstreams[0] = (NMDnsStubUpstream){
+        .addr.addr4  = htonl(INADDR_LOOPBACK),
+        .addr_family = AF_INET,
+        .port        = fu_default.port,
+        .domains     = NM_MAKE_STRV("~."),
+    };
+    upstreams[1] = (NMDnsStubUpstream){
+        .addr.addr4  = htonl(INADDR_LOOPBACK),
+        .addr_family = AF_INET,
+        .port        = fu_dead.port,
+        .domains     = NM_MAKE_STRV("corp.example."),
+    };
+    upstreams[2] = (NMDnsStubUpstream){
+        .addr.addr4  = htonl(INADDR_LOOPBACK),
+        .addr_family = AF_INET,
+        .port        = fu_corp.port,
+        .domains     = NM_MAKE_STRV("~corp.example", "lab.example"),
+    };
+    nm_dns_stub_server_set_upstreams(server, upstreams, G_N_ELEMENTS(upstreams));
+
+    _client_query(server, "www.example.com", 1, 0, "192.0.2.1");
+    g_assert_cmpint(fu_default.n_queries, ==, 1);
+    g_assert_cmpint(fu_corp.n_queries, ==, 0);
+
+    _client_query(server, "corp.example", 2, 0, "198.51.100.1");
+    _client_query(server, "host.lab.example", 3, 0, "198.51.100.1");
+    g_assert_cmpint(fu_default.n_queries, ==, 1);
+    g_assert_cmpint(fu_corp.n_queries, ==, 2);
+
+    /* The first server for "corp.example" doesn't reply, the query fails over. */
+    g_assert_cmpint(fu_dead.n_queries, ==, 1);
+
+    /* A domain that merely ends with the same characters is not a match. */
+    _client_query(server, "notcorp.example", 4, 0, "192.0.2.1");
+    g_assert_cmpint(fu_default.n_queries, ==, 2);
+
+    /* Changing the routing flushes the cache. Without upstreams, queries fail. */
+    nm_dns_stub_server_set_upstreams(server, NULL, 0);
+    _client_query(server, "www.example.com", 5, 2, NULL);
+
+    nm_clear_pointer(&server, nm_dns_stub_server_free);
+    _fake_upstream_stop(&fu_default);
+    _fake_upstream_stop(&fu_corp);
+    _fake_upstream_stop(&fu_dead);
+}
+
+static void
+test_source_ports(void)
+{
+    nm_auto_free_dns_stub_server NMDnsStubServer *server = NULL;
+    gs_free_error GError                         *error  = NULL;
+    FakeUpstream                                  fu;
+    NMDnsStubUpstream                             upstream;
+    NMIPAddr                                      listen_addr = NM_IP_ADDR_INIT;
+    guint                                         n_same      = 0;
+    guint                                         i;
+
+    _fake_upstream_start(&fu, "192.0.2.1");
+
+    listen_addr.addr4 = htonl(INADDR_LOOPBACK);
+    server            = nm_dns_stub_server_new(&listen_addr, 0, 10, &error);
+    nmtst_assert_success(server, error);
+
+    upstream = (NMDnsStubUpstream){
+        .addr.addr4  = htonl(INADDR_LOOPBACK),
+        .addr_family = AF_INET,
+        .port        = fu.port,
+    };
+    nm_dns_stub_server_set_upstreams(server, &upstream, 1);
+
+    for (i = 0; i < G_N_ELEMENTS(fu.src_ports); i++) {
+        gs_free char *name = g_strdup_printf("host%u.example.com", i);
+
+        _client_query(server, name, i + 1, 0, "192.0.2.1");
+    }
+    g_assert_cmpint(fu.n_queries, ==, G_N_ELEMENTS(fu.src_ports));
+
+    /* Every query is sent from a new, random source port. */
+    for (i = 1; i < G_N_ELEMENTS(fu.src_ports); i++) {
+        if (fu.src_ports[i] == fu.src_ports[0])
+            n_same++;
+    }
+    g_assert_cmpint(n_same, <, G_N_ELEMENTS(fu.src_ports) - 1);
+
+    nm_clear_pointer(&server, nm_dns_stub_server_free);
+    _fake_upstream_stop(&fu);
+}
+
+static void
+test_tcp(void)
+{
+    nm_auto_free_dns_stub_server NMDnsStubServer *server = NULL;
+    gs_free_error GError                         *error  = NULL;
+    FakeUpstream                                  fu;
+    NMDnsStubUpstream                             upstream;
+    NMDnsStubStats                                stats;
+    NMIPAddr                                      listen_addr = NM_IP_ADDR_INIT;
+    guint16                                       flags;
+
+    _fake_upstream_start(&fu, "192.0.2.1");
+    fu.truncate = TRUE;
+
+    listen_addr.addr4 = htonl(INADDR_LOOPBACK);
+    server            = nm_dns_stub_server_new(&listen_addr, 0, 10, &error);
+    nmtst_assert_success(server, error);
+
+    upstream = (NMDnsStubUpstream){
+        .addr.addr4  = htonl(INADDR_LOOPBACK),
+        .addr_family = AF_INET,
+        .port        = fu.port,
+    };
+    nm_dns_stub_server_set_upstreams(server, &upstream, 1);
+
+    /* The truncated reply is passed on, and not cached. */
+    flags = _client_query_full(server, FALSE, "big.example.com", 1, 0, NULL);
+    g_assert(flags & 0x0200);
+    g_assert_cmpint(fu.n_queries, ==, 1);
+    nm_dns_stub_server_get_stats(server, &stats);
+    g_assert_cmpint(stats.cache_entries, ==, 0);
+
+    /* The client retries over TCP, which is forwarded over TCP. */
+    flags = _client_query_full(server, TRUE, "big.example.com", 2, 0, "192.0.2.1");
+    g_assert(!(flags & 0x0200));
+    g_assert_cmpint(fu.n_queries, ==, 1);
+    g_assert_cmpint(fu.n_tcp_queries, ==, 1);
+
+    /* The answer over TCP is cached, and also served over TCP. */
+    _client_query_full(server, TRUE, "big.example.com", 3, 0, "192.0.2.1");
+    g_assert_cmpint(fu.n_tcp_queries, ==, 1);
+
+    nm_clear_pointer(&server, nm_dns_stub_server_free);
+    _fake_upstream_stop(&fu);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE();
+
+int
+main(int argc, char **argv)
+{
+    nmtst_init(&argc, &argv, TRUE);
+
+    _nm_logging_enabled_init(g_getenv("NM_DNS_STUB_LOG"));
+
+    g_test_add_func("/dns-stub/forward-and-cache", test_forward_and_cache);
+    g_test_add_func("/dns-stub/split-dns", test_split_dns);
+    g_test_add_func("/dns-stub/source-ports", test_source_ports);
+    g_test_add_func("/dns-stub/tcp", test_tcp);
+
+    return g_test_run();
+}
@@ -1226,6 +1226,50 @@ typedef struct {
 static void
 call_cmd(NmCli *nmc, GTask *task, const NMCCommand *cmd, int argc, const char *const *argv);
 
+static void
+call_cmd_with_client(NmCli             *nmc,
+                     GTask             *task,
+                     const NMCCommand  *cmd,
+                     int                argc,
+                     const char *const *argv)
+{
+    /* Check whether NetworkManager is running */
+    if (cmd->needs_nm_running && !nm_client_get_nm_running(nmc->client)) {
+        g_task_return_new_error(task,
+                                NMCLI_ERROR,
+                                NMC_RESULT_ERROR_NM_NOT_RUNNING,
+                                _("Error: NetworkManager is not running."));
+    } else {
+        cmd->func(cmd, nmc, argc, argv);
+        g_task_return_boolean(task, TRUE);
+    }
+
+    g_object_unref(task);
+}
+
+static void
+got_settings(GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    CmdCall *call = user_data;
+    NmCli   *nmc;
+
+    nmc = g_task_get_task_data(call->task);
+    nmc->should_wait--;
+
+    /* Profiles whose settings could not be fetched are hidden by the client.
+     * That is not fatal for the command, so ignore the error. */
+    nm_client_ensure_connection_settings_finish(NM_CLIENT(source_object), res, NULL);
+
+    call_cmd_with_client(nmc,
+                         g_steal_pointer(&call->task),
+                         call->cmd,
+                         call->argc,
+                         (const char *const *) call->argv);
+
+    g_strfreev(call->argv);
+    nm_g_slice_free(call);
+}
+
 static void
 got_client(GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
@@ -1368,11 +1412,57 @@ dummy_offline_connection(void)
     return connection;
 }
 
+static GPtrArray *
+_cmd_get_connections_to_fetch(NmCli *nmc, const NMCCommand *cmd)
+{
+    GPtrArray       *result;
+    const GPtrArray *arr;
+    guint            i;
+    guint            j;
+
+    if (cmd->needs_all_settings)
+        return g_ptr_array_ref((GPtrArray *) nm_client_get_connections(nmc->client));
+
+    if (!cmd->needs_device_settings)
+        return NULL;
+
+    result = g_ptr_array_new_with_free_func(g_object_unref);
+
+    arr = nm_client_get_devices(nmc->client);
+    for (i = 0; i < arr->len; i++) {
+        const GPtrArray *avail = nm_device_get_available_connections(arr->pdata[i]);
+
+        for (j = 0; avail && j < avail->len; j++) {
+            if (!g_ptr_array_find(result, avail->pdata[j], NULL))
+                g_ptr_array_add(result, g_object_ref(avail->pdata[j]));
+        }
+    }
+
+    arr = nm_client_get_active_connections(nmc->client);
+    for (i = 0; i < arr->len; i++) {
+        NMRemoteConnection *connection = nm_active_connection_get_connection(arr->pdata[i]);
+
+        if (connection && !g_ptr_array_find(result, connection, NULL))
+            g_ptr_array_add(result, g_object_ref(connection));
+    }
+
+    return result;
+}
+
 static void
 call_cmd(NmCli *nmc, GTask *task, const NMCCommand *cmd, int argc, const char *const *argv)
 {
     CmdCall *call;
 
+    if (nmc->batch && (cmd->interactive || cmd->endless)) {
+        g_task_return_new_error(task,
+                                NMCLI_ERROR,
+                                NMC_RESULT_ERROR_USER_INPUT,
+                                _("Error: command is not supported in --batch mode."));
+        g_object_unref(task);
+        return;
+    }
+
     if (nmc->nmc_config.offline) {
         if (!cmd->supports_offline) {
             g_task_return_new_error(task,
@@ -1412,19 +1502,35 @@ call_cmd(NmCli *nmc, GTask *task, const NMCCommand *cmd, int argc, const char *c
             g_task_return_boolean(task, TRUE);
             g_object_unref(task);
         }
-    } else if (nmc->client || !cmd->needs_client) {
-        /* Check whether NetworkManager is running */
-        if (cmd->needs_nm_running && !nm_client_get_nm_running(nmc->client)) {
-            g_task_return_new_error(task,
-                                    NMCLI_ERROR,
-                                    NMC_RESULT_ERROR_NM_NOT_RUNNING,
-                                    _("Error: NetworkManager is not running."));
-        } else {
-            cmd->func(cmd, nmc, argc, argv);
-            g_task_return_boolean(task, TRUE);
+    } else if (nmc->client && cmd->needs_client
+               && NM_FLAGS_HAS(nm_client_get_instance_flags(nmc->client),
+                               NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS)) {
+        gs_unref_ptrarray GPtrArray *connections = NULL;
+
+        /* The client only fetches the settings of the profiles on request.
+         * Fetch those that the command needs with one D-Bus call. Profiles
+         * that are already fetched are skipped by the client. */
+        connections = _cmd_get_connections_to_fetch(nmc, cmd);
+        if (!connections || connections->len == 0) {
+            call_cmd_with_client(nmc, task, cmd, argc, argv);
+            return;
         }
 
-        g_object_unref(task);
+        nmc->should_wait++;
+        call  = g_slice_new(CmdCall);
+        *call = (CmdCall){
+            .cmd  = cmd,
+            .argc = argc,
+            .argv = nm_strv_dup(argv, argc, TRUE),
+            .task = task,
+        };
+        nm_client_ensure_connection_settings_async(nmc->client,
+                                                   connections,
+                                                   NULL,
+                                                   got_settings,
+                                                   call);
+    } else if (nmc->client || !cmd->needs_client) {
+        call_cmd_with_client(nmc, task, cmd, argc, argv);
     } else {
         nm_assert(nmc->client == NULL);
 
@@ -1440,7 +1546,9 @@ call_cmd(NmCli *nmc, GTask *task, const NMCCommand *cmd, int argc, const char *c
                              got_client,
                              call,
                              NM_CLIENT_INSTANCE_FLAGS,
-                             (guint) NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_PERMISSIONS,
+                             (guint) (NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_PERMISSIONS
+                                      | (nmc->batch ? NM_CLIENT_INSTANCE_FLAGS_LAZY_FETCH_SETTINGS
+                                                    : NM_CLIENT_INSTANCE_FLAGS_NONE)),
                              NULL);
     }
 }
@@ -10151,21 +10151,70 @@ void
 nmc_command_func_connection(const NMCCommand *cmd, NmCli *nmc, int argc, const char *const *argv)
 {
     static const NMCCommand cmds[] = {
-        {"show", do_connections_show, usage_connection_show, TRUE, TRUE},
-        {"up", do_connection_up, usage_connection_up, TRUE, TRUE},
-        {"down", do_connection_down, usage_connection_down, TRUE, TRUE},
-        {"add", do_connection_add, usage_connection_add, TRUE, TRUE, TRUE},
-        {"edit", do_connection_edit, usage_connection_edit, TRUE, TRUE},
-        {"delete", do_connection_delete, usage_connection_delete, TRUE, TRUE},
+        {"show",
+         do_connections_show,
+         usage_connection_show,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE},
+        {"up", do_connection_up, usage_connection_up, TRUE, TRUE, .needs_all_settings = TRUE},
+        {"down", do_connection_down, usage_connection_down, TRUE, TRUE, .needs_all_settings = TRUE},
+        {"add",
+         do_connection_add,
+         usage_connection_add,
+         TRUE,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE},
+        {"edit", do_connection_edit, usage_connection_edit, TRUE, TRUE, .interactive = TRUE},
+        {"delete",
+         do_connection_delete,
+         usage_connection_delete,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE},
         {"reload", do_connection_reload, usage_connection_reload, FALSE, FALSE},
-        {"load", do_connection_load, usage_connection_load, TRUE, TRUE},
-        {"modify", do_connection_modify, usage_connection_modify, TRUE, TRUE, TRUE, TRUE},
-        {"clone", do_connection_clone, usage_connection_clone, TRUE, TRUE},
-        {"import", do_connection_import, usage_connection_import, TRUE, TRUE},
-        {"export", do_connection_export, usage_connection_export, TRUE, TRUE},
-        {"migrate", do_connection_migrate, usage_connection_migrate, TRUE, TRUE},
-        {"monitor", do_connection_monitor, usage_connection_monitor, TRUE, TRUE},
-        {NULL, do_connections_show, usage, TRUE, TRUE},
+        {"load", do_connection_load, usage_connection_load, TRUE, TRUE, .needs_all_settings = TRUE},
+        {"modify",
+         do_connection_modify,
+         usage_connection_modify,
+         TRUE,
+         TRUE,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE},
+        {"clone",
+         do_connection_clone,
+         usage_connection_clone,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE},
+        {"import",
+         do_connection_import,
+         usage_connection_import,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE},
+        {"export",
+         do_connection_export,
+         usage_connection_export,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE},
+        {"migrate",
+         do_connection_migrate,
+         usage_connection_migrate,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE},
+        {"monitor",
+         do_connection_monitor,
+         usage_connection_monitor,
+         TRUE,
+         TRUE,
+         .needs_all_settings = TRUE,
+         .endless            = TRUE},
+        {NULL, do_connections_show, usage, TRUE, TRUE, .needs_all_settings = TRUE},
     };
 
     next_arg(nmc, &argc, &argv, NULL);
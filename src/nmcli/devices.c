@@ -4868,10 +4868,15 @@ do_device_wifi_show_password(const NMCCommand *cmd, NmCli *nmc, int argc, const
 
 static NMCCommand device_wifi_cmds[] = {
     {"list", do_device_wifi_list, NULL, TRUE, TRUE},
-    {"connect", do_device_wifi_connect, NULL, TRUE, TRUE},
-    {"hotspot", do_device_wifi_hotspot, NULL, TRUE, TRUE},
+    {"connect", do_device_wifi_connect, NULL, TRUE, TRUE, .needs_all_settings = TRUE},
+    {"hotspot", do_device_wifi_hotspot, NULL, TRUE, TRUE, .needs_all_settings = TRUE},
     {"rescan", do_device_wifi_rescan, NULL, TRUE, TRUE},
-    {"show-password", do_device_wifi_show_password, NULL, TRUE, TRUE},
+    {"show-password",
+     do_device_wifi_show_password,
+     NULL,
+     TRUE,
+     TRUE,
+     .needs_device_settings = TRUE},
     {NULL, do_device_wifi_list, NULL, TRUE, TRUE},
 };
 
@@ -5324,18 +5329,23 @@ nmc_command_func_device(const NMCCommand *cmd, NmCli *nmc, int argc, const char
 {
     static const NMCCommand cmds[] = {
         {"checkpoint", do_device_checkpoint, usage_device_checkpoint, TRUE, TRUE},
-        {"connect", do_device_connect, usage_device_connect, TRUE, TRUE},
+        {"connect",
+         do_device_connect,
+         usage_device_connect,
+         TRUE,
+         TRUE,
+         .needs_device_settings = TRUE},
         {"disconnect", do_devices_disconnect, usage_device_disconnect, TRUE, TRUE},
         {"delete", do_devices_delete, usage_device_delete, TRUE, TRUE},
         {"down", do_devices_disconnect, usage_device_disconnect, TRUE, TRUE},
         {"lldp", do_device_lldp, usage_device_lldp, FALSE, FALSE},
-        {"monitor", do_devices_monitor, usage_device_monitor, TRUE, TRUE},
+        {"monitor", do_devices_monitor, usage_device_monitor, TRUE, TRUE, .endless = TRUE},
         {"modify", do_device_modify, usage_device_modify, TRUE, TRUE},
         {"reapply", do_device_reapply, usage_device_reapply, TRUE, TRUE},
         {"status", do_devices_status, usage_device_status, TRUE, TRUE},
         {"set", do_device_set, usage_device_set, TRUE, TRUE},
-        {"show", do_device_show, usage_device_show, TRUE, TRUE},
-        {"up", do_device_connect, usage_device_connect, TRUE, TRUE},
+        {"show", do_device_show, usage_device_show, TRUE, TRUE, .needs_device_settings = TRUE},
+        {"up", do_device_connect, usage_device_connect, TRUE, TRUE, .needs_device_settings = TRUE},
         {"wifi", do_device_wifi, usage_device_wifi, FALSE, FALSE},
         {NULL, do_devices_status, usage, TRUE, TRUE},
     };
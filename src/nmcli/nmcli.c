@@ -244,6 +244,7 @@ usage(void)
         "\n"
         "OPTIONS\n"
         "  -a, --ask                                ask for missing parameters\n"
+        "  -b, --batch                              run the commands read from stdin\n"
         "  -c, --colors auto|yes|no                 whether to use colors in output\n"
         "  -e, --escape yes|no                      escape columns separators in values\n"
         "  -f, --fields <field,...>|all|common      specify fields to output\n"
@@ -720,19 +721,20 @@ set_colors(NmcColorOption   color_option,
 
 /*************************************************************************************/
 
+static const NMCCommand nmcli_cmds[] = {
+    {"general", nmc_command_func_general, NULL, FALSE, FALSE},
+    {"monitor", nmc_command_func_monitor, NULL, TRUE, FALSE, .endless = TRUE},
+    {"networking", nmc_command_func_networking, NULL, FALSE, FALSE},
+    {"radio", nmc_command_func_radio, NULL, FALSE, FALSE},
+    {"connection", nmc_command_func_connection, NULL, FALSE, FALSE, TRUE},
+    {"device", nmc_command_func_device, NULL, FALSE, FALSE},
+    {"agent", nmc_command_func_agent, NULL, FALSE, FALSE, .interactive = TRUE},
+    {NULL, nmc_command_func_overview, usage, TRUE, TRUE},
+};
+
 static gboolean
 process_command_line(NmCli *nmc, int argc, char **argv_orig)
 {
-    static const NMCCommand nmcli_cmds[] = {
-        {"general", nmc_command_func_general, NULL, FALSE, FALSE},
-        {"monitor", nmc_command_func_monitor, NULL, TRUE, FALSE},
-        {"networking", nmc_command_func_networking, NULL, FALSE, FALSE},
-        {"radio", nmc_command_func_radio, NULL, FALSE, FALSE},
-        {"connection", nmc_command_func_connection, NULL, FALSE, FALSE, TRUE},
-        {"device", nmc_command_func_device, NULL, FALSE, FALSE},
-        {"agent", nmc_command_func_agent, NULL, FALSE, FALSE},
-        {NULL, nmc_command_func_overview, usage, TRUE, TRUE},
-    };
     NmcColorOption     colors = NMC_USE_COLOR_AUTO;
     const char        *base;
     const char *const *argv;
@@ -763,6 +765,7 @@ process_command_line(NmCli *nmc, int argc, char **argv_orig)
 
         if (argc == 1 && nmc->complete) {
             nmc_complete_strings(argv[0],
+                                 "--batch",
                                  "--overview",
                                  "--offline",
                                  "--terse",
@@ -784,7 +787,9 @@ process_command_line(NmCli *nmc, int argc, char **argv_orig)
             break;
         }
 
-        if (matches_arg(nmc, &argc, &argv, "-overview", NULL)) {
+        if (matches_arg(nmc, &argc, &argv, "-batch", NULL)) {
+            nmc->batch = TRUE;
+        } else if (matches_arg(nmc, &argc, &argv, "-overview", NULL)) {
             nmc->nmc_config_mutable.overview = TRUE;
         } else if (matches_arg(nmc, &argc, &argv, "-offline", NULL)) {
             nmc->nmc_config_mutable.offline = TRUE;
@@ -919,12 +924,186 @@ process_command_line(NmCli *nmc, int argc, char **argv_orig)
                &nmc->palette_buffer,
                &nmc->nmc_config_mutable.palette);
 
+    if (nmc->batch && !nmc->complete) {
+        if (argc > 0) {
+            g_string_printf(nmc->return_text,
+                            _("Error: Option '--batch' doesn't accept a command, got '%s'."),
+                            argv[0]);
+            nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+            return FALSE;
+        }
+        if (nmc->nmc_config.offline) {
+            g_string_printf(nmc->return_text,
+                            _("Error: Option '--batch' is mutually exclusive with '--offline'."));
+            nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+            return FALSE;
+        }
+        if (nmc->ask) {
+            /* The commands are read from stdin, so we cannot prompt there. */
+            g_string_printf(nmc->return_text,
+                            _("Error: Option '--batch' is mutually exclusive with '--ask'."));
+            nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+            return FALSE;
+        }
+
+        /* The commands are run by run_batch(). */
+        return TRUE;
+    }
+
     /* Now run the requested command */
     nmc_do_cmd(nmc, nmcli_cmds, *argv, argc, argv);
 
     return TRUE;
 }
 
+/*****************************************************************************/
+
+static gboolean
+_batch_stdin_ready_cb(int fd, GIOCondition condition, gpointer user_data)
+{
+    g_main_loop_quit(loop);
+    return G_SOURCE_CONTINUE;
+}
+
+/* Returns the next line from standard input, or %NULL at the end of the input
+ * or when interrupted by a signal. The input is awaited in the main loop, so
+ * that the signal handlers can run. @buf keeps what was read past the line. */
+static char *
+_batch_read_line(NmCli *nmc, GString *buf, gboolean *p_eof)
+{
+    for (;;) {
+        GSource    *source;
+        const char *nl;
+        char        chunk[4096];
+        gssize      n;
+
+        nl = memchr(buf->str, '\n', buf->len);
+        if (nl) {
+            char *line = g_strndup(buf->str, nl - buf->str);
+
+            g_string_erase(buf, 0, (nl - buf->str) + 1);
+            return line;
+        }
+
+        if (*p_eof) {
+            char *line;
+
+            if (buf->len == 0)
+                return NULL;
+            line = g_strndup(buf->str, buf->len);
+            g_string_truncate(buf, 0);
+            return line;
+        }
+
+        source = nm_g_unix_fd_add_source(STDIN_FILENO,
+                                         G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                         _batch_stdin_ready_cb,
+                                         NULL);
+        g_main_loop_run(loop);
+        nm_clear_g_source_inst(&source);
+
+        if (nmc->return_value >= 0x80) {
+            /* Terminated by a signal. */
+            return NULL;
+        }
+
+        n = read(STDIN_FILENO, chunk, sizeof(chunk));
+        if (n > 0)
+            g_string_append_len(buf, chunk, n);
+        else if (n == 0 || !NM_IN_SET(errno, EINTR, EAGAIN))
+            *p_eof = TRUE;
+    }
+}
+
+static void
+run_batch(NmCli *nmc)
+{
+    const NmcConfig               nmc_config      = nmc->nmc_config;
+    const bool                    mode_specified  = nmc->mode_specified;
+    gs_free char                 *required_fields = g_steal_pointer(&nmc->required_fields);
+    gs_unref_ptrarray GPtrArray  *argvs           = NULL;
+    nm_auto_free_gstring GString *buf             = NULL;
+    gboolean                      eof             = FALSE;
+    NMCResultCode                 return_value    = NMC_RESULT_SUCCESS;
+    guint                         n_failed        = 0;
+
+    argvs = g_ptr_array_new_with_free_func((GDestroyNotify) g_strfreev);
+    buf   = g_string_new(NULL);
+
+    for (;;) {
+        gs_free_error GError *error = NULL;
+        gs_free char         *line  = NULL;
+        char                **cmd_argv;
+        int                   cmd_argc;
+
+        line = _batch_read_line(nmc, buf, &eof);
+        if (!line)
+            break;
+
+        g_strstrip(line);
+        if (NM_IN_SET(line[0], '\0', '#'))
+            continue;
+
+        if (!g_shell_parse_argv(line, &cmd_argc, &cmd_argv, &error)) {
+            g_string_printf(nmc->return_text,
+                            _("Error: invalid command '%s': %s"),
+                            line,
+                            error->message);
+            nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+        } else {
+            /* The commands may modify the global options. Start each of them
+             * with the options from the command line. */
+            nmc->nmc_config_mutable = nmc_config;
+            nmc->mode_specified     = mode_specified;
+            nmc->required_fields    = g_strdup(required_fields);
+            nmc->return_value       = NMC_RESULT_SUCCESS;
+            g_string_assign(nmc->return_text, _("Success"));
+
+            /* The command handlers may keep pointers to the arguments until
+             * the end. */
+            g_ptr_array_add(argvs, cmd_argv);
+
+            nmc_do_cmd(nmc, nmcli_cmds, cmd_argv[0], cmd_argc, (const char *const *) cmd_argv);
+            g_main_loop_run(loop);
+
+            /* Dispatch what is still pending, like the completion of the parent
+             * command or queued D-Bus signals. The next command then sees an
+             * up-to-date client cache. */
+            while (g_main_context_iteration(NULL, FALSE)) {}
+
+            /* The command owns its copy and may have freed it already. */
+            nm_clear_g_free(&nmc->required_fields);
+        }
+
+        fflush(stdout);
+
+        if (nmc->return_value >= 0x80) {
+            /* Terminated by a signal. main() prints the reason. */
+            return;
+        }
+
+        if (nmc->return_value != NMC_RESULT_SUCCESS) {
+            nmc_printerr("%s\n", nmc->return_text->str);
+            if (return_value == NMC_RESULT_SUCCESS)
+                return_value = nmc->return_value;
+            n_failed++;
+        }
+    }
+
+    if (nmc->return_value >= 0x80) {
+        /* Interrupted while waiting for the next command. */
+        return;
+    }
+
+    nmc->return_value = return_value;
+    if (n_failed > 0) {
+        g_string_printf(nmc->return_text,
+                        _("Error: %u command(s) failed, the first with exit status %d."),
+                        n_failed,
+                        (int) return_value);
+    }
+}
+
 static gboolean nmcli_sigint = FALSE;
 
 gboolean
@@ -1040,8 +1219,12 @@ main(int argc, char *argv[])
     g_unix_signal_add(SIGTERM, signal_handler, GINT_TO_POINTER(SIGTERM));
     g_unix_signal_add(SIGINT, signal_handler, GINT_TO_POINTER(SIGINT));
 
-    if (process_command_line(&nm_cli, argc, argv))
-        g_main_loop_run(loop);
+    if (process_command_line(&nm_cli, argc, argv)) {
+        if (nm_cli.batch && !nm_cli.complete)
+            run_batch(&nm_cli);
+        else
+            g_main_loop_run(loop);
+    }
 
     if (nm_cli.complete) {
         /* Remove error statuses from command completion runs. */
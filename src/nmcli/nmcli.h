@@ -193,6 +193,9 @@ typedef struct _NmCli {
     /* Whether to ask for confirmation on saving connections with 'autoconnect=yes' */
     bool editor_save_confirmation : 1;
 
+    /* Read commands from stdin and run them with one client instance: option '--batch' */
+    bool batch : 1;
+
     union {
         const NmcConfig nmc_config;
         NmcConfig       nmc_config_mutable;
@@ -250,6 +253,20 @@ typedef struct _NMCCommand {
 
     /* With --online, read in a keyfile from standard input before dispatching the handler. */
     bool needs_offline_conn : 1;
+
+    /* With --batch, fetch the settings of all profiles before dispatching the handler.
+     * Looking up a profile by id or uuid requires them. */
+    bool needs_all_settings : 1;
+
+    /* With --batch, fetch the settings of the profiles of the devices (the available and
+     * active ones) before dispatching the handler. */
+    bool needs_device_settings : 1;
+
+    /* The handler reads from standard input, so it is not available with --batch. */
+    bool interactive : 1;
+
+    /* The handler runs until interrupted, so it is not available with --batch. */
+    bool endless : 1;
 } NMCCommand;
 
 void nmc_command_func_agent(const NMCCommand *cmd, NmCli *nmc, int argc, const char *const *argv);
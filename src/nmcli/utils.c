@@ -125,11 +125,13 @@ colorize_string(const NmcConfig *nmc_config, NMMetaColor color, const char *str,
 static gboolean
 parse_global_arg(NmCli *nmc, const char *arg)
 {
-    if (nmc_arg_is_option(arg, "ask"))
-        nmc->ask = TRUE;
-    else if (nmc_arg_is_option(arg, "show-secrets"))
+    if (nmc_arg_is_option(arg, "ask")) {
+        /* With --batch, the commands are read from stdin. Never prompt there. */
+        if (!nmc->batch)
+            nmc->ask = TRUE;
+    } else if (nmc_arg_is_option(arg, "show-secrets")) {
         nmc->nmc_config_mutable.show_secrets = TRUE;
-    else
+    } else
         return FALSE;
 
     return TRUE;
@@ -992,21 +994,11 @@ _print_data_cell_clear(gpointer cell_p)
     _print_data_cell_clear_text(cell);
 }
 
-static void
-_print_fill(const NmcConfig    *nmc_config,
-            gpointer const     *targets,
-            gpointer            targets_data,
-            const PrintDataCol *cols,
-            guint               cols_len,
-            GArray            **out_header_row,
-            GArray            **out_cells)
+static GArray *
+_print_fill_header(const NmcConfig *nmc_config, const PrintDataCol *cols, guint cols_len)
 {
-    GArray                *cells;
-    GArray                *header_row;
-    guint                  i_row, i_col;
-    guint                  targets_len;
-    NMMetaAccessorGetType  text_get_type;
-    NMMetaAccessorGetFlags text_get_flags;
+    GArray *header_row;
+    guint   i_col;
 
     header_row = g_array_sized_new(FALSE, TRUE, sizeof(PrintDataHeaderCell), cols_len);
     g_array_set_clear_func(header_row, _print_data_header_cell_clear);
@@ -1048,102 +1040,134 @@ _print_fill(const NmcConfig    *nmc_config,
         }
     }
 
-    targets_len = NM_PTRARRAY_LEN(targets);
+    return header_row;
+}
 
-    cells = g_array_sized_new(FALSE, TRUE, sizeof(PrintDataCell), targets_len * header_row->len);
-    g_array_set_clear_func(cells, _print_data_cell_clear);
-    g_array_set_size(cells, targets_len * header_row->len);
+static void
+_print_fill_cell(const NmcConfig     *nmc_config,
+                 gpointer             target,
+                 gpointer             targets_data,
+                 guint                i_row,
+                 PrintDataHeaderCell *header_cell,
+                 PrintDataCell       *cell)
+{
+    char                     *to_free = NULL;
+    const NMMetaAbstractInfo *info;
+    NMMetaAccessorGetType     text_get_type;
+    NMMetaAccessorGetFlags    text_get_flags;
+    NMMetaAccessorGetOutFlags text_out_flags, color_out_flags;
+    gconstpointer             value;
+    gboolean                  is_default;
 
     text_get_type  = nmc_print_output_to_accessor_get_type(nmc_config->print_output);
     text_get_flags = NM_META_ACCESSOR_GET_FLAGS_ACCEPT_STRV;
     if (nmc_config->show_secrets)
         text_get_flags |= NM_META_ACCESSOR_GET_FLAGS_SHOW_SECRETS;
 
+    info = header_cell->col->selection_item->info;
+
+    cell->row_idx     = i_row;
+    cell->header_cell = header_cell;
+
+    value = nm_meta_abstract_info_get(info,
+                                      nmc_meta_environment,
+                                      (gpointer) nmc_meta_environment_arg,
+                                      target,
+                                      targets_data,
+                                      text_get_type,
+                                      text_get_flags,
+                                      &text_out_flags,
+                                      &is_default,
+                                      (gpointer *) &to_free);
+
+    nm_assert(!to_free || value == to_free);
+
+    if ((is_default && nmc_config->overview)
+        || NM_FLAGS_HAS(text_out_flags, NM_META_ACCESSOR_GET_OUT_FLAGS_HIDE)) {
+        /* don't mark the entry for display. This is to shorten the output in case
+         * the property is the default value. But we only do that, if the user
+         * opts in to this behavior (-overview), or of the property marks itself
+         * eligible to be hidden.
+         *
+         * In general, only new API shall mark itself eligible to be hidden.
+         * Long established properties cannot, because it would be a change
+         * in behavior. */
+    } else
+        header_cell->to_print = TRUE;
+
+    if (NM_FLAGS_HAS(text_out_flags, NM_META_ACCESSOR_GET_OUT_FLAGS_STRV)) {
+        if (nmc_config->multiline_output) {
+            cell->text_format  = PRINT_DATA_CELL_FORMAT_TYPE_STRV;
+            cell->text.strv    = value;
+            cell->text_to_free = !!to_free;
+        } else {
+            if (value && ((const char *const *) value)[0]) {
+                cell->text.plain   = g_strjoinv(" | ", (char **) value);
+                cell->text_to_free = TRUE;
+            }
+            if (to_free)
+                g_strfreev(NM_CAST_ALIGN(char *, to_free));
+        }
+    } else {
+        cell->text.plain   = value;
+        cell->text_to_free = !!to_free;
+    }
+
+    cell->color = GPOINTER_TO_INT(nm_meta_abstract_info_get(info,
+                                                            nmc_meta_environment,
+                                                            (gpointer) nmc_meta_environment_arg,
+                                                            target,
+                                                            targets_data,
+                                                            NM_META_ACCESSOR_GET_TYPE_COLOR,
+                                                            NM_META_ACCESSOR_GET_FLAGS_NONE,
+                                                            &color_out_flags,
+                                                            NULL,
+                                                            NULL));
+
+    if (cell->text_format == PRINT_DATA_CELL_FORMAT_TYPE_PLAIN) {
+        if (NM_IN_SET(nmc_config->print_output, NMC_PRINT_NORMAL, NMC_PRINT_PRETTY)
+            && (!cell->text.plain || !cell->text.plain[0])) {
+            _print_data_cell_clear_text(cell);
+            cell->text.plain = "--";
+        } else if (!cell->text.plain)
+            cell->text.plain = "";
+        nm_assert(cell->text_format == PRINT_DATA_CELL_FORMAT_TYPE_PLAIN);
+    }
+}
+
+static void
+_print_fill(const NmcConfig    *nmc_config,
+            gpointer const     *targets,
+            gpointer            targets_data,
+            const PrintDataCol *cols,
+            guint               cols_len,
+            GArray            **out_header_row,
+            GArray            **out_cells)
+{
+    GArray *cells;
+    GArray *header_row;
+    guint   i_row, i_col;
+    guint   targets_len;
+
+    header_row = _print_fill_header(nmc_config, cols, cols_len);
+
+    targets_len = NM_PTRARRAY_LEN(targets);
+
+    cells = g_array_sized_new(FALSE, TRUE, sizeof(PrintDataCell), targets_len * header_row->len);
+    g_array_set_clear_func(cells, _print_data_cell_clear);
+    g_array_set_size(cells, targets_len * header_row->len);
+
     for (i_row = 0; i_row < targets_len; i_row++) {
-        gpointer       target = targets[i_row];
         PrintDataCell *cells_line =
             &nm_g_array_index(cells, PrintDataCell, i_row * header_row->len);
 
         for (i_col = 0; i_col < header_row->len; i_col++) {
-            char                     *to_free = NULL;
-            PrintDataCell            *cell    = &cells_line[i_col];
-            PrintDataHeaderCell      *header_cell;
-            const NMMetaAbstractInfo *info;
-            NMMetaAccessorGetOutFlags text_out_flags, color_out_flags;
-            gconstpointer             value;
-            gboolean                  is_default;
-
-            header_cell = &nm_g_array_index(header_row, PrintDataHeaderCell, i_col);
-            info        = header_cell->col->selection_item->info;
-
-            cell->row_idx     = i_row;
-            cell->header_cell = header_cell;
-
-            value = nm_meta_abstract_info_get(info,
-                                              nmc_meta_environment,
-                                              (gpointer) nmc_meta_environment_arg,
-                                              target,
-                                              targets_data,
-                                              text_get_type,
-                                              text_get_flags,
-                                              &text_out_flags,
-                                              &is_default,
-                                              (gpointer *) &to_free);
-
-            nm_assert(!to_free || value == to_free);
-
-            if ((is_default && nmc_config->overview)
-                || NM_FLAGS_HAS(text_out_flags, NM_META_ACCESSOR_GET_OUT_FLAGS_HIDE)) {
-                /* don't mark the entry for display. This is to shorten the output in case
-                 * the property is the default value. But we only do that, if the user
-                 * opts in to this behavior (-overview), or of the property marks itself
-                 * eligible to be hidden.
-                 *
-                 * In general, only new API shall mark itself eligible to be hidden.
-                 * Long established properties cannot, because it would be a change
-                 * in behavior. */
-            } else
-                header_cell->to_print = TRUE;
-
-            if (NM_FLAGS_HAS(text_out_flags, NM_META_ACCESSOR_GET_OUT_FLAGS_STRV)) {
-                if (nmc_config->multiline_output) {
-                    cell->text_format  = PRINT_DATA_CELL_FORMAT_TYPE_STRV;
-                    cell->text.strv    = value;
-                    cell->text_to_free = !!to_free;
-                } else {
-                    if (value && ((const char *const *) value)[0]) {
-                        cell->text.plain   = g_strjoinv(" | ", (char **) value);
-                        cell->text_to_free = TRUE;
-                    }
-                    if (to_free)
-                        g_strfreev(NM_CAST_ALIGN(char *, to_free));
-                }
-            } else {
-                cell->text.plain   = value;
-                cell->text_to_free = !!to_free;
-            }
-
-            cell->color =
-                GPOINTER_TO_INT(nm_meta_abstract_info_get(info,
-                                                          nmc_meta_environment,
-                                                          (gpointer) nmc_meta_environment_arg,
-                                                          target,
-                                                          targets_data,
-                                                          NM_META_ACCESSOR_GET_TYPE_COLOR,
-                                                          NM_META_ACCESSOR_GET_FLAGS_NONE,
-                                                          &color_out_flags,
-                                                          NULL,
-                                                          NULL));
-
-            if (cell->text_format == PRINT_DATA_CELL_FORMAT_TYPE_PLAIN) {
-                if (NM_IN_SET(nmc_config->print_output, NMC_PRINT_NORMAL, NMC_PRINT_PRETTY)
-                    && (!cell->text.plain || !cell->text.plain[0])) {
-                    _print_data_cell_clear_text(cell);
-                    cell->text.plain = "--";
-                } else if (!cell->text.plain)
-                    cell->text.plain = "";
-                nm_assert(cell->text_format == PRINT_DATA_CELL_FORMAT_TYPE_PLAIN);
-            }
+            _print_fill_cell(nmc_config,
+                             targets[i_row],
+                             targets_data,
+                             i_row,
+                             &nm_g_array_index(header_row, PrintDataHeaderCell, i_col),
+                             &cells_line[i_col]);
         }
     }
 
@@ -1219,19 +1243,15 @@ _print_skip_column(const NmcConfig *nmc_config, const PrintDataHeaderCell *heade
 }
 
 static void
-_print_do(const NmcConfig           *nmc_config,
-          const char                *header_name_no_l10n,
-          guint                      col_len,
-          guint                      row_len,
-          const PrintDataHeaderCell *header_row,
-          const PrintDataCell       *cells)
+_print_do_header(const NmcConfig           *nmc_config,
+                 const char                *header_name_no_l10n,
+                 guint                      col_len,
+                 const PrintDataHeaderCell *header_row,
+                 GString                   *str)
 {
-    int                           width1, width2;
-    int                           table_width = 0;
-    guint                         i_row, i_col;
-    nm_auto_free_gstring GString *str = NULL;
-
-    g_return_if_fail(col_len);
+    int   width1, width2;
+    int   table_width = 0;
+    guint i_col;
 
     /* Main header */
     if (nmc_config->print_output == NMC_PRINT_PRETTY && header_name_no_l10n) {
@@ -1256,8 +1276,6 @@ _print_do(const NmcConfig           *nmc_config,
         nmc_print("%s\n", line);
     }
 
-    str = !nmc_config->multiline_output ? g_string_sized_new(100) : NULL;
-
     /* print the header for the tabular form */
     if (NM_IN_SET(nmc_config->print_output, NMC_PRINT_NORMAL, NMC_PRINT_PRETTY)
         && !nmc_config->multiline_output) {
@@ -1293,96 +1311,224 @@ _print_do(const NmcConfig           *nmc_config,
             nmc_print("%s\n", (line = g_strnfill(table_width, '-')));
         }
     }
+}
 
-    for (i_row = 0; i_row < row_len; i_row++) {
-        const PrintDataCell *current_line = &cells[i_row * col_len];
+static void
+_print_do_row(const NmcConfig           *nmc_config,
+              guint                      col_len,
+              const PrintDataHeaderCell *header_row,
+              const PrintDataCell       *current_line,
+              GString                   *str)
+{
+    int   width1, width2;
+    guint i_col;
 
-        for (i_col = 0; i_col < col_len; i_col++) {
-            const PrintDataCell *cell  = &current_line[i_col];
-            const char *const   *lines = NULL;
-            guint                i_lines, lines_len;
+    for (i_col = 0; i_col < col_len; i_col++) {
+        const PrintDataCell *cell  = &current_line[i_col];
+        const char *const   *lines = NULL;
+        guint                i_lines, lines_len;
 
-            if (_print_skip_column(nmc_config, cell->header_cell))
-                continue;
+        if (_print_skip_column(nmc_config, cell->header_cell))
+            continue;
 
-            lines_len = 0;
-            switch (cell->text_format) {
-            case PRINT_DATA_CELL_FORMAT_TYPE_PLAIN:
-                lines     = &cell->text.plain;
-                lines_len = 1;
-                break;
-            case PRINT_DATA_CELL_FORMAT_TYPE_STRV:
-                nm_assert(nmc_config->multiline_output);
-                lines     = cell->text.strv;
-                lines_len = NM_PTRARRAY_LEN(lines);
-                break;
-            }
+        lines_len = 0;
+        switch (cell->text_format) {
+        case PRINT_DATA_CELL_FORMAT_TYPE_PLAIN:
+            lines     = &cell->text.plain;
+            lines_len = 1;
+            break;
+        case PRINT_DATA_CELL_FORMAT_TYPE_STRV:
+            nm_assert(nmc_config->multiline_output);
+            lines     = cell->text.strv;
+            lines_len = NM_PTRARRAY_LEN(lines);
+            break;
+        }
 
-            for (i_lines = 0; i_lines < lines_len; i_lines++) {
-                gs_free char *text_to_free = NULL;
-                const char   *text;
+        for (i_lines = 0; i_lines < lines_len; i_lines++) {
+            gs_free char *text_to_free = NULL;
+            const char   *text;
 
-                text = colorize_string(nmc_config, cell->color, lines[i_lines], &text_to_free);
-                if (nmc_config->multiline_output) {
-                    gs_free char *prefix = NULL;
+            text = colorize_string(nmc_config, cell->color, lines[i_lines], &text_to_free);
+            if (nmc_config->multiline_output) {
+                gs_free char *prefix = NULL;
 
-                    if (cell->text_format == PRINT_DATA_CELL_FORMAT_TYPE_STRV)
-                        prefix = g_strdup_printf("%s[%u]:", cell->header_cell->title, i_lines + 1);
-                    else
-                        prefix = g_strdup_printf("%s:", cell->header_cell->title);
-                    width1 = strlen(prefix);
-                    width2 = nmc_string_screen_width(prefix, NULL);
-                    nmc_print("%-*s%s\n",
-                              (int) (nmc_config->print_output == NMC_PRINT_TERSE
-                                         ? 0
-                                         : ML_VALUE_INDENT + width1 - width2),
-                              prefix,
-                              text);
+                if (cell->text_format == PRINT_DATA_CELL_FORMAT_TYPE_STRV)
+                    prefix = g_strdup_printf("%s[%u]:", cell->header_cell->title, i_lines + 1);
+                else
+                    prefix = g_strdup_printf("%s:", cell->header_cell->title);
+                width1 = strlen(prefix);
+                width2 = nmc_string_screen_width(prefix, NULL);
+                nmc_print("%-*s%s\n",
+                          (int) (nmc_config->print_output == NMC_PRINT_TERSE
+                                     ? 0
+                                     : ML_VALUE_INDENT + width1 - width2),
+                          prefix,
+                          text);
+            } else {
+                if (nmc_config->print_output == NMC_PRINT_TERSE) {
+                    if (nmc_config->escape_values) {
+                        const char *p = text;
+                        while (*p) {
+                            if (*p == ':' || *p == '\\')
+                                g_string_append_c(str, '\\'); /* Escaping by '\' */
+                            g_string_append_c(str, *p);
+                            p++;
+                        }
+                    } else
+                        g_string_append_printf(str, "%s", text);
+                    g_string_append_c(str, ':'); /* Column separator */
                 } else {
-                    nm_assert(str);
-                    if (nmc_config->print_output == NMC_PRINT_TERSE) {
-                        if (nmc_config->escape_values) {
-                            const char *p = text;
-                            while (*p) {
-                                if (*p == ':' || *p == '\\')
-                                    g_string_append_c(str, '\\'); /* Escaping by '\' */
-                                g_string_append_c(str, *p);
-                                p++;
-                            }
-                        } else
-                            g_string_append_printf(str, "%s", text);
-                        g_string_append_c(str, ':'); /* Column separator */
-                    } else {
-                        const PrintDataHeaderCell *header_cell = &header_row[i_col];
-
-                        width1 = strlen(text);
-                        width2 = nmc_string_screen_width(
-                            text,
-                            NULL); /* Width of the string (in screen columns) */
-                        g_string_append_printf(str,
-                                               "%-*s",
-                                               (int) (header_cell->width + width1 - width2),
-                                               text);
-                        g_string_append_c(str, ' '); /* Column separator */
-                        table_width += header_cell->width + width1 - width2 + 1;
-                    }
+                    const PrintDataHeaderCell *header_cell = &header_row[i_col];
+
+                    width1 = strlen(text);
+                    width2 = nmc_string_screen_width(
+                        text,
+                        NULL); /* Width of the string (in screen columns) */
+                    g_string_append_printf(str,
+                                           "%-*s",
+                                           (int) (header_cell->width + width1 - width2),
+                                           text);
+                    g_string_append_c(str, ' '); /* Column separator */
                 }
             }
         }
+    }
+
+    if (!nmc_config->multiline_output) {
+        if (str->len)
+            g_string_truncate(str, str->len - 1); /* Chop off last column separator */
+        nmc_print("%s\n", str->str);
+
+        g_string_truncate(str, 0);
+    }
+
+    if (nmc_config->print_output == NMC_PRINT_PRETTY && nmc_config->multiline_output) {
+        gs_free char *line = NULL;
+
+        nmc_print("%s\n", (line = g_strnfill(ML_HEADER_WIDTH, '-')));
+    }
+}
+
+static void
+_print_do(const NmcConfig           *nmc_config,
+          const char                *header_name_no_l10n,
+          guint                      col_len,
+          guint                      row_len,
+          const PrintDataHeaderCell *header_row,
+          const PrintDataCell       *cells)
+{
+    nm_auto_free_gstring GString *str = NULL;
+    guint                         i_row;
+
+    g_return_if_fail(col_len);
+
+    str = g_string_sized_new(100);
+
+    _print_do_header(nmc_config, header_name_no_l10n, col_len, header_row, str);
+
+    for (i_row = 0; i_row < row_len; i_row++)
+        _print_do_row(nmc_config, col_len, header_row, &cells[i_row * col_len], str);
+}
+
+static gboolean
+_print_can_stream(const NmcConfig *nmc_config)
+{
+    /* Only the tabular output of the normal and pretty modes aligns the
+     * columns, which requires all cells upfront. The other modes don't
+     * use the column width, and can print each row as soon as it is
+     * computed. */
+    return nmc_config->print_output == NMC_PRINT_TERSE || nmc_config->multiline_output;
+}
+
+static void
+_print_stream(const NmcConfig    *nmc_config,
+              gpointer const     *targets,
+              gpointer            targets_data,
+              const char         *header_name_no_l10n,
+              const PrintDataCol *cols,
+              guint               cols_len)
+{
+    nm_auto_free_gstring GString *str        = NULL;
+    gs_unref_array GArray        *header_row = NULL;
+    gs_unref_array GArray        *cells      = NULL;
+    guint                         targets_len;
+    guint                         n_undecided;
+    guint                         n_rows_filled;
+    guint                         i_row, i_col;
+
+    header_row = _print_fill_header(nmc_config, cols, cols_len);
 
-        if (!nmc_config->multiline_output) {
-            if (str->len)
-                g_string_truncate(str, str->len - 1); /* Chop off last column separator */
-            nmc_print("%s\n", str->str);
+    g_return_if_fail(header_row->len);
+
+    targets_len = NM_PTRARRAY_LEN(targets);
 
-            g_string_truncate(str, 0);
+    cells = g_array_new(FALSE, TRUE, sizeof(PrintDataCell));
+    g_array_set_clear_func(cells, _print_data_cell_clear);
+
+    /* A column is only skipped if none of its cells opt-in to be printed.
+     * Fill rows until all the columns are decided, and keep these rows for
+     * printing. Usually the first row already decides all the columns. */
+    n_undecided = header_row->len;
+    for (i_row = 0; i_row < targets_len && n_undecided > 0; i_row++) {
+        PrintDataCell *cells_row;
+
+        g_array_set_size(cells, (i_row + 1) * header_row->len);
+        cells_row   = &nm_g_array_index(cells, PrintDataCell, i_row * header_row->len);
+        n_undecided = 0;
+        for (i_col = 0; i_col < header_row->len; i_col++) {
+            PrintDataHeaderCell *header_cell =
+                &nm_g_array_index(header_row, PrintDataHeaderCell, i_col);
+
+            _print_fill_cell(nmc_config,
+                             targets[i_row],
+                             targets_data,
+                             i_row,
+                             header_cell,
+                             &cells_row[i_col]);
+            if (!header_cell->to_print)
+                n_undecided++;
         }
+    }
+    n_rows_filled = i_row;
+
+    str = g_string_sized_new(100);
+
+    _print_do_header(nmc_config,
+                     header_name_no_l10n,
+                     header_row->len,
+                     nm_g_array_first_p(header_row, PrintDataHeaderCell),
+                     str);
+
+    for (i_row = 0; i_row < n_rows_filled; i_row++) {
+        _print_do_row(nmc_config,
+                      header_row->len,
+                      nm_g_array_first_p(header_row, PrintDataHeaderCell),
+                      &nm_g_array_index(cells, PrintDataCell, i_row * header_row->len),
+                      str);
+    }
 
-        if (nmc_config->print_output == NMC_PRINT_PRETTY && nmc_config->multiline_output) {
-            gs_free char *line = NULL;
+    /* The remaining rows are printed as they are filled, reusing the
+     * cells of the first row. */
+    g_array_set_size(cells, header_row->len);
 
-            nmc_print("%s\n", (line = g_strnfill(ML_HEADER_WIDTH, '-')));
+    for (; i_row < targets_len; i_row++) {
+        for (i_col = 0; i_col < header_row->len; i_col++) {
+            PrintDataCell *cell = &nm_g_array_index(cells, PrintDataCell, i_col);
+
+            _print_data_cell_clear(cell);
+            _print_fill_cell(nmc_config,
+                             targets[i_row],
+                             targets_data,
+                             i_row,
+                             &nm_g_array_index(header_row, PrintDataHeaderCell, i_col),
+                             cell);
         }
+
+        _print_do_row(nmc_config,
+                      header_row->len,
+                      nm_g_array_first_p(header_row, PrintDataHeaderCell),
+                      nm_g_array_first_p(cells, PrintDataCell),
+                      str);
     }
 }
 
@@ -1404,6 +1550,11 @@ nmc_print_table(const NmcConfig                 *nmc_config,
     if (!_output_selection_parse(fields, fields_str, &cols_data, &cols_len, &gfree_keeper, error))
         return FALSE;
 
+    if (_print_can_stream(nmc_config)) {
+        _print_stream(nmc_config, targets, targets_data, header_name_no_l10n, cols_data, cols_len);
+        return TRUE;
+    }
+
     _print_fill(nmc_config, targets, targets_data, cols_data, cols_len, &header_row, &cells);
 
     _print_do(nmc_config,
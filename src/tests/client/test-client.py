@@ -2248,6 +2248,48 @@ class TestNmcli(unittest.TestCase):
         nmc.pexp.expect(pexpect.EOF)
         Util.valgrind_check_log(nmc.valgrind_log, "test_ask_offline")
 
+    @Util.skip_without_pexpect
+    @nm_test
+    def test_batch(self):
+        self.init_001()
+
+        nmc = Util.cmd_call_pexpect_nmcli(
+            ["--batch", "-g", "connection.id,connection.type"]
+        )
+        nmc.pexp.setecho(False)
+        # Each command must get its own copy of the "-g" fields. "connection show"
+        # frees them, which must not affect the next command.
+        for _ in range(3):
+            nmc.pexp.sendline("connection show con-1")
+            nmc.pexp.expect("con-1\r\n802-3-ethernet\r\n")
+        nmc.pexp.sendline("connection show con-missing")
+        nmc.pexp.expect("Error: con-missing - no such connection profile.")
+        nmc.pexp.sendline("connection show con-1")
+        nmc.pexp.expect("con-1\r\n802-3-ethernet\r\n")
+        nmc.pexp.sendeof()
+        nmc.pexp.expect(
+            "Error: 1 command\\(s\\) failed, the first with exit status 10."
+        )
+        nmc.pexp.expect(pexpect.EOF)
+        Util.valgrind_check_log(nmc.valgrind_log, "test_batch")
+
+        nmc = Util.cmd_call_pexpect_nmcli(["--batch", "-t", "-f", "DEVICE"])
+        nmc.pexp.setecho(False)
+        nmc.pexp.sendline("device status")
+        nmc.pexp.expect("eth0\r\neth1\r\nwlan0\r\nwlan1\r\nwlan1\r\n")
+        nmc.pexp.sendline("connection edit con-1")
+        nmc.pexp.expect("Error: command is not supported in --batch mode.")
+        nmc.pexp.sendeof()
+        nmc.pexp.expect(pexpect.EOF)
+        Util.valgrind_check_log(nmc.valgrind_log, "test_batch")
+
+        nmc = Util.cmd_call_pexpect_nmcli(["--batch", "--ask"])
+        nmc.pexp.expect(
+            "Error: Option '--batch' is mutually exclusive with '--ask'."
+        )
+        nmc.pexp.expect(pexpect.EOF)
+        Util.valgrind_check_log(nmc.valgrind_log, "test_batch")
+
     @Util.skip_without_pexpect
     @nm_test
     def test_monitor(self):
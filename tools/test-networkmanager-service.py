@@ -2190,6 +2190,17 @@ class Settings(ExportedObj):
     def ListConnections(self):
         return self.get_connection_paths()
 
+    @dbus.service.method(
+        dbus_interface=IFACE_SETTINGS, in_signature="ao", out_signature="a{oa{sa{sv}}}"
+    )
+    def GetSettingsMany(self, paths):
+        result = {}
+        for path in paths:
+            for c in self.find_connections(path=path):
+                if c.visible:
+                    result[path] = c.con_hash
+        return dbus.Dictionary(result, signature="oa{sa{sv}}")
+
     @dbus.service.method(
         dbus_interface=IFACE_SETTINGS, in_signature="a{sa{sv}}", out_signature="o"
     )